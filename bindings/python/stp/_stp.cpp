@@ -0,0 +1,1115 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+/*
+ * A CPython extension providing the Solver and Expr classes of stp.py
+ * natively. Building expressions, asserting, checking and reading models
+ * call the C interface directly rather than through ctypes. Checks release
+ * the GIL, and models are read with vc_getCounterExampleWords, so neither
+ * strings nor expressions are made for the values.
+ *
+ * Each Expr owns its C interface expression and keeps its Solver alive, so
+ * the validity checker is destroyed once the last of them has gone.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "stp/c_interface.h"
+#include <vector>
+
+namespace
+{
+
+struct SolverObject
+{
+  PyObject_HEAD
+  VC vc;
+  PyObject* keys; // name -> Expr of the variables, in creation order.
+  bool busy;      // a check is running without the GIL.
+  std::vector<Expr>* dropped; // by Exprs freed while it was, to delete after.
+};
+
+struct ExprObject
+{
+  PyObject_HEAD
+  SolverObject* s;
+  Expr expr;
+  int width; // -1 for booleans, which have a width of None.
+  PyObject* name;
+};
+
+// Filled in by PyInit__stp.
+PyTypeObject SolverType;
+PyTypeObject ExprType;
+
+typedef Expr (*UnaryOp)(VC, Expr);
+typedef Expr (*BinaryOp)(VC, Expr, Expr);
+typedef Expr (*WidthOp)(VC, int, Expr, Expr);
+
+bool isExpr(PyObject* o)
+{
+  return PyObject_TypeCheck(o, &ExprType);
+}
+
+ExprObject* asExpr(PyObject* o)
+{
+  return reinterpret_cast<ExprObject*>(o);
+}
+
+// Another thread may only use the solver once its check is over. A solver
+// the garbage collector has cleared can't be used at all.
+bool usable(SolverObject* s)
+{
+  if (s->busy)
+    PyErr_SetString(PyExc_RuntimeError, "The solver is running a check");
+  else if (s->keys == NULL)
+    PyErr_SetString(PyExc_RuntimeError, "The solver has been cleared");
+  else
+    return true;
+  return false;
+}
+
+// Takes ownership of "e".
+PyObject* wrap(SolverObject* s, Expr e, int width, PyObject* name = NULL)
+{
+  if (e == NULL)
+  {
+    if (!PyErr_Occurred())
+      PyErr_SetString(PyExc_RuntimeError, "STP couldn't create the expression");
+    return NULL;
+  }
+
+  ExprObject* result = PyObject_GC_New(ExprObject, &ExprType);
+  if (result == NULL)
+  {
+    vc_DeleteExpr(e);
+    return NULL;
+  }
+
+  Py_INCREF(s);
+  result->s = s;
+  result->expr = e;
+  result->width = width;
+  Py_XINCREF(name);
+  result->name = name;
+  PyObject_GC_Track(result);
+  return reinterpret_cast<PyObject*>(result);
+}
+
+// A constant of "width" bits holding "value" modulo 2^width. Returns NULL,
+// with an error set, on failure.
+Expr constant(SolverObject* s, int width, PyObject* value)
+{
+  if (width <= 0)
+  {
+    PyErr_SetString(PyExc_TypeError, "Constants need a bitvector width");
+    return NULL;
+  }
+
+  if (width <= 64)
+  {
+    const unsigned long long v = PyLong_AsUnsignedLongLongMask(value);
+    if (v == (unsigned long long)-1 && PyErr_Occurred())
+      return NULL;
+    return vc_bvConstExprFromLL(s->vc, width, v);
+  }
+
+  // Wider constants go through their decimal string.
+  Expr result = NULL;
+  PyObject* one = PyLong_FromLong(1);
+  PyObject* bits = PyLong_FromLong(width);
+  PyObject* modulus = (one && bits) ? PyNumber_Lshift(one, bits) : NULL;
+  PyObject* mask = modulus ? PyNumber_Subtract(modulus, one) : NULL;
+  PyObject* masked = mask ? PyNumber_And(value, mask) : NULL;
+  PyObject* str = masked ? PyObject_Str(masked) : NULL;
+  const char* decimal = str ? PyUnicode_AsUTF8(str) : NULL;
+  if (decimal != NULL)
+    result = vc_bvConstExprFromDecStr(s->vc, width, decimal);
+  Py_XDECREF(str);
+  Py_XDECREF(masked);
+  Py_XDECREF(mask);
+  Py_XDECREF(modulus);
+  Py_XDECREF(bits);
+  Py_XDECREF(one);
+  return result;
+}
+
+// Converts "other" to an expression like "self", as Expr._toexpr does.
+// Returns NULL with no error set if it's neither an Expr nor an integer.
+PyObject* coerce(ExprObject* self, PyObject* other)
+{
+  if (isExpr(other))
+  {
+    if (asExpr(other)->s != self->s)
+    {
+      PyErr_SetString(PyExc_ValueError,
+                      "The expressions belong to different solvers");
+      return NULL;
+    }
+    Py_INCREF(other);
+    return other;
+  }
+
+  if (PyLong_Check(other)) // bools too, as in stp.py.
+  {
+    Expr e = constant(self->s, self->width, other);
+    if (e == NULL)
+      return NULL;
+    return wrap(self->s, e, self->width);
+  }
+
+  return NULL;
+}
+
+// Number slots let Python try the other operand. Methods and comparisons
+// fail as the assertions in stp.py do.
+PyObject* unsupported(bool slot, PyObject*)
+{
+  if (slot)
+    Py_RETURN_NOTIMPLEMENTED;
+  PyErr_SetString(PyExc_AssertionError,
+                  "Other object must be an Expr instance");
+  return NULL;
+}
+
+// "op" applied to "a" and "b", one of which is "self", as Expr._2w does.
+PyObject* applyWidth(WidthOp op, ExprObject* self, PyObject* a, PyObject* b,
+                     bool slot)
+{
+  if (!usable(self->s))
+    return NULL;
+
+  PyObject* left = coerce(self, a);
+  if (left == NULL)
+    return PyErr_Occurred() ? NULL : unsupported(slot, a);
+  PyObject* right = coerce(self, b);
+  if (right == NULL)
+  {
+    Py_DECREF(left);
+    return PyErr_Occurred() ? NULL : unsupported(slot, b);
+  }
+
+  PyObject* result = NULL;
+  if (asExpr(left)->width != self->width || asExpr(right)->width != self->width)
+    PyErr_SetString(PyExc_AssertionError, "Width must be equal");
+  else
+    result = wrap(self->s, op(self->s->vc, self->width, asExpr(left)->expr,
+                              asExpr(right)->expr),
+                  self->width);
+  Py_DECREF(left);
+  Py_DECREF(right);
+  return result;
+}
+
+// "op" applied to "self" and "other", as Expr._2 does.
+PyObject* applyBinary(BinaryOp op, ExprObject* self, PyObject* other,
+                      bool slot)
+{
+  if (!usable(self->s))
+    return NULL;
+
+  PyObject* right = coerce(self, other);
+  if (right == NULL)
+    return PyErr_Occurred() ? NULL : unsupported(slot, other);
+
+  PyObject* result = wrap(
+      self->s, op(self->s->vc, self->expr, asExpr(right)->expr), self->width);
+  Py_DECREF(right);
+  return result;
+}
+
+template <WidthOp op> PyObject* widthMethod(PyObject* self, PyObject* other)
+{
+  return applyWidth(op, asExpr(self), self, other, false);
+}
+
+template <WidthOp op>
+PyObject* reversedWidthMethod(PyObject* self, PyObject* other)
+{
+  return applyWidth(op, asExpr(self), other, self, false);
+}
+
+template <WidthOp op> PyObject* widthSlot(PyObject* a, PyObject* b)
+{
+  return applyWidth(op, asExpr(isExpr(a) ? a : b), a, b, true);
+}
+
+template <BinaryOp op> PyObject* binaryMethod(PyObject* self, PyObject* other)
+{
+  return applyBinary(op, asExpr(self), other, false);
+}
+
+// The bitwise operations commute, so the Expr is the left operand.
+template <BinaryOp op> PyObject* binarySlot(PyObject* a, PyObject* b)
+{
+  return isExpr(a) ? applyBinary(op, asExpr(a), b, true)
+                   : applyBinary(op, asExpr(b), a, true);
+}
+
+template <UnaryOp op> PyObject* unaryMethod(PyObject* self, PyObject*)
+{
+  ExprObject* e = asExpr(self);
+  if (!usable(e->s))
+    return NULL;
+  return wrap(e->s, op(e->s->vc, e->expr), e->width);
+}
+
+template <UnaryOp op> PyObject* unarySlot(PyObject* self)
+{
+  return unaryMethod<op>(self, NULL);
+}
+
+Expr notEqual(VC vc, Expr a, Expr b)
+{
+  Expr eq = vc_eqExpr(vc, a, b);
+  Expr result = vc_notExpr(vc, eq);
+  vc_DeleteExpr(eq);
+  return result;
+}
+
+// The values of "exprs" in the last model. Booleans are Python bools, and
+// bitvectors are ints of any width.
+PyObject* values(SolverObject* s, const std::vector<Expr>& exprs)
+{
+  const size_t needed =
+      vc_getCounterExampleWords(s->vc, exprs.data(), exprs.size(), NULL, 0);
+  std::vector<uint64_t> words(needed);
+  vc_getCounterExampleWords(s->vc, exprs.data(), exprs.size(), words.data(),
+                            words.size());
+
+  PyObject* result = PyList_New(exprs.size());
+  if (result == NULL)
+    return NULL;
+
+  size_t at = 0;
+  for (size_t i = 0; i < exprs.size(); i++)
+  {
+    const int width = getVWidth(exprs[i]);
+    PyObject* value;
+    if (width == 0)
+    {
+      value = PyBool_FromLong(words[at++] != 0);
+    }
+    else
+    {
+      const size_t count = (width + 63) / 64;
+      value = PyLong_FromUnsignedLongLong(words[at + count - 1]);
+      for (size_t j = count - 1; j-- > 0 && value != NULL;)
+      {
+        PyObject* sixtyFour = PyLong_FromLong(64);
+        PyObject* low = PyLong_FromUnsignedLongLong(words[at + j]);
+        PyObject* shifted =
+            (sixtyFour && low) ? PyNumber_Lshift(value, sixtyFour) : NULL;
+        Py_DECREF(value);
+        value = shifted ? PyNumber_Or(shifted, low) : NULL;
+        Py_XDECREF(shifted);
+        Py_XDECREF(low);
+        Py_XDECREF(sixtyFour);
+      }
+      at += count;
+    }
+
+    if (value == NULL)
+    {
+      Py_DECREF(result);
+      return NULL;
+    }
+    PyList_SET_ITEM(result, i, value);
+  }
+  return result;
+}
+
+// The Expr in "arg", or NULL with an error set.
+ExprObject* expectExpr(SolverObject* s, PyObject* arg)
+{
+  if (!isExpr(arg))
+  {
+    PyErr_SetString(PyExc_AssertionError, "Object should be an Expression");
+    return NULL;
+  }
+  if (asExpr(arg)->s != s)
+  {
+    PyErr_SetString(PyExc_ValueError,
+                    "The expression belongs to another solver");
+    return NULL;
+  }
+  return asExpr(arg);
+}
+
+// The expressions in the sequence "args".
+bool collect(SolverObject* s, PyObject* args, std::vector<Expr>& out)
+{
+  PyObject* seq = PySequence_Fast(args, "Expected a sequence of expressions");
+  if (seq == NULL)
+    return false;
+
+  const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+  out.reserve(out.size() + n);
+  for (Py_ssize_t i = 0; i < n; i++)
+  {
+    ExprObject* e = expectExpr(s, PySequence_Fast_GET_ITEM(seq, i));
+    if (e == NULL)
+    {
+      Py_DECREF(seq);
+      return false;
+    }
+    out.push_back(e->expr);
+  }
+  Py_DECREF(seq);
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Solver                                                                  //
+/////////////////////////////////////////////////////////////////////////////
+
+PyObject* Solver_new(PyTypeObject* type, PyObject*, PyObject*)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(type->tp_alloc(type, 0));
+  if (self == NULL)
+    return NULL;
+
+  self->keys = PyDict_New();
+  self->dropped = new std::vector<Expr>;
+  if (self->keys == NULL)
+  {
+    Py_DECREF(self);
+    return NULL;
+  }
+
+  self->vc = vc_createValidityChecker();
+  if (self->vc == NULL)
+  {
+    Py_DECREF(self);
+    PyErr_SetString(PyExc_RuntimeError, "Error creating validity checker");
+    return NULL;
+  }
+
+  // The Exprs delete their own expressions.
+  vc_setInterfaceFlags(self->vc, EXPRDELETE, 0);
+  return reinterpret_cast<PyObject*>(self);
+}
+
+int Solver_init(PyObject*, PyObject* args, PyObject* kwargs)
+{
+  static const char* kwlist[] = {NULL};
+  return PyArg_ParseTupleAndKeywords(args, kwargs, ":Solver",
+                                     const_cast<char**>(kwlist))
+             ? 0
+             : -1;
+}
+
+int Solver_traverse(PyObject* o, visitproc visit, void* arg)
+{
+  Py_VISIT(reinterpret_cast<SolverObject*>(o)->keys);
+  return 0;
+}
+
+// Breaks the cycles through "keys". The Exprs, not this, are cleared last.
+int Solver_clear(PyObject* o)
+{
+  Py_CLEAR(reinterpret_cast<SolverObject*>(o)->keys);
+  return 0;
+}
+
+// SolverType is static, so a heap subclass's reference is released, and
+// visited, by CPython's subtype_dealloc() and subtype_traverse(), not here.
+void Solver_dealloc(PyObject* o)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  PyObject_GC_UnTrack(o);
+  Solver_clear(o);
+  if (self->vc != NULL)
+    vc_Destroy(self->vc);
+  delete self->dropped;
+  Py_TYPE(o)->tp_free(o);
+}
+
+PyObject* Solver_getVC(PyObject* o, void*)
+{
+  return PyLong_FromVoidPtr(reinterpret_cast<SolverObject*>(o)->vc);
+}
+
+PyObject* Solver_getKeys(PyObject* o, void*)
+{
+  PyObject* keys = reinterpret_cast<SolverObject*>(o)->keys;
+  if (keys == NULL)
+    Py_RETURN_NONE;
+  Py_INCREF(keys);
+  return keys;
+}
+
+// Declares the variables "names", all of "width" bits, and returns a list of
+// them.
+PyObject* declare(SolverObject* self, PyObject* names, int width)
+{
+  if (!usable(self))
+    return NULL;
+
+  PyObject* seq = PySequence_Fast(names, "Expected a sequence of names");
+  if (seq == NULL)
+    return NULL;
+
+  const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+  PyObject* result = PyList_New(n);
+  Type type = vc_bvType(self->vc, width);
+  for (Py_ssize_t i = 0; i < n && result != NULL; i++)
+  {
+    PyObject* name = PySequence_Fast_GET_ITEM(seq, i);
+    const char* utf8 = PyUnicode_AsUTF8(name);
+    PyObject* e =
+        utf8 ? wrap(self, vc_varExpr(self->vc, utf8, type), width, name) : NULL;
+    if (e == NULL || PyDict_SetItem(self->keys, name, e) < 0)
+    {
+      Py_XDECREF(e);
+      Py_CLEAR(result);
+    }
+    else
+      PyList_SET_ITEM(result, i, e);
+  }
+  vc_DeleteExpr(type);
+  Py_DECREF(seq);
+  return result;
+}
+
+PyObject* Solver_bitvec(PyObject* o, PyObject* args, PyObject* kwargs)
+{
+  static const char* kwlist[] = {"name", "width", NULL};
+  PyObject* name;
+  int width = 32;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "U|i:bitvec",
+                                   const_cast<char**>(kwlist), &name, &width))
+    return NULL;
+
+  PyObject* names = PyTuple_Pack(1, name);
+  if (names == NULL)
+    return NULL;
+  PyObject* list = declare(reinterpret_cast<SolverObject*>(o), names, width);
+  Py_DECREF(names);
+  if (list == NULL)
+    return NULL;
+  PyObject* result = PyList_GET_ITEM(list, 0);
+  Py_INCREF(result);
+  Py_DECREF(list);
+  return result;
+}
+
+// Accepts a list of names, as well as the space separated string of stp.py.
+PyObject* Solver_bitvecs(PyObject* o, PyObject* args, PyObject* kwargs)
+{
+  static const char* kwlist[] = {"names", "width", NULL};
+  PyObject* names;
+  int width = 32;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|i:bitvecs",
+                                   const_cast<char**>(kwlist), &names, &width))
+    return NULL;
+
+  PyObject* split = PyUnicode_Check(names) ? PyUnicode_Split(names, NULL, -1)
+                                           : (Py_INCREF(names), names);
+  if (split == NULL)
+    return NULL;
+  PyObject* result = declare(reinterpret_cast<SolverObject*>(o), split, width);
+  Py_DECREF(split);
+  return result;
+}
+
+PyObject* Solver_bitvecval(PyObject* o, PyObject* args)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  int width;
+  PyObject* value;
+  if (!PyArg_ParseTuple(args, "iO!:bitvecval", &width, &PyLong_Type, &value) ||
+      !usable(self))
+    return NULL;
+
+  Expr e = constant(self, width, value);
+  return e ? wrap(self, e, width) : NULL;
+}
+
+PyObject* Solver_bitvecvalD(PyObject* o, PyObject* args)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  int width;
+  const char* value;
+  if (!PyArg_ParseTuple(args, "is:bitvecvalD", &width, &value) ||
+      !usable(self))
+    return NULL;
+
+  return wrap(self, vc_bvConstExprFromDecStr(self->vc, width, value), width);
+}
+
+PyObject* Solver_true(PyObject* o, PyObject*)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  return usable(self) ? wrap(self, vc_trueExpr(self->vc), -1) : NULL;
+}
+
+PyObject* Solver_false(PyObject* o, PyObject*)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  return usable(self) ? wrap(self, vc_falseExpr(self->vc), -1) : NULL;
+}
+
+PyObject* Solver_add(PyObject* o, PyObject* args)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  std::vector<Expr> exprs;
+  if (!usable(self) || !collect(self, args, exprs))
+    return NULL;
+
+  for (Expr e : exprs)
+    vc_assertFormula(self->vc, e);
+  Py_RETURN_NONE;
+}
+
+PyObject* Solver_push(PyObject* o, PyObject*)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  if (!usable(self))
+    return NULL;
+  vc_push(self->vc);
+  Py_RETURN_NONE;
+}
+
+PyObject* Solver_pop(PyObject* o, PyObject*)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  if (!usable(self))
+    return NULL;
+  vc_pop(self->vc);
+  Py_RETURN_NONE;
+}
+
+PyObject* combine(PyObject* o, PyObject* args,
+                  Expr (*op)(VC, Expr*, int))
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  std::vector<Expr> exprs;
+  if (!usable(self) || !collect(self, args, exprs))
+    return NULL;
+  return wrap(self, op(self->vc, exprs.data(), exprs.size()), -1);
+}
+
+PyObject* Solver_and(PyObject* o, PyObject* args)
+{
+  return combine(o, args, vc_andExprN);
+}
+
+PyObject* Solver_or(PyObject* o, PyObject* args)
+{
+  return combine(o, args, vc_orExprN);
+}
+
+PyObject* Solver_xor(PyObject* o, PyObject* args)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  PyObject *a, *b;
+  if (!PyArg_ParseTuple(args, "OO:xor", &a, &b) || !usable(self))
+    return NULL;
+  ExprObject* ea = expectExpr(self, a);
+  ExprObject* eb = ea ? expectExpr(self, b) : NULL;
+  if (eb == NULL)
+    return NULL;
+  return wrap(self, vc_xorExpr(self->vc, ea->expr, eb->expr), -1);
+}
+
+PyObject* Solver_ite(PyObject* o, PyObject* args)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  PyObject *a, *b, *c;
+  if (!PyArg_ParseTuple(args, "OOO:ite", &a, &b, &c) || !usable(self))
+    return NULL;
+  ExprObject* ea = expectExpr(self, a);
+  ExprObject* eb = ea ? expectExpr(self, b) : NULL;
+  ExprObject* ec = eb ? expectExpr(self, c) : NULL;
+  if (ec == NULL)
+    return NULL;
+  if (eb->width != ec->width)
+  {
+    PyErr_SetString(PyExc_AssertionError, "Objects must have the same width");
+    return NULL;
+  }
+  return wrap(self, vc_iteExpr(self->vc, ea->expr, eb->expr, ec->expr),
+              eb->width);
+}
+
+PyObject* Solver_not(PyObject* o, PyObject* arg)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  ExprObject* e = usable(self) ? expectExpr(self, arg) : NULL;
+  if (e == NULL)
+    return NULL;
+  return wrap(self, vc_notExpr(self->vc, e->expr), e->width);
+}
+
+// Returns the result of vc_query_with_timeout for the negation of the
+// conjunction of "exprs", or -1 with an error set.
+int query(SolverObject* self, const std::vector<Expr>& exprs,
+          int max_conflicts, int max_time)
+{
+  Expr conjunction = exprs.empty()
+                         ? vc_falseExpr(self->vc)
+                         : vc_andExprN(self->vc,
+                                       const_cast<Expr*>(exprs.data()),
+                                       exprs.size());
+  Expr negation = exprs.empty() ? conjunction
+                                : vc_notExpr(self->vc, conjunction);
+
+  vc_push(self->vc);
+  int result;
+  self->busy = true;
+  Py_BEGIN_ALLOW_THREADS
+  result = vc_query_with_timeout(self->vc, negation, max_conflicts, max_time);
+  Py_END_ALLOW_THREADS
+  self->busy = false;
+  for (Expr e : *self->dropped)
+    vc_DeleteExpr(e);
+  self->dropped->clear();
+  vc_pop(self->vc);
+
+  if (negation != conjunction)
+    vc_DeleteExpr(negation);
+  vc_DeleteExpr(conjunction);
+  return result;
+}
+
+bool checkArguments(SolverObject* self, PyObject* args, PyObject* kwargs,
+                    std::vector<Expr>& exprs, int& max_conflicts, int& max_time)
+{
+  max_conflicts = -1;
+  max_time = -1;
+  if (kwargs != NULL)
+  {
+    PyObject* v = PyDict_GetItemString(kwargs, "max_conflicts");
+    if (v != NULL && (max_conflicts = PyLong_AsLong(v)) == -1 &&
+        PyErr_Occurred())
+      return false;
+    v = PyDict_GetItemString(kwargs, "max_time");
+    if (v != NULL && (max_time = PyLong_AsLong(v)) == -1 && PyErr_Occurred())
+      return false;
+  }
+  return usable(self) && collect(self, args, exprs);
+}
+
+PyObject* Solver_check_with_timeout(PyObject* o, PyObject* args,
+                                    PyObject* kwargs)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  std::vector<Expr> exprs;
+  int max_conflicts, max_time;
+  if (!checkArguments(self, args, kwargs, exprs, max_conflicts, max_time))
+    return NULL;
+  return PyLong_FromLong(query(self, exprs, max_conflicts, max_time));
+}
+
+PyObject* Solver_check(PyObject* o, PyObject* args)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  std::vector<Expr> exprs;
+  if (!usable(self) || !collect(self, args, exprs))
+    return NULL;
+
+  const int result = query(self, exprs, -1, -1);
+  if (result != 0 && result != 1)
+  {
+    PyErr_SetString(PyExc_AssertionError, "Error querying your input");
+    return NULL;
+  }
+  return PyBool_FromLong(result == 0);
+}
+
+// The value of a single expression in the last model.
+PyObject* valueOf(SolverObject* self, Expr e)
+{
+  PyObject* list = values(self, std::vector<Expr>(1, e));
+  if (list == NULL)
+    return NULL;
+  PyObject* result = PyList_GET_ITEM(list, 0);
+  Py_INCREF(result);
+  Py_DECREF(list);
+  return result;
+}
+
+PyObject* Solver_model(PyObject* o, PyObject* args, PyObject* kwargs)
+{
+  static const char* kwlist[] = {"key", "expr", NULL};
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  PyObject* key = Py_None;
+  PyObject* expr = Py_None;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|OO:model",
+                                   const_cast<char**>(kwlist), &key, &expr) ||
+      !usable(self))
+    return NULL;
+
+  if (isExpr(expr))
+    return valueOf(self, asExpr(expr)->expr);
+
+  // A raw expression from the C interface.
+  if (PyLong_Check(expr))
+  {
+    Expr e = PyLong_AsVoidPtr(expr);
+    return e ? valueOf(self, e) : NULL;
+  }
+
+  if (key != Py_None)
+  {
+    PyObject* e = PyDict_GetItemWithError(self->keys, key);
+    if (e == NULL)
+    {
+      if (!PyErr_Occurred())
+        PyErr_SetObject(PyExc_KeyError, key);
+      return NULL;
+    }
+    return valueOf(self, asExpr(e)->expr);
+  }
+
+  // All the variables at once.
+  std::vector<Expr> exprs;
+  exprs.reserve(PyDict_Size(self->keys));
+  Py_ssize_t pos = 0;
+  PyObject *k, *v;
+  while (PyDict_Next(self->keys, &pos, &k, &v))
+    exprs.push_back(asExpr(v)->expr);
+
+  PyObject* list = values(self, exprs);
+  PyObject* result = list ? PyDict_New() : NULL;
+  pos = 0;
+  for (size_t i = 0; result != NULL && PyDict_Next(self->keys, &pos, &k, &v);
+       i++)
+    if (PyDict_SetItem(result, k, PyList_GET_ITEM(list, i)) < 0)
+      Py_CLEAR(result);
+  Py_XDECREF(list);
+  return result;
+}
+
+PyObject* Solver_getitem(PyObject* o, PyObject* key)
+{
+  PyObject* args = PyTuple_Pack(1, key);
+  if (args == NULL)
+    return NULL;
+  PyObject* result = Solver_model(o, args, NULL);
+  Py_DECREF(args);
+  return result;
+}
+
+PyObject* Solver_values(PyObject* o, PyObject* exprs)
+{
+  SolverObject* self = reinterpret_cast<SolverObject*>(o);
+  std::vector<Expr> e;
+  if (!usable(self) || !collect(self, exprs, e))
+    return NULL;
+  return values(self, e);
+}
+
+PyMethodDef Solver_methods[] = {
+    {"bitvec", (PyCFunction)(void (*)(void))Solver_bitvec,
+     METH_VARARGS | METH_KEYWORDS, "Creates a new BitVector variable."},
+    {"bitvecs", (PyCFunction)(void (*)(void))Solver_bitvecs,
+     METH_VARARGS | METH_KEYWORDS,
+     "Creates BitVector variables, given a list of names or a string of "
+     "space separated names."},
+    {"bitvecval", Solver_bitvecval, METH_VARARGS,
+     "Creates a new BitVector with a constant value."},
+    {"bitvecvalD", Solver_bitvecvalD, METH_VARARGS,
+     "Creates a new BitVector with a constant value given in decimal."},
+    {"true", Solver_true, METH_NOARGS, "Creates a True boolean."},
+    {"false", Solver_false, METH_NOARGS, "Creates a False boolean."},
+    {"add", Solver_add, METH_VARARGS, "Adds one or more constraint(s) to STP."},
+    {"push", Solver_push, METH_NOARGS, "Enter a new frame."},
+    {"pop", Solver_pop, METH_NOARGS, "Leave the current frame."},
+    {"and_", Solver_and, METH_VARARGS, NULL},
+    {"or_", Solver_or, METH_VARARGS, NULL},
+    {"xor", Solver_xor, METH_VARARGS, NULL},
+    {"ite", Solver_ite, METH_VARARGS, NULL},
+    {"not_", Solver_not, METH_O, NULL},
+    {"check_with_timeout",
+     (PyCFunction)(void (*)(void))Solver_check_with_timeout,
+     METH_VARARGS | METH_KEYWORDS,
+     "Check whether the various expressions are satisfiable. The GIL is "
+     "released while STP runs."},
+    {"check", Solver_check, METH_VARARGS,
+     "Check whether the various expressions are satisfiable. The GIL is "
+     "released while STP runs."},
+    {"model", (PyCFunction)(void (*)(void))Solver_model,
+     METH_VARARGS | METH_KEYWORDS,
+     "Returns the value for an expression (or a name), or a model for the "
+     "entire counterexample otherwise."},
+    {"values", Solver_values, METH_O,
+     "Returns the values of a sequence of expressions in the model."},
+    {NULL, NULL, 0, NULL}};
+
+PyGetSetDef Solver_getset[] = {
+    {"vc", Solver_getVC, NULL, "The validity checker, for the C interface.",
+     NULL},
+    {"keys", Solver_getKeys, NULL, "The variables, by name.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}};
+
+PyMappingMethods Solver_mapping = {NULL, Solver_getitem, NULL};
+
+/////////////////////////////////////////////////////////////////////////////
+// Expr                                                                    //
+/////////////////////////////////////////////////////////////////////////////
+
+// Takes ownership of the C interface expression "expr", an integer.
+PyObject* Expr_new(PyTypeObject*, PyObject* args, PyObject* kwargs)
+{
+  static const char* kwlist[] = {"s", "width", "expr", "name", NULL};
+  PyObject *s, *width, *expr, *name = Py_None;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!OO!|O:Expr",
+                                   const_cast<char**>(kwlist), &SolverType, &s,
+                                   &width, &PyLong_Type, &expr, &name))
+    return NULL;
+
+  const int w = (width == Py_None) ? -1 : (int)PyLong_AsLong(width);
+  Expr e = PyLong_AsVoidPtr(expr);
+  if (PyErr_Occurred())
+    return NULL;
+  return wrap(reinterpret_cast<SolverObject*>(s), e, w,
+              name == Py_None ? NULL : name);
+}
+
+int Expr_traverse(PyObject* o, visitproc visit, void* arg)
+{
+  ExprObject* self = asExpr(o);
+  Py_VISIT(self->s);
+  Py_VISIT(self->name);
+  return 0;
+}
+
+void Expr_dealloc(PyObject* o)
+{
+  ExprObject* self = asExpr(o);
+  PyObject_GC_UnTrack(o);
+  // Deleting an expression changes reference counts STP reads, so one freed
+  // by another thread, or the collector, during a check waits for its end.
+  if (self->s->busy)
+    self->s->dropped->push_back(self->expr);
+  else
+    vc_DeleteExpr(self->expr);
+  Py_XDECREF(self->name);
+  Py_DECREF(self->s); // may destroy the validity checker.
+  PyObject_GC_Del(o);
+}
+
+PyObject* Expr_getS(PyObject* o, void*)
+{
+  PyObject* s = reinterpret_cast<PyObject*>(asExpr(o)->s);
+  Py_INCREF(s);
+  return s;
+}
+
+PyObject* Expr_getWidth(PyObject* o, void*)
+{
+  if (asExpr(o)->width < 0)
+    Py_RETURN_NONE;
+  return PyLong_FromLong(asExpr(o)->width);
+}
+
+PyObject* Expr_getExpr(PyObject* o, void*)
+{
+  return PyLong_FromVoidPtr(asExpr(o)->expr);
+}
+
+PyObject* Expr_getName(PyObject* o, void*)
+{
+  PyObject* name = asExpr(o)->name ? asExpr(o)->name : Py_None;
+  Py_INCREF(name);
+  return name;
+}
+
+PyObject* Expr_getValue(PyObject* o, void*)
+{
+  ExprObject* self = asExpr(o);
+  return usable(self->s) ? valueOf(self->s, self->expr) : NULL;
+}
+
+PyObject* Expr_extract(PyObject* o, PyObject* args)
+{
+  ExprObject* self = asExpr(o);
+  int high, low;
+  if (!PyArg_ParseTuple(args, "ii:extract", &high, &low) || !usable(self->s))
+    return NULL;
+  return wrap(self->s, vc_bvExtract(self->s->vc, self->expr, high, low),
+              high - low + 1);
+}
+
+PyObject* Expr_simplify(PyObject* o, PyObject*)
+{
+  ExprObject* self = asExpr(o);
+  if (!usable(self->s))
+    return NULL;
+  return wrap(self->s, vc_simplify(self->s->vc, self->expr), self->width);
+}
+
+PyObject* Expr_pos(PyObject* o)
+{
+  Py_INCREF(o);
+  return o;
+}
+
+PyObject* Expr_richcompare(PyObject* o, PyObject* other, int op)
+{
+  ExprObject* self = asExpr(o);
+  switch (op)
+  {
+    case Py_EQ:
+      return applyBinary(vc_eqExpr, self, other, false);
+    case Py_NE:
+      return applyBinary(notEqual, self, other, false);
+    case Py_LT:
+      return applyBinary(vc_bvLtExpr, self, other, false);
+    case Py_LE:
+      return applyBinary(vc_bvLeExpr, self, other, false);
+    case Py_GT:
+      return applyBinary(vc_bvGtExpr, self, other, false);
+    case Py_GE:
+      return applyBinary(vc_bvGeExpr, self, other, false);
+  }
+  Py_RETURN_NOTIMPLEMENTED;
+}
+
+#define WIDTH_METHODS(NAME, OP)                                                \
+  {NAME, widthMethod<OP>, METH_O, NULL},                                       \
+  {"r" NAME, reversedWidthMethod<OP>, METH_O, NULL}
+
+PyMethodDef Expr_methods[] = {
+    WIDTH_METHODS("add", vc_bvPlusExpr),
+    WIDTH_METHODS("sub", vc_bvMinusExpr),
+    WIDTH_METHODS("mul", vc_bvMultExpr),
+    WIDTH_METHODS("div", vc_bvDivExpr),
+    WIDTH_METHODS("mod", vc_bvModExpr),
+    WIDTH_METHODS("rem", vc_bvRemExpr),
+    WIDTH_METHODS("sdiv", vc_sbvDivExpr),
+    WIDTH_METHODS("smod", vc_sbvModExpr),
+    WIDTH_METHODS("srem", vc_sbvRemExpr),
+    WIDTH_METHODS("shl", vc_bvLeftShiftExprExpr),
+    WIDTH_METHODS("shr", vc_bvRightShiftExprExpr),
+    WIDTH_METHODS("sar", vc_bvSignedRightShiftExprExpr),
+    {"eq", binaryMethod<vc_eqExpr>, METH_O, NULL},
+    {"ne", binaryMethod<notEqual>, METH_O, NULL},
+    {"lt", binaryMethod<vc_bvLtExpr>, METH_O, NULL},
+    {"le", binaryMethod<vc_bvLeExpr>, METH_O, NULL},
+    {"gt", binaryMethod<vc_bvGtExpr>, METH_O, NULL},
+    {"ge", binaryMethod<vc_bvGeExpr>, METH_O, NULL},
+    {"slt", binaryMethod<vc_sbvLtExpr>, METH_O, NULL},
+    {"sle", binaryMethod<vc_sbvLeExpr>, METH_O, NULL},
+    {"sgt", binaryMethod<vc_sbvGtExpr>, METH_O, NULL},
+    {"sge", binaryMethod<vc_sbvGeExpr>, METH_O, NULL},
+    {"and_", binaryMethod<vc_bvAndExpr>, METH_O, NULL},
+    {"or_", binaryMethod<vc_bvOrExpr>, METH_O, NULL},
+    {"xor", binaryMethod<vc_bvXorExpr>, METH_O, NULL},
+    {"neg", unaryMethod<vc_bvUMinusExpr>, METH_NOARGS, NULL},
+    {"not_", unaryMethod<vc_bvNotExpr>, METH_NOARGS, NULL},
+    {"extract", Expr_extract, METH_VARARGS, NULL},
+    {"simplify", Expr_simplify, METH_NOARGS, "Simplify an expression."},
+    {NULL, NULL, 0, NULL}};
+
+#undef WIDTH_METHODS
+
+PyGetSetDef Expr_getset[] = {
+    {"s", Expr_getS, NULL, NULL, NULL},
+    {"width", Expr_getWidth, NULL, NULL, NULL},
+    {"expr", Expr_getExpr, NULL, "The expression, for the C interface.", NULL},
+    {"name", Expr_getName, NULL, NULL, NULL},
+    {"value", Expr_getValue, NULL,
+     "Returns the value of this BitVec in the current model.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}};
+
+PyNumberMethods Expr_number;
+
+PyModuleDef module;
+
+} // end anonymous namespace
+
+PyMODINIT_FUNC PyInit__stp(void)
+{
+  // Static types start with a reference, so they're never freed.
+  const PyVarObject head = {PyObject_HEAD_INIT(NULL) 0};
+  SolverType.ob_base = head;
+  ExprType.ob_base = head;
+
+  SolverType.tp_name = "_stp.Solver";
+  SolverType.tp_basicsize = sizeof(SolverObject);
+  SolverType.tp_flags =
+      Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC;
+  SolverType.tp_new = Solver_new;
+  SolverType.tp_init = Solver_init;
+  SolverType.tp_dealloc = Solver_dealloc;
+  SolverType.tp_traverse = Solver_traverse;
+  SolverType.tp_clear = Solver_clear;
+  SolverType.tp_methods = Solver_methods;
+  SolverType.tp_getset = Solver_getset;
+  SolverType.tp_as_mapping = &Solver_mapping;
+
+  Expr_number.nb_add = widthSlot<vc_bvPlusExpr>;
+  Expr_number.nb_subtract = widthSlot<vc_bvMinusExpr>;
+  Expr_number.nb_multiply = widthSlot<vc_bvMultExpr>;
+  Expr_number.nb_floor_divide = widthSlot<vc_bvDivExpr>;
+  Expr_number.nb_remainder = widthSlot<vc_bvModExpr>;
+  Expr_number.nb_lshift = widthSlot<vc_bvLeftShiftExprExpr>;
+  Expr_number.nb_rshift = widthSlot<vc_bvRightShiftExprExpr>;
+  Expr_number.nb_and = binarySlot<vc_bvAndExpr>;
+  Expr_number.nb_or = binarySlot<vc_bvOrExpr>;
+  Expr_number.nb_xor = binarySlot<vc_bvXorExpr>;
+  Expr_number.nb_negative = unarySlot<vc_bvUMinusExpr>;
+  Expr_number.nb_invert = unarySlot<vc_bvNotExpr>;
+  Expr_number.nb_positive = Expr_pos;
+
+  ExprType.tp_name = "_stp.Expr";
+  ExprType.tp_basicsize = sizeof(ExprObject);
+  ExprType.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC;
+  ExprType.tp_new = Expr_new;
+  ExprType.tp_dealloc = Expr_dealloc;
+  // No tp_clear: an Expr must keep its solver until it has deleted its
+  // expression, so the cycles are broken at the solver.
+  ExprType.tp_traverse = Expr_traverse;
+  ExprType.tp_richcompare = Expr_richcompare;
+  ExprType.tp_hash = PyObject_HashNotImplemented;
+  ExprType.tp_methods = Expr_methods;
+  ExprType.tp_getset = Expr_getset;
+  ExprType.tp_as_number = &Expr_number;
+
+  if (PyType_Ready(&SolverType) < 0 || PyType_Ready(&ExprType) < 0)
+    return NULL;
+
+  module.m_base = PyModuleDef_Base PyModuleDef_HEAD_INIT;
+  module.m_name = "_stp";
+  module.m_doc = "Native Solver and Expr classes for stp.py.";
+  module.m_size = -1;
+  PyObject* m = PyModule_Create(&module);
+  if (m == NULL)
+    return NULL;
+
+  Py_INCREF(&SolverType);
+  Py_INCREF(&ExprType);
+  PyObject* solver = reinterpret_cast<PyObject*>(&SolverType);
+  PyObject* expr = reinterpret_cast<PyObject*>(&ExprType);
+  if (PyModule_AddObject(m, "Solver", solver) < 0 ||
+      PyModule_AddObject(m, "Expr", expr) < 0)
+  {
+    Py_DECREF(m);
+    return NULL;
+  }
+  return m;
+}
@@ -26,6 +26,7 @@ THE SOFTWARE.
 
 #include "stp/AST/ASTNode.h"
 #include "stp/AST/UsefulDefs.h"
+#include <atomic>
 #include <iostream>
 
 using std::ostream;
@@ -62,6 +63,7 @@ private:
 class ASTInternal
 {
   friend class ASTNode;
+  friend class STPMgr;
 
 protected:
   // Pointer back to the node manager that holds this.
@@ -76,8 +78,13 @@ protected:
   uint64_t node_uid;
   static THREAD_LOCAL uint64_t node_uid_cntr;
 
-  // reference counting for garbage collection
-  uint32_t _ref_count;
+  // The next node number. Shared between the threads while "mgr" is
+  // concurrent.
+  static uint64_t newNodeNum(STPMgr* mgr);
+
+  // reference counting for garbage collection. Only updated atomically while
+  // the node manager is concurrent.
+  std::atomic<uint32_t> _ref_count;
 
   /*******************************************************************
    * ASTNode is of type BV      <==> ((indexwidth=0)&&(valuewidth>0))*
@@ -136,7 +143,7 @@ protected:
 public:
   // Constructor (kind only, empty children, int nodenum)
   ASTInternal(STPMgr* mgr, Kind kind)
-      : nodeManager(mgr), node_uid(node_uid_cntr += 2), _ref_count(0),
+      : nodeManager(mgr), node_uid(newNodeNum(mgr)), _ref_count(0),
         _kind(kind), iteration(0)
   {
   }
@@ -154,17 +161,10 @@ public:
   }
 
   // Increment Reference Count
-  void IncRef() { ++_ref_count; }
+  void IncRef();
 
   // Decrement Reference Count
-  void DecRef()
-  {
-    if (--_ref_count == 0)
-    {
-      // Delete node from unique table and kill it.
-      CleanUp();
-    }
-  }
+  void DecRef();
 
   unsigned GetNodeNum() const { return node_uid; }
 
@@ -0,0 +1,93 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Indexes long chains of array writes, so that a read at a constant index
+ * can skip the writes to other constant indexes without visiting them.
+ *
+ * The chain below each write is stored as a list of segments, outermost
+ * first. Each segment maps the constant indexes written in it to the
+ * outermost such write, and lists the writes with non-constant indexes.
+ * Segments are merged like a binary counter, so a chain of n writes has
+ * O(log n) segments, and the segments are shared between the chains of
+ * successive writes.
+ */
+
+#ifndef ARRAYWRITEINDEX_H
+#define ARRAYWRITEINDEX_H
+
+#include "stp/AST/AST.h"
+#include "stp/Util/Attributes.h"
+#include <memory>
+
+namespace stp
+{
+
+class DLL_PUBLIC ArrayWriteIndex
+{
+public:
+  struct Segment
+  {
+    ASTVec writes; // outermost first.
+    std::unordered_map<ASTNode, uint32_t, ASTNode::ASTNodeHasher,
+                       ASTNode::ASTNodeEqual>
+        constant;
+    std::vector<uint32_t> symbolic; // increasing.
+  };
+
+  struct Chain
+  {
+    std::vector<std::shared_ptr<const Segment>> segments;
+    ASTNode base; // the array below the innermost write.
+    uint32_t length;
+  };
+
+  // Chains shorter than this aren't indexed. Walking them is quick enough.
+  static const unsigned min_length = 16;
+
+  // Returns the index of the chain of writes starting at "write", or NULL if
+  // the chain is too short to be worth indexing.
+  const Chain* get(const ASTNode& write);
+
+  // The position, at or after "from", of the next write in "chain" that a
+  // read at the constant "index" may be reading from. Writes to other
+  // constant indexes are skipped. Returns chain.length if there is none.
+  // None of the writes before "from" may be to "index".
+  static uint32_t next(const Chain& chain, const ASTNode& index,
+                       uint32_t from);
+
+  // The write at "position" in "chain", counting from the outermost.
+  static const ASTNode& write(const Chain& chain, uint32_t position);
+
+  void clear() { chains.clear(); }
+
+private:
+  std::unordered_map<ASTNode, Chain, ASTNode::ASTNodeHasher,
+                     ASTNode::ASTNodeEqual>
+      chains;
+
+  const Chain& extend(const ASTNode& write, const Chain* below);
+};
+
+} // end namespace stp
+
+#endif
@@ -30,8 +30,10 @@ THE SOFTWARE.
 #ifndef MUTABLEASTNODE_H_
 #define MUTABLEASTNODE_H_
 #include "stp/AST/AST.h"
+#include "stp/AST/ParentIndex.h"
 #include "stp/STPManager/STPManager.h"
 #include "stp/Simplifier/Simplifier.h"
+#include <algorithm>
 
 namespace stp
 {
@@ -40,7 +42,8 @@ class MutableASTNode
   static THREAD_LOCAL vector<MutableASTNode*> all;
 
 public:
-  typedef std::set<MutableASTNode*> ParentsType;
+  // Distinct, in no particular order.
+  typedef vector<MutableASTNode*> ParentsType;
   ParentsType parents;
 
 private:
@@ -49,6 +52,23 @@ private:
 
   MutableASTNode(const ASTNode& n_) : n(n_) { dirty = false; }
 
+  // A new parent's children are linked to it together, so a repeated child
+  // has the parent last.
+  void addNewParent(MutableASTNode* parent)
+  {
+    if (parents.empty() || parents.back() != parent)
+      parents.push_back(parent);
+  }
+
+  void removeParent(MutableASTNode* parent)
+  {
+    ParentsType::iterator it = std::find(parents.begin(), parents.end(), parent);
+    if (it == parents.end())
+      return;
+    *it = parents.back();
+    parents.pop_back();
+  }
+
   /* Make a mutable ASTNode graph like the ASTNode one, but with pointers back
    * up too. It's convoluted because we want a post order traversal. The root
    * node of a sub-tree will be created after its children.
@@ -75,7 +95,7 @@ public:
 
     for (size_t i = 0; i < n.Degree(); i++)
     {
-      tempChildren[i]->parents.insert(mut);
+      tempChildren[i]->addNewParent(mut);
     }
 
     mut->children.insert(mut->children.end(), tempChildren.begin(),
@@ -116,7 +136,9 @@ public:
       children[i]->checkInvariant();
 
       // all my children have me as a parent.
-      assert(children[i]->parents.find(this) != children[i]->parents.end());
+      assert(std::find(children[i]->parents.begin(),
+                       children[i]->parents.end(),
+                       this) != children[i]->parents.end());
     }
 
     return true; // ignored.
@@ -125,7 +147,7 @@ public:
   MutableASTNode& getParent()
   {
     assert(parents.size() == 1);
-    return **(parents.begin());
+    return *parents[0];
   }
 
   ASTNode toASTNode(stp::STPMgr* stpMgr)
@@ -188,8 +210,33 @@ public:
 
   static MutableASTNode* build(ASTNode n)
   {
-    std::map<ASTNode, MutableASTNode*> visited;
-    return build(n, visited);
+    const ParentIndex index(n);
+    return build(index);
+  }
+
+  // The graph of the indexed DAG. Nodes are created in the index's order,
+  // children first, and the parents come from the index already counted.
+  static MutableASTNode* build(const ParentIndex& index)
+  {
+    vector<MutableASTNode*> mutables(index.size());
+    for (ParentIndex::Id i = 0; i < index.size(); i++)
+    {
+      MutableASTNode* mut = createNode(index.node(i));
+      const ParentIndex::Id* c = index.childrenBegin(i);
+      mut->children.reserve(index.childrenEnd(i) - c);
+      for (; c != index.childrenEnd(i); c++)
+        mut->children.push_back(mutables[*c]);
+      mut->parents.reserve(index.uses(i));
+      mutables[i] = mut;
+    }
+
+    for (ParentIndex::Id i = 0; i < index.size(); i++)
+    {
+      const ParentIndex::Id* p = index.parentsBegin(i);
+      for (; p != index.parentsEnd(i); p++)
+        mutables[i]->parents.push_back(mutables[*p]);
+    }
+    return mutables[index.root()];
   }
 
   void propagateUpDirty()
@@ -211,7 +258,7 @@ public:
     children.insert(children.begin(), newN->children.begin(),
                     newN->children.end());
     for (size_t i = 0; i < children.size(); i++)
-      children[i]->parents.insert(this);
+      children[i]->addNewParent(this);
 
     propagateUpDirty();
     assert(newN->parents.size() == 0); // we don't copy 'em in you see.
@@ -235,10 +282,9 @@ public:
     for (unsigned i = 0; i < children.size(); i++)
     {
       MutableASTNode* child = children[i];
-      ParentsType& children_parents = child->parents;
-      children_parents.erase(this);
+      child->removeParent(this);
 
-      if (children_parents.size() == 0)
+      if (child->parents.size() == 0)
       {
         child->removeChildren(variables);
       }
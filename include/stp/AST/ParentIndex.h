@@ -0,0 +1,102 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+/*
+ * The parents of each node below a root, for passes that work up from the
+ * leaves, built in one pass over the DAG.
+ *
+ * Nodes are numbered children first, so a node's number is bigger than its
+ * children's. The distinct parents of all the nodes are stored in one array,
+ * node i's starting at parentsBegin[i]. The first uses(i) of them are live.
+ * Removing a parent swaps it past the live ones, so passes that delete parts
+ * of the DAG can keep the index up to date without rebuilding it.
+ *
+ * Each node also has a polarity: whether it's reached from the root through
+ * an even number of NOTs, an odd number, or either (or through a node that
+ * isn't propositional).
+ */
+
+#ifndef PARENTINDEX_H
+#define PARENTINDEX_H
+
+#include "stp/AST/AST.h"
+#include "stp/Util/Attributes.h"
+
+namespace stp
+{
+
+class DLL_PUBLIC ParentIndex
+{
+public:
+  typedef uint32_t Id;
+  static const Id none = ~(Id)0;
+
+  typedef char Polarity;
+  static const Polarity truePolarity = 1;
+  static const Polarity falsePolarity = 2;
+  static const Polarity bothPolarity = 3;
+
+  explicit ParentIndex(const ASTNode& top);
+
+  ParentIndex(const ParentIndex&) = delete;
+  ParentIndex& operator=(const ParentIndex&) = delete;
+
+  size_t size() const { return nodes.size(); }
+  Id root() const { return nodes.size() - 1; }
+
+  const ASTNode& node(Id i) const { return nodes[i]; }
+
+  // The number of "n", or none if it isn't below the root.
+  Id find(const ASTNode& n) const;
+
+  const Id* childrenBegin(Id i) const { return kids.data() + kidsBegin[i]; }
+  const Id* childrenEnd(Id i) const { return kids.data() + kidsBegin[i + 1]; }
+
+  // The distinct nodes that have "i" as a child.
+  const Id* parentsBegin(Id i) const { return parents.data() + parentBegin[i]; }
+  const Id* parentsEnd(Id i) const { return parentsBegin(i) + live[i]; }
+  uint32_t uses(Id i) const { return live[i]; }
+
+  Polarity polarity(Id i) const { return polarities[i]; }
+
+  // Whether "parent" is one of the parents of "child".
+  bool isParent(Id parent, Id child) const;
+
+  // "parent" no longer has "child" as a child.
+  void removeParent(Id child, Id parent);
+
+private:
+  ASTVec nodes;
+  std::unordered_map<unsigned, Id> ids; // by node number.
+
+  std::vector<uint32_t> kidsBegin; // children of i are kids[kidsBegin[i]..]
+  std::vector<Id> kids;
+  std::vector<uint32_t> parentBegin;
+  std::vector<Id> parents;
+  std::vector<uint32_t> live;
+  std::vector<Polarity> polarities;
+};
+
+} // end namespace stp
+
+#endif
@@ -27,9 +27,11 @@ THE SOFTWARE.
 
 #include "stp/AST/AST.h"
 #include "stp/AbsRefineCounterExample/ArrayTransformer.h"
+#include "stp/AbsRefineCounterExample/ModelCache.h"
 #include "stp/STPManager/STPManager.h"
 #include "stp/Simplifier/Simplifier.h"
 #include "stp/ToSat/ToSATBase.h"
+#include "stp/Simplifier/constantBitP/NodeToFixedBitsMap.h"
 
 namespace stp
 {
@@ -54,6 +56,11 @@ private:
   // Ptr to ArrayTransformer
   ArrayTransformer* ArrayTransform;
 
+  // Number of read-over-read lemmas added for each array.
+  std::map<ASTNode, unsigned> arrayLemmaCount;
+
+  void printArrayLemmaStats(unsigned rounds) const;
+
   // Checks if the counterexample is good. In order for the
   // counterexample to be ok, every assert must evaluate to true
   // w.r.t couner_example, and the query must evaluate to
@@ -70,6 +77,12 @@ private:
 
   void CopySolverMap_To_CounterExample(void);
 
+  // Adds the values of the array reads, given the values of the symbols.
+  void CopyArrayReads_To_CounterExample(void);
+
+  // Checks and prints the counterexample, as the flags ask.
+  void ReportCounterExample(void);
+
   // Converts a vector of bools to a BVConst
   ASTNode BoolVectoBVConst(const vector<bool>* w, const unsigned int l);
 
@@ -113,6 +126,22 @@ public:
   vector<std::pair<ASTNode, ASTNode>> GetCounterExampleArray(bool t,
                                                              const ASTNode& e);
 
+  // Writes the value of e to "words", least significant word first. There
+  // must be room for (width + 63) / 64 words. Booleans take one word.
+  void GetCounterExampleWords(const ASTNode& e, uint64_t* words);
+
+  // Like GetCounterExampleArray, but for several arrays at once, with one
+  // pass over the counterexample.
+  void GetCounterExampleArrays(
+      const ASTVec& arrays,
+      vector<vector<std::pair<ASTNode, ASTNode>>>& entries);
+
+  // Number of 64-bit words that GetCounterExampleWords writes for e.
+  static size_t WordsFor(const ASTNode& e)
+  {
+    return (BOOLEAN_TYPE == e.GetType()) ? 1 : (e.GetValueWidth() + 63) / 64;
+  }
+
   int CounterExampleSize(void) const { return CounterExampleMap.size(); }
 
   // FIXME: This is bloody dangerous function. Hack attack to take
@@ -131,10 +160,31 @@ public:
                       const ASTNode& original_input, ToSATBase* tosat,
                       bool refinement);
 
+  // Looks for a model by local search, before bit-blasting. Returns
+  // SOLVER_INVALID if it finds one that satisfies the original input, and
+  // SOLVER_UNDECIDED otherwise. "fixed" may be NULL.
+  SOLVER_RETURN_TYPE
+  LocalSearch_ResultCheck(const ASTNode& modified_input,
+                          const ASTNode& original_input,
+                          simplifier::constantBitP::NodeToFixedBitsMap* fixed);
+
+  // Looks for a remembered model that satisfies the original input. If
+  // there is one, it becomes the counterexample and SOLVER_INVALID is
+  // returned. Otherwise returns SOLVER_UNDECIDED.
+  SOLVER_RETURN_TYPE CachedModel_ResultCheck(const ASTNode& original_input,
+                                             ModelCache& cache);
+
   SOLVER_RETURN_TYPE
   SATBased_ArrayReadRefinement(SATSolver& newS, const ASTNode& original_input,
                                ToSATBase* tosat);
 
+  // Adds just the read-over-read axioms that the model violates, until
+  // the model is good.
+  SOLVER_RETURN_TYPE
+  LemmaOnDemand_ArrayRefinement(SATSolver& SatSolver,
+                                const ASTNode& original_input,
+                                ToSATBase* tosat);
+
   void applyAllCongruenceConstraints(SATSolver& SatSolver, ToSATBase* tosat);
 
 #if 0
@@ -156,6 +206,7 @@ public:
   {
     CounterExampleMap.clear();
     ComputeFormulaMap.clear();
+    arrayLemmaCount.clear();
   }
 
   ~AbsRefine_CounterExample() { ClearAllTables(); }
@@ -26,7 +26,10 @@ THE SOFTWARE.
 #define TRANSFORM_H
 
 #include "stp/AST/AST.h"
+#include "stp/AST/ArrayWriteIndex.h"
 #include "stp/STPManager/STPManager.h"
+#include "stp/Util/UndoTrail.h"
+#include <memory>
 
 namespace stp
 {
@@ -70,6 +73,40 @@ public:
 private:
   std::map<ASTNode, vector<std::pair<ASTNode, ASTNode>>> ack_pair;
 
+  // So reads at constant indexes skip the writes to other constants.
+  ArrayWriteIndex writeChains;
+
+  // What to undo to get back to a checkpoint. The write chains are a cache
+  // of what's in the nodes, so aren't recorded.
+  struct Saved
+  {
+    ArrType arrayToIndexToRead;
+    std::map<ASTNode, vector<std::pair<ASTNode, ASTNode>>> ack_pair;
+  };
+
+  struct Change
+  {
+    enum Kind
+    {
+      READ,         // the read of "array" at "index" was added.
+      INDEX_SYMBOL, // its index symbol was "old".
+      ACK,          // a pair was appended to ack_pair[array].
+      CLEARED
+    } kind;
+    ASTNode array, index, old;
+    std::unique_ptr<Saved> saved;
+  };
+
+  UndoTrail<Change> trail;
+
+  void addRead(const ASTNode& array, const ASTNode& index,
+               const ArrayRead& read);
+  void setIndexSymbol(const ASTNode& array, const ASTNode& index,
+                      ArrayRead& read, const ASTNode& symbol);
+  void addAck(const ASTNode& array, const ASTNode& index,
+              const ASTNode& symbol);
+  void undo(Change& c);
+
   /****************************************************************
    * Private Typedefs and Data                                    *
    ****************************************************************/
@@ -132,10 +169,31 @@ public:
 
   void ClearAllTables(void)
   {
+    if (trail.clearNeedsSaving())
+    {
+      std::unique_ptr<Saved> saved(new Saved);
+      saved->arrayToIndexToRead.swap(arrayToIndexToRead);
+      saved->ack_pair.swap(ack_pair);
+      trail.push(Change{Change::CLEARED, ASTNode(), ASTNode(), ASTNode(),
+                        std::move(saved)});
+    }
     arrayToIndexToRead.clear();
     ack_pair.clear();
+    writeChains.clear();
+  }
+
+  // Marks the reads that rollback() returns to. Checkpoints nest.
+  void checkpoint() { trail.checkpoint(); }
+
+  // Forgets the reads added since the last checkpoint, and removes it.
+  void rollback()
+  {
+    trail.rollback([this](Change& c) { undo(c); });
   }
 
+  // Removes the last checkpoint, keeping the reads added since.
+  void release() { trail.release(); }
+
   void printArrayStats()
   {
     std::cerr << "Array Sizes:";
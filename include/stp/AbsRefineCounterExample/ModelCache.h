@@ -0,0 +1,77 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Remembers the last few models and unsatisfiable inputs of a validity
+ * checker, so that later queries can be answered without solving.
+ *
+ * A new input that a remembered model satisfies is satisfiable. An input
+ * whose top-level conjuncts include all those of a remembered
+ * unsatisfiable input is unsatisfiable. Incremental users mostly add
+ * conjuncts to earlier inputs, so both happen often.
+ */
+
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include "stp/AST/AST.h"
+#include <deque>
+
+namespace stp
+{
+
+class ModelCache
+{
+public:
+  // The symbols and the array reads at constant indexes of "model" are
+  // kept. Evicts the least recently used model if there are too many.
+  void addModel(const ASTNodeMap& model, unsigned capacity);
+
+  // Records that "input" is unsatisfiable.
+  void addUnsatisfiable(const ASTNode& input, unsigned capacity);
+
+  // Whether the conjuncts of "input" include those of a remembered
+  // unsatisfiable input.
+  bool knownUnsatisfiable(const ASTNode& input) const;
+
+  // The remembered models, the most recently used first.
+  const std::deque<ASTNodeMap>& getModels() const { return models; }
+
+  // Marks the i-th model as the most recently used.
+  void used(size_t i);
+
+  void clear()
+  {
+    models.clear();
+    unsatisfiable.clear();
+  }
+
+private:
+  std::deque<ASTNodeMap> models;
+
+  // The conjuncts of each unsatisfiable input, sorted by node number.
+  std::deque<ASTVec> unsatisfiable;
+};
+
+} // end namespace stp
+
+#endif
@@ -38,8 +38,16 @@ public:
   ASTNode CreateNode(const Kind kind, const ASTVec& back_children);
   ASTNode CreateTerm(Kind kind, unsigned int width,
                                 const ASTVec& children);
+  ASTNode CreateArrayTerm(Kind kind, unsigned int index, unsigned int width,
+                          const ASTVec& children);
 
   virtual std::string getName() { return "hashing"; }
+
+private:
+  // The widths are set before the node is in the unique table, so that other
+  // threads never see them change.
+  ASTNode createInterior(const Kind kind, const ASTVec& back_children,
+                         unsigned width, unsigned index);
 };
 
 #endif /* HASHINGNODEFACTORY_H_ */
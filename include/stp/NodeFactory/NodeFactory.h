@@ -55,6 +55,8 @@ public:
   NodeFactory(STPMgr& bm_) : bm(bm_) {}
   virtual ~NodeFactory() {}
 
+  STPMgr& getSTPMgr() const { return bm; }
+
   virtual ASTNode CreateTerm(Kind kind, unsigned int width,
                                         const ASTVec& children) = 0;
 
@@ -104,6 +106,9 @@ public:
   ASTNode CreateBVConst(unsigned int width, unsigned long long int bvconst);
 
   virtual std::string getName() = 0;
+
+  // Drops what the factory remembers about the nodes it has made.
+  virtual void ClearAllTables() {}
 };
 
 #endif
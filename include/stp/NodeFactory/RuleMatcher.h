@@ -0,0 +1,185 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Applies the rewrite rules in lib/NodeFactory/RewriteRules.rules when nodes
+ * are created.
+ *
+ * genrules.pl compiles the rules into a discrimination tree. The tree is
+ * entered by the (Kind, arity) of the node being created, then walks the
+ * children in pre-order: each edge either requires a kind (and arity), binds
+ * a pattern variable, checks a variable that is already bound (so non-linear
+ * patterns like (BVXOR x x) are checked by pointer comparison), or requires
+ * one of the constants zero/one/max/true/false. Commutative kinds are
+ * expanded by the generator, so matching never permutes children.
+ *
+ * The number of edges visited per node is capped, so the per-node cost is
+ * bounded no matter how many rules are loaded.
+ */
+
+#ifndef RULEMATCHER_H
+#define RULEMATCHER_H
+
+#include "stp/AST/AST.h"
+#include "stp/Util/Attributes.h"
+#include <cstdint>
+#include <vector>
+
+namespace stp
+{
+namespace rules
+{
+
+// Constants that can appear in rules. Bit-vector constants take their width
+// from the node being matched.
+enum RuleConstant
+{
+  RC_ZERO = 0,
+  RC_ONE,
+  RC_MAX,
+  RC_TRUE,
+  RC_FALSE
+};
+
+struct RuleRoot
+{
+  Kind kind;
+  uint8_t arity;
+  uint32_t state;
+};
+
+struct RuleEdge
+{
+  enum Type
+  {
+    KIND = 0, // node of "kind" with "arg" children.
+    BIND,     // binds any node to variable "arg".
+    SAME,     // must be the node already bound to variable "arg".
+    CONST     // must be the constant "arg".
+  };
+  uint8_t type;
+  Kind kind;
+  uint8_t arg;
+  uint32_t target;
+};
+
+// Leaf states have no edges and rule >= 0.
+struct RuleState
+{
+  uint32_t edge_begin;
+  uint32_t edge_end;
+  int32_t rule;
+};
+
+// Post-fix program that builds one side of a rule.
+struct RuleInstr
+{
+  enum Op
+  {
+    VAR = 0,
+    CONSTANT,
+    APPLY
+  };
+  uint8_t op;
+  Kind kind;
+  uint8_t arg; // variable, constant, or number of children.
+};
+
+struct RuleInfo
+{
+  uint16_t min_width;
+  uint8_t vars;
+  uint32_t lhs_begin;
+  uint32_t lhs_end;
+  uint32_t rhs_begin;
+  uint32_t rhs_end;
+  const char* text;
+};
+
+// Generated by genrules.pl.
+extern const RuleRoot rule_roots[];
+extern const RuleState rule_states[];
+extern const RuleEdge rule_edges[];
+extern const RuleInstr rule_code[];
+extern const RuleInfo rule_info[];
+extern const unsigned rule_roots_count;
+extern const unsigned rule_count;
+
+} // end namespace rules
+
+class DLL_PUBLIC RuleMatcher
+{
+public:
+  RuleMatcher(STPMgr& bm, NodeFactory* nf);
+
+  RuleMatcher(const RuleMatcher&) = delete;
+  RuleMatcher& operator=(const RuleMatcher&) = delete;
+
+  // Returns the rewritten node, or a null node if no rule applies to the node
+  // that would be created from kind/children. "width" is the width of the
+  // node if it's a term, otherwise ignored.
+  ASTNode apply(const Kind kind, const unsigned width, const ASTVec& children);
+
+  // Builds the left or right hand side of a rule, with the variables given.
+  // Used to check the rule set.
+  ASTNode instantiate(const unsigned rule, bool lhs, const unsigned width,
+                      const ASTVec& vars, NodeFactory* factory);
+
+  static unsigned numberOfRules() { return rules::rule_count; }
+
+  uint64_t rulesApplied() const { return applied; }
+  uint64_t edgesVisited() const { return visited; }
+
+  // Upper bound on the edges followed when matching a single node.
+  static const unsigned max_edges_per_node = 64;
+
+private:
+  STPMgr& bm;
+  NodeFactory* nf;
+
+  // For each kind, the range of rule_roots with that kind.
+  std::vector<std::pair<uint32_t, uint32_t>> by_kind;
+
+  // Rewrites produce nodes through the factory, which tries the rules again.
+  // Stop runaway chains.
+  unsigned depth;
+
+  uint64_t applied;
+  uint64_t visited;
+
+  // Scratch space, reused between calls.
+  std::vector<const ASTNode*> pending;
+  ASTVec bound;
+  unsigned budget;
+
+  // Rule chains deeper than this aren't followed.
+  static const unsigned max_depth = 16;
+
+  bool matchFrom(uint32_t state, unsigned width, int32_t& rule);
+  bool isConstant(const ASTNode& n, uint8_t c) const;
+  ASTNode constant(uint8_t c, unsigned width);
+  ASTNode build(const Kind k, unsigned width, const ASTVec& children,
+                NodeFactory* factory);
+};
+} // end namespace stp
+
+#endif
@@ -49,7 +49,9 @@ THE SOFTWARE.
 #ifndef SIMPLIFYINGNODEFACTORY_H
 #define SIMPLIFYINGNODEFACTORY_H
 
+#include "stp/AST/ArrayWriteIndex.h"
 #include "stp/NodeFactory/NodeFactory.h"
+#include "stp/NodeFactory/RuleMatcher.h"
 #include "stp/STPManager/STPManager.h"
 #include "stp/Util/Attributes.h"
 
@@ -63,7 +65,8 @@ public:
 
   SimplifyingNodeFactory(NodeFactory& raw_, STPMgr& bm_)
       : NodeFactory(bm_), hashing(raw_), ASTTrue(bm_.ASTTrue),
-        ASTFalse(bm_.ASTFalse), ASTUndefined(bm_.ASTUndefined){};
+        ASTFalse(bm_.ASTFalse), ASTUndefined(bm_.ASTUndefined),
+        rules(bm_, this){};
   ~SimplifyingNodeFactory() {}
 
   SimplifyingNodeFactory(const SimplifyingNodeFactory&) = delete;
@@ -72,6 +75,11 @@ public:
   static ASTNode convertKnownShiftAmount(const Kind k,
                                             const ASTVec& children, STPMgr& bm,
                                             NodeFactory* nf);
+
+  stp::RuleMatcher& getRuleMatcher() { return rules; }
+
+  virtual void ClearAllTables() override { writeIndex.clear(); }
+
 private:
   NodeFactory& hashing;
 
@@ -79,6 +87,12 @@ private:
   const ASTNode& ASTFalse;
   const ASTNode& ASTUndefined;
 
+  // The rules from RewriteRules.rules.
+  stp::RuleMatcher rules;
+
+  // Used by chaseRead.
+  stp::ArrayWriteIndex writeIndex;
+
   ASTNode CreateSimpleFormITE(const ASTVec& children);
   ASTNode CreateSimpleXor(const ASTVec& children);
 
@@ -49,6 +49,8 @@ public:
                                unsigned int width, const ASTVec& children);
 
   virtual std::string getName() { return "type checking"; }
+
+  virtual void ClearAllTables() { f.ClearAllTables(); }
 };
 
 #endif /* TYPECHECKER_H_ */
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "stp/AST/AST.h"
 #include "stp/AbsRefineCounterExample/AbsRefine_CounterExample.h"
 #include "stp/AbsRefineCounterExample/ArrayTransformer.h"
+#include "stp/AbsRefineCounterExample/ModelCache.h"
 #include "stp/Parser/LetMgr.h"
 #include "stp/STPManager/STPManager.h"
 #include "stp/Simplifier/BVSolver.h"
@@ -36,6 +37,7 @@ THE SOFTWARE.
 #include "stp/Util/Attributes.h"
 #include "stp/ToSat/ToSATAIG.h"
 #include "stp/Simplifier/NodeDomainAnalysis.h"
+#include "stp/Simplifier/PassScheduler.h"
 
 namespace stp
 {
@@ -43,17 +45,44 @@ namespace stp
 class STP
 {
 
-  ASTNode sizeReducing(ASTNode input, BVSolver* bvSolver,
-                       PropagateEqualities* pe, NodeDomainAnalysis* domain);
+  // Adds the simplifications that shouldn't increase the size of the DAG.
+  void addSizeReducingPasses(PassScheduler& scheduler, BVSolver* bvSolver,
+                             PropagateEqualities* pe,
+                             NodeDomainAnalysis* domain);
 
-  // A copy of all the state we need to restore to a prior expression.
-  struct Revert_to
+  // A checkpoint to go back to if simplifying makes the problem harder.
+  // Unless it's reverted, the changes since are kept when it's destroyed.
+  class Revert_to
   {
-    ASTNodeMap initialSolverMap; // Map from variables to expressions they were
-                                 // replaced with.
-    ASTNode toRevertTo;          // The original expression.
-    ArrayTransformer::ArrType
-        backup_arrayToIndexToRead; // array-indices already removed.
+    STP& stp;
+    ASTNode toRevertTo; // The original expression.
+    bool reverted;
+
+  public:
+    Revert_to(STP& s, const ASTNode& original)
+        : stp(s), toRevertTo(original), reverted(false)
+    {
+      stp.checkpoint();
+    }
+
+    Revert_to(const Revert_to&) = delete;
+    Revert_to& operator=(const Revert_to&) = delete;
+
+    ~Revert_to()
+    {
+      if (!reverted)
+        stp.release();
+    }
+
+    // Undoes the substitutions and array reads made since, and returns the
+    // original expression.
+    ASTNode revert()
+    {
+      assert(!reverted);
+      reverted = true;
+      stp.rollback();
+      return toRevertTo;
+    }
   };
 
   // Accepts query and returns the answer. if query is valid,
@@ -66,8 +95,24 @@ class STP
   SOLVER_RETURN_TYPE solve_by_sat_solver(SATSolver* newS,
                                          ASTNode original_input);
 
+  // Refreshes the memory estimates for the node tables and the simplifier,
+  // dropping the simplifier's caches if memory is tight. Returns false if
+  // the query is over its memory budget anyway.
+  bool withinMemoryBudget();
+
   SATSolver* get_new_sat_solver();
 
+  // The solver picked by the user flags, without cube-and-conquer.
+  SATSolver* get_backend_sat_solver();
+
+  // Outlives the tables that are cleared between queries.
+  ModelCache modelCache;
+
+  // Fresh symbols standing for the assumptions of the current query, each
+  // implying its assumption, and those of them the SAT solver refuted.
+  ASTVec selectors;
+  ASTVec refuted;
+
 public:
   STPMgr* bm;
   Simplifier* simp;
@@ -92,7 +137,8 @@ public:
 
   ~STP() 
   { 
-    ClearAllTables(); 
+    // The node factory might have gone already.
+    clearSolverTables();
     deleteObjects();
   }
 
@@ -120,11 +166,48 @@ public:
   DLL_PUBLIC SOLVER_RETURN_TYPE TopLevelSTP(const ASTNode& inputasserts,
                                             const ASTNode& query);
 
-  // calls sizeReducing and the bitblasting simplification.
-  ASTNode callSizeReducing(ASTNode simplified_solved_InputToSAT,
-                           BVSolver* bvSolver, PropagateEqualities* pe, NodeDomainAnalysis* domain);
+  // As above, also assuming each of the formulas in "assumptions". If the
+  // answer is SOLVER_VALID, "core" holds those of the assumptions that
+  // together with the input were found unsatisfiable, without solving again
+  // for each. It's empty if the input is unsatisfiable on its own.
+  DLL_PUBLIC SOLVER_RETURN_TYPE TopLevelSTP(const ASTNode& inputasserts,
+                                            const ASTNode& query,
+                                            const ASTVec& assumptions,
+                                            ASTVec& core);
+
+  // Marks the substitutions and array reads that rollback() returns to.
+  // Checkpoints nest.
+  void checkpoint()
+  {
+    substitutionMap->checkpoint();
+    arrayTransformer->checkpoint();
+  }
+
+  // Undoes the substitutions and array reads made since the last
+  // checkpoint, and removes it. The simplifier's caches might have used
+  // what was undone, so they're dropped.
+  void rollback()
+  {
+    substitutionMap->rollback();
+    arrayTransformer->rollback();
+    simp->ClearCaches();
+  }
+
+  // Removes the last checkpoint, keeping what was done since.
+  void release()
+  {
+    substitutionMap->release();
+    arrayTransformer->release();
+  }
 
   void ClearAllTables(void)
+  {
+    clearSolverTables();
+    bm->defaultNodeFactory->ClearAllTables();
+  }
+
+private:
+  void clearSolverTables()
   {
     if (simp != NULL)
       simp->ClearAllTables();
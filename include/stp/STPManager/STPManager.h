@@ -32,9 +32,12 @@ THE SOFTWARE.
 
 #include "stp/AST/AST.h"
 #include "stp/NodeFactory/HashingNodeFactory.h"
+#include "stp/STPManager/UniqueTable.h"
 #include "stp/STPManager/UserDefinedFlags.h"
 #include "stp/Sat/SATSolver.h"
 #include "stp/Util/Attributes.h"
+#include "stp/Util/MemoryUsage.h"
+#include <atomic>
 
 namespace stp
 {
@@ -44,26 +47,26 @@ namespace stp
 class STPMgr
 {
   friend class ASTNode;
+  friend class ASTInternal;
   friend class ASTInterior;
   friend class ASTBVConst;
   friend class ASTSymbol;
-  friend ASTNode HashingNodeFactory::CreateNode(const Kind kind,
-                                                const ASTVec& back_children);
+  friend class ::HashingNodeFactory;
 
 private:
   // Typedef for unique Interior node table.
-  typedef std::unordered_set<ASTInterior*, ASTInterior::ASTInteriorHasher,
-                             ASTInterior::ASTInteriorEqual>
+  typedef UniqueTable<ASTInterior, ASTInterior::ASTInteriorHasher,
+                      ASTInterior::ASTInteriorEqual>
       ASTInteriorSet;
 
   // Typedef for unique Symbol node (leaf) table.
-  typedef std::unordered_set<ASTSymbol*, ASTSymbol::ASTSymbolHasher,
-                             ASTSymbol::ASTSymbolEqual>
+  typedef UniqueTable<ASTSymbol, ASTSymbol::ASTSymbolHasher,
+                      ASTSymbol::ASTSymbolEqual>
       ASTSymbolSet;
 
   // Typedef for unique BVConst node (leaf) table.
-  typedef std::unordered_set<ASTBVConst*, ASTBVConst::ASTBVConstHasher,
-                             ASTBVConst::ASTBVConstEqual>
+  typedef UniqueTable<ASTBVConst, ASTBVConst::ASTBVConstHasher,
+                      ASTBVConst::ASTBVConstEqual>
       ASTBVConstSet;
 
   // Unique node tables that enables common subexpression sharing
@@ -75,6 +78,16 @@ private:
   // Table to uniquefy bvconst
   ASTBVConstSet _bvconst_unique_table;
 
+  // Set between beginConcurrent() and endConcurrent().
+  bool concurrent;
+
+  // While concurrent, the node numbers are handed out from here rather than
+  // from each thread's own counter.
+  std::atomic<uint64_t> sharedNodeNum;
+
+  // Guards the fresh variable state while concurrent.
+  std::mutex freshLock;
+
   uint8_t last_iteration;
 
 public:
@@ -86,6 +99,9 @@ public:
 
   bool soft_timeout_expired;
 
+  // What each part of the current query is using, and the budget.
+  MemoryUsage memoryUsage;
+
   // No nodes should already have the iteration number that is returned from
   // here. This never returns zero.
   uint8_t getNextIteration()
@@ -104,24 +120,23 @@ public:
   // Detauls the iteration count back to zero.
   void resetIteration()
   {
-    for (ASTInteriorSet::iterator it = _interior_unique_table.begin();
-         it != _interior_unique_table.end(); it++)
-    {
-      (*it)->iteration = 0;
-    }
+    _interior_unique_table.forEach([](ASTInterior* n) { n->iteration = 0; });
+    _symbol_unique_table.forEach([](ASTSymbol* n) { n->iteration = 0; });
+    _bvconst_unique_table.forEach([](ASTBVConst* n) { n->iteration = 0; });
+  }
 
-    for (ASTSymbolSet::iterator it = _symbol_unique_table.begin();
-         it != _symbol_unique_table.end(); it++)
-    {
-      (*it)->iteration = 0;
-    }
+  // Between these calls any number of threads may create nodes, and copy and
+  // destroy ASTNodes, in this manager. Each thread needs its own node
+  // factories above the hashing one, mustn't use the iteration numbers, and
+  // must call CONSTANTBV::BitVector_Boot() first.
+  // The threads must be started after beginConcurrent() and joined before
+  // endConcurrent(). Nodes that lose their last reference in between are
+  // only deleted by endConcurrent(), so the threads never wait on each other
+  // to free nodes. Not reentrant.
+  void beginConcurrent(unsigned threads);
+  void endConcurrent();
 
-    for (ASTBVConstSet::iterator it = _bvconst_unique_table.begin();
-         it != _bvconst_unique_table.end(); it++)
-    {
-      (*it)->iteration = 0;
-    }
-  }
+  bool isConcurrent() const { return concurrent; }
 
   size_t getAssertLevel() { return _asserts.size(); }
 
@@ -179,6 +194,13 @@ private:
 
   CBV CreateBVConstVal;
 
+  // The bit-vector to build a constant of "width" in, and its release.
+  CBV scratchBitVector(unsigned width);
+  void releaseScratch(CBV bv);
+
+  // Deletes the nodes whose references were all dropped while concurrent.
+  void sweepUnreferenced();
+
 public:
   bool LookupSymbol(const char* const name);
   bool LookupSymbol(const char* const name, ASTNode& output);
@@ -203,7 +225,8 @@ public:
    ****************************************************************/
 
   DLL_PUBLIC STPMgr()
-      : last_iteration(0), soft_timeout_expired(false), _symbol_count(0),
+      : concurrent(false), sharedNodeNum(0), last_iteration(0),
+        soft_timeout_expired(false), _symbol_count(0),
         CNFFileNameCounter(0)
   {
     ValidFlag = false;
@@ -224,6 +247,9 @@ public:
 
   unsigned int NodeSize(const ASTNode& a);
 
+  // Estimate of the bytes used by the unique tables and the nodes in them.
+  DLL_PUBLIC size_t memoryUsed() const;
+
   /****************************************************************
    * Create Symbol and BVConst functions                          *
    ****************************************************************/
@@ -231,6 +257,10 @@ public:
   // Create and return an ASTNode for a symbol
   ASTNode LookupOrCreateSymbol(const char* const name);
 
+  // Also sets the widths of the symbol.
+  ASTNode LookupOrCreateSymbol(const char* const name, unsigned indexWidth,
+                               unsigned valueWidth);
+
   // Create and return an ASTNode for a symbol Width is number of bits.
   ASTNode CreateOneConst(unsigned int width);
   ASTNode CreateTwoConst(unsigned int width);
@@ -382,6 +412,10 @@ public:
   ASTNode CreateFreshVariable(int indexWidth, int valueWidth,
                               std::string prefix)
   {
+    std::unique_lock<std::mutex> guard;
+    if (concurrent)
+      guard = std::unique_lock<std::mutex>(freshLock);
+
     char* d = (char*)alloca(sizeof(char) * (32 + prefix.length()));
     sprintf(d, "%s_%d", prefix.c_str(), _symbol_count++);
     assert(!LookupSymbol(d));
@@ -393,6 +427,10 @@ public:
 
   bool FoundIntroducedSymbolSet(const ASTNode& in)
   {
+    std::unique_lock<std::mutex> guard;
+    if (concurrent)
+      guard = std::unique_lock<std::mutex>(freshLock);
+
     if (Introduced_SymbolsSet.find(in) != Introduced_SymbolsSet.end())
     {
       return true;
@@ -430,15 +468,13 @@ public:
     if (_interior_unique_table.size() > 0)
     {
       std::cerr << "Interiors:" << _interior_unique_table.size() << " of ";
-      std::cerr << sizeof(**_interior_unique_table.begin()) << " bytes each"
+      std::cerr << sizeof(ASTInterior) << " bytes each"
                 << std::endl;
     }
 
     std::map<Kind, int> freq;
-    for (auto it : _interior_unique_table)
-    {
-      freq[it->GetKind()]++;
-    }
+    _interior_unique_table.forEach(
+        [&](ASTInterior* n) { freq[n->GetKind()]++; });
 
     for (auto it : freq)
       std::cerr << it.first << " " << it.second << std::endl;
@@ -446,14 +482,14 @@ public:
     if (_symbol_unique_table.size() > 0)
     {
       std::cerr << "Symbols:" << _symbol_unique_table.size() << " of ";
-      std::cerr << sizeof(**_symbol_unique_table.begin()) << " bytes each"
+      std::cerr << sizeof(ASTSymbol) << " bytes each"
                 << std::endl;
     }
 
     if (_bvconst_unique_table.size() > 0)
     {
       std::cerr << "BVConsts:" << _bvconst_unique_table.size() << " of ";
-      std::cerr << sizeof(**_bvconst_unique_table.begin()) << " bytes each"
+      std::cerr << sizeof(ASTBVConst) << " bytes each"
                 << std::endl;
     }
   }
@@ -463,11 +499,10 @@ public:
      ASTNodeSet symbols;
      symbols.reserve(_symbol_unique_table.size());
 
-     for (const auto& s : _symbol_unique_table)
-      {
+     _symbol_unique_table.forEach([&](ASTSymbol* s) {
           ASTNode n(s);
           symbols.insert(n);
-      }
+     });
 
     return symbols; //hopefully move semantics.
   }
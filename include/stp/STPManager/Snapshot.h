@@ -0,0 +1,82 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * A binary form of formulas, which loads much faster than text parses.
+ *
+ * After the header come four records per node: kind, value width, index
+ * width, and a count. Nodes are numbered children first. A symbol's count
+ * is the length of its name, a constant's is its number of 32-bit words,
+ * and any other node's is its number of children. The children, the
+ * constants' words, the roots and the solver map follow, as node numbers
+ * and words, then the symbol names. Numbers are little-endian and 32 bits
+ * wide, so the file can be mapped into memory and read in one pass, each
+ * node going straight into the unique tables.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "stp/AST/AST.h"
+#include "stp/Util/Attributes.h"
+#include <string>
+
+namespace stp
+{
+class STPMgr;
+
+struct Snapshot
+{
+  ASTVec roots;
+
+  // Substitutions made while simplifying the roots. The roots no longer
+  // mention the symbols that were replaced.
+  ASTNodeMap solverMap;
+};
+
+// Writes "snapshot" to "filename". Returns false if it can't.
+DLL_PUBLIC bool saveSnapshot(const Snapshot& snapshot,
+                             const std::string& filename);
+
+// The bytes that saveSnapshot writes.
+DLL_PUBLIC std::string snapshotBytes(const Snapshot& snapshot);
+
+// Rebuilds the nodes in "data" through the hashing node factory of "bm",
+// so nothing is simplified again. Returns false, with the reason in
+// "error", if "data" isn't a snapshot that this build can read.
+DLL_PUBLIC bool loadSnapshot(STPMgr* bm, const char* data, size_t size,
+                             Snapshot& snapshot, std::string& error);
+
+DLL_PUBLIC bool loadSnapshot(STPMgr* bm, const std::string& filename,
+                             Snapshot& snapshot, std::string& error);
+
+// Whether "filename", or "data", starts like a snapshot.
+DLL_PUBLIC bool isSnapshot(const std::string& filename);
+DLL_PUBLIC bool isSnapshot(const char* data, size_t size);
+
+// The solver map as a conjunction of equalities, for conjoining with the
+// roots when the map itself can't be kept.
+DLL_PUBLIC ASTNode substitutionsAsFormula(STPMgr* bm,
+                                          const ASTNodeMap& solverMap);
+}
+
+#endif
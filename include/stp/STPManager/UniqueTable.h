@@ -0,0 +1,162 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+/*
+ * The hash-consing table for one kind of node. Normally it's a single
+ * unordered_set that is used without locking. While the node manager is in
+ * concurrent mode, the nodes are spread over a number of shards, each with
+ * its own lock, so threads creating different nodes rarely wait on each other.
+ */
+
+#ifndef UNIQUETABLE_H
+#define UNIQUETABLE_H
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace stp
+{
+
+template <class Node, class Hasher, class Equal> class UniqueTable
+{
+  typedef std::unordered_set<Node*, Hasher, Equal> Set;
+
+  struct Shard
+  {
+    Set set;
+    std::mutex lock;
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards;
+
+  // log2 of the number of shards.
+  unsigned bits;
+
+  // The shard is chosen by the top bits of the mixed hash, so that it doesn't
+  // correlate with the bucket chosen inside the shard.
+  Shard& shardFor(const Node* n) const
+  {
+    if (bits == 0)
+      return *shards[0];
+    const uint64_t h = (uint64_t)Hasher()(n) * 0x9E3779B97F4A7C15ULL;
+    return *shards[h >> (64 - bits)];
+  }
+
+  std::unique_lock<std::mutex> lockFor(Shard& s) const
+  {
+    if (bits == 0)
+      return std::unique_lock<std::mutex>();
+    return std::unique_lock<std::mutex>(s.lock);
+  }
+
+public:
+  UniqueTable() : bits(0) { shards.emplace_back(new Shard); }
+
+  UniqueTable(const UniqueTable&) = delete;
+  UniqueTable& operator=(const UniqueTable&) = delete;
+
+  // Returns the node equal to "key" if there is one. Otherwise inserts the
+  // node returned by "create", and returns it.
+  template <class Create> Node* lookupOrCreate(Node* key, Create create)
+  {
+    Shard& s = shardFor(key);
+    std::unique_lock<std::mutex> guard = lockFor(s);
+    typename Set::const_iterator it = s.set.find(key);
+    if (it != s.set.end())
+      return *it;
+    return *s.set.insert(create()).first;
+  }
+
+  // The node equal to "key", or NULL.
+  Node* find(Node* key) const
+  {
+    Shard& s = shardFor(key);
+    std::unique_lock<std::mutex> guard = lockFor(s);
+    typename Set::const_iterator it = s.set.find(key);
+    return it == s.set.end() ? NULL : *it;
+  }
+
+  void erase(Node* n)
+  {
+    Shard& s = shardFor(n);
+    std::unique_lock<std::mutex> guard = lockFor(s);
+    s.set.erase(n);
+  }
+
+  // The following aren't safe while other threads are using the table.
+
+  template <class F> void forEach(F f) const
+  {
+    for (const auto& s : shards)
+      for (Node* n : s->set)
+        f(n);
+  }
+
+  size_t size() const
+  {
+    size_t result = 0;
+    for (const auto& s : shards)
+      result += s->set.size();
+    return result;
+  }
+
+  size_t bucket_count() const
+  {
+    size_t result = 0;
+    for (const auto& s : shards)
+      result += s->set.bucket_count();
+    return result;
+  }
+
+  void clear()
+  {
+    for (const auto& s : shards)
+      s->set.clear();
+  }
+
+  // Redistributes the nodes over 2^"log2" shards.
+  void setShards(unsigned log2)
+  {
+    assert(log2 < 16);
+    if (log2 == bits)
+      return;
+
+    std::vector<std::unique_ptr<Shard>> old;
+    old.swap(shards);
+    bits = log2;
+    for (size_t i = 0; i < ((size_t)1 << bits); i++)
+      shards.emplace_back(new Shard);
+
+    for (const auto& s : old)
+      for (Node* n : s->set)
+        shardFor(n).set.insert(n);
+  }
+};
+
+} // end namespace stp
+
+#endif
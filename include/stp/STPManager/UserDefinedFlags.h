@@ -24,6 +24,8 @@ THE SOFTWARE.
 #ifndef UDEFFLAGS_H
 #define UDEFFLAGS_H
 
+#include <string>
+
 namespace stp
 {
 
@@ -54,6 +56,7 @@ public:
   /* Control simplification */
   bool optimize_flag = true; // the Simplifier functions (which might increase the size).
   bool wordlevel_solve_flag = true;   // turn on word level bitvector solver
+  bool linear_system_solve_flag = true; // solve linear equations together.
   bool propagate_equalities = true; // Remove equalities.
   bool bitConstantProp_flag = true; // Constant bit propagation enabled.
   bool enable_unconstrained = true;
@@ -66,10 +69,28 @@ public:
   bool enable_split_extracts = true;
   bool enable_sharing_aware_rewriting = true;
   bool enable_merge_same = true;
+  bool enable_rewrite_rules = true; // rules in RewriteRules.rules.
 
   int64_t AIG_rewrites_iterations = 0; // Number of iterations of AIG rewrites.
+
+  // The AIG passes of each iteration, comma separated: "rw" rewrites, "rwz"
+  // rewrites with zero-cost replacements and "b" balances.
+  std::string aig_script = "rw";
+  // Stop the AIG passes after this long. -1 means no limit.
+  int64_t aig_time_budget_ms = -1;
+  // Don't run AIG passes on more AND nodes than this. -1 means no limit.
+  int64_t aig_node_limit = -1;
+  // Stop iterating once an iteration removes no more than this percentage
+  // of the nodes.
+  int64_t aig_min_gain_percent = 0;
+  // Bit-blast and convert to CNF the independent parts of the query on this
+  // many threads. 1 converts the query as a whole.
+  int bitblast_threads = 1;
   int64_t bitblast_simplification = 0;
   int64_t size_reducing_fixed_point = 1000000;
+  // Stop each fixed point of the simplification passes after this long. -1
+  // means no limit.
+  int64_t simplification_time_budget_ms = -1;
   
 
   bool simplify_to_constants_only = false;
@@ -84,6 +105,9 @@ public:
   // eagerly write through the array's function congruence axioms.
   bool ackermannisation = false;
 
+  // otherwise, only add the axioms that each model violates.
+  bool array_lemmas_on_demand = true;
+
   // construct the counterexample in terms of original variable based
   // on the counterexample returned by SAT solver
   bool print_counterexample_flag = false;
@@ -117,6 +141,8 @@ public:
   bool division_variant_1 = true;
   bool division_variant_2 = true;
   bool division_variant_3 = true;
+  // Divide with fresh q and r such that x = q*y + r and r < y.
+  bool division_by_multiplication = false;
   bool adder_variant = true;
   bool bbbvle_variant =true;
   bool upper_multiplication_bound = false;
@@ -134,14 +160,40 @@ public:
   bool traditional_cnf = false;
   bool simple_cnf = false; // don't use the good AIG based CNF conversion.
 
+  // Recover XORs from the CNF, for solvers that take them natively.
+  bool native_xor_clauses = false;
+
   bool exit_after_CNF = false;
 
+  // Keep the CNF generator's tables after the first query, for processes
+  // that will solve many.
+  bool keep_cnf_memory = false;
+
+  // Save the simplified formula to this file as a snapshot, if it's set.
+  std::string simplified_snapshot_file;
+
   /* SAT solving options */
 
+  // Look for a model by local search for this long before bit-blasting.
+  // 0 disables it.
+  int64_t local_search_ms = 0;
+
+  // Remember this many models and unsatisfiable inputs, and answer later
+  // queries from them where they can be. 0 disables it.
+  int64_t model_cache_size = 8;
+
   int64_t timeout_max_conflicts = -1;
   int num_solver_threads = 1;
+
+  // Split the query into 2^cube_depth cubes, and solve them on this many
+  // threads. 1 solves the query as a whole.
+  int cube_threads = 1;
+  int cube_depth = 4;
   int64_t timeout_max_time = -1; // seconds
 
+  // Give up on a query, rather than use more than this. -1 means no limit.
+  int64_t memory_budget_mb = -1;
+
   // check the counterexample against the original input to STP
   bool check_counterexample_flag = false;
   //This is derived from other settings.
@@ -176,6 +228,7 @@ public:
     enable_pure_literals = false;
     enable_always_true = false;
     wordlevel_solve_flag = false;
+    linear_system_solve_flag = false;
     propagate_equalities = false;
     enable_flatten = false;
     enable_split_extracts = false;
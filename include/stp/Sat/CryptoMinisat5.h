@@ -56,16 +56,32 @@ public:
 
   virtual void setMaxTime(int64_t max_time); // set max solver time in seconds
 
+  virtual void interrupt();
+
   bool addClause(const vec_literals& ps); // Add a clause to the solver.
 
+  virtual bool addClauses(const int* lits, const int* offsets, size_t n);
+
+  // Turns on Gaussian elimination the first time.
+  virtual bool addXorClause(const std::vector<uint32_t>& vars, bool rhs);
+
+  virtual bool hasNativeXor() const { return true; }
+
   bool okay() const; // FALSE means solver is in a conflicting state
 
   bool solve(bool& timeout_expired); // Search without assumptions.
 
+  virtual bool solveAssuming(bool& timeout_expired,
+                             const vec_literals& assumptions);
+
+  virtual void failedAssumptions(std::vector<uint32_t>& vars) const;
+
   virtual uint8_t modelValue(uint32_t x) const;
 
   virtual uint32_t newVar();
 
+  virtual void newVars(uint32_t n);
+
   void setVerbosity(int v);
 
   unsigned long nVars() const;
@@ -89,6 +105,7 @@ private:
   void* temp_cl;
   int64_t max_confl = 0;
   int64_t max_time = 0; // seconds
+  bool gauss = false;
 };
 }
 
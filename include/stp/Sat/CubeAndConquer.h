@@ -0,0 +1,128 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Splits the search on a few variables, and solves the resulting cubes in
+ * parallel, each on its own instance of a SAT solver. It stops at the first
+ * satisfiable cube, or once every cube is unsatisfiable.
+ *
+ * The clauses are kept here, and each cube's solver is built from them when
+ * the cube is solved. Only the solver that found the model is kept after
+ * solve(). Cubes found to be unsatisfiable stay so as clauses are added, so
+ * they aren't solved again.
+ */
+
+#ifndef CUBEANDCONQUER_H_
+#define CUBEANDCONQUER_H_
+
+#include "stp/Sat/SATSolver.h"
+#include "stp/Util/Attributes.h"
+#include <functional>
+#include <memory>
+
+namespace stp
+{
+
+class DLL_PUBLIC CubeAndConquer : public SATSolver
+{
+public:
+  typedef std::function<SATSolver*()> Factory;
+
+  // Makes 2^depth cubes, and solves up to "threads" of them at once.
+  CubeAndConquer(Factory factory, unsigned threads, unsigned depth);
+
+  ~CubeAndConquer();
+
+  bool addClause(const vec_literals& ps);
+
+  virtual bool addClauses(const int* lits, const int* offsets, size_t n);
+
+  bool okay() const { return ok; }
+
+  bool solve(bool& timeout_expired);
+
+  virtual void setMaxConflicts(int64_t max_confl) { max_conflicts = max_confl; }
+
+  virtual void setMaxTime(int64_t max_t) { max_time = max_t; }
+
+  // Shared between the solvers running at once.
+  virtual void setMaxMemory(int64_t bytes) { max_memory = bytes; }
+
+  virtual size_t memoryUsed() const;
+
+  virtual void setSplitCandidates(const std::vector<uint32_t>& vars)
+  {
+    candidates = vars;
+  }
+
+  virtual void setFrozen(uint32_t var) { frozen.push_back(var); }
+
+  // The model comes from the solver of the satisfiable cube.
+  virtual uint8_t modelValue(uint32_t x) const;
+
+  virtual uint32_t newVar() { return vars++; }
+
+  virtual void newVars(uint32_t n) { vars += n; }
+
+  unsigned long nVars() const { return vars; }
+
+  void printStats() const;
+
+  // The cubes' solvers stay quiet, their output would be interleaved.
+  void setVerbosity(int /*v*/) {}
+
+  virtual int nClauses() { return offsets.size() - 1; }
+
+  virtual lbool true_literal();
+  virtual lbool false_literal();
+  virtual lbool undef_literal();
+
+  // The variables the cubes were split on.
+  const std::vector<uint32_t>& getSplitVariables() const { return split; }
+
+private:
+  Factory factory;
+  const unsigned threads;
+  const unsigned depth;
+
+  // Clause i is lits[offsets[i]] up to lits[offsets[i + 1]].
+  std::vector<int> lits;
+  std::vector<int> offsets;
+  uint32_t vars;
+  bool ok;
+
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> frozen;
+  std::vector<uint32_t> split;
+  std::vector<char> refuted; // per cube, written by the threads.
+
+  std::unique_ptr<SATSolver> model; // of the satisfiable cube.
+  int64_t max_conflicts;
+  int64_t max_time;
+  int64_t max_memory;
+
+  void chooseSplit();
+  SATSolver* build(unsigned cube, int64_t memory);
+};
+}
+
+#endif
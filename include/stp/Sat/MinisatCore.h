@@ -34,6 +34,7 @@ THE SOFTWARE.
 namespace Minisat
 {
 class Solver;
+class SimpSolver;
 }
 
 namespace stp
@@ -47,6 +48,8 @@ namespace stp
 
 {
   Minisat::Solver* s;
+  int64_t conflict_limit; // absolute, -1 for none.
+  int64_t max_memory;     // bytes, -1 for none.
 
 public:
   MinisatCore();
@@ -55,14 +58,44 @@ public:
 
   bool addClause(const vec_literals& ps); // Add a clause to the solver.
 
+  virtual bool addClauses(const int* lits, const int* offsets, size_t n);
+
   bool okay() const; // FALSE means solver is in a conflicting state
 
   bool solve(bool& timeout_expired); // Search without assumptions.
 
+  virtual bool solveAssuming(bool& timeout_expired,
+                             const vec_literals& assumptions);
+
+  virtual void failedAssumptions(std::vector<uint32_t>& vars) const;
+
   bool propagateWithAssumptions(const stp::SATSolver::vec_literals& assumps);
 
   virtual void setMaxConflicts(int64_t max_confl);
 
+  virtual void setMaxMemory(int64_t bytes);
+
+  virtual size_t memoryUsed() const;
+
+  virtual void interrupt();
+
+  // These are shared with SimplifyingMinisat, whose SimpSolver is a Solver.
+  static size_t memoryUsed(const Minisat::Solver& s);
+
+  // Solves with the budgets. Without a memory limit, it's a single call to
+  // the solver. Minisat's solveLimited() isn't virtual, so the SimpSolver
+  // has its own overload to keep its preprocessing.
+  static bool solveWithin(Minisat::Solver& s, int64_t conflict_limit,
+                          int64_t max_memory, bool& timeout_expired,
+                          const vec_literals& assumptions = vec_literals());
+
+  static bool solveWithin(Minisat::SimpSolver& s, int64_t conflict_limit,
+                          int64_t max_memory, bool& timeout_expired,
+                          const vec_literals& assumptions = vec_literals());
+
+  static void failedAssumptions(const Minisat::Solver& s,
+                                std::vector<uint32_t>& vars);
+
   virtual bool simplify(); // Removes already satisfied clauses.
 
   virtual uint8_t modelValue(uint32_t x) const;
@@ -56,6 +56,8 @@ public:
 
   bool addClause(const vec_literals& ps); // Add a clause to the solver.
 
+  virtual bool addClauses(const int* lits, const int* offsets, size_t n);
+
   bool okay() const; // FALSE means solver is in a conflicting state
 
   bool solve(bool& timeout_expired); // Search without assumptions.
@@ -64,6 +66,8 @@ public:
 
   virtual void setMaxConflicts(int64_t max_confl);
 
+  virtual void interrupt();
+
   virtual bool simplify(); // Removes already satisfied clauses.
 
   virtual uint8_t modelValue(uint32_t x) const;
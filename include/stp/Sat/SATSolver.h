@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "minisat/core/SolverTypes.h"
 #include "minisat/mtl/Vec.h"
 #include <iostream>
+#include <vector>
 
 // Don't let the defines escape outside.
 
@@ -51,10 +52,73 @@ public:
   virtual bool addClause(
       const SATSolver::vec_literals& ps) = 0; // Add a clause to the solver.
 
+  // Adds "n" clauses. Clause i is lits[offsets[i]] up to, but not including,
+  // lits[offsets[i + 1]], with the literals encoded as by mkLit. Returns
+  // false once the solver is in a conflicting state.
+  virtual bool addClauses(const int* lits, const int* offsets, size_t n)
+  {
+    vec_literals clause;
+    for (size_t i = 0; i < n; i++)
+    {
+      clause.clear();
+      for (int j = offsets[i]; j < offsets[i + 1]; j++)
+        clause.push(mkLit(lits[j] >> 1, lits[j] & 1));
+      if (!addClause(clause))
+        return false;
+    }
+    return true;
+  }
+
+  // Adds the constraint that the XOR of the variables is "rhs". Solvers
+  // without native XORs get the 2^(n-1) clauses, so keep "vars" short.
+  virtual bool addXorClause(const std::vector<uint32_t>& vars, bool rhs)
+  {
+    const uint32_t n = vars.size();
+    vec_literals clause;
+    for (uint32_t a = 0; a < (1u << n); a++)
+    {
+      // Exclude each assignment of the wrong parity.
+      bool parity = false;
+      clause.clear();
+      for (uint32_t i = 0; i < n; i++)
+      {
+        parity ^= (a >> i) & 1;
+        clause.push(mkLit(vars[i], (a >> i) & 1));
+      }
+      if (parity != rhs && !addClause(clause))
+        return false;
+    }
+    return true;
+  }
+
+  // Whether addXorClause is better than the clauses.
+  virtual bool hasNativeXor() const { return false; }
+
   virtual bool okay() const = 0; // FALSE means solver is in a conflicting state
 
   virtual bool solve(bool& timeout_expired) = 0; // Search without assumptions.
 
+  // Search assuming each of the literals is true. Solvers that can't make
+  // assumptions give up, as if timed out.
+  virtual bool solveAssuming(bool& timeout_expired,
+                             const vec_literals& assumptions)
+  {
+    if (assumptions.size() == 0)
+      return solve(timeout_expired);
+
+    std::cerr << "Warning: Assumptions are not supported by this SAT solver"
+              << std::endl;
+    timeout_expired = true;
+    return false;
+  }
+
+  // After solveAssuming() found the assumptions unsatisfiable, the variables
+  // of those that were refuted together.
+  virtual void failedAssumptions(std::vector<uint32_t>& vars) const
+  {
+    vars.clear();
+  }
+
   typedef uint8_t lbool;
 
   static inline Minisat::Lit mkLit(uint32_t var, bool sign)
@@ -78,10 +142,33 @@ public:
         << std::endl;
   }
 
+  // Give up, as if timed out, once the solver's clauses are estimated to
+  // take more than this many bytes. -1 means no limit. It's set for every
+  // query with a memory budget, so solvers without a limit ignore it quietly.
+  virtual void setMaxMemory(int64_t /*bytes*/) {}
+
+  // Estimate of the bytes taken by the solver's clauses and variables.
+  virtual size_t memoryUsed() const { return 0; }
+
+  // Makes a solve() running on another thread give up soon, as if it had
+  // timed out. Solvers that can't be interrupted finish the search.
+  virtual void interrupt() {}
+
+  // Variables that are good to split the search on, best first. Only
+  // solvers that split the search use them.
+  virtual void setSplitCandidates(const std::vector<uint32_t>& /*vars*/) {}
+
   virtual uint8_t modelValue(uint32_t x) const = 0;
 
   virtual uint32_t newVar() = 0;
 
+  // Adds "n" variables, numbered on from nVars().
+  virtual void newVars(uint32_t n)
+  {
+    for (uint32_t i = 0; i < n; i++)
+      newVar();
+  }
+
   virtual unsigned long nVars() const = 0;
 
   virtual void printStats() const = 0;
@@ -37,6 +37,8 @@ namespace stp
 class SimplifyingMinisat : public SATSolver
 {
   Minisat::SimpSolver* s;
+  int64_t conflict_limit; // absolute, -1 for none.
+  int64_t max_memory;     // bytes, -1 for none.
 
 public:
   SimplifyingMinisat();
@@ -44,14 +46,28 @@ public:
 
   bool addClause(const vec_literals& ps); // Add a clause to the solver.
 
+  virtual bool addClauses(const int* lits, const int* offsets, size_t n);
+
   bool okay() const; // FALSE means solver is in a conflicting state
 
   bool solve(bool& timeout_expired); // Search without assumptions.
 
+  // The assumptions' variables must be frozen.
+  virtual bool solveAssuming(bool& timeout_expired,
+                             const vec_literals& assumptions);
+
+  virtual void failedAssumptions(std::vector<uint32_t>& vars) const;
+
   bool simplify(); // Removes already satisfied clauses.
 
   virtual void setMaxConflicts(int64_t max_confl);
 
+  virtual void setMaxMemory(int64_t bytes);
+
+  virtual size_t memoryUsed() const;
+
+  virtual void interrupt();
+
   void setVerbosity(int v);
 
   virtual uint8_t modelValue(uint32_t x) const;
@@ -0,0 +1,142 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+/*
+ * Which variables in the substitution map depend on which, kept so that
+ * adding a substitution that would make the map loop is cheap to detect.
+ *
+ * Variables are numbered in a topological order: if x depends on y, x comes
+ * before y. Adding an edge that agrees with the order costs nothing. An edge
+ * that doesn't only searches the variables between its two ends, and
+ * reorders those it reaches (Pearce & Kelly's dynamic topological sort).
+ * Variables that are substituted by other variables are merged with them,
+ * so chains of equalities between variables stay one node.
+ *
+ * Changes can be undone back to a checkpoint. While there is one, finds
+ * don't compress paths, so that only the changes themselves are recorded.
+ */
+
+#ifndef DEPENDENCYORDER_H
+#define DEPENDENCYORDER_H
+
+#include "stp/AST/AST.h"
+#include "stp/Util/UndoTrail.h"
+#include <memory>
+#include <vector>
+
+namespace stp
+{
+
+class DependencyOrder
+{
+  typedef std::unordered_map<ASTNode, unsigned, ASTNode::ASTNodeHasher,
+                             ASTNode::ASTNodeEqual>
+      IndexMap;
+  IndexMap index;
+
+  std::vector<unsigned> parent; // union-find over merged variables.
+  std::vector<unsigned> order;
+  std::vector<std::vector<unsigned>> dependsOn;
+  std::vector<std::vector<unsigned>> dependents;
+
+  // Scratch space for the searches.
+  std::vector<char> visited;
+  std::vector<unsigned> forward, backward, stack;
+
+  // Everything, as it was before a clear.
+  struct Saved
+  {
+    IndexMap index;
+    std::vector<unsigned> parent;
+    std::vector<unsigned> order;
+    std::vector<std::vector<unsigned>> dependsOn;
+    std::vector<std::vector<unsigned>> dependents;
+  };
+
+  struct Change
+  {
+    enum Kind
+    {
+      ADDED,  // "node" was given the last number.
+      ORDER,  // order[v] was w.
+      EDGE,   // v came to depend on w.
+      MERGED, // v was merged into w, which had "size" dependents.
+      CLEARED
+    } kind;
+    unsigned v, w;
+    size_t size;
+    ASTNode node;
+    std::vector<unsigned> dependents; // of v, before it was merged.
+    std::unique_ptr<Saved> saved;
+
+    Change(Kind k, unsigned _v = 0, unsigned _w = 0)
+        : kind(k), v(_v), w(_w), size(0)
+    {
+    }
+  };
+
+  UndoTrail<Change> trail;
+
+  void setOrder(unsigned v, unsigned position);
+  void undo(Change& c);
+
+  unsigned find(unsigned v);
+  unsigned lookup(const ASTNode& n);
+  bool reaches(unsigned from, unsigned to);
+  void addEdge(unsigned from, unsigned to);
+  void unvisit(const std::vector<unsigned>& nodes);
+
+public:
+  DependencyOrder() {}
+  DependencyOrder(const DependencyOrder&) = delete;
+  DependencyOrder& operator=(const DependencyOrder&) = delete;
+
+  // Whether anything depends on "var".
+  bool hasDependents(const ASTNode& var);
+
+  // Whether making "var" depend on each of "vars" would create a cycle.
+  bool wouldLoop(const ASTNode& var, const ASTNodeSet& vars);
+  bool wouldLoop(const ASTNode& var, const ASTNode& other);
+
+  // Records that "var" depends on each of "vars". It mustn't loop.
+  void add(const ASTNode& var, const ASTNodeSet& vars);
+
+  // Records that "var" is the variable "other", and merges them.
+  void addEquality(const ASTNode& var, const ASTNode& other);
+
+  size_t size() const { return parent.size(); }
+
+  void clear();
+
+  // Marks the state that rollback() returns to. Checkpoints nest.
+  void checkpoint() { trail.checkpoint(); }
+
+  // Undoes the changes since the last checkpoint, and removes it.
+  void rollback();
+
+  // Removes the last checkpoint, keeping the changes since.
+  void release() { trail.release(); }
+};
+}
+
+#endif
@@ -36,33 +36,25 @@ THE SOFTWARE.
 #define FINDPURELITERALS_H_
 
 #include "stp/AST/AST.h"
+#include "stp/AST/ParentIndex.h"
 #include "stp/STPManager/STPManager.h"
 #include "stp/Simplifier/Simplifier.h"
-#include <map>
 
 namespace stp
 {
-using std::map;
 
 class FindPureLiterals // not copyable
 {
-  typedef char polarity_type;
-  const static polarity_type truePolarity = 1;
-  const static polarity_type falsePolarity = 2;
-  const static polarity_type bothPolarity = 3;
-
-  map<ASTNode, polarity_type> nodeToPolarity;
-
-  int swap(polarity_type polarity);
-
 public:
   FindPureLiterals() {}
   virtual ~FindPureLiterals() {}
 
-  // Build the polarities, then iterate through fixing them.
+  // Find the polarities, then iterate through fixing them.
   bool topLevel(ASTNode& n, Simplifier* simplifier, STPMgr* stpMgr);
 
-  void build(const ASTNode& n, polarity_type polarity);
+  // The same, with the parents of "n" already indexed.
+  bool topLevel(const ParentIndex& index, Simplifier* simplifier,
+                STPMgr* stpMgr);
 };
 }
 #endif /* FINDPURELITERALS_H_ */
@@ -0,0 +1,93 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+/*
+ * Solves the linear equations asserted at the top level together, rather
+ * than one at a time as the BVSolver does.
+ *
+ * The equations of each width (up to 64 bits) whose sides are sums of
+ * constants times symbols are collected into a matrix, which is reduced by
+ * elimination over Z/2^w. Each step pivots on the coefficient with the
+ * fewest trailing zeros, t. Every other coefficient in the remaining rows is
+ * a multiple of 2^t, so the pivot's column can be eliminated from them
+ * exactly. The pivot row then fixes the low w-t bits of its symbol, which is
+ * replaced by a fresh t-bit variable concatenated with them. Rows that
+ * reduce to 0 = c with c non-zero make the problem unsatisfiable.
+ *
+ * The solved symbols are written to the substitution map.
+ */
+
+#ifndef LINEARSYSTEMSOLVER_H
+#define LINEARSYSTEMSOLVER_H
+
+#include "stp/AST/AST.h"
+#include "stp/STPManager/STPManager.h"
+#include "stp/Simplifier/NodeSimplifier.h"
+#include "stp/Simplifier/Simplifier.h"
+
+namespace stp
+{
+
+class LinearSystemSolver : public NodeSimplifier
+{
+  struct Row
+  {
+    std::vector<uint64_t> coefficients; // indexed by column.
+    uint64_t constant;                  // the right hand side.
+  };
+
+  STPMgr* bm;
+  Simplifier* simp;
+  NodeFactory* nf;
+
+  std::vector<ASTNode> columns;
+  std::unordered_map<ASTNode, unsigned, ASTNode::ASTNodeHasher,
+                     ASTNode::ASTNodeEqual>
+      columnOf;
+
+  unsigned solved = 0;
+
+  bool linearise(const ASTNode& term, unsigned width, uint64_t scale,
+                 std::vector<std::pair<ASTNode, uint64_t>>& monomials,
+                 uint64_t& constant) const;
+
+  // Returns false if the system is unsatisfiable. Otherwise writes the
+  // solutions to the substitution map, or to "unsolved" if it rejects them.
+  bool solve(const ASTVec& equations, unsigned width, ASTVec& unsolved);
+
+public:
+  // Systems with more coefficients than this are left to the SAT solver.
+  static const size_t max_cells = 1 << 20;
+
+  LinearSystemSolver(STPMgr* bm_, Simplifier* simp_, NodeFactory* nf_)
+      : bm(bm_), simp(simp_), nf(nf_)
+  {
+  }
+
+  virtual ~LinearSystemSolver() override {}
+
+  virtual ASTNode topLevel(const ASTNode& n) override;
+};
+}
+
+#endif
@@ -0,0 +1,120 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Word-level stochastic local search for a model of a formula.
+ *
+ * The formula's DAG is copied into flat arrays, and each node's value is
+ * kept, up to 64 bits wide. Changing a symbol re-evaluates just the nodes
+ * above it whose inputs changed. Each step picks an unsatisfied conjunct,
+ * tries flipping each bit, incrementing, decrementing and negating the
+ * symbols below it, and, where the conjunct equates a symbol with a term,
+ * setting the symbol to the term's value. The move that most improves the
+ * score is made. The score of a false conjunct grows as its operands get
+ * closer. Without an improving move, a random bit is flipped. Bits that
+ * constant bit propagation fixed are never flipped.
+ *
+ * Formulas with array operations, or wider than 64 bits, aren't searched.
+ */
+
+#ifndef LOCALSEARCH_H_
+#define LOCALSEARCH_H_
+
+#include "stp/AST/AST.h"
+#include "stp/STPManager/STPManager.h"
+#include "stp/Simplifier/constantBitP/NodeToFixedBitsMap.h"
+#include <random>
+
+namespace stp
+{
+
+class LocalSearch
+{
+public:
+  // "fixed" may be NULL.
+  LocalSearch(STPMgr* bm,
+              simplifier::constantBitP::NodeToFixedBitsMap* fixed);
+
+  LocalSearch(const LocalSearch&) = delete;
+  LocalSearch& operator=(const LocalSearch&) = delete;
+
+  // Looks for values of the symbols that make "form" true, for up to
+  // "milliseconds". If it finds them, they're put in "model".
+  bool search(const ASTNode& form, int64_t milliseconds, ASTNodeMap& model);
+
+  uint64_t movesMade() const { return moves; }
+
+private:
+  struct Node
+  {
+    Kind kind;
+    unsigned width;
+    uint64_t mask;
+    uint32_t first; // children are kids[first] up to kids[first + count].
+    uint32_t count;
+  };
+
+  STPMgr* bm;
+  simplifier::constantBitP::NodeToFixedBitsMap* fixed;
+
+  // In topological order, children first.
+  vector<Node> nodes;
+  vector<uint32_t> kids;
+  vector<uint64_t> value;
+  vector<uint32_t> parentsBegin; // parents of i are parents[parentsBegin[i]..]
+  vector<uint32_t> parents;
+
+  vector<uint32_t> vars; // the symbols.
+  vector<ASTNode> symbols;
+  vector<uint64_t> fixedMask; // per symbol.
+  vector<uint64_t> fixedValue;
+  vector<int32_t> varOf; // per node, the symbol's position, or -1.
+
+  vector<uint32_t> roots;
+  vector<int32_t> rootOf; // per node, the conjunct's position, or -1.
+  vector<double> rootScore;
+  vector<vector<uint32_t>> rootVars; // symbols below each conjunct.
+  double total;
+  vector<uint32_t> unsat; // the false conjuncts.
+  vector<int32_t> unsatPosition;
+
+  // Changes made by assign(), so they can be undone.
+  vector<std::pair<uint32_t, uint64_t>> trail;
+  vector<uint32_t> queue; // a heap of nodes to re-evaluate.
+  vector<char> queued;
+
+  std::mt19937_64 rng;
+  uint64_t moves;
+
+  bool build(const ASTNode& form);
+  uint64_t eval(uint32_t n) const;
+  double score(uint32_t root) const;
+  void setScore(uint32_t root);
+  void changed(uint32_t n);
+
+  void assign(uint32_t var, uint64_t v);
+  void undo();
+  const vector<uint32_t>& varsBelow(uint32_t root);
+};
+}
+
+#endif
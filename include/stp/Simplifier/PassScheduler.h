@@ -0,0 +1,112 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+/*
+ * Runs a list of simplification passes over a formula, recording what each
+ * costs (time) and what it achieves (the drop in the DifficultyScore).
+ *
+ * fixedPoint() repeats rounds of the passes until none of them changes the
+ * formula. Within a round the passes that have done the most so far go
+ * first. A pass isn't rerun on a formula it has already left unchanged, and
+ * a pass that keeps changing nothing is rested for exponentially more
+ * rounds. Rested passes are given the final formula before the fixed point
+ * is accepted, so the result is a fixed point of every pass unless the time
+ * budget runs out first.
+ */
+
+#ifndef PASSSCHEDULER_H
+#define PASSSCHEDULER_H
+
+#include "stp/AST/AST.h"
+#include "stp/STPManager/STPManager.h"
+#include "stp/Simplifier/DifficultyScore.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace stp
+{
+
+class PassScheduler // not copyable
+{
+public:
+  typedef std::function<ASTNode(const ASTNode&)> Pass;
+
+  // "budget_ms" limits the time of each fixedPoint(). -1 means no limit.
+  PassScheduler(STPMgr* bm, int64_t budget_ms);
+
+  PassScheduler(const PassScheduler&) = delete;
+  PassScheduler& operator=(const PassScheduler&) = delete;
+
+  // Passes without a history run in the order they were added.
+  void add(const std::string& name, Pass pass);
+
+  // Runs each pass once, in the order they were added.
+  ASTNode once(const ASTNode& input);
+
+  // Runs rounds of the passes until a round changes nothing, the budget
+  // runs out, or "keepGoing" returns false. It is asked before each round.
+  ASTNode fixedPoint(const ASTNode& input,
+                     const std::function<bool()>& keepGoing = nullptr);
+
+  // Whether the last fixedPoint() was stopped by "keepGoing".
+  bool interrupted() const { return stopped; }
+
+  void printStats(std::ostream& os) const;
+
+private:
+  typedef std::chrono::steady_clock clock;
+
+  struct Entry
+  {
+    std::string name;
+    Pass pass;
+
+    unsigned runs = 0;
+    unsigned changes = 0;
+    unsigned skips = 0;
+    clock::duration spent = clock::duration::zero();
+    clock::duration last = clock::duration::zero();
+    long reduction = 0; // in the difficulty score, over all runs.
+
+    unsigned idle = 0; // runs in a row that changed nothing.
+    unsigned rest = 0; // rounds to skip before the next run.
+    ASTNode unchanged; // the last input it left alone.
+  };
+
+  STPMgr* bm;
+  const int64_t budget_ms;
+  std::vector<Entry> passes;
+  DifficultyScore difficulty;
+  bool stopped = false;
+
+  // How much "e" has reduced the difficulty per run, or per second when
+  // there is a budget. Passes that haven't run come first.
+  double rate(const Entry& e) const;
+
+  ASTNode run(Entry& e, const ASTNode& input);
+};
+} // end namespace stp
+
+#endif
@@ -141,6 +141,9 @@ public:
 
   void printCacheStatus();
 
+  // Estimate of the bytes used by the caches that ClearCaches() empties.
+  size_t memoryUsed() const;
+
   bool hasUnappliedSubstitutions()
   {
     return substitutionMap.hasUnappliedSubstitutions();
@@ -27,8 +27,11 @@ THE SOFTWARE.
 
 #include "stp/AST/AST.h"
 #include "stp/STPManager/STPManager.h"
+#include "stp/Simplifier/DependencyOrder.h"
 #include "stp/Simplifier/VariablesInExpression.h"
 #include "stp/Util/Attributes.h"
+#include "stp/Util/UndoTrail.h"
+#include <memory>
 
 namespace stp
 {
@@ -45,25 +48,46 @@ class DLL_PUBLIC SubstitutionMap
   STPMgr* bm;
   ASTNode ASTTrue, ASTFalse, ASTUndefined;
 
-  // These are used to avoid substituting {x = f(y,z), z = f(x)}
-  typedef std::unordered_map<ASTNode, Symbols*, ASTNode::ASTNodeHasher>
-      DependsType;
-  DependsType dependsOn; // The lhs depends on the variables in the rhs.
-  ASTNodeSet rhs;        // All the rhs that have been seeen.
-  std::set<ASTNodeSet*> rhsAlreadyAdded;
-  VariablesInExpression::SymbolPtrSet
-      rhs_visited; // the rhs contains all the variables in here already.
-
-  int loopCount;
+  // Used to avoid substituting {x = f(y,z), z = f(x)}. It's only needed as
+  // long as all the substitutions haven't been written through.
+  DependencyOrder dependsOn;
 
   void buildDepends(const ASTNode& n0, const ASTNode& n1);
-  void loops_helper(const std::set<ASTNode>& varsToCheck,
-                    std::set<ASTNode>& visited);
   bool loops(const ASTNode& n0, const ASTNode& n1);
 
   size_t substitutionsLastApplied;
   VariablesInExpression vars;
 
+  // What to undo to get back to a checkpoint. Only the map and the count of
+  // applied substitutions are recorded; "vars" is a cache of what's in the
+  // nodes, so it's right whatever the map holds.
+  struct Change
+  {
+    ASTNode key;                      // was inserted, if not null.
+    size_t applied;                   // the previous substitutionsLastApplied.
+    std::unique_ptr<ASTNodeMap> saved; // the map, if it was cleared.
+  };
+  UndoTrail<Change> trail;
+
+  void insert(const ASTNode& key, const ASTNode& value)
+  {
+    (*SolverMap)[key] = value;
+    trail.push(Change{key, substitutionsLastApplied, nullptr});
+  }
+
+  void setApplied(size_t applied)
+  {
+    if (applied != substitutionsLastApplied)
+      trail.push(Change{ASTNode(), substitutionsLastApplied, nullptr});
+    substitutionsLastApplied = applied;
+  }
+
+  static ASTNode replace_helper(const ASTNode& n, ASTNodeMap& fromTo,
+                                ASTNodeMap& cache, NodeFactory* nf,
+                                bool stopAtArrays, bool preventInfiniteLoops,
+                                VariablesInExpression* symbols,
+                                uint64_t mapped);
+
 public:
   SubstitutionMap(STPMgr* _bm)
   {
@@ -74,7 +98,6 @@ public:
     ASTUndefined = bm->CreateNode(UNDEFINED);
 
     SolverMap = new ASTNodeMap(INITIAL_TABLE_SIZE);
-    loopCount = 0;
     substitutionsLastApplied = 0;
   }
 
@@ -85,10 +108,33 @@ public:
 
   void clear()
   {
+    if (trail.clearNeedsSaving())
+    {
+      std::unique_ptr<ASTNodeMap> saved(new ASTNodeMap(INITIAL_TABLE_SIZE));
+      saved->swap(*SolverMap);
+      trail.push(Change{ASTNode(), substitutionsLastApplied, std::move(saved)});
+    }
     SolverMap->clear();
     haveAppliedSubstitutionMap();
   }
 
+  // Marks the state that rollback() returns to. Checkpoints nest.
+  void checkpoint()
+  {
+    trail.checkpoint();
+    dependsOn.checkpoint();
+  }
+
+  // Undoes the substitutions made since the last checkpoint, and removes it.
+  void rollback();
+
+  // Removes the last checkpoint, keeping the substitutions made since.
+  void release()
+  {
+    trail.release();
+    dependsOn.release();
+  }
+
   VariablesInExpression& getVariablesInExpression() { return vars; }
 
   bool hasUnappliedSubstitutions()
@@ -101,10 +147,7 @@ public:
   void haveAppliedSubstitutionMap()
   {
     dependsOn.clear();
-    rhs.clear();
-    rhs_visited.clear();
-    rhsAlreadyAdded.clear();
-    substitutionsLastApplied = SolverMap->size();
+    setApplied(SolverMap->size());
   }
 
   // check the solver map for 'key'. If key is present, then return the
@@ -132,7 +175,7 @@ public:
     {
       // cerr << "from" << key << "to" <<value;
       buildDepends(key, value);
-      (*SolverMap)[key] = value;
+      insert(key, value);
       return true;
     }
     return false;
@@ -154,7 +197,7 @@ public:
   {
     assert(e0.GetKind() == SYMBOL);
     assert(!InsideSubstitutionMap(e0) && "e0 MUST NOT be in the SolverMap");
-    (*SolverMap)[e0] = e1;
+    insert(e0, e1);
     return true;
   }
 
@@ -170,11 +213,14 @@ public:
 
   // Replace any nodes in "n" that exist in the fromTo map.
   // NB the fromTo map is changed.
+  // If "symbols" is given, its signatures are used to skip the parts of "n"
+  // that contain none of the symbols in the fromTo map's keys.
   static ASTNode replace(const ASTNode& n, ASTNodeMap& fromTo,
                          ASTNodeMap& cache, NodeFactory* nf);
   static ASTNode replace(const ASTNode& n, ASTNodeMap& fromTo,
                          ASTNodeMap& cache, NodeFactory* nf, bool stopAtArrays,
-                         bool preventInfiniteLoops);
+                         bool preventInfiniteLoops,
+                         VariablesInExpression* symbols = NULL);
 
   ASTNode applySubstitutionMapAtTopLevel(const ASTNode& n)  __attribute__((warn_unused_result));
 };
@@ -40,6 +40,8 @@ private:
   typedef std::unordered_map<int, Symbols*> ASTNodeToNodes;
   ASTNodeToNodes symbol_graph;
 
+  std::unordered_map<unsigned, uint64_t> signatures;
+
 public:
   DLL_PUBLIC VariablesInExpression();
   DLL_PUBLIC virtual ~VariablesInExpression();
@@ -69,6 +71,11 @@ public:
   void VarSeenInTerm(Symbols* term, SymbolPtrSet& visited, ASTNodeSet& found,
                      vector<Symbols*>& av);
 
+  // A Bloom filter of the symbols, arrays included, below "n". Each symbol
+  // sets one of the 64 bits, so if "n" contains "m", n's signature has all
+  // of m's bits.
+  uint64_t signature(const ASTNode& n);
+
   void ClearAllTables();
 };
 }
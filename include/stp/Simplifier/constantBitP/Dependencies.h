@@ -26,6 +26,7 @@ THE SOFTWARE.
 #define DEPENDENCIES_H_
 
 #include "stp/AST/AST.h"
+#include "stp/AST/ParentIndex.h"
 namespace simplifier
 {
 namespace constantBitP
@@ -35,104 +36,46 @@ using std::set;
 using std::cout;
 using std::endl;
 
+using stp::ParentIndex;
+
 // From a child, get the parents of that node.
 class Dependencies
 {
 private:
-  typedef std::unordered_map<stp::ASTNode, set<stp::ASTNode>*,
-                             stp::ASTNode::ASTNodeHasher,
-                             stp::ASTNode::ASTNodeEqual>
-      NodeToDependentNodeMap;
-  NodeToDependentNodeMap dependents;
-
-  const set<ASTNode> empty;
-
-public:
-  // All the nodes that depend on the value of a particular node.
-  void build(const ASTNode& current, const ASTNode& prior)
-  {
-    if (current.isConstant()) // don't care about what depends on constants.
-      return;
-
-    set<ASTNode>* vec;
-    const NodeToDependentNodeMap::iterator it = dependents.find(current);
-    if (dependents.end() == it)
-    {
-      // add it in with a reference to the vector.
-      vec = new set<ASTNode>();
-
-      dependents.insert(std::pair<ASTNode, set<ASTNode>*>(current, vec));
-    }
-    else
-    {
-      vec = it->second;
-    }
-
-    if (prior != current) // initially called with both the same.
-    {
-      if (vec->count(prior) == 0)
-        vec->insert(prior);
-      else
-        return; // already been added in.
-    }
-
-    for (unsigned int i = 0; i < current.GetChildren().size(); i++)
-    {
-      build(current.GetChildren()[i], current);
-    }
-  }
+  ParentIndex index;
 
   Dependencies(const Dependencies&); // Shouldn't needed to copy or assign.
   Dependencies& operator=(const Dependencies&);
 
 public:
-  Dependencies(const ASTNode& top)
-  {
-    build(top, top);
-    checkInvariant();
-  }
+  Dependencies(const ASTNode& top) : index(top) {}
 
-  ~Dependencies()
+  // The "toRemove" node is being removed. Used by unconstrained elimination.
+  void removeNode(const ASTNode& toRemove, ASTVec& variables)
   {
-    NodeToDependentNodeMap::iterator it = dependents.begin();
-    for (/**/; it != dependents.end(); it++)
-    {
-      // set<stp::ASTNode>*
-      delete it->second;
-    }
+    removeNode(index.find(toRemove), variables);
   }
 
-  void replaceFresh(const ASTNode& old, const ASTNode& newN,
-                    set<ASTNode>* newNDepends, ASTVec& variables)
+  void removeNode(ParentIndex::Id toRemove, ASTVec& variables)
   {
-    NodeToDependentNodeMap::const_iterator it = dependents.find(old);
-    if (it == dependents.end())
+    if (toRemove == ParentIndex::none)
       return;
 
-    it->second->erase(old);
-    dependents.insert(make_pair(newN, newNDepends));
-    variables.push_back(newN);
-  }
-
-  // The "toRemove" node is being removed. Used by unconstrained elimination.
-  void removeNode(const ASTNode& toRemove, ASTVec& variables)
-  {
-    for (unsigned i = 0; i < toRemove.GetChildren().size(); i++)
+    const ParentIndex::Id* c = index.childrenBegin(toRemove);
+    for (; c != index.childrenEnd(toRemove); c++)
     {
-      const ASTNode child = toRemove.GetChildren()[i];
-
-      NodeToDependentNodeMap::const_iterator it = dependents.find(child);
-      if (it == dependents.end())
-        continue;
+      if (!index.isParent(toRemove, *c))
+        continue; // a repeated child.
 
-      it->second->erase(toRemove);
-      if (it->second->size() == 0)
+      index.removeParent(*c, toRemove);
+      if (index.uses(*c) == 0)
       {
-        removeNode(child, variables);
+        removeNode(*c, variables);
         continue;
       }
 
-      if (child.GetKind() == stp::SYMBOL && it->second->size() == 1)
+      const ASTNode& child = index.node(*c);
+      if (child.GetKind() == stp::SYMBOL && index.uses(*c) == 1)
       {
         variables.push_back(child);
       }
@@ -141,68 +84,51 @@ public:
 
   void print() const
   {
-    NodeToDependentNodeMap::const_iterator it = dependents.begin();
-    for (/**/; it != dependents.end(); it++)
+    for (ParentIndex::Id i = 0; i < index.size(); i++)
     {
-      cout << (it->first).GetNodeNum();
-
-      const set<ASTNode>* dep = it->second;
-
-      set<ASTNode>::iterator it = dep->begin();
-      while (it != dep->end())
-      {
-        cout << " " << (*it).GetNodeNum();
-        it++;
-      }
+      cout << index.node(i).GetNodeNum();
+      const ParentIndex::Id* p = index.parentsBegin(i);
+      for (; p != index.parentsEnd(i); p++)
+        cout << " " << index.node(*p).GetNodeNum();
       cout << endl;
     }
   }
 
-  void checkInvariant() const
-  {
-    // only one node with a single dependent.
-  }
-
-  const set<ASTNode>* getDependents(const ASTNode n) const
+  // Calls "f" with each node that depends on "n".
+  template <class F> void forEachDependent(const ASTNode& n, F f) const
   {
-    if (n.isConstant())
-      return &empty;
-    const NodeToDependentNodeMap::const_iterator it = dependents.find(n);
-    if (it == dependents.end())
-      return &empty;
+    if (n.isConstant()) // don't care about what depends on constants.
+      return;
+    const ParentIndex::Id i = index.find(n);
+    if (i == ParentIndex::none)
+      return;
 
-    return it->second;
+    const ParentIndex::Id* p = index.parentsBegin(i);
+    for (; p != index.parentsEnd(i); p++)
+      f(index.node(*p));
   }
 
   // The higher node depends on the lower node.
   // The value produces by the lower node is read by the higher node.
   bool nodeDependsOn(const ASTNode& higher, const ASTNode& lower) const
   {
-    const set<ASTNode>* s = getDependents(lower);
-    return s->count(higher) > 0;
+    if (lower.isConstant())
+      return false;
+    const ParentIndex::Id h = index.find(higher);
+    const ParentIndex::Id l = index.find(lower);
+    return h != ParentIndex::none && l != ParentIndex::none &&
+           index.isParent(h, l);
   }
 
-  bool isUnconstrained(const ASTNode& n)
+  bool isUnconstrained(const ASTNode& n) const
   {
     if (n.GetKind() != stp::SYMBOL)
       return false;
 
-    NodeToDependentNodeMap::const_iterator it = dependents.find(n);
-    assert(it != dependents.end());
-    return it->second->size() == 1;
+    const ParentIndex::Id i = index.find(n);
+    assert(i != ParentIndex::none);
+    return index.uses(i) == 1;
   }
-
-#if 0
-      void
-      getAllVariables(ASTVec& v)
-      {
-        for (NodeToDependentNodeMap::const_iterator it = dependents.begin(); it != dependents. end(); it++)
-          {
-            if (it->first.GetKind() == SYMBOL)
-              v.push_back(it->first);
-          }
-      }
-#endif
 };
 }
 }
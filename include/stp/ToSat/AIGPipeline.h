@@ -0,0 +1,81 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Runs a script of the ABC AIG optimisations: rewriting, rewriting with
+ * zero-cost replacements and balancing. The script is repeated until a
+ * round stops paying for itself, or the budgets run out. (Refactoring is
+ * compiled out of the copy of ABC in extlib-abc.)
+ */
+
+#ifndef AIGPIPELINE_H_
+#define AIGPIPELINE_H_
+
+#include "extlib-abc/aig.h"
+#include "stp/STPManager/UserDefinedFlags.h"
+#include <string>
+#include <vector>
+
+namespace stp
+{
+
+class AIGPipeline // not copyable
+{
+public:
+  enum Pass
+  {
+    REWRITE,
+    REWRITE_ZEROS,
+    BALANCE
+  };
+
+  // Reads a comma separated list of "rw", "rwz" and "b".
+  static std::vector<Pass> parse(const std::string& script);
+
+  // Starts the rewriting library, unless this thread already has.
+  static void startLibrary();
+
+  AIGPipeline(const UserDefinedFlags& uf, const std::vector<Pass>& passes,
+              int64_t rounds);
+
+  AIGPipeline(const AIGPipeline&) = delete;
+  AIGPipeline& operator=(const AIGPipeline&) = delete;
+
+  // Replaces "aig" with an optimised copy. The primary inputs and outputs
+  // keep their positions.
+  void run(Aig_Man_t*& aig);
+
+  // How many times the pass has been applied, over all the runs.
+  unsigned getRuns(Pass p) const { return runs[p]; }
+
+private:
+  const UserDefinedFlags& uf;
+  const std::vector<Pass> passes;
+  const int64_t rounds;
+  std::vector<unsigned> runs; // per pass.
+
+  static const char* name(Pass p);
+  void apply(Pass p, Aig_Man_t*& aig);
+};
+}
+
+#endif
@@ -59,6 +59,16 @@ public:
     return aigMgr->nObjs[AIG_OBJ_AND]; // without having removed non-reachable.
   }
 
+  // Estimate of the bytes used by the AIG objects and the structural hash
+  // table.
+  size_t memoryUsed()
+  {
+    if (aigMgr == NULL)
+      return 0;
+    return Aig_ManObjNumMax(aigMgr) * (sizeof(Aig_Obj_t) + sizeof(void*)) +
+           aigMgr->nTableSize * sizeof(Aig_Obj_t*);
+  }
+
 private:
   // AIGs can only take two parameters. This makes a log_2 height
   // tower of varadic inputs.
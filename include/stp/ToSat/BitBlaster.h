@@ -96,6 +96,16 @@ template <class BBNode, class BBNodeManagerT> class BitBlaster // not copyable
   vector<BBNode> mult_normal(const vector<BBNode>& x, const vector<BBNode>& y,
                              set<BBNode>& support, const ASTNode& n);
 
+  // With multiplication variant 0, the encoding is chosen for each
+  // multiplication from what is known about it when it's bit-blasted.
+  int chooseMultiplicationVariant(vector<BBNode>& x, vector<BBNode>& y,
+                                  const ASTNode& n);
+
+  // How many of the low bits of each multiplication are read, when it's fewer
+  // than all of them. Only used to pick an encoding.
+  std::map<ASTNode, unsigned> multiplicationDemand;
+  void findMultiplicationDemand(const ASTNode& form);
+
   vector<BBNode> batcher(const vector<BBNode>& in);
   vector<BBNode> mergeSorted(const vector<BBNode>& in1,
                              const vector<BBNode>& in2);
@@ -172,6 +182,20 @@ template <class BBNode, class BBNodeManagerT> class BitBlaster // not copyable
                 vector<BBNode>& q, vector<BBNode>& r, unsigned int rwidth,
                 set<BBNode>& support);
 
+  // The quotient and remainder of dividing one term by another. x / y and
+  // x % y, and the signed operations that are translated into them, share a
+  // single divider.
+  const std::pair<vector<BBNode>, vector<BBNode>>&
+  BBQuotientRemainder(const ASTNode& dividend, const ASTNode& divisor,
+                      set<BBNode>& support);
+  std::map<std::pair<ASTNode, ASTNode>,
+           std::pair<vector<BBNode>, vector<BBNode>>>
+      BBDivModMemo;
+
+  void BBDivModByMult(const ASTNode& dividend, const ASTNode& divisor,
+                      vector<BBNode>& q, vector<BBNode>& r,
+                      set<BBNode>& support);
+
   // Return formula for majority function of three formulas.
   BBNode Majority(const BBNode& a, const BBNode& b, const BBNode& c);
 
@@ -247,6 +271,8 @@ public:
   {
     BBTermMemo.clear();
     BBFormMemo.clear();
+    BBDivModMemo.clear();
+    multiplicationDemand.clear();
   }
 
   ~BitBlaster() { ClearAllTables(); }
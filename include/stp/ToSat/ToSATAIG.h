@@ -57,8 +57,20 @@ private:
   // from being removed.
   void mark_variables_as_frozen(SATSolver& satSolver);
 
+  // SAT variables to split the search on, best first: the high bits of the
+  // array indexes, then the boolean symbols that are ITE conditions.
+  vector<uint32_t> splitCandidates(const ASTNode& input);
+
   bool runSolver(SATSolver& satSolver);
   void handle_cnf_options(Cnf_Dat_t* cnfData, bool needAbsRef);
+
+  // Whether bit-blasting can be split between threads with these flags.
+  bool canBitblastInParallel() const;
+
+  // Bit-blasts and converts to CNF each group of conjuncts on its own
+  // thread, then renumbers the variables of their CNFs into one.
+  Cnf_Dat_t* bitblastInParallel(const vector<ASTVec>& groups,
+                                bool needAbsRef);
  
   int count;
   bool first;
@@ -78,8 +90,19 @@ public:
   Cnf_Dat_t* bitblast(const ASTNode& input, bool needAbsRef);
   void release_cnf_memory(Cnf_Dat_t* cnfData);
 
+  // Splits the conjuncts of "input" into at most "count" groups of about the
+  // same size. Conjuncts that share a term, other than a symbol or a
+  // constant, go in the same group, so no term is bit-blasted twice.
+  static vector<ASTVec> partition(const ASTNode& input, unsigned count);
+
   bool cbIsDestructed() { return cb == NULL; }
 
+  // Boolean symbols that the SAT solver assumes are true. Those that aren't
+  // in the CNF don't matter to it, so aren't assumed. After the solver finds
+  // the input unsatisfiable, "failed" holds those that it refuted together.
+  ASTVec assumptions;
+  ASTVec failed;
+
   ToSATAIG(STPMgr* bm, ArrayTransformer* at)
       : ToSATBase(bm), toCNF(bm->UserFlags)
   {
@@ -0,0 +1,72 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#ifndef XORFINDER_H_
+#define XORFINDER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace stp
+{
+
+/*
+ * Recovers XOR constraints from the clauses that encode them. The AIG has
+ * only AND gates, so the CNF generator encodes each XOR it finds in a cut as
+ * the 2^(k-1) clauses over the k variables that exclude the assignments of
+ * the wrong parity. Solvers with Gaussian elimination do better with the
+ * XOR itself.
+ *
+ * The clauses are in ABC's layout: clause i is the literals from clauses[i]
+ * up to clauses[i + 1], each literal being 2 * variable + negated.
+ */
+class XorFinder // not copyable
+{
+public:
+  struct Xor
+  {
+    std::vector<uint32_t> vars; // increasing.
+    bool rhs;                   // the XOR of the variables.
+  };
+
+  // Only XORs of this many variables or fewer are looked for. The CNF
+  // generator's cuts have at most four inputs, plus the output.
+  static const unsigned max_size = 5;
+
+  XorFinder(int** clauses, int count);
+
+  const std::vector<Xor>& getXors() const { return xors; }
+
+  // Whether clause i is implied by one of the XORs.
+  bool isCovered(int i) const { return covered[i]; }
+
+private:
+  std::vector<Xor> xors;
+  std::vector<bool> covered;
+
+  XorFinder(const XorFinder&) = delete;
+  XorFinder& operator=(const XorFinder&) = delete;
+};
+
+} // end namespace stp
+
+#endif
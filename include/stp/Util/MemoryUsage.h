@@ -0,0 +1,88 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include "stp/Util/Attributes.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace stp
+{
+
+// Estimates of the memory used by each part of the solving pipeline, and the
+// budget that they share. The estimates are refreshed at checkpoints, rather
+// than on each allocation, so they lag a little.
+class MemoryUsage // not copyable
+{
+public:
+  enum Subsystem
+  {
+    NodeTables = 0,
+    SimplifierCaches,
+    AIG,
+    CNF,
+    ClauseDatabase,
+    NumberOfSubsystems
+  };
+
+private:
+  size_t current[NumberOfSubsystems];
+  size_t peak[NumberOfSubsystems];
+  int64_t limit; // bytes, -1 for no limit.
+
+  MemoryUsage(const MemoryUsage&);
+  MemoryUsage& operator=(const MemoryUsage&);
+
+public:
+  MemoryUsage() : limit(-1) { reset(); }
+
+  void setLimit(int64_t bytes) { limit = bytes; }
+  bool hasLimit() const { return limit >= 0; }
+
+  DLL_PUBLIC void reset();
+
+  DLL_PUBLIC void record(Subsystem s, size_t bytes);
+
+  size_t get(Subsystem s) const { return current[s]; }
+
+  DLL_PUBLIC size_t total() const;
+
+  // Past half the budget. Caches should be dropped, and optional passes
+  // skipped.
+  bool tight() const { return hasLimit() && total() > (size_t)limit / 2; }
+
+  // Past the budget. The query should be given up on.
+  bool exceeded() const { return hasLimit() && total() > (size_t)limit; }
+
+  // The bytes left for "s" once the others are accounted for, or -1 if
+  // there's no limit.
+  DLL_PUBLIC int64_t remaining(Subsystem s) const;
+
+  DLL_PUBLIC void print(std::ostream& os) const;
+};
+
+} // end namespace stp
+
+#endif
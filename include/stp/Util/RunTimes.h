@@ -64,7 +64,8 @@ public:
     StrengthReduction,
     SplitExtracts,
     Rewriting,
-    MergeSame
+    MergeSame,
+    LocalSearch
   };
 
   std::vector<std::string> CategoryNames = {"Transforming",
@@ -92,7 +93,8 @@ public:
                                             "Strength Reduction",
                                             "Spliting Extracts",
                                             "Sharing-aware rewriting",
-                                            "Merge Same"
+                                            "Merge Same",
+                                            "Local Search"
                                           };
 
 
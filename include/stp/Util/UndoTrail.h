@@ -0,0 +1,111 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+#ifndef UNDOTRAIL_H
+#define UNDOTRAIL_H
+
+#include <cstddef>
+#include <vector>
+
+namespace stp
+{
+
+// The changes made to a structure since its checkpoints, so that it can be
+// rolled back to the last of them in time proportional to the changes.
+// Nothing is recorded while there are no checkpoints.
+//
+// A structure being cleared saves its whole state as one entry, by moving
+// it. Once that has happened, later clears before the next checkpoint
+// needn't save anything: the entries after the saved state are dropped.
+template <typename Entry> class UndoTrail // not copyable
+{
+  static const size_t none = ~(size_t)0;
+
+  struct Level
+  {
+    size_t start;   // the first entry after the checkpoint.
+    size_t cleared; // the entry saving a clear since then, or none.
+  };
+
+  std::vector<Entry> entries;
+  std::vector<Level> levels;
+
+public:
+  UndoTrail() {}
+  UndoTrail(const UndoTrail&) = delete;
+  UndoTrail& operator=(const UndoTrail&) = delete;
+
+  bool recording() const { return !levels.empty(); }
+  size_t checkpoints() const { return levels.size(); }
+
+  void push(Entry e)
+  {
+    if (recording())
+      entries.push_back(std::move(e));
+  }
+
+  void checkpoint() { levels.push_back(Level{entries.size(), none}); }
+
+  // Calls "undo" on the entries since the last checkpoint, newest first,
+  // and removes the checkpoint.
+  template <typename Undo> void rollback(Undo undo)
+  {
+    const size_t start = levels.back().start;
+    levels.pop_back();
+    for (size_t i = entries.size(); i-- > start;)
+      undo(entries[i]);
+    entries.erase(entries.begin() + start, entries.end());
+  }
+
+  // Removes the last checkpoint, keeping the state. Its changes are
+  // undone with the checkpoint before, if there is one.
+  void release()
+  {
+    const Level inner = levels.back();
+    levels.pop_back();
+    if (levels.empty())
+      entries.clear();
+    else if (levels.back().cleared == none)
+      levels.back().cleared = inner.cleared;
+  }
+
+  // Whether a clear should push an entry saving the state being cleared.
+  bool clearNeedsSaving()
+  {
+    if (!recording())
+      return false;
+
+    Level& level = levels.back();
+    if (level.cleared != none)
+    {
+      entries.erase(entries.begin() + level.cleared + 1, entries.end());
+      return false;
+    }
+
+    level.cleared = entries.size();
+    return true;
+  }
+};
+} // end namespace stp
+
+#endif
@@ -36,6 +36,8 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /////////////////////////////////////////////////////////////////////////////
 /// STP API INTERNAL MACROS FOR LINKING
@@ -371,6 +373,22 @@ DLL_PUBLIC Expr vc_writeExpr(VC vc, Expr array, Expr index, Expr newValue);
 //!
 DLL_PUBLIC Expr vc_parseExpr(VC vc, const char* filepath);
 
+//! \brief Saves the given boolean expression to the file of the given
+//!        filepath in STP's binary snapshot format.
+//!
+//! Returns 1 on success and 0 if the file can't be written.
+//!
+DLL_PUBLIC int vc_saveSnapshot(VC vc, const char* filepath, Expr e);
+
+//! \brief Reads a snapshot from the file of the given filepath, and returns
+//!        it as a boolean expression, or NULL if it can't be read.
+//!
+//! Snapshots are written by vc_saveSnapshot and by the stp binary, and load
+//! much faster than vc_parseExpr reads text. Like vc_parseExpr, a snapshot
+//! holding asserts and a query gives the asserts and the negated query.
+//!
+DLL_PUBLIC Expr vc_loadSnapshot(VC vc, const char* filepath);
+
 //! \brief Prints the given expression to stdout in the presentation language.
 //!
 DLL_PUBLIC void vc_printExpr(VC vc, Expr e);
@@ -488,6 +506,17 @@ DLL_PUBLIC Expr vc_simplify(VC vc, Expr e);
 //!
 DLL_PUBLIC int vc_query_with_timeout(VC vc, Expr e, int timeout_max_conflicts, int timeout_max_time);
 
+//! \brief Sets the memory budget, in megabytes, for each following query.
+//!
+//! Near the budget STP drops caches and skips optional simplifications. Over
+//! it, the query is abandoned and reported as a timeout. The usage is an
+//! estimate, covering the node tables, the simplifier caches, the AIGs, the
+//! CNF and the SAT solver's clause database. -1 means no budget.
+//!
+//! Note: Only the minisat solvers limit the memory used during SAT solving.
+//!
+DLL_PUBLIC void vc_setMemoryBudget(VC vc, int64_t megabytes);
+
 //! \brief Checks the validity of the given expression 'e' in the given context
 //!        with an unlimited timeout.
 //!
@@ -513,6 +542,39 @@ DLL_PUBLIC Expr vc_getCounterExample(VC vc, Expr e);
 DLL_PUBLIC void vc_getCounterExampleArray(VC vc, Expr e, Expr** outIndices,
                                           Expr** outValues, int* outSize);
 
+//! \brief Writes the values of the expressions 'exprs' in the counter example
+//!        after an invalid query to the caller's buffer 'words'.
+//!
+//! Each bitvector value takes (width + 63) / 64 words, least significant word
+//! first. Each boolean value takes one word, holding 0 or 1. The values are
+//! written one after another, in the order of 'exprs'. No expressions are
+//! allocated, so this is much cheaper than calling 'vc_getCounterExample' for
+//! each of many symbols.
+//!
+//! Returns the number of words needed. Nothing is written if that is more
+//! than 'capacity'.
+//!
+DLL_PUBLIC size_t vc_getCounterExampleWords(VC vc, const Expr* exprs,
+                                            int count, uint64_t* words,
+                                            size_t capacity);
+
+//! \brief Writes the (index, value) pairs of the array symbols 'arrays' in
+//!        the counter example after an invalid query to the caller's buffer
+//!        'words'.
+//!
+//! Indexes and values are laid out as by 'vc_getCounterExampleWords', each
+//! index followed by its value, and the pairs of 'arrays[0]' first. The
+//! number of pairs for 'arrays[i]' is written to 'outSizes[i]', which must
+//! have room for 'count' entries.
+//!
+//! Returns the number of words needed. Nothing is written to 'words' if that
+//! is more than 'capacity', but 'outSizes' is filled in regardless.
+//!
+DLL_PUBLIC size_t vc_getCounterExampleArrayWords(VC vc, const Expr* arrays,
+                                                 int count, uint64_t* words,
+                                                 size_t capacity,
+                                                 int* outSizes);
+
 //! \brief Returns the size of the counter example array,
 //!        i.e. the number of variable and array locations
 //!        in the counter example.
@@ -97,9 +97,14 @@ class Cpp_interface
     // Obtain the symbols for the current frame
     ASTVec& getSymbols();
 
+    // The names of the frame's named assertions, which are assumed rather
+    // than asserted when unsat cores are produced.
+    ASTVec& getNamedAssertions();
+
   private:
     vector<std::string> _scoped_functions;
     ASTVec _scoped_symbols;
+    ASTVec _named_assertions;
     std::unordered_map<std::string, Function>* _global_function_context;
   };
 
@@ -117,6 +122,18 @@ class Cpp_interface
 
   bool produce_models;
   bool changed_model_status;
+  bool produce_unsat_cores;
+
+  // The formula most recently given a name, and its name.
+  ASTNode lastNamed, lastName;
+
+  // What the last check-sat found unsatisfiable. Valid if it was unsat.
+  bool haveUnsatCore;
+  ASTVec unsatCore;        // of names.
+  ASTVec unsatAssumptions; // of check-sat-assuming literals.
+
+  // Prints the answer, and the model if that was asked for.
+  void printCheckSat(SOLVER_RETURN_TYPE result);
 
 public:
   std::unique_ptr<LETMgr> letMgr;
@@ -134,6 +151,14 @@ public:
   DLL_PUBLIC UserDefinedFlags& getUserFlags();
 
   DLL_PUBLIC void AddAssert(const ASTNode& assert);
+
+  // Records that "formula" is named "name", so that asserting it can be
+  // tracked for unsat cores.
+  DLL_PUBLIC void nameFormula(const ASTNode& name, const ASTNode& formula);
+
+  // An assert command. If unsat cores are produced and the formula is named,
+  // its name is assumed by each check-sat rather than it being asserted.
+  DLL_PUBLIC void AddTopLevelAssert(const ASTNode& assert);
   DLL_PUBLIC void SetQuery(const ASTNode& q);
 
   // NODES//
@@ -211,6 +236,14 @@ public:
   DLL_PUBLIC void printStatus();
   DLL_PUBLIC void checkSat(const ASTVec& assertionsSMT2);
 
+  // Checks the assertions, assuming each of the literals in "assumptions"
+  // and the named assertions. Doesn't use the cache of prior results.
+  DLL_PUBLIC void checkSatAssuming(const ASTVec& assertionsSMT2,
+                                   const ASTVec& assumptions);
+
+  DLL_PUBLIC void getUnsatCore();
+  DLL_PUBLIC void getUnsatAssumptions();
+
   DLL_PUBLIC void deleteGlobal();
   DLL_PUBLIC void cleanUp();
 
@@ -64,6 +64,35 @@ THREAD_LOCAL int ASTNode::destroy = 0;
 THREAD_LOCAL int ASTNode::assign_move = 0;
 #endif
 
+// Outside of concurrent mode the counts are only touched by one thread, so
+// they're updated with plain loads and stores.
+inline void ASTInternal::IncRef()
+{
+  if (nodeManager->isConcurrent())
+    _ref_count.fetch_add(1, std::memory_order_relaxed);
+  else
+    _ref_count.store(_ref_count.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+}
+
+inline void ASTInternal::DecRef()
+{
+  if (nodeManager->isConcurrent())
+  {
+    // Nodes that drop to zero are deleted by STPMgr::endConcurrent().
+    _ref_count.fetch_sub(1, std::memory_order_relaxed);
+    return;
+  }
+
+  const uint32_t count = _ref_count.load(std::memory_order_relaxed) - 1;
+  _ref_count.store(count, std::memory_order_relaxed);
+  if (count == 0)
+  {
+    // Delete node from unique table and kill it.
+    CleanUp();
+  }
+}
+
 //Maintain _ref_count
 ASTNode::ASTNode(const ASTNode& n) : _int_node_ptr(n._int_node_ptr)
 {
@@ -41,6 +41,13 @@ using std::endl;
 
 THREAD_LOCAL uint64_t ASTInternal::node_uid_cntr = 0;
 
+uint64_t ASTInternal::newNodeNum(STPMgr* mgr)
+{
+  if (mgr != NULL && mgr->isConcurrent())
+    return mgr->sharedNodeNum.fetch_add(2, std::memory_order_relaxed) + 2;
+  return node_uid_cntr += 2;
+}
+
 /****************************************************************
  * Universal Helper Functions                                   *
  ****************************************************************/
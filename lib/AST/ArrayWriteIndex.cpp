@@ -0,0 +1,170 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/AST/ArrayWriteIndex.h"
+#include <algorithm>
+
+namespace stp
+{
+
+namespace
+{
+// The writes of "outer" followed by those of "inner".
+std::shared_ptr<const ArrayWriteIndex::Segment>
+merge(const ArrayWriteIndex::Segment& outer,
+      const ArrayWriteIndex::Segment& inner)
+{
+  const uint32_t offset = outer.writes.size();
+  std::shared_ptr<ArrayWriteIndex::Segment> result =
+      std::make_shared<ArrayWriteIndex::Segment>();
+
+  result->writes.reserve(outer.writes.size() + inner.writes.size());
+  result->writes.insert(result->writes.end(), outer.writes.begin(),
+                        outer.writes.end());
+  result->writes.insert(result->writes.end(), inner.writes.begin(),
+                        inner.writes.end());
+
+  // The outer write to a given index hides the inner ones.
+  result->constant = outer.constant;
+  for (const auto& c : inner.constant)
+    result->constant.insert(std::make_pair(c.first, c.second + offset));
+
+  result->symbolic = outer.symbolic;
+  for (uint32_t p : inner.symbolic)
+    result->symbolic.push_back(p + offset);
+
+  return result;
+}
+} // namespace
+
+const ArrayWriteIndex::Chain& ArrayWriteIndex::extend(const ASTNode& write,
+                                                      const Chain* below)
+{
+  assert(write.GetKind() == WRITE);
+
+  std::shared_ptr<Segment> segment = std::make_shared<Segment>();
+  segment->writes.push_back(write);
+  if (write[1].GetKind() == BVCONST)
+    segment->constant.insert(std::make_pair(write[1], 0));
+  else
+    segment->symbolic.push_back(0);
+
+  Chain chain;
+  chain.segments.push_back(segment);
+  if (below != NULL)
+  {
+    assert(write[0] == below->segments[0]->writes[0]);
+    chain.segments.insert(chain.segments.end(), below->segments.begin(),
+                          below->segments.end());
+    chain.base = below->base;
+    chain.length = below->length + 1;
+  }
+  else
+  {
+    chain.base = write[0];
+    chain.length = 1;
+  }
+
+  while (chain.segments.size() > 1 &&
+         chain.segments[0]->writes.size() == chain.segments[1]->writes.size())
+  {
+    chain.segments[1] = merge(*chain.segments[0], *chain.segments[1]);
+    chain.segments.erase(chain.segments.begin());
+  }
+
+  // References to the elements of an unordered_map survive rehashing.
+  return chains.insert(std::make_pair(write, chain)).first->second;
+}
+
+const ArrayWriteIndex::Chain* ArrayWriteIndex::get(const ASTNode& write)
+{
+  assert(write.GetKind() == WRITE);
+
+  // Walk down to a write that's already indexed, or to the base array.
+  ASTVec unindexed;
+  const Chain* below = NULL;
+  ASTNode n = write;
+  while (n.GetKind() == WRITE)
+  {
+    auto it = chains.find(n);
+    if (it != chains.end())
+    {
+      below = &it->second;
+      break;
+    }
+    unindexed.push_back(n);
+    n = n[0];
+  }
+
+  if (below == NULL && unindexed.size() < min_length)
+    return NULL;
+
+  for (size_t i = unindexed.size(); i > 0; i--)
+    below = &extend(unindexed[i - 1], below);
+
+  return below;
+}
+
+uint32_t ArrayWriteIndex::next(const Chain& chain, const ASTNode& index,
+                               uint32_t from)
+{
+  assert(index.GetKind() == BVCONST);
+
+  uint32_t offset = 0;
+  for (const auto& s : chain.segments)
+  {
+    const uint32_t size = s->writes.size();
+    if (from < offset + size)
+    {
+      const uint32_t local = (from > offset) ? from - offset : 0;
+      uint32_t best = size;
+
+      auto c = s->constant.find(index);
+      if (c != s->constant.end() && c->second >= local)
+        best = c->second;
+
+      auto it = std::lower_bound(s->symbolic.begin(), s->symbolic.end(), local);
+      if (it != s->symbolic.end() && *it < best)
+        best = *it;
+
+      if (best < size)
+        return offset + best;
+    }
+    offset += size;
+  }
+  return chain.length;
+}
+
+const ASTNode& ArrayWriteIndex::write(const Chain& chain, uint32_t position)
+{
+  assert(position < chain.length);
+  for (const auto& s : chain.segments)
+  {
+    if (position < s->writes.size())
+      return s->writes[position];
+    position -= s->writes.size();
+  }
+  FatalError("ArrayWriteIndex: position is past the end of the chain");
+  return chain.base;
+}
+
+} // end namespace stp
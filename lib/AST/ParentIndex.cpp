@@ -0,0 +1,134 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+#include "stp/AST/ParentIndex.h"
+
+namespace stp
+{
+
+const ParentIndex::Id ParentIndex::none;
+
+ParentIndex::ParentIndex(const ASTNode& top)
+{
+  // Number the nodes children first, without recursing.
+  std::vector<std::pair<ASTNode, size_t>> stack;
+  stack.push_back(std::make_pair(top, 0));
+  ids.insert(std::make_pair(top.GetNodeNum(), none));
+  while (!stack.empty())
+  {
+    const ASTNode n = stack.back().first;
+    const size_t i = stack.back().second;
+    if (i < n.Degree())
+    {
+      stack.back().second++;
+      const ASTNode& child = n[i];
+      if (ids.insert(std::make_pair(child.GetNodeNum(), none)).second)
+        stack.push_back(std::make_pair(child, 0));
+      continue;
+    }
+
+    ids[n.GetNodeNum()] = nodes.size();
+    kidsBegin.push_back(kids.size());
+    for (const ASTNode& child : n.GetChildren())
+      kids.push_back(ids.find(child.GetNodeNum())->second);
+    nodes.push_back(n);
+    stack.pop_back();
+  }
+  kidsBegin.push_back(kids.size());
+
+  // Count the distinct parents. A parent's children are visited together,
+  // so remembering the last parent counted is enough to skip repeats.
+  const size_t count = nodes.size();
+  std::vector<Id> last(count, none);
+  parentBegin.assign(count + 1, 0);
+  for (Id i = 0; i < count; i++)
+    for (const Id* c = childrenBegin(i); c != childrenEnd(i); c++)
+      if (last[*c] != i)
+      {
+        last[*c] = i;
+        parentBegin[*c + 1]++;
+      }
+  for (size_t i = 0; i < count; i++)
+    parentBegin[i + 1] += parentBegin[i];
+
+  parents.resize(parentBegin[count]);
+  live.assign(count, 0);
+  last.assign(count, none);
+  for (Id i = 0; i < count; i++)
+    for (const Id* c = childrenBegin(i); c != childrenEnd(i); c++)
+      if (last[*c] != i)
+      {
+        last[*c] = i;
+        parents[parentBegin[*c] + live[*c]++] = i;
+      }
+
+  // Parents are numbered after their children, so going down the numbers
+  // sees every parent of a node before the node.
+  polarities.assign(count, 0);
+  polarities[root()] = truePolarity;
+  for (Id i = root() + 1; i-- > 0;)
+  {
+    const Polarity p = polarities[i];
+    const Kind k = nodes[i].GetKind();
+    const Id* c = childrenBegin(i);
+    for (size_t j = 0; c + j != childrenEnd(i); j++)
+    {
+      Polarity& child = polarities[c[j]];
+      if (k == AND || k == OR || (k == ITE && j > 0))
+        child |= p;
+      else if (k == NOT)
+        child |= (p == bothPolarity) ? p : (p ^ bothPolarity);
+      else
+        child = bothPolarity;
+    }
+  }
+}
+
+ParentIndex::Id ParentIndex::find(const ASTNode& n) const
+{
+  std::unordered_map<unsigned, Id>::const_iterator it =
+      ids.find(n.GetNodeNum());
+  return it == ids.end() ? none : it->second;
+}
+
+bool ParentIndex::isParent(Id parent, Id child) const
+{
+  for (const Id* p = parentsBegin(child); p != parentsEnd(child); p++)
+    if (*p == parent)
+      return true;
+  return false;
+}
+
+void ParentIndex::removeParent(Id child, Id parent)
+{
+  Id* begin = parents.data() + parentBegin[child];
+  for (Id* p = begin; p != begin + live[child]; p++)
+    if (*p == parent)
+    {
+      std::swap(*p, begin[live[child] - 1]);
+      live[child]--;
+      return;
+    }
+}
+
+} // end namespace stp
@@ -27,11 +27,13 @@ THE SOFTWARE.
 #include "stp/STPManager/STPManager.h"
 #include <cassert>
 #include <math.h>
+#include <unordered_map>
 
 namespace stp
 {
 using std::pair;
 using std::map;
+using std::make_pair;
 
 /******************************************************************
  * Abstraction Refinement related functions
@@ -448,6 +450,142 @@ AbsRefine_CounterExample::SATBased_ArrayReadRefinement(
   return SOLVER_UNDECIDED;
 }
 
+/******************************************************************
+ * LEMMAS ON DEMAND
+ *
+ * LemmaOnDemand_ArrayRefinement()
+ *
+ * Each round, the reads of every array are bucketed by the value that
+ * their index takes in the current model. Two reads in the same bucket
+ * with different values violate the read-over-read axiom, so only those
+ * axioms are added, then the solver is called again. The solver isn't
+ * rebuilt between rounds, and the literal for each pair of index symbols
+ * is created at most once, however many arrays or rounds use it.
+ *
+ * Checking a model is linear in the number of reads, rather than
+ * quadratic, which matters when there are thousands of reads per array.
+ *****************************************************************/
+
+typedef std::map<std::pair<ASTNode, ASTNode>, Minisat::Var> IndexEqualsMap;
+
+// Adds: (index0 = index1) -> (value0 = value1).
+void applyLemmaToSAT(SATSolver& SatSolver, const AxiomToBe& toBe,
+                     ToSATBase::ASTNodeToSATVar& satVar,
+                     IndexEqualsMap& indexEquals)
+{
+  assert(!toBe.index0.isConstant() || !toBe.index1.isConstant());
+
+  std::pair<ASTNode, ASTNode> key = (toBe.index0 < toBe.index1)
+                                        ? make_pair(toBe.index0, toBe.index1)
+                                        : make_pair(toBe.index1, toBe.index0);
+  IndexEqualsMap::const_iterator it = indexEquals.find(key);
+  Minisat::Var a;
+  if (it != indexEquals.end())
+    a = it->second;
+  else
+  {
+    a = getEquals(SatSolver, toBe.index0, toBe.index1, satVar, LEFT_ONLY);
+    indexEquals.insert(make_pair(key, a));
+  }
+
+  SATSolver::vec_literals satSolverClause;
+  satSolverClause.push(SATSolver::mkLit(a, true));
+
+  // Two different constants, so the indexes must differ.
+  if (!toBe.value0.isConstant() || !toBe.value1.isConstant())
+  {
+    Minisat::Var b =
+        getEquals(SatSolver, toBe.value0, toBe.value1, satVar, RIGHT_ONLY);
+    satSolverClause.push(SATSolver::mkLit(b, false));
+  }
+  SatSolver.addClause(satSolverClause);
+}
+
+SOLVER_RETURN_TYPE
+AbsRefine_CounterExample::LemmaOnDemand_ArrayRefinement(
+    SATSolver& SatSolver, const ASTNode& original_input, ToSATBase* tosat)
+{
+  bm->GetRunTimes()->start(RunTimes::ArrayReadRefinement);
+
+  IndexEqualsMap indexEquals;
+  unsigned rounds = 0;
+
+  while (true)
+  {
+    rounds++;
+    unsigned added = 0;
+    ToSATBase::ASTNodeToSATVar& satVar = tosat->SATVar_to_SymbolIndexMap();
+
+    for (ArrayTransformer::ArrType::const_iterator
+             iset = ArrayTransform->arrayToIndexToRead.begin(),
+             iset_end = ArrayTransform->arrayToIndexToRead.end();
+         iset != iset_end; iset++)
+    {
+      const ArrayTransformer::arrTypeMap& mapper = iset->second;
+
+      // From the value of the index in the model, to the first read there,
+      // and the value it read.
+      std::unordered_map<
+          ASTNode, std::pair<const ArrayTransformer::ArrayRead*, ASTNode>,
+          ASTNode::ASTNodeHasher, ASTNode::ASTNodeEqual>
+          bucket;
+      bucket.reserve(mapper.size());
+
+      for (ArrayTransformer::arrTypeMap::const_iterator it = mapper.begin();
+           it != mapper.end(); it++)
+      {
+        const ArrayTransformer::ArrayRead& read = it->second;
+        const ASTNode concreteIndex = TermToConstTermUsingModel(it->first);
+        const ASTNode concreteValue = TermToConstTermUsingModel(read.symbol);
+
+        auto p = bucket.insert(
+            make_pair(concreteIndex, make_pair(&read, concreteValue)));
+        if (p.second || p.first->second.second == concreteValue)
+          continue;
+
+        const ArrayTransformer::ArrayRead& first = *p.first->second.first;
+        AxiomToBe o(first.index_symbol, read.index_symbol, first.symbol,
+                    read.symbol);
+        applyLemmaToSAT(SatSolver, o, satVar, indexEquals);
+        added++;
+        arrayLemmaCount[iset->first]++;
+      }
+    }
+
+    if (added == 0)
+    {
+      // The model satisfies every read-over-read axiom, but not the input.
+      // This shouldn't happen, so fall back to adding all the axioms.
+      bm->GetRunTimes()->stop(RunTimes::ArrayReadRefinement);
+      return SATBased_ArrayReadRefinement(SatSolver, original_input, tosat);
+    }
+
+    bm->GetRunTimes()->stop(RunTimes::ArrayReadRefinement);
+    SOLVER_RETURN_TYPE res =
+        CallSAT_ResultCheck(SatSolver, ASTTrue, original_input, tosat, true);
+
+    if (SOLVER_UNDECIDED != res)
+    {
+      if (bm->UserFlags.stats_flag)
+        printArrayLemmaStats(rounds);
+      return res;
+    }
+    bm->GetRunTimes()->start(RunTimes::ArrayReadRefinement);
+  }
+}
+
+void AbsRefine_CounterExample::printArrayLemmaStats(unsigned rounds) const
+{
+  std::cerr << "Array lemmas, after " << rounds << " rounds:";
+  for (std::map<ASTNode, unsigned>::const_iterator it =
+           arrayLemmaCount.begin();
+       it != arrayLemmaCount.end(); it++)
+  {
+    std::cerr << " " << it->first.GetName() << " : " << it->second;
+  }
+  std::cerr << std::endl;
+}
+
 // This is another way of performing Ackermannisation.
 void AbsRefine_CounterExample::applyAllCongruenceConstraints(
     SATSolver& SatSolver, ToSATBase* tosat)
@@ -84,12 +84,13 @@ ASTNode ArrayTransformer::TransformFormula_TopLevel(const ASTNode& form)
 
         if (the_index.isConstant() || the_index.GetKind() == SYMBOL)
         {
-          it->second.index_symbol = the_index;
+          setIndexSymbol(iset->first, the_index, it->second, the_index);
         }
         else if (replaced.find(the_index) !=
                  replaced.end()) // Already associated with a variable.
         {
-          it->second.index_symbol = replaced.find(the_index)->second;
+          setIndexSymbol(iset->first, the_index, it->second,
+                         replaced.find(the_index)->second);
         }
         else
         {
@@ -97,7 +98,7 @@ ASTNode ArrayTransformer::TransformFormula_TopLevel(const ASTNode& form)
                                                  "STP__IndexVariables");
           equalsNodes.push_back(nf->CreateNode(EQ, the_index, newV));
           replaced.insert(make_pair(the_index, newV));
-          it->second.index_symbol = newV;
+          setIndexSymbol(iset->first, the_index, it->second, newV);
         }
         assert(it->second.index_symbol.GetValueWidth() ==
                the_index.GetValueWidth());
@@ -596,12 +597,11 @@ ASTNode ArrayTransformer::TransformArrayRead(const ASTNode& term)
             result = simp->CreateSimplifiedTermITE(cond, it2->second, result);
         }
 
-        ack_pair[arrName].push_back(make_pair(readIndex, CurrentSymbol));
+        addAck(arrName, readIndex, CurrentSymbol);
       }
 
       assert(arrName.GetType() == ARRAY_TYPE);
-      arrayToIndexToRead[arrName].insert(
-          make_pair(readIndex, ArrayRead(result, CurrentSymbol)));
+      addRead(arrName, readIndex, ArrayRead(result, CurrentSymbol));
       break;
     }
     case WRITE:
@@ -624,6 +624,26 @@ ASTNode ArrayTransformer::TransformArrayRead(const ASTNode& term)
        *    be an array read)
        */
 
+      // A read at a constant index goes straight past the writes to other
+      // constant indexes. They would each become ITE(false, ..).
+      if (BVCONST == readIndex.GetKind())
+      {
+        const ArrayWriteIndex::Chain* chain = writeChains.get(arrName);
+        if (chain != NULL)
+        {
+          const uint32_t p = ArrayWriteIndex::next(*chain, readIndex, 0);
+          const ASTNode& skipTo = (p == chain->length)
+                                      ? chain->base
+                                      : ArrayWriteIndex::write(*chain, p);
+          if (skipTo != arrName)
+          {
+            result =
+                TransformTerm(nf->CreateTerm(READ, width, skipTo, readIndex));
+            break;
+          }
+        }
+      }
+
       ASTNode writeIndex = TransformTerm(arrName[1]);
       ASTNode writeVal = TransformTerm(arrName[2]);
 
@@ -772,12 +792,73 @@ void ArrayTransformer::FillUp_ArrReadIndex_Vec(const ASTNode& e0,
   assert(e0[0].GetKind() == SYMBOL);
   assert(e0[1].GetKind() == BVCONST);
   assert(e1.GetKind() == BVCONST);
-  assert(arrayToIndexToRead[e0[0]].find(e0[1]) ==
-         arrayToIndexToRead[e0[0]].end());
+  assert(arrayToIndexToRead.find(e0[0]) == arrayToIndexToRead.end() ||
+         arrayToIndexToRead.find(e0[0])->second.find(e0[1]) ==
+             arrayToIndexToRead.find(e0[0])->second.end());
 
-  arrayToIndexToRead[e0[0]].insert(make_pair(e0[1], ArrayRead(e1, e1)));
+  addRead(e0[0], e0[1], ArrayRead(e1, e1));
+  addAck(e0[0], e0[1], e1);
+}
 
-  ack_pair[e0[0]].push_back(make_pair(e0[1], e1));
+void ArrayTransformer::addRead(const ASTNode& array, const ASTNode& index,
+                               const ArrayRead& read)
+{
+  if (arrayToIndexToRead[array].insert(make_pair(index, read)).second)
+    trail.push(Change{Change::READ, array, index, ASTNode(), nullptr});
+}
+
+void ArrayTransformer::setIndexSymbol(const ASTNode& array,
+                                      const ASTNode& index, ArrayRead& read,
+                                      const ASTNode& symbol)
+{
+  if (read.index_symbol == symbol)
+    return;
+  trail.push(
+      Change{Change::INDEX_SYMBOL, array, index, read.index_symbol, nullptr});
+  read.index_symbol = symbol;
+}
+
+void ArrayTransformer::addAck(const ASTNode& array, const ASTNode& index,
+                              const ASTNode& symbol)
+{
+  ack_pair[array].push_back(make_pair(index, symbol));
+  trail.push(Change{Change::ACK, array, index, ASTNode(), nullptr});
+}
+
+// An array left with no reads is the same as one never read, so it's
+// removed rather than being kept empty.
+void ArrayTransformer::undo(Change& c)
+{
+  switch (c.kind)
+  {
+    case Change::READ:
+    {
+      ArrType::iterator it = arrayToIndexToRead.find(c.array);
+      it->second.erase(c.index);
+      if (it->second.empty())
+        arrayToIndexToRead.erase(it);
+      break;
+    }
+
+    case Change::INDEX_SYMBOL:
+      arrayToIndexToRead.find(c.array)->second.find(c.index)->second
+          .index_symbol = c.old;
+      break;
+
+    case Change::ACK:
+    {
+      auto it = ack_pair.find(c.array);
+      it->second.pop_back();
+      if (it->second.empty())
+        ack_pair.erase(it);
+      break;
+    }
+
+    case Change::CLEARED:
+      arrayToIndexToRead.swap(c.saved->arrayToIndexToRead);
+      ack_pair.swap(c.saved->ack_pair);
+      break;
+  }
 }
 
 } // end of namespace stp
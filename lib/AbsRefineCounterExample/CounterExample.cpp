@@ -25,6 +25,9 @@ THE SOFTWARE.
 #include "stp/AbsRefineCounterExample/AbsRefine_CounterExample.h"
 #include "stp/Printer/printers.h"
 #include "stp/ToSat/ToSATAIG.h"
+#include "stp/Simplifier/LocalSearch.h"
+#include <algorithm>
+#include <unordered_map>
 
 const bool debug_counterexample = false;
 
@@ -99,6 +102,11 @@ void AbsRefine_CounterExample::ConstructCounterExample(
     }
   }
 
+  CopyArrayReads_To_CounterExample();
+}
+
+void AbsRefine_CounterExample::CopyArrayReads_To_CounterExample(void)
+{
   for (ArrayTransformer::ArrType::const_iterator
            it = ArrayTransform->arrayToIndexToRead.begin(),
            itend = ArrayTransform->arrayToIndexToRead.end();
@@ -684,6 +692,78 @@ AbsRefine_CounterExample::GetCounterExampleArray(bool t, const ASTNode& e)
   return entries;
 }
 
+void AbsRefine_CounterExample::GetCounterExampleWords(const ASTNode& e,
+                                                      uint64_t* words)
+{
+  const size_t size = WordsFor(e);
+  std::fill(words, words + size, 0);
+  if (bm->ValidFlag) // there's no counterexample.
+    return;
+
+  // Most symbols are in the counterexample already, so skip building
+  // anything for them.
+  ASTNode value;
+  ASTNodeMap::const_iterator it = CounterExampleMap.find(e);
+  if (it != CounterExampleMap.end() && it->second.isConstant())
+    value = it->second;
+  else
+    value = GetCounterExample(e);
+
+  if (BOOLEAN_TYPE == e.GetType())
+  {
+    words[0] = (value == ASTTrue) ? 1 : 0;
+    return;
+  }
+
+  assert(BVCONST == value.GetKind());
+
+  const unsigned width = value.GetValueWidth();
+  for (unsigned offset = 0; offset < width; offset += 32)
+  {
+    const unsigned chunk = std::min(32u, width - offset);
+    const uint64_t bits =
+        CONSTANTBV::BitVector_Chunk_Read(value.GetBVConst(), chunk, offset);
+    words[offset / 64] |= bits << (offset % 64);
+  }
+}
+
+void AbsRefine_CounterExample::GetCounterExampleArrays(
+    const ASTVec& arrays, vector<vector<std::pair<ASTNode, ASTNode>>>& entries)
+{
+  entries.clear();
+  entries.resize(arrays.size());
+  if (bm->ValidFlag)
+    return;
+
+  std::unordered_map<ASTNode, size_t, ASTNode::ASTNodeHasher,
+                     ASTNode::ASTNodeEqual>
+      position;
+  for (size_t i = 0; i < arrays.size(); i++)
+    position.insert(std::make_pair(arrays[i], i));
+
+  // Collect first: TermToConstTermUsingModel can add to the counterexample.
+  for (const auto& it : CounterExampleMap)
+  {
+    const ASTNode& f = it.first;
+    if (f.GetKind() != READ || f[1].GetKind() != BVCONST)
+      continue;
+
+    auto p = position.find(f[0]);
+    if (p != position.end())
+      entries[p->second].push_back(std::make_pair(f[1], it.second));
+  }
+
+  for (auto& array : entries)
+    for (auto& entry : array)
+    {
+      if (BITVECTOR_TYPE == entry.second.GetType())
+        entry.second = TermToConstTermUsingModel(entry.second, false);
+      else
+        entry.second = ComputeFormulaUsingModel(entry.second);
+      assert(entry.second.isConstant());
+    }
+}
+
 // TODO printing of expressions.
 // TODO move to printer file.
 void AbsRefine_CounterExample::PrintSMTLIB2(std::ostream& os, const ASTNode& n)
@@ -1054,6 +1134,87 @@ void AbsRefine_CounterExample::CopySolverMap_To_CounterExample(void)
   }
 }
 
+void AbsRefine_CounterExample::ReportCounterExample(void)
+{
+  if (bm->UserFlags.check_counterexample_flag)
+    CheckCounterExample(true);
+
+  if ((bm->UserFlags.stats_flag || bm->UserFlags.print_counterexample_flag) &&
+      (!bm->UserFlags.smtlib2_parser_flag))
+  {
+    PrintCounterExample(true);
+    PrintCounterExample_InOrder(true);
+  }
+}
+
+SOLVER_RETURN_TYPE AbsRefine_CounterExample::LocalSearch_ResultCheck(
+    const ASTNode& modified_input, const ASTNode& original_input,
+    simplifier::constantBitP::NodeToFixedBitsMap* fixed)
+{
+  bm->GetRunTimes()->start(RunTimes::LocalSearch);
+  LocalSearch search(bm, fixed);
+  ASTNodeMap model;
+  const bool found =
+      search.search(modified_input, bm->UserFlags.local_search_ms, model);
+  bm->GetRunTimes()->stop(RunTimes::LocalSearch);
+
+  if (bm->UserFlags.stats_flag)
+    cerr << "Local search moves:" << search.movesMade()
+         << (found ? " found a model" : "") << endl;
+
+  if (!found)
+    return SOLVER_UNDECIDED;
+
+  // The model is always checked, it's cheap next to bit-blasting.
+  bm->GetRunTimes()->start(RunTimes::CounterExampleGeneration);
+  CounterExampleMap.clear();
+  ComputeFormulaMap.clear();
+  CopySolverMap_To_CounterExample();
+  CounterExampleMap.insert(model.begin(), model.end());
+  CopyArrayReads_To_CounterExample();
+  const ASTNode orig_result = ComputeFormulaUsingModel(original_input);
+  bm->GetRunTimes()->stop(RunTimes::CounterExampleGeneration);
+
+  if (ASTTrue != orig_result)
+  {
+    CounterExampleMap.clear();
+    ComputeFormulaMap.clear();
+    return SOLVER_UNDECIDED;
+  }
+
+  ReportCounterExample();
+  return SOLVER_INVALID;
+}
+
+SOLVER_RETURN_TYPE AbsRefine_CounterExample::CachedModel_ResultCheck(
+    const ASTNode& original_input, ModelCache& cache)
+{
+  const std::deque<ASTNodeMap>& models = cache.getModels();
+  for (size_t i = 0; i < models.size(); i++)
+  {
+    // Symbols the model doesn't mention take the defaults that
+    // GetCounterExample() gives them.
+    bm->GetRunTimes()->start(RunTimes::CounterExampleGeneration);
+    CounterExampleMap = models[i];
+    ComputeFormulaMap.clear();
+    const ASTNode result = ComputeFormulaUsingModel(original_input);
+    bm->GetRunTimes()->stop(RunTimes::CounterExampleGeneration);
+
+    if (ASTTrue == result)
+    {
+      if (bm->UserFlags.stats_flag)
+        cerr << "Remembered model " << i << " satisfies the input" << endl;
+      cache.used(i);
+      ReportCounterExample();
+      return SOLVER_INVALID;
+    }
+  }
+
+  CounterExampleMap.clear();
+  ComputeFormulaMap.clear();
+  return SOLVER_UNDECIDED;
+}
+
 SOLVER_RETURN_TYPE
 AbsRefine_CounterExample::CallSAT_ResultCheck(SATSolver& SatSolver,
                                               const ASTNode& modified_input,
@@ -1096,16 +1257,7 @@ AbsRefine_CounterExample::CallSAT_ResultCheck(SATSolver& SatSolver,
     // invalid
     if (ASTTrue == orig_result)
     {
-      if (bm->UserFlags.check_counterexample_flag)
-      {
-        CheckCounterExample(SatSolver.okay());
-      }
-
-      if ((bm->UserFlags.stats_flag || bm->UserFlags.print_counterexample_flag) && (!bm->UserFlags.smtlib2_parser_flag))
-      {
-        PrintCounterExample(SatSolver.okay());
-        PrintCounterExample_InOrder(SatSolver.okay());
-      }
+      ReportCounterExample();
       return SOLVER_INVALID;
     }
     // counterexample is bogus: flag it
@@ -0,0 +1,108 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/AbsRefineCounterExample/ModelCache.h"
+#include <algorithm>
+
+namespace stp
+{
+
+namespace
+{
+// The top-level conjuncts of "input", sorted, without TRUE.
+ASTVec conjuncts(const ASTNode& input)
+{
+  ASTVec result;
+  if (input.GetKind() == AND)
+  {
+    ASTNodeSet flattened;
+    FlattenKindNoDuplicates(AND, input.GetChildren(), result, flattened);
+  }
+  else
+    result.push_back(input);
+
+  result.erase(std::remove_if(result.begin(), result.end(),
+                              [](const ASTNode& n) {
+                                return n.GetKind() == TRUE;
+                              }),
+               result.end());
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+} // namespace
+
+void ModelCache::addModel(const ASTNodeMap& model, unsigned capacity)
+{
+  if (capacity == 0)
+    return;
+
+  // The rest of the counterexample is memoised terms, which are worked out
+  // again when they're needed.
+  ASTNodeMap kept;
+  for (const auto& entry : model)
+  {
+    const ASTNode& n = entry.first;
+    if (n.GetKind() == SYMBOL ||
+        (n.GetKind() == READ && n[0].GetKind() == SYMBOL &&
+         n[1].GetKind() == BVCONST))
+      kept.insert(entry);
+  }
+
+  models.push_front(std::move(kept));
+  while (models.size() > capacity)
+    models.pop_back();
+}
+
+void ModelCache::addUnsatisfiable(const ASTNode& input, unsigned capacity)
+{
+  if (capacity == 0)
+    return;
+
+  unsatisfiable.push_front(conjuncts(input));
+  while (unsatisfiable.size() > capacity)
+    unsatisfiable.pop_back();
+}
+
+bool ModelCache::knownUnsatisfiable(const ASTNode& input) const
+{
+  if (unsatisfiable.empty())
+    return false;
+
+  const ASTVec current = conjuncts(input);
+  for (const ASTVec& u : unsatisfiable)
+    if (std::includes(current.begin(), current.end(), u.begin(), u.end()))
+      return true;
+  return false;
+}
+
+void ModelCache::used(size_t i)
+{
+  assert(i < models.size());
+  if (i == 0)
+    return;
+  ASTNodeMap m = std::move(models[i]);
+  models.erase(models.begin() + i);
+  models.push_front(std::move(m));
+}
+
+} // end namespace stp
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "stp/Interface/fdstream.h"
 #include "stp/Parser/parser.h"
 #include "stp/Printer/printers.h"
+#include "stp/STPManager/Snapshot.h"
 #include "stp/cpp_interface.h"
 #include "stp/Util/GitSHA1.h"
 // FIXME: External library
@@ -526,6 +527,12 @@ int vc_query(VC vc, Expr e)
   return vc_query_with_timeout(vc, e, -1, -1);
 }
 
+void vc_setMemoryBudget(VC vc, int64_t megabytes)
+{
+  stp::STP* stp_i = (stp::STP*)vc;
+  stp_i->bm->UserFlags.memory_budget_mb = megabytes;
+}
+
 int vc_query_with_timeout(VC vc, Expr e, int timeout_max_conflicts, int timeout_max_time)
 {
   stp::STP* stp_i = (stp::STP*)vc;
@@ -672,6 +679,69 @@ void vc_getCounterExampleArray(VC vc, Expr e, Expr** indices, Expr** values,
   }
 }
 
+size_t vc_getCounterExampleWords(VC vc, const Expr* exprs, int count,
+                                 uint64_t* words, size_t capacity)
+{
+  stp::STP* stp_i = (stp::STP*)vc;
+  stp::AbsRefine_CounterExample* ce =
+      (stp::AbsRefine_CounterExample*)(stp_i->Ctr_Example);
+
+  size_t needed = 0;
+  for (int i = 0; i < count; i++)
+    needed += stp::AbsRefine_CounterExample::WordsFor(*(stp::ASTNode*)exprs[i]);
+
+  if (needed > capacity)
+    return needed;
+
+  for (int i = 0; i < count; i++)
+  {
+    const stp::ASTNode& e = *(stp::ASTNode*)exprs[i];
+    ce->GetCounterExampleWords(e, words);
+    words += stp::AbsRefine_CounterExample::WordsFor(e);
+  }
+  return needed;
+}
+
+size_t vc_getCounterExampleArrayWords(VC vc, const Expr* arrays, int count,
+                                      uint64_t* words, size_t capacity,
+                                      int* sizes)
+{
+  stp::STP* stp_i = (stp::STP*)vc;
+  stp::AbsRefine_CounterExample* ce =
+      (stp::AbsRefine_CounterExample*)(stp_i->Ctr_Example);
+
+  stp::ASTVec a;
+  a.reserve(count);
+  for (int i = 0; i < count; i++)
+    a.push_back(*(stp::ASTNode*)arrays[i]);
+
+  vector<vector<std::pair<ASTNode, ASTNode>>> entries;
+  ce->GetCounterExampleArrays(a, entries);
+
+  size_t needed = 0;
+  for (int i = 0; i < count; i++)
+  {
+    sizes[i] = entries[i].size();
+    for (const auto& entry : entries[i])
+      needed += stp::AbsRefine_CounterExample::WordsFor(entry.first) +
+                stp::AbsRefine_CounterExample::WordsFor(entry.second);
+  }
+
+  if (needed > capacity)
+    return needed;
+
+  // The entries are constants already.
+  for (const auto& array : entries)
+    for (const auto& entry : array)
+    {
+      ce->GetCounterExampleWords(entry.first, words);
+      words += stp::AbsRefine_CounterExample::WordsFor(entry.first);
+      ce->GetCounterExampleWords(entry.second, words);
+      words += stp::AbsRefine_CounterExample::WordsFor(entry.second);
+    }
+  return needed;
+}
+
 int vc_counterexample_size(VC vc)
 {
   stp::STP* stp_i = (stp::STP*)vc;
@@ -1859,6 +1929,44 @@ Expr vc_parseExpr(VC vc, const char* infile)
   return output;
 }
 
+int vc_saveSnapshot(VC vc, const char* filepath, Expr e)
+{
+  stp::STP* stp_i = (stp::STP*)vc;
+  stp::STPMgr* b = stp_i->bm;
+
+  stp::Snapshot snapshot;
+  snapshot.roots.push_back(*(stp::ASTNode*)e);
+  snapshot.roots.push_back(b->ASTFalse);
+  return stp::saveSnapshot(snapshot, filepath) ? 1 : 0;
+}
+
+Expr vc_loadSnapshot(VC vc, const char* filepath)
+{
+  stp::STP* stp_i = (stp::STP*)vc;
+  stp::STPMgr* b = stp_i->bm;
+
+  stp::Snapshot snapshot;
+  std::string error;
+  if (!stp::loadSnapshot(b, filepath, snapshot, error))
+  {
+    fprintf(stderr, "STP: Error: %s: %s\n", filepath, error.c_str());
+    return NULL;
+  }
+  if (snapshot.roots.size() != 2)
+  {
+    fprintf(stderr, "STP: Error: %s: snapshot must hold asserts and a query\n",
+            filepath);
+    return NULL;
+  }
+
+  stp::ASTVec conjuncts;
+  conjuncts.push_back(snapshot.roots[0]);
+  conjuncts.push_back(b->CreateNode(stp::NOT, snapshot.roots[1]));
+  conjuncts.push_back(stp::substitutionsAsFormula(b, snapshot.solverMap));
+  stp::ASTNode* output = new stp::ASTNode(b->CreateNode(stp::AND, conjuncts));
+  return output;
+}
+
 char* exprString(Expr e)
 {
   stringstream ss;
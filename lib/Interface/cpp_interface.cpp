@@ -58,6 +58,11 @@ void Cpp_interface::init()
   ignoreCheckSatRequest = false;
   produce_models = false;
   changed_model_status = false;
+  produce_unsat_cores = false;
+  lastNamed = lastName = ASTNode();
+  haveUnsatCore = false;
+  unsatCore.clear();
+  unsatAssumptions.clear();
 }
 
 void Cpp_interface::addFrame()
@@ -127,6 +132,23 @@ void Cpp_interface::AddAssert(const ASTNode& assert)
   bm.AddAssert(assert);
 }
 
+void Cpp_interface::nameFormula(const ASTNode& name, const ASTNode& formula)
+{
+  lastName = name;
+  lastNamed = formula;
+}
+
+// The name is already asserted to be equivalent to the formula.
+void Cpp_interface::AddTopLevelAssert(const ASTNode& assert)
+{
+  if (produce_unsat_cores && !lastNamed.IsNull() && assert == lastNamed)
+    frames.back()->getNamedAssertions().push_back(lastName);
+  else
+    bm.AddAssert(assert);
+
+  lastNamed = lastName = ASTNode();
+}
+
 void Cpp_interface::SetQuery(const ASTNode& q)
 {
   bm.SetQuery(q);
@@ -356,6 +378,9 @@ void Cpp_interface::unsupported()
   flush(cout);
 }
 
+// Eliminating pure literals and unconstrained variables substitutes values
+// that the assertions don't imply, so nothing is kept between check-sats,
+// and there's nothing for a pop to put back.
 void Cpp_interface::resetSolver()
 {
   bm.ClearAllTables();
@@ -453,6 +478,14 @@ void Cpp_interface::checkSat(const ASTVec& assertionsSMT2)
   if (ignoreCheckSatRequest)
     return;
 
+  // The cache doesn't know about the named assertions.
+  for (SolverFrame* frame : frames)
+    if (!frame->getNamedAssertions().empty())
+    {
+      checkSatAssuming(assertionsSMT2, ASTVec());
+      return;
+    }
+
   bm.GetRunTimes()->stop(RunTimes::Parsing);
 
   checkInvariant();
@@ -509,12 +542,93 @@ void Cpp_interface::checkSat(const ASTVec& assertionsSMT2)
     }
   }
 
+  // Unsatisfiable without assumptions, so nothing is in the core. Any core
+  // from an earlier check-sat-assuming is stale, even if the cache answered.
+  haveUnsatCore = (last_run.result == SOLVER_UNSATISFIABLE);
+  unsatCore.clear();
+  unsatAssumptions.clear();
+
+  printCheckSat(last_run.result);
+}
+
+void Cpp_interface::checkSatAssuming(const ASTVec& assertionsSMT2,
+                                     const ASTVec& assumptions)
+{
+  if (ignoreCheckSatRequest)
+    return;
+
+  for (const ASTNode& a : assumptions)
+  {
+    const ASTNode& v = (a.GetKind() == NOT) ? a[0] : a;
+    if (v.GetKind() != SYMBOL)
+    {
+      error("check-sat-assuming takes boolean constants or their negations");
+      return;
+    }
+  }
+
+  bm.GetRunTimes()->stop(RunTimes::Parsing);
+
+  checkInvariant();
+  assert(assertionsSMT2.size() == cache.size());
+
+  if (changed_model_status)
+  {
+    bm.UserFlags.check_counterexample_flag = produce_models;
+  }
+
+  ASTVec assumed;
+  for (SolverFrame* frame : frames)
+  {
+    const ASTVec& names = frame->getNamedAssertions();
+    assumed.insert(assumed.end(), names.begin(), names.end());
+  }
+  const size_t named = assumed.size();
+  assumed.insert(assumed.end(), assumptions.begin(), assumptions.end());
+
+  resetSolver();
+
+  ASTNode query;
+  if (assertionsSMT2.size() > 1)
+    query = nf->CreateNode(AND, assertionsSMT2);
+  else if (assertionsSMT2.size() == 1)
+    query = assertionsSMT2[0];
+  else
+    query = bm.ASTTrue;
+
+  ASTVec core;
+  const SOLVER_RETURN_TYPE result =
+      GlobalSTP->TopLevelSTP(query, bm.ASTFalse, assumed, core);
+
+  haveUnsatCore = (result == SOLVER_UNSATISFIABLE);
+  unsatCore.clear();
+  unsatAssumptions.clear();
+  const ASTNodeSet inCore(core.begin(), core.end());
+  for (size_t i = 0; i < assumed.size(); i++)
+    if (inCore.find(assumed[i]) != inCore.end())
+      (i < named ? unsatCore : unsatAssumptions).push_back(assumed[i]);
+
+  // Satisfiable with the assumptions means satisfiable without them, but
+  // unsatisfiable with them says nothing.
+  Entry& last_run = cache.back();
+  last_run = Entry(result == SOLVER_SATISFIABLE ? SOLVER_SATISFIABLE
+                                                : SOLVER_UNDECIDED);
+  last_run.node_number = assertionsSMT2.back().GetNodeNum();
+  if (result == SOLVER_SATISFIABLE)
+    for (size_t i = 0; i < cache.size(); i++)
+      cache[i].result = SOLVER_SATISFIABLE;
+
+  printCheckSat(result);
+}
+
+void Cpp_interface::printCheckSat(SOLVER_RETURN_TYPE result)
+{
   if (bm.UserFlags.quick_statistics_flag)
   {
     bm.GetRunTimes()->print();
   }
 
-  (GlobalSTP->tosat)->PrintOutput(last_run.result);
+  (GlobalSTP->tosat)->PrintOutput(result);
 
   // User has specified -p option to print model.
    if (bm.UserFlags.print_counterexample_flag)
@@ -526,6 +640,46 @@ void Cpp_interface::checkSat(const ASTVec& assertionsSMT2)
   bm.GetRunTimes()->start(RunTimes::Parsing);
 }
 
+void Cpp_interface::getUnsatCore()
+{
+  if (!produce_unsat_cores)
+  {
+    error("unsat cores aren't being produced");
+    return;
+  }
+  if (!haveUnsatCore)
+  {
+    error("the last check wasn't unsat");
+    return;
+  }
+
+  cout << "(";
+  for (size_t i = 0; i < unsatCore.size(); i++)
+    cout << (i > 0 ? " " : "") << unsatCore[i].GetName();
+  cout << ")" << endl;
+}
+
+void Cpp_interface::getUnsatAssumptions()
+{
+  if (!haveUnsatCore)
+  {
+    error("the last check wasn't unsat");
+    return;
+  }
+
+  cout << "(";
+  for (size_t i = 0; i < unsatAssumptions.size(); i++)
+  {
+    const ASTNode& a = unsatAssumptions[i];
+    cout << (i > 0 ? " " : "");
+    if (a.GetKind() == NOT)
+      cout << "(not " << a[0].GetName() << ")";
+    else
+      cout << a.GetName();
+  }
+  cout << ")" << endl;
+}
+
 // This method sets up some of the globally required data.
 Cpp_interface::Cpp_interface(STPMgr& bm_)
     : bm(bm_), letMgr(new LETMgr(bm.ASTUndefined)), nf(bm_.defaultNodeFactory)
@@ -581,6 +735,29 @@ void Cpp_interface::setOption(std::string option, std::string value)
     else
       unsupported();
   }
+  else if (option == "produce-unsat-cores")
+  {
+    if (value == "true")
+    {
+      produce_unsat_cores = true;
+      success();
+    }
+    else if (value == "false")
+    {
+      produce_unsat_cores = false;
+      success();
+    }
+    else
+      unsupported();
+  }
+  else if (option == "produce-unsat-assumptions")
+  {
+    // They always are.
+    if (value == "true" || value == "false")
+      success();
+    else
+      unsupported();
+  }
   else if (option == "produce-models")
   {
     changed_model_status = true;
@@ -696,4 +873,9 @@ ASTVec& Cpp_interface::SolverFrame::getSymbols()
 {
   return _scoped_symbols;
 }
+
+ASTVec& Cpp_interface::SolverFrame::getNamedAssertions()
+{
+  return _named_assertions;
+}
 }
@@ -35,6 +35,13 @@ HashingNodeFactory::~HashingNodeFactory()
 // Get structurally hashed version of the node.
 ASTNode HashingNodeFactory::CreateNode(const Kind kind,
                                        const ASTVec& back_children)
+{
+  return createInterior(kind, back_children, 0, 0);
+}
+
+ASTNode HashingNodeFactory::createInterior(const Kind kind,
+                                           const ASTVec& back_children,
+                                           unsigned width, unsigned index)
 {
   // We can't create NOT(NOT (..)) nodes because of how the numbering scheme we
   // use works. So you can't trust the hashing node factory even to return
@@ -48,6 +55,8 @@ ASTNode HashingNodeFactory::CreateNode(const Kind kind,
   {
     // Don't create a new vector if it won't be sorted.
     ASTInterior* n_ptr = new ASTInterior(&bm, kind, back_children);
+    n_ptr->_value_width = width;
+    n_ptr->_index_width = index;
     ASTNode n(bm.LookupOrCreateInterior(n_ptr));
     return n;    
   }
@@ -57,6 +66,8 @@ ASTNode HashingNodeFactory::CreateNode(const Kind kind,
     if (isSorted)
     {
       ASTInterior* n_ptr = new ASTInterior(&bm, kind, back_children);
+      n_ptr->_value_width = width;
+      n_ptr->_index_width = index;
       ASTNode n(bm.LookupOrCreateInterior(n_ptr));
       return n;
     }
@@ -64,6 +75,8 @@ ASTNode HashingNodeFactory::CreateNode(const Kind kind,
     ASTVec sorted_children = back_children;
     SortByExprNum(sorted_children);  
     ASTInterior* n_ptr = new ASTInterior(&bm, kind, sorted_children);
+    n_ptr->_value_width = width;
+    n_ptr->_index_width = index;
     ASTNode n(bm.LookupOrCreateInterior(n_ptr));
     return n;
   }
@@ -76,6 +89,8 @@ ASTNode HashingNodeFactory::CreateNode(const Kind kind,
 
     // Todo - we could move the children into the astinterior.
     ASTInterior* n_ptr = new ASTInterior(&bm, kind, children);
+    n_ptr->_value_width = width;
+    n_ptr->_index_width = index;
     ASTNode n(bm.LookupOrCreateInterior(n_ptr));
     return n;
   }
@@ -86,11 +101,23 @@ ASTNode HashingNodeFactory::CreateTerm(Kind kind, unsigned int width,
                                        const ASTVec& children)
 {
 
-  ASTNode n = CreateNode(kind, children);
-  n.SetValueWidth(width);
+  ASTNode n = createInterior(kind, children, width, 0);
+  if (n.GetValueWidth() != width)
+    n.SetValueWidth(width);
 
   // by default we assume that the term is a Bitvector. If
   // necessary the indexwidth can be changed later
-  n.SetIndexWidth(0);
+  if (n.GetIndexWidth() != 0)
+    n.SetIndexWidth(0);
+  return n;
+}
+
+ASTNode HashingNodeFactory::CreateArrayTerm(Kind kind, unsigned int index,
+                                            unsigned int width,
+                                            const ASTVec& children)
+{
+  ASTNode n = createInterior(kind, children, width, index);
+  assert(n.GetValueWidth() == width);
+  assert(n.GetIndexWidth() == index);
   return n;
 }
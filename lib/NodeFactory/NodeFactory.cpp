@@ -125,7 +125,8 @@ stp::ASTNode NodeFactory::CreateArrayTerm(Kind kind, unsigned int index,
                                           const stp::ASTVec& children)
 {
   ASTNode result = CreateTerm(kind, width, children);
-  result.SetIndexWidth(index);
+  if (result.GetIndexWidth() != index)
+    result.SetIndexWidth(index);
   return result;
 }
 
@@ -148,10 +149,7 @@ stp::ASTNode NodeFactory::getUndefined()
 ASTNode NodeFactory::CreateSymbol(const char* const name, unsigned indexWidth,
                                   unsigned valueWidth)
 {
-  ASTNode n = bm.LookupOrCreateSymbol(name);
-  n.SetIndexWidth(indexWidth);
-  n.SetValueWidth(valueWidth);
-  return n;
+  return bm.LookupOrCreateSymbol(name, indexWidth, valueWidth);
 }
 
 ASTNode NodeFactory::CreateConstant(stp::CBV cbv, unsigned width)
@@ -0,0 +1,304 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/NodeFactory/RuleMatcher.h"
+#include "stp/STPManager/STPManager.h"
+
+namespace stp
+{
+using namespace rules;
+
+RuleMatcher::RuleMatcher(STPMgr& bm_, NodeFactory* nf_)
+    : bm(bm_), nf(nf_), depth(0), applied(0), visited(0), budget(0)
+{
+  for (unsigned i = 0; i < rule_roots_count; i++)
+  {
+    const unsigned k = rule_roots[i].kind;
+    if (k >= by_kind.size())
+      by_kind.resize(k + 1, std::make_pair(0, 0));
+
+    if (by_kind[k].first == by_kind[k].second)
+      by_kind[k] = std::make_pair(i, i + 1);
+    else
+    {
+      assert(by_kind[k].second == i); // the generator sorts them.
+      by_kind[k].second = i + 1;
+    }
+  }
+}
+
+bool RuleMatcher::isConstant(const ASTNode& n, uint8_t c) const
+{
+  switch (c)
+  {
+    case RC_TRUE:
+      return n == bm.ASTTrue;
+    case RC_FALSE:
+      return n == bm.ASTFalse;
+    default:
+      if (n.GetKind() != BVCONST)
+        return false;
+  }
+
+  const CBV v = n.GetBVConst();
+  switch (c)
+  {
+    case RC_ZERO:
+      return CONSTANTBV::BitVector_is_empty(v);
+    case RC_MAX:
+      return CONSTANTBV::BitVector_is_full(v);
+    case RC_ONE:
+      return CONSTANTBV::Set_Max(v) == 0;
+  }
+  return false;
+}
+
+ASTNode RuleMatcher::constant(uint8_t c, unsigned width)
+{
+  switch (c)
+  {
+    case RC_TRUE:
+      return bm.ASTTrue;
+    case RC_FALSE:
+      return bm.ASTFalse;
+  }
+
+  if (width == 0)
+    return ASTNode();
+
+  switch (c)
+  {
+    case RC_ZERO:
+      return bm.CreateZeroConst(width);
+    case RC_ONE:
+      return bm.CreateOneConst(width);
+    case RC_MAX:
+      return bm.CreateMaxConst(width);
+  }
+  return ASTNode();
+}
+
+// Pending holds the sub-terms still to be visited, the next one at the back.
+bool RuleMatcher::matchFrom(uint32_t state, unsigned width, int32_t& rule)
+{
+  const RuleState& s = rule_states[state];
+  if (s.rule >= 0)
+  {
+    assert(pending.empty());
+    if (width < rule_info[s.rule].min_width)
+      return false;
+    rule = s.rule;
+    return true;
+  }
+
+  assert(!pending.empty());
+  const ASTNode* n = pending.back();
+
+  for (uint32_t i = s.edge_begin; i < s.edge_end; i++)
+  {
+    if (budget == 0)
+      return false;
+    budget--;
+    visited++;
+
+    const RuleEdge& e = rule_edges[i];
+    switch (e.type)
+    {
+      case RuleEdge::KIND:
+      {
+        if (n->GetKind() != e.kind || n->Degree() != e.arg)
+          break;
+        pending.pop_back();
+        const ASTVec& c = n->GetChildren();
+        for (size_t j = c.size(); j > 0; j--)
+          pending.push_back(&c[j - 1]);
+        if (matchFrom(e.target, width, rule))
+          return true;
+        pending.resize(pending.size() - c.size());
+        pending.push_back(n);
+        break;
+      }
+      case RuleEdge::BIND:
+        bound[e.arg] = *n;
+        pending.pop_back();
+        if (matchFrom(e.target, width, rule))
+          return true;
+        pending.push_back(n);
+        break;
+
+      case RuleEdge::SAME:
+        if (*n != bound[e.arg])
+          break;
+        pending.pop_back();
+        if (matchFrom(e.target, width, rule))
+          return true;
+        pending.push_back(n);
+        break;
+
+      case RuleEdge::CONST:
+        if (!isConstant(*n, e.arg))
+          break;
+        pending.pop_back();
+        if (matchFrom(e.target, width, rule))
+          return true;
+        pending.push_back(n);
+        break;
+    }
+  }
+  return false;
+}
+
+ASTNode RuleMatcher::apply(const Kind kind, const unsigned width_,
+                           const ASTVec& children)
+{
+  if ((unsigned)kind >= by_kind.size() || depth >= max_depth)
+    return ASTNode();
+
+  const std::pair<uint32_t, uint32_t> range = by_kind[kind];
+  if (range.first == range.second)
+    return ASTNode();
+
+  // Predicates take the width of their operands.
+  unsigned width = width_;
+  if (!is_Term_kind(kind) && !children.empty() &&
+      children[0].GetType() == BITVECTOR_TYPE)
+    width = children[0].GetValueWidth();
+
+  for (uint32_t r = range.first; r < range.second; r++)
+  {
+    if (rule_roots[r].arity != children.size())
+      continue;
+
+    pending.clear();
+    for (size_t j = children.size(); j > 0; j--)
+      pending.push_back(&children[j - 1]);
+    bound.resize(16);
+    budget = max_edges_per_node;
+
+    int32_t rule = -1;
+    if (!matchFrom(rule_roots[r].state, width, rule))
+      return ASTNode();
+
+    // Building the replacement can re-enter the matcher.
+    const ASTVec vars(bound.begin(), bound.begin() + rule_info[rule].vars);
+    depth++;
+    ASTNode result = instantiate(rule, false, width, vars, nf);
+    depth--;
+
+    if (!result.IsNull())
+      applied++;
+    return result;
+  }
+  return ASTNode();
+}
+
+ASTNode RuleMatcher::build(const Kind k, unsigned width,
+                           const ASTVec& children, NodeFactory* factory)
+{
+  // The rules are untyped, so check that the bindings fit.
+  for (size_t i = 0; i < children.size(); i++)
+  {
+    const ASTNode& c = children[i];
+    bool ok;
+    switch (k)
+    {
+      case ITE:
+        if (i == 0)
+          ok = c.GetType() == BOOLEAN_TYPE;
+        else
+          ok = c.GetType() == children[1].GetType() &&
+               (c.GetType() == BOOLEAN_TYPE || c.GetValueWidth() == width);
+        break;
+      case NOT:
+      case AND:
+      case OR:
+      case NAND:
+      case NOR:
+      case XOR:
+      case IFF:
+      case IMPLIES:
+        ok = c.GetType() == BOOLEAN_TYPE;
+        break;
+      default:
+        ok = c.GetType() == BITVECTOR_TYPE && c.GetValueWidth() == width;
+    }
+    if (!ok)
+      return ASTNode();
+  }
+
+  if (k == ITE && children[1].GetType() == BOOLEAN_TYPE)
+    return factory->CreateNode(k, children);
+
+  if (is_Term_kind(k))
+    return factory->CreateTerm(k, width, children);
+
+  return factory->CreateNode(k, children);
+}
+
+ASTNode RuleMatcher::instantiate(const unsigned rule, bool lhs,
+                                 const unsigned width, const ASTVec& vars,
+                                 NodeFactory* factory)
+{
+  assert(rule < rule_count);
+  const RuleInfo& info = rule_info[rule];
+  assert(vars.size() >= info.vars);
+
+  const uint32_t begin = lhs ? info.lhs_begin : info.rhs_begin;
+  const uint32_t end = lhs ? info.lhs_end : info.rhs_end;
+
+  ASTVec stack;
+  for (uint32_t i = begin; i < end; i++)
+  {
+    const RuleInstr& instr = rule_code[i];
+    switch (instr.op)
+    {
+      case RuleInstr::VAR:
+        stack.push_back(vars[instr.arg]);
+        break;
+
+      case RuleInstr::CONSTANT:
+      {
+        ASTNode c = constant(instr.arg, width);
+        if (c.IsNull())
+          return c;
+        stack.push_back(c);
+        break;
+      }
+
+      case RuleInstr::APPLY:
+      {
+        assert(stack.size() >= instr.arg);
+        ASTVec children(stack.end() - instr.arg, stack.end());
+        stack.resize(stack.size() - instr.arg);
+        ASTNode n = build(instr.kind, width, children, factory);
+        if (n.IsNull())
+          return n;
+        stack.push_back(n);
+        break;
+      }
+    }
+  }
+
+  assert(stack.size() == 1);
+  return stack.back();
+}
+} // end namespace stp
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include <cassert>
 #include <cmath>
 
+using stp::ArrayWriteIndex;
 using stp::Kind;
 
 using stp::SYMBOL;
@@ -176,6 +177,13 @@ ASTNode SimplifyingNodeFactory::CreateNode(Kind kind, const ASTVec& children)
     return c;
   }
 
+  if (bm.UserFlags.enable_rewrite_rules)
+  {
+    const ASTNode rewritten = rules.apply(kind, 0, children);
+    if (!rewritten.IsNull())
+      return rewritten;
+  }
+
   ASTNode result;
   switch (kind)
   {
@@ -898,6 +906,31 @@ ASTNode SimplifyingNodeFactory::chaseRead(const ASTVec& children,
   const bool read_is_const = (stp::BVCONST == readIndex.GetKind());
   ASTVec c(2);
 
+  // On long chains, jump over the writes to other constant indexes.
+  const ArrayWriteIndex::Chain* chain =
+      read_is_const ? writeIndex.get(write) : NULL;
+  if (chain != NULL)
+  {
+    uint32_t position = 0;
+    while ((position = ArrayWriteIndex::next(*chain, readIndex, position)) <
+           chain->length)
+    {
+      const ASTNode& w = ArrayWriteIndex::write(*chain, position);
+      if (readIndex == w[1])
+        return w[2];
+
+      c[0] = w[1];
+      c[1] = readIndex;
+      ASTNode n = CreateSimpleEQ(c);
+      if (n == ASTTrue)
+        return w[2];
+      else if (n != ASTFalse)
+        return hashing.CreateTerm(stp::READ, width, w, readIndex);
+      position++;
+    }
+    return hashing.CreateTerm(stp::READ, width, chain->base, readIndex);
+  }
+
   while (write.GetKind() == stp::WRITE)
   {
     const ASTNode& write_index = write[1];
@@ -1455,6 +1488,13 @@ ASTNode SimplifyingNodeFactory::CreateTerm(Kind kind, unsigned int width,
     return c;
   }
 
+  if (bm.UserFlags.enable_rewrite_rules)
+  {
+    const ASTNode rewritten = rules.apply(kind, width, children);
+    if (!rewritten.IsNull())
+      return rewritten;
+  }
+
   ASTNode result;
   switch (kind)
   {
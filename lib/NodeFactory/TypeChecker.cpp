@@ -47,8 +47,7 @@ stp::ASTNode TypeChecker::CreateArrayTerm(Kind kind, unsigned int index,
                                           unsigned int width,
                                           const stp::ASTVec& children)
 {
-  ASTNode r = f.CreateTerm(kind, width, children);
-  r.SetIndexWidth(index);
+  ASTNode r = f.CreateArrayTerm(kind, index, width, children);
   BVTypeCheck(r);
   return r;
 }
@@ -0,0 +1,309 @@
+#!/usr/bin/perl -w
+
+#Permission is hereby granted, free of charge, to any person obtaining
+#a copy of this software and associated documentation files (the
+#"Software"), to deal in the Software without restriction, including
+#without limitation the rights to use, copy, modify, merge, publish,
+#distribute, sublicense, and/or sell copies of the Software, and to
+#permit persons to whom the Software is furnished to do so, subject to
+#the following conditions:
+#
+#The above copyright notice and this permission notice shall be
+#included in all copies or substantial portions of the Software.
+#
+#THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+#EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+#MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+#NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+#LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+#OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+#WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+#given a file of rewrite rules (see RewriteRules.rules for the syntax),
+#produces a .cpp file containing the discrimination tree that
+#RuleMatcher uses to apply them.
+
+use strict;
+use Getopt::Long;
+my $fname = "RewriteRules.rules";
+my $out = "RewriteRules.cpp";
+my $timestamp = 1;
+GetOptions ("file=s" => \$fname, "output=s" => \$out, "timestamp!" => \$timestamp);
+
+my $now = $timestamp ? " " . localtime time : "";
+
+my %constants = (zero => "RC_ZERO", one => "RC_ONE", max => "RC_MAX",
+                 true => "RC_TRUE", false => "RC_FALSE");
+
+# Binary kinds whose children may appear in either order.
+my %commutative = map { $_ => 1 }
+  qw(BVPLUS BVMULT BVAND BVOR BVXOR BVNAND BVNOR BVXNOR AND OR XOR NAND NOR IFF EQ);
+
+# Kinds allowed on the right hand side. Terms here have the same width as
+# their children, so the replacement can be built knowing just one width.
+my %rhs_kinds = map { $_ => 1 }
+  qw(BVNOT BVAND BVOR BVXOR BVNAND BVNOR BVXNOR BVPLUS BVSUB BVUMINUS BVMULT
+     BVDIV BVMOD SBVDIV SBVREM SBVMOD BVLEFTSHIFT BVRIGHTSHIFT BVSRSHIFT ITE
+     EQ BVLT BVLE BVGT BVGE BVSLT BVSLE BVSGT BVSGE
+     NOT AND OR NAND NOR XOR IFF IMPLIES);
+
+my $line_no = 0;
+
+sub fail {
+  die "$fname:$line_no: $_[0]\n";
+}
+
+# Parses an s-expression into nested array refs. Leaves are strings.
+sub parse_expr {
+  my ($tokens) = @_;
+  my $t = shift @$tokens;
+  fail("unexpected end of rule") unless defined $t;
+  if ($t eq "(") {
+    my $kind = shift @$tokens;
+    fail("expected a kind after '('") unless defined $kind && $kind =~ /^[A-Z][A-Z_]*$/;
+    my @node = ($kind);
+    while (1) {
+      fail("missing ')'") unless @$tokens;
+      if ($tokens->[0] eq ")") {
+        shift @$tokens;
+        last;
+      }
+      push(@node, parse_expr($tokens));
+    }
+    fail("$kind has no children") if @node == 1;
+    return \@node;
+  }
+  fail("unexpected ')'") if $t eq ")";
+  fail("bad atom '$t'") unless $t =~ /^[a-z][a-z0-9_]*$/;
+  return $t;
+}
+
+sub parse_side {
+  my ($text) = @_;
+  $text =~ s/([()])/ $1 /g;
+  my @tokens = split(' ', $text);
+  my $e = parse_expr(\@tokens);
+  fail("trailing text '@tokens'") if @tokens;
+  return $e;
+}
+
+sub is_var {
+  my ($e) = @_;
+  return !ref($e) && !exists $constants{$e};
+}
+
+sub size {
+  my ($e) = @_;
+  return 1 unless ref($e);
+  my $s = 1;
+  $s += size($_) for @{$e}[1 .. $#$e];
+  return $s;
+}
+
+sub to_text {
+  my ($e) = @_;
+  return $e unless ref($e);
+  return "(" . join(" ", $e->[0], map { to_text($_) } @{$e}[1 .. $#$e]) . ")";
+}
+
+# Numbers the variables by their first occurrence in pre-order.
+sub number_vars {
+  my ($e, $vars) = @_;
+  if (!ref($e)) {
+    $vars->{$e} = scalar(keys %$vars) if is_var($e) && !exists $vars->{$e};
+    return;
+  }
+  number_vars($_, $vars) for @{$e}[1 .. $#$e];
+}
+
+# All orderings of the children of the commutative nodes.
+sub variants {
+  my ($e) = @_;
+  return ($e) unless ref($e);
+  my @partial = ([$e->[0]]);
+  for my $c (@{$e}[1 .. $#$e]) {
+    my @next;
+    for my $p (@partial) {
+      push(@next, [@$p, $_]) for variants($c);
+    }
+    @partial = @next;
+  }
+  my @result = @partial;
+  if ($commutative{$e->[0]} && @$e == 3) {
+    push(@result, [$_->[0], $_->[2], $_->[1]]) for @partial;
+  }
+  return @result;
+}
+
+# Flattens a pattern into the pre-order list of edge labels, after the root.
+sub flatten {
+  my ($e, $vars, $seen, $out) = @_;
+  if (!ref($e)) {
+    if (exists $constants{$e}) {
+      push(@$out, "RuleEdge::CONST, UNDEFINED, $constants{$e}");
+    } elsif ($seen->{$e}++) {
+      push(@$out, "RuleEdge::SAME, UNDEFINED, $vars->{$e}");
+    } else {
+      push(@$out, "RuleEdge::BIND, UNDEFINED, $vars->{$e}");
+    }
+    return;
+  }
+  push(@$out, "RuleEdge::KIND, $e->[0], " . (@$e - 1));
+  flatten($_, $vars, $seen, $out) for @{$e}[1 .. $#$e];
+}
+
+# Post-fix code to build an expression.
+sub code {
+  my ($e, $vars, $out) = @_;
+  if (!ref($e)) {
+    if (exists $constants{$e}) {
+      push(@$out, "RuleInstr::CONSTANT, UNDEFINED, $constants{$e}");
+    } else {
+      fail("'$e' isn't bound by the left hand side") unless exists $vars->{$e};
+      push(@$out, "RuleInstr::VAR, UNDEFINED, $vars->{$e}");
+    }
+    return;
+  }
+  code($_, $vars, $out) for @{$e}[1 .. $#$e];
+  push(@$out, "RuleInstr::APPLY, $e->[0], " . (@$e - 1));
+}
+
+sub check_rhs_kinds {
+  my ($e) = @_;
+  return unless ref($e);
+  fail("$e->[0] can't be used on the right hand side") unless $rhs_kinds{$e->[0]};
+  check_rhs_kinds($_) for @{$e}[1 .. $#$e];
+}
+
+# The discrimination tree. Each state is a list of [label, target] edges.
+my @states = ();
+my @state_rule = ();
+my %roots = ();      # "kind, arity" -> state
+my @root_order = ();
+
+sub new_state {
+  push(@states, []);
+  push(@state_rule, -1);
+  return $#states;
+}
+
+sub insert {
+  my ($root_key, $labels, $rule) = @_;
+  if (!exists $roots{$root_key}) {
+    $roots{$root_key} = new_state();
+    push(@root_order, $root_key);
+  }
+  my $s = $roots{$root_key};
+  for my $l (@$labels) {
+    my ($edge) = grep { $_->[0] eq $l } @{$states[$s]};
+    if (!defined $edge) {
+      $edge = [$l, new_state()];
+      push(@{$states[$s]}, $edge);
+    }
+    $s = $edge->[1];
+  }
+  # The first rule wins if two rules have the same left hand side.
+  $state_rule[$s] = $rule if $state_rule[$s] < 0;
+}
+
+my @code = ();
+my @info = ();
+
+sub read_rules {
+  open(RFILE, "< $fname") || die "Cannot open rules file $fname: $!\n";
+  my @lines = <RFILE>;
+  close(RFILE);
+
+  for (@lines) {
+    $line_no++;
+    s/#.*//;
+    next if /^\s*$/;
+    /^\s*(.*?)\s*->\s*(.*?)\s*(?:\bif\s+width\s*>=\s*(\d+))?\s*$/
+      || fail("expected: <pattern> -> <replacement> [if width >= N]");
+    my ($lhs_text, $rhs_text, $min_width) = ($1, $2, $3 || 0);
+    my $lhs = parse_side($lhs_text);
+    my $rhs = parse_side($rhs_text);
+    fail("the left hand side must be an application") unless ref($lhs);
+    check_rhs_kinds($rhs);
+    fail("the right hand side must be smaller than the left")
+      unless size($rhs) < size($lhs);
+
+    my %vars = ();
+    number_vars($lhs, \%vars);
+    fail("too many variables") if scalar(keys %vars) > 16;
+
+    my $rule = scalar(@info);
+    my (@lhs_code, @rhs_code);
+    code($lhs, \%vars, \@lhs_code);
+    code($rhs, \%vars, \@rhs_code);
+    my $lhs_begin = scalar(@code);
+    push(@code, @lhs_code);
+    my $rhs_begin = scalar(@code);
+    push(@code, @rhs_code);
+    my $text = to_text($lhs) . " -> " . to_text($rhs);
+    $text .= " if width >= $min_width" if $min_width;
+    push(@info, "$min_width, " . scalar(keys %vars) . ", $lhs_begin, $rhs_begin, $rhs_begin, "
+                . scalar(@code) . ", \"$text\"");
+
+    my %done = ();
+    for my $v (variants($lhs)) {
+      my @labels = ();
+      my %seen = ();
+      flatten($_, \%vars, \%seen, \@labels) for @{$v}[1 .. $#$v];
+      my $root_key = "$v->[0], " . (@$v - 1);
+      my $key = join(";", $root_key, @labels);
+      next if $done{$key}++;
+      insert($root_key, \@labels, $rule);
+    }
+  }
+}
+
+sub gen_cpp_file {
+  open(CPPFILE, "> $out") || die "Cannot open .cpp file: $!\n";
+
+  print CPPFILE
+    "// Generated automatically by genrules.pl from RewriteRules.rules$now.\n",
+    "// Do not edit\n",
+    "#include \"stp/NodeFactory/RuleMatcher.h\"\n\n",
+    "namespace stp {\n",
+    "namespace rules {\n\n";
+
+  # Roots of the same kind must be next to each other.
+  print CPPFILE "const RuleRoot rule_roots[] = {\n";
+  for (sort @root_order) {
+    print CPPFILE "  { $_, $roots{$_} },\n";
+  }
+  print CPPFILE "  { UNDEFINED, 0, 0 }\n};\n\n";
+
+  my @edges = ();
+  print CPPFILE "const RuleState rule_states[] = {\n";
+  for my $s (0 .. $#states) {
+    my $begin = scalar(@edges);
+    push(@edges, "$_->[0], $_->[1]") for @{$states[$s]};
+    print CPPFILE "  { $begin, ", scalar(@edges), ", $state_rule[$s] },\n";
+  }
+  print CPPFILE "};\n\n";
+
+  print CPPFILE "const RuleEdge rule_edges[] = {\n";
+  print CPPFILE "  { $_ },\n" for @edges;
+  print CPPFILE "  { RuleEdge::KIND, UNDEFINED, 0, 0 }\n};\n\n";
+
+  print CPPFILE "const RuleInstr rule_code[] = {\n";
+  print CPPFILE "  { $_ },\n" for @code;
+  print CPPFILE "  { RuleInstr::VAR, UNDEFINED, 0 }\n};\n\n";
+
+  print CPPFILE "const RuleInfo rule_info[] = {\n";
+  print CPPFILE "  { $_ },\n" for @info;
+  print CPPFILE "  { 0, 0, 0, 0, 0, 0, \"\" }\n};\n\n";
+
+  print CPPFILE
+    "const unsigned rule_roots_count = ", scalar(@root_order), ";\n",
+    "const unsigned rule_count = ", scalar(@info), ";\n\n",
+    "} // end namespace rules\n",
+    "} // end namespace stp\n";
+
+  close(CPPFILE);
+}
+
+&read_rules;
+&gen_cpp_file;
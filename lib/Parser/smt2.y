@@ -412,7 +412,7 @@ commands: commands LPAREN_TOK cmdi RPAREN_TOK
 cmdi:
      ASSERT_TOK an_formula
     {
-      stp::GlobalParserInterface->AddAssert(*$2);
+      stp::GlobalParserInterface->AddTopLevelAssert(*$2);
       stp::GlobalParserInterface->deleteNode($2);
       stp::GlobalParserInterface->success();
     }
@@ -422,9 +422,15 @@ cmdi:
       stp::GlobalParserInterface->checkSat(stp::GlobalParserInterface->getAssertVector());
     }
 |
-     CHECK_SAT_ASSUMING_TOK LPAREN_TOK an_term RPAREN_TOK
+     CHECK_SAT_ASSUMING_TOK LPAREN_TOK an_formulas RPAREN_TOK
     {
-      stp::GlobalParserInterface->unsupported();
+      stp::GlobalParserInterface->checkSatAssuming(stp::GlobalParserInterface->getAssertVector(), *$3);
+      delete $3;
+    }
+|
+     CHECK_SAT_ASSUMING_TOK LPAREN_TOK RPAREN_TOK
+    {
+      stp::GlobalParserInterface->checkSatAssuming(stp::GlobalParserInterface->getAssertVector(), ASTVec());
     }
 |
      DECLARE_CONST_TOK const_decl
@@ -466,6 +472,16 @@ cmdi:
       stp::GlobalParserInterface->getValue(*$3);
       delete $3;
     }
+|
+     GET_UNSAT_CORE_TOK
+    {
+      stp::GlobalParserInterface->getUnsatCore();
+    }
+|
+     GET_UNSAT_ASSUMPTION_TOK
+    {
+      stp::GlobalParserInterface->getUnsatAssumptions();
+    }
 |
      SET_OPTION_TOK COLON_TOK STRING_TOK STRING_TOK
     {
@@ -1077,6 +1093,7 @@ TRUE_TOK
   ASTNode n = stp::GlobalParserInterface->CreateNode(IFF,s, *$3);
 
   stp::GlobalParserInterface->AddAssert(n);
+  stp::GlobalParserInterface->nameFormula(s, *$3);
 
   delete $5;
 
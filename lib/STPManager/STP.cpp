@@ -23,6 +23,7 @@ THE SOFTWARE.
 ********************************************************************/
 
 #include "stp/STPManager/STP.h"
+#include "stp/STPManager/Snapshot.h"
 #include "stp/Simplifier/constantBitP/ConstantBitPropagation.h"
 #include "stp/Simplifier/constantBitP/NodeToFixedBitsMap.h"
 #include "stp/ToSat/ToSATAIG.h"
@@ -37,6 +38,7 @@ THE SOFTWARE.
 #include "stp/Sat/Riss.h"
 #endif
 
+#include "stp/Sat/CubeAndConquer.h"
 #include "stp/Sat/MinisatCore.h"
 #include "stp/Sat/SimplifyingMinisat.h"
 
@@ -52,6 +54,8 @@ THE SOFTWARE.
 #include "stp/Simplifier/StrengthReduction.h"
 #include "stp/Simplifier/Rewriting.h"
 #include "stp/Simplifier/MergeSame.h"
+#include "stp/Simplifier/PassScheduler.h"
+#include <algorithm>
 #include <memory>
 using std::cout;
 
@@ -85,11 +89,54 @@ SOLVER_RETURN_TYPE STP::solve_by_sat_solver(SATSolver* newS,
   // reset the timeout expired flag for the new check
   bm->soft_timeout_expired = false;
 
+  bm->memoryUsage.reset();
+  if (bm->UserFlags.memory_budget_mb >= 0)
+    bm->memoryUsage.setLimit(bm->UserFlags.memory_budget_mb * 1024 * 1024);
+  else
+    bm->memoryUsage.setLimit(-1);
+
   SOLVER_RETURN_TYPE result = TopLevelSTPAux(NewSolver, original_input);
   return result;
 }
 
+bool STP::withinMemoryBudget()
+{
+  MemoryUsage& usage = bm->memoryUsage;
+  if (!usage.hasLimit() && !bm->UserFlags.stats_flag)
+    return true;
+
+  usage.record(MemoryUsage::NodeTables, bm->memoryUsed());
+  usage.record(MemoryUsage::SimplifierCaches, simp->memoryUsed());
+
+  if (usage.tight())
+  {
+    simp->ClearCaches();
+    bm->TermsAlreadySeenMap_Clear();
+    usage.record(MemoryUsage::SimplifierCaches, simp->memoryUsed());
+  }
+
+  if (usage.exceeded())
+  {
+    if (bm->UserFlags.stats_flag)
+      cerr << "Over the memory budget, giving up." << endl;
+    bm->soft_timeout_expired = true;
+    return false;
+  }
+  return true;
+}
+
 SATSolver* STP::get_new_sat_solver()
+{
+  // The cubes' solvers don't take assumptions.
+  if (bm->UserFlags.cube_threads > 1 && selectors.empty())
+    return new CubeAndConquer([this]() { return get_backend_sat_solver(); },
+                              bm->UserFlags.cube_threads,
+                              std::max(bm->UserFlags.cube_depth, 0));
+
+  return get_backend_sat_solver();
+}
+
+SATSolver* STP::get_backend_sat_solver()
 {
   SATSolver* newS = NULL;
   switch (bm->UserFlags.solver_to_use)
@@ -148,114 +195,195 @@ SOLVER_RETURN_TYPE STP::TopLevelSTP(const ASTNode& inputasserts,
     original_input = inputasserts;
   }
 
+  // The cache knows nothing of the assumptions.
+  const unsigned cache_size =
+      selectors.empty() ? std::max<int64_t>(bm->UserFlags.model_cache_size, 0)
+                        : 0;
+  if (cache_size > 0)
+  {
+    if (modelCache.knownUnsatisfiable(original_input))
+    {
+      if (bm->UserFlags.stats_flag)
+        cerr << "Input includes a remembered unsatisfiable input" << endl;
+      Ctr_Example->ClearCounterExampleMap();
+      bm->soft_timeout_expired = false;
+      return SOLVER_VALID;
+    }
+
+    if (Ctr_Example->CachedModel_ResultCheck(original_input, modelCache) ==
+        SOLVER_INVALID)
+    {
+      bm->soft_timeout_expired = false;
+      return SOLVER_INVALID;
+    }
+  }
+
   SATSolver* newS = get_new_sat_solver();
   SOLVER_RETURN_TYPE result = solve_by_sat_solver(newS, original_input);
   delete newS;
 
+  if (result == SOLVER_VALID)
+    modelCache.addUnsatisfiable(original_input, cache_size);
+  else if (result == SOLVER_INVALID &&
+           bm->UserFlags.construct_counterexample_flag)
+    modelCache.addModel(Ctr_Example->GetCompleteCounterExample(), cache_size);
+
   bm->UserFlags.ackermannisation = saved_ack;
   return result;
 }
 
-ASTNode STP::callSizeReducing(ASTNode inputToSat, 
-                              BVSolver* bvSolver,
-                              PropagateEqualities* pe,
-                              NodeDomainAnalysis* domain
-                              )
+SOLVER_RETURN_TYPE STP::TopLevelSTP(const ASTNode& inputasserts,
+                                    const ASTNode& query,
+                                    const ASTVec& assumptions, ASTVec& core)
 {
-  while (true)
-  {
-    ASTNode last = inputToSat;
-    inputToSat = sizeReducing(last, bvSolver, pe, domain);
-    if (last == inputToSat)
+  core.clear();
+  if (assumptions.empty())
+    return TopLevelSTP(inputasserts, query);
+
+  // Each assumption is implied by a fresh symbol, which the SAT solver
+  // assumes is true. Simplifying can't remove the implications, so the core
+  // is in terms of the assumptions, whatever was substituted for them.
+  ASTVec conjuncts(1, inputasserts);
+  selectors.clear();
+  for (const ASTNode& a : assumptions)
+  {
+    const ASTNode s = bm->CreateFreshVariable(0, 0, "STP__Selector");
+    selectors.push_back(s);
+    conjuncts.push_back(
+        bm->defaultNodeFactory->CreateNode(OR, bm->CreateNode(NOT, s), a));
+  }
+  refuted.clear();
+
+  // These would give the selectors values that aren't implied, and false
+  // ones would hide the assumptions.
+  const bool pure_literals = bm->UserFlags.enable_pure_literals;
+  const bool unconstrained = bm->UserFlags.enable_unconstrained;
+  const int64_t local_search_ms = bm->UserFlags.local_search_ms;
+  bm->UserFlags.enable_pure_literals = false;
+  bm->UserFlags.enable_unconstrained = false;
+  bm->UserFlags.local_search_ms = 0;
+
+  SOLVER_RETURN_TYPE result =
+      TopLevelSTP(bm->defaultNodeFactory->CreateNode(AND, conjuncts), query);
+
+  bm->UserFlags.enable_pure_literals = pure_literals;
+  bm->UserFlags.enable_unconstrained = unconstrained;
+  bm->UserFlags.local_search_ms = local_search_ms;
+
+  // Simplifying only fixes what's implied. A selector that's false is
+  // refuted on its own, whatever the SAT solver found.
+  ASTNodeSet failed(refuted.begin(), refuted.end());
+  for (size_t i = 0; i < selectors.size(); i++)
+  {
+    const ASTNode value = simp->applySubstitutionMap(selectors[i]);
+    if (value == bm->ASTFalse)
+    {
+      result = SOLVER_VALID;
+      failed.clear();
+      failed.insert(selectors[i]);
       break;
+    }
+    if (value != selectors[i] && value != bm->ASTTrue)
+      FatalError("TopLevelSTP: an assumption's selector was replaced");
   }
 
-  return inputToSat;
+  if (result == SOLVER_VALID)
+    for (size_t i = 0; i < selectors.size(); i++)
+      if (failed.find(selectors[i]) != failed.end())
+        core.push_back(assumptions[i]);
+
+  selectors.clear();
+  refuted.clear();
+  return result;
 }
 
 // These transformations should never increase the size of the DAG.
-ASTNode STP::sizeReducing(ASTNode inputToSat, 
-                          BVSolver* bvSolver,
-                          PropagateEqualities* pe,
-                          NodeDomainAnalysis* domain
-                          )
+void STP::addSizeReducingPasses(PassScheduler& scheduler, BVSolver* bvSolver,
+                                PropagateEqualities* pe,
+                                NodeDomainAnalysis* domain)
 {
-
   if (bm->UserFlags.propagate_equalities)
-  {
-    inputToSat = pe->topLevel(inputToSat);
-    bm->ASTNodeStats(pe_message.c_str(), inputToSat);
-  }
-  
+    scheduler.add("propagate-equalities", [=](ASTNode n) {
+      ASTNode result = pe->topLevel(n);
+      bm->ASTNodeStats(pe_message.c_str(), result);
+      return result;
+    });
+
   if (bm->UserFlags.enable_unconstrained)
-  {
-    RemoveUnconstrained r1(*bm);
-    inputToSat = r1.topLevel(inputToSat, simp);
-    bm->ASTNodeStats(uc_message.c_str(), inputToSat);
-  }
+    scheduler.add("remove-unconstrained", [=](ASTNode n) {
+      RemoveUnconstrained r1(*bm);
+      ASTNode result = r1.topLevel(n, simp);
+      bm->ASTNodeStats(uc_message.c_str(), result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_use_intervals && bm->UserFlags.bitConstantProp_flag)
-  {
-    bm->GetRunTimes()->start(RunTimes::StrengthReduction);
-    StrengthReduction sr(bm->defaultNodeFactory, &bm->UserFlags);
-    inputToSat = sr.topLevel(inputToSat, *domain);
-    bm->GetRunTimes()->stop(RunTimes::StrengthReduction);
+    scheduler.add("strength-reduction", [=](ASTNode n) {
+      bm->GetRunTimes()->start(RunTimes::StrengthReduction);
+      StrengthReduction sr(bm->defaultNodeFactory, &bm->UserFlags);
+      ASTNode result = sr.topLevel(n, *domain);
+      bm->GetRunTimes()->stop(RunTimes::StrengthReduction);
 
-    bm->ASTNodeStats(domain_message.c_str(), inputToSat);
-  }
+      bm->ASTNodeStats(domain_message.c_str(), result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_pure_literals)
-  {
-    FindPureLiterals fpl;
-    fpl.topLevel(inputToSat, simp, bm);
-    inputToSat = simp->applySubstitutionMapAtTopLevel(inputToSat);
-    bm->ASTNodeStats(pl_message.c_str(), inputToSat);
-  }
+    scheduler.add("pure-literals", [=](ASTNode n) {
+      FindPureLiterals fpl;
+      fpl.topLevel(n, simp, bm);
+      ASTNode result = simp->applySubstitutionMapAtTopLevel(n);
+      bm->ASTNodeStats(pl_message.c_str(), result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_split_extracts)
-  {
-    SplitExtracts se(*bm);
-    inputToSat = se.topLevel(inputToSat);
-    bm->ASTNodeStats(se_message.c_str(), inputToSat);
-  }
+    scheduler.add("split-extracts", [=](ASTNode n) {
+      SplitExtracts se(*bm);
+      ASTNode result = se.topLevel(n);
+      bm->ASTNodeStats(se_message.c_str(), result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_always_true)
-  {
-    AlwaysTrue always(bm, bm->defaultNodeFactory);
-    inputToSat = always.topLevel(inputToSat);
-    bm->ASTNodeStats("After removing always true: ", inputToSat);
-  }
+    scheduler.add("always-true", [=](ASTNode n) {
+      AlwaysTrue always(bm, bm->defaultNodeFactory);
+      ASTNode result = always.topLevel(n);
+      bm->ASTNodeStats("After removing always true: ", result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_merge_same)
-  {
-    MergeSame ms(bm, bm->defaultNodeFactory);
-    inputToSat = ms.topLevel(inputToSat);
-    bm->ASTNodeStats("After Merge Same: ", inputToSat);
-  }
-
+    scheduler.add("merge-same", [=](ASTNode n) {
+      MergeSame ms(bm, bm->defaultNodeFactory);
+      ASTNode result = ms.topLevel(n);
+      bm->ASTNodeStats("After Merge Same: ", result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_flatten)
-  {
-    Flatten flatten(bm,bm->defaultNodeFactory);
-    inputToSat = flatten.topLevel(inputToSat);
-    bm->ASTNodeStats("After Sharing-aware Flattening: ", inputToSat);
-  }
+    scheduler.add("flatten", [=](ASTNode n) {
+      Flatten flatten(bm, bm->defaultNodeFactory);
+      ASTNode result = flatten.topLevel(n);
+      bm->ASTNodeStats("After Sharing-aware Flattening: ", result);
+      return result;
+    });
 
   if (bm->UserFlags.enable_sharing_aware_rewriting)
-  {
-    Rewriting rewrite(bm,bm->defaultNodeFactory);
-    inputToSat = rewrite.topLevel(inputToSat);
-    bm->ASTNodeStats("After Sharing-aware rewriting: ", inputToSat);
-  }
+    scheduler.add("rewriting", [=](ASTNode n) {
+      Rewriting rewrite(bm, bm->defaultNodeFactory);
+      ASTNode result = rewrite.topLevel(n);
+      bm->ASTNodeStats("After Sharing-aware rewriting: ", result);
+      return result;
+    });
 
   // I suspect this could increase the size.
   if (bm->UserFlags.wordlevel_solve_flag)
-  {
-    inputToSat = bvSolver->TopLevelBVSolve(inputToSat, false);
-    bm->ASTNodeStats(bitvec_message.c_str(), inputToSat);
-  }
-
-  return inputToSat;
+    scheduler.add("bv-solver", [=](ASTNode n) {
+      ASTNode result = bvSolver->TopLevelBVSolve(n, false);
+      bm->ASTNodeStats(bitvec_message.c_str(), result);
+      return result;
+    });
 }
 
 // Acceps a query, calls the SAT solver and generates Valid/InValid.
@@ -342,25 +470,35 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
 
   std::unique_ptr<NodeDomainAnalysis> domain(new NodeDomainAnalysis(bm));
 
+  // One scheduler, so the fixed point below orders the passes by how they
+  // did the first time.
+  PassScheduler sizeReducing(bm, bm->UserFlags.simplification_time_budget_ms);
+  addSizeReducingPasses(sizeReducing, bvSolver.get(), pe.get(), domain.get());
+
   // Run size reducing just once.
-  inputToSat = sizeReducing(inputToSat, bvSolver.get(), pe.get(), domain.get());
+  inputToSat = sizeReducing.once(inputToSat);
+  if (!withinMemoryBudget())
+    return SOLVER_TIMEOUT;
   long initial_difficulty_score = difficulty.score(inputToSat, bm);
 
   // It's helpful to know the initial node size. The difficulty scorer can easily get something similar:
   const long initial_node_size = difficulty.getEvalCount();
 
   // Fixed point it if it's not too difficult.
-  // Currently we discards all the state each time sizeReducing is called,
-  // so it's expensive to call.
-  if (!arrayops && ( -1 == bm->UserFlags.size_reducing_fixed_point || initial_node_size < bm->UserFlags.size_reducing_fixed_point))
+  if (!arrayops && !bm->memoryUsage.tight() && ( -1 == bm->UserFlags.size_reducing_fixed_point || initial_node_size < bm->UserFlags.size_reducing_fixed_point))
   {
-    inputToSat =
-        callSizeReducing(inputToSat, bvSolver.get(), pe.get(), domain.get());
+    inputToSat = sizeReducing.fixedPoint(inputToSat);
   }
 
+  if (bm->UserFlags.stats_flag)
+    sizeReducing.printStats(cerr);
+
   long bitblasted_difficulty = -1;
-  // Expensive, so only want to do it once.
-  if (bm->UserFlags.bitblast_simplification == -1 || initial_difficulty_score < bm->UserFlags.bitblast_simplification)
+  // Expensive, so only want to do it once. Optional, so skipped if memory is
+  // tight.
+  if (!bm->memoryUsage.tight() &&
+      (bm->UserFlags.bitblast_simplification == -1 ||
+       initial_difficulty_score < bm->UserFlags.bitblast_simplification))
   {
     BBNodeManagerAIG bitblast_nodemgr;
     BitBlaster<BBNodeAIG, BBNodeManagerAIG> bb(
@@ -382,15 +520,17 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
       */
       ASTNodeMap cache;
       inputToSat = SubstitutionMap::replace(
-          inputToSat, equivs, cache, bm->defaultNodeFactory, false, true);
+          inputToSat, equivs, cache, bm->defaultNodeFactory, false, true,
+          &simp->getVariablesInExpression());
       bm->ASTNodeStats(bb_message.c_str(), inputToSat);
     }
 
     if (fromTo.size() > 0)
     {
       ASTNodeMap cache;
-      inputToSat = SubstitutionMap::replace(inputToSat, fromTo, cache,
-                                            bm->defaultNodeFactory);
+      inputToSat = SubstitutionMap::replace(
+          inputToSat, fromTo, cache, bm->defaultNodeFactory, false, false,
+          &simp->getVariablesInExpression());
       bm->ASTNodeStats(bb_message.c_str(), inputToSat);
     }
     
@@ -410,75 +550,74 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
     cout << "Difficulty After Size reducing:" << initial_difficulty_score
          << endl;
 
-  // So we can delete the object and release all the hash-buckets storage.
-  std::unique_ptr<Revert_to> revert(new Revert_to());
-
+  // Released on the way out, so the early returns keep what was done.
+  std::unique_ptr<Revert_to> revert;
   if (!arrayops || bm->UserFlags.array_difficulty_reversion)
-  {
-    revert->initialSolverMap.insert(simp->Return_SolverMap()->begin(),
-                                    simp->Return_SolverMap()->end());
-    revert->backup_arrayToIndexToRead.insert(
-        arrayTransformer->arrayToIndexToRead.begin(),
-        arrayTransformer->arrayToIndexToRead.end());
-    revert->toRevertTo = inputToSat;
-  }
+    revert.reset(new Revert_to(*this, inputToSat));
 
   // round of substitution, solving, and simplification. ensures that
   // DAG is minimized as much as possibly, and ideally should
   // garuntee that all liketerms in BVPLUSes have been combined.
   bm->TermsAlreadySeenMap_Clear();
 
-  ASTNode tmp_inputToSAT;
-  do
-  {
-    tmp_inputToSAT = inputToSat;
-
-    if (bm->soft_timeout_expired)
-      return SOLVER_TIMEOUT;
-
-    if (bm->UserFlags.optimize_flag)
-    {
-      if (bm->UserFlags.propagate_equalities)
+  PassScheduler simplification(bm,
+                               bm->UserFlags.simplification_time_budget_ms);
+  if (bm->UserFlags.optimize_flag)
+  {
+    if (bm->UserFlags.propagate_equalities)
+      simplification.add("propagate-equalities", [&](ASTNode n) {
+        ASTNode result = pe->topLevel(n);
+        bm->ASTNodeStats(pe_message.c_str(), result);
+        return result;
+      });
+
+    // Imagine:
+    // The simplifier simplifies (0 + T) to T
+    // Then bvsolve introduces (0 + T)
+    // Then CreateSubstitutionMap decides T maps to a constant, but leaving
+    // another (0+T).
+    // When we go to simplify (0 + T) will still be in the simplify cache, so
+    // will be mapped to T.
+    // But it shouldn't be T, it should be a constant.
+    // Applying the substitution map fixes this case.
+    //
+    simplification.add("simplify", [&](ASTNode n) {
+      ASTNode result;
+      if (bm->UserFlags.simplify_to_constants_only)
       {
-        inputToSat = pe->topLevel(inputToSat);
-        bm->ASTNodeStats(pe_message.c_str(), inputToSat);
-      }
+        auto constants = simp->FindConsts_TopLevel(n, false);
 
+        if (bm->UserFlags.stats_flag)
+          cerr << "constants found:" << constants.size() << endl;
 
-      // Imagine:
-      // The simplifier simplifies (0 + T) to T
-      // Then bvsolve introduces (0 + T)
-      // Then CreateSubstitutionMap decides T maps to a constant, but leaving
-      // another (0+T).
-      // When we go to simplify (0 + T) will still be in the simplify cache, so
-      // will be mapped to T.
-      // But it shouldn't be T, it should be a constant.
-      // Applying the substitution map fixes this case.
-      //
+        ASTNodeMap cache;
+        result = stp::SubstitutionMap::replace(n, constants, cache,
+                                               bm->defaultNodeFactory);
+      }
+      else
+        result = simp->SimplifyFormula_TopLevel(n, false);
 
-      
-      if (bm->UserFlags.simplify_to_constants_only)
-      {    
-          auto constants = simp->FindConsts_TopLevel(inputToSat, false);
+      bm->ASTNodeStats(size_inc_message.c_str(), result);
+      return result;
+    });
 
-          if (bm->UserFlags.stats_flag)
-                cerr << "constants found:" << constants.size() << endl;
+    if (bm->UserFlags.wordlevel_solve_flag)
+      simplification.add("bv-solver", [&](ASTNode n) {
+        ASTNode result = bvSolver->TopLevelBVSolve(
+            n, !bm->UserFlags.simplify_to_constants_only);
+        bm->ASTNodeStats(bitvec_message.c_str(), result);
+        return result;
+      });
+  }
 
-          ASTNodeMap cache;
-          inputToSat = stp::SubstitutionMap::replace(inputToSat, constants, cache, bm->defaultNodeFactory);
-      }
-      else
-        inputToSat = simp->SimplifyFormula_TopLevel(inputToSat, false);
-      
-      bm->ASTNodeStats(size_inc_message.c_str(), inputToSat);
+  inputToSat = simplification.fixedPoint(inputToSat, [&]() {
+    return !bm->soft_timeout_expired && withinMemoryBudget();
+  });
+  if (simplification.interrupted())
+    return SOLVER_TIMEOUT;
 
-      if (bm->UserFlags.wordlevel_solve_flag)
-      {
-        inputToSat = bvSolver->TopLevelBVSolve(inputToSat, !bm->UserFlags.simplify_to_constants_only);
-        bm->ASTNodeStats(bitvec_message.c_str(), inputToSat);
-      }
-    }
-  } while (tmp_inputToSAT != inputToSat);
+  if (bm->UserFlags.stats_flag)
+    simplification.printStats(cerr);
 
   if (bm->UserFlags.bitConstantProp_flag)
   {
@@ -556,7 +695,7 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
   // measure whether the number of AIG nodes is smaller. The difficulty score
   // is sometimes completelywrong, the sage-app7 are the motivating examples.
   // The other way to improve it would be to fix the difficulty scorer!
-  if (!worse && (bitblasted_difficulty != -1))
+  if (!worse && (bitblasted_difficulty != -1) && !bm->memoryUsage.tight())
   {
     BBNodeManagerAIG bitblast_nodemgr;
     BitBlaster<BBNodeAIG, BBNodeManagerAIG> bb(
@@ -576,8 +715,7 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
   }
 
   bool optimize_enabled = bm->UserFlags.optimize_flag;
-  if (worse && (!arrayops || bm->UserFlags.array_difficulty_reversion) &&
-      bm->UserFlags.difficulty_reversion)
+  if (worse && revert && bm->UserFlags.difficulty_reversion)
   {
     // If the simplified problem is harder, than the
     // initial problem we revert back to the initial
@@ -585,22 +723,10 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
 
     if (bm->UserFlags.stats_flag)
       cerr << "simplification made the problem harder, reverting." << endl;
-    inputToSat = revert->toRevertTo;
-
-    // I do this to clear the substitution/solver map.
-    // Not sure what would happen if it contained simplifications
-    // that haven't been applied.
-    simp->ClearAllTables();
 
-    simp->Return_SolverMap()->insert(revert->initialSolverMap.begin(),
-                                     revert->initialSolverMap.end());
-    revert->initialSolverMap.clear();
-
-    // Copy back what we knew about arrays at the start..
-    arrayTransformer->arrayToIndexToRead.clear();
-    arrayTransformer->arrayToIndexToRead.insert(
-        revert->backup_arrayToIndexToRead.begin(),
-        revert->backup_arrayToIndexToRead.end());
+    // Undoes the substitutions and the array reads, and drops the
+    // simplifier's caches.
+    inputToSat = revert->revert();
 
     // The arrayTransformer calls simplify. We don't want
     // it to put back in all the bad simplifications.
@@ -608,6 +734,16 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
   }
   revert.reset(NULL);
 
+  if (!bm->UserFlags.simplified_snapshot_file.empty())
+  {
+    Snapshot snapshot;
+    snapshot.roots.push_back(inputToSat);
+    snapshot.roots.push_back(bm->ASTFalse);
+    snapshot.solverMap = *simp->Return_SolverMap();
+    if (!saveSnapshot(snapshot, bm->UserFlags.simplified_snapshot_file))
+      FatalError("Can't write the simplified snapshot");
+  }
+
   inputToSat = arrayTransformer->TransformFormula_TopLevel(inputToSat);
   bm->ASTNodeStats("after transformation: ", inputToSat);
   bm->TermsAlreadySeenMap_Clear();
@@ -635,7 +771,8 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
   std::unique_ptr<simplifier::constantBitP::ConstantBitPropagation> cleaner;
 
   //TODO should be replaced by the upwards cbitp cache.
-  if (bm->UserFlags.bitConstantProp_flag)
+  // The selectors mustn't be fixed when bit-blasting, they must be in the CNF.
+  if (bm->UserFlags.bitConstantProp_flag && selectors.empty())
   {
     bm->GetRunTimes()->start(RunTimes::ConstantBitPropagation);
     cb = new simplifier::constantBitP::ConstantBitPropagation(
@@ -649,26 +786,54 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
       inputToSat = bm->ASTFalse;
   }
 
+  // Only the AIG path tells the SAT solver the assumptions.
   ToSATAIG toSATAIG(bm, cb, arrayTransformer);
-  ToSATBase* satBase = bm->UserFlags.traditional_cnf ? tosat : &toSATAIG;
+  toSATAIG.assumptions = selectors;
+  ToSATBase* satBase = (bm->UserFlags.traditional_cnf && selectors.empty())
+                           ? tosat
+                           : &toSATAIG;
 
-  if (bm->soft_timeout_expired)
+  if (bm->soft_timeout_expired || !withinMemoryBudget())
     return SOLVER_TIMEOUT;
 
   NewSolver.enableRefinement(maybeRefinement);
 
   if (bm->UserFlags.stats_flag)
+  {
     bm->print_stats();
+    bm->memoryUsage.print(cerr);
+  }
+
+  // Satisfiable queries are often easy enough to find a model for without
+  // bit-blasting.
+  if (bm->UserFlags.local_search_ms > 0 && !maybeRefinement &&
+      inputToSat != bm->ASTFalse)
+  {
+    res = Ctr_Example->LocalSearch_ResultCheck(
+        inputToSat, original_input, (cb != NULL) ? cb->fixedMap : NULL);
+    if (SOLVER_INVALID == res)
+    {
+      if (bm->UserFlags.stats_flag)
+        bm->memoryUsage.print(cerr);
+
+      CountersAndStats("print_func_stats", bm);
+      return res;
+    }
+  }
 
   // If it doesn't contain array operations, use ABC's CNF generation.
   res = Ctr_Example->CallSAT_ResultCheck(NewSolver, inputToSat, original_input,
                                          satBase, maybeRefinement);
+  refuted = toSATAIG.failed;
 
   if (bm->soft_timeout_expired)
   {
     if (toSATAIG.cbIsDestructed())
       cleaner.release();
 
+    if (bm->UserFlags.stats_flag)
+      bm->memoryUsage.print(cerr);
+
     return SOLVER_TIMEOUT;
   }
 
@@ -679,6 +844,9 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
     if (toSATAIG.cbIsDestructed())
       cleaner.release();
 
+    if (bm->UserFlags.stats_flag)
+      bm->memoryUsage.print(cerr);
+
     CountersAndStats("print_func_stats", bm);
     return res;
   }
@@ -687,13 +855,21 @@ STP::TopLevelSTPAux(SATSolver& NewSolver, const ASTNode& original_input)
   assert(arrayops);
   assert(!bm->UserFlags.ackermannisation); // Refinement must be enabled too.
 
-  res = Ctr_Example->SATBased_ArrayReadRefinement(NewSolver, original_input,
-                                                  satBase);
+  if (bm->UserFlags.array_lemmas_on_demand)
+    res = Ctr_Example->LemmaOnDemand_ArrayRefinement(NewSolver, original_input,
+                                                     satBase);
+  else
+    res = Ctr_Example->SATBased_ArrayReadRefinement(NewSolver, original_input,
+                                                    satBase);
+  refuted = toSATAIG.failed;
   if (SOLVER_UNDECIDED != res)
   {
     if (toSATAIG.cbIsDestructed())
       cleaner.release();
 
+    if (bm->UserFlags.stats_flag)
+      bm->memoryUsage.print(cerr);
+
     CountersAndStats("print_func_stats", bm);
     return res;
   }
@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include "stp/Printer/SMTLIBPrinter.h"
 #include "stp/Util/NodeIterator.h"
 #include <cmath>
+#include <cstring>
 #include <cstdint>
 
 namespace stp
@@ -36,9 +37,7 @@ using std::endl;
 
 ASTInterior* STPMgr::LookupOrCreateInterior(ASTInterior* n_ptr)
 {
-  ASTInteriorSet::iterator it = _interior_unique_table.find(n_ptr);
-  if (it == _interior_unique_table.end())
-  {
+  ASTInterior* result = _interior_unique_table.lookupOrCreate(n_ptr, [&]() {
     // Make a new ASTInterior node We want (NOT alpha) always to
     // have alpha.nodenum + 1.
     if (n_ptr->GetKind() == NOT)
@@ -48,15 +47,13 @@ ASTInterior* STPMgr::LookupOrCreateInterior(ASTInterior* n_ptr)
       // which could duplicate the next newNodeNum().
       assert(n_ptr->GetChildren()[0].GetKind() != NOT);
     }
-
-    std::pair<ASTInteriorSet::const_iterator, bool> p =
-        _interior_unique_table.insert(n_ptr);
-    return *(p.first);
-  }
+    return n_ptr;
+  });
 
   // Delete the temporary node, and return the found node.
-  delete n_ptr;
-  return *it;
+  if (result != n_ptr)
+    delete n_ptr;
+  return result;
 }
 
 ASTInterior* STPMgr::CreateInteriorNode(Kind /*kind*/,
@@ -109,6 +106,21 @@ ASTNode STPMgr::LookupOrCreateSymbol(const char* const name)
   return n;
 }
 
+// The widths are given to a new symbol before other threads can see it.
+ASTNode STPMgr::LookupOrCreateSymbol(const char* const name,
+                                     unsigned indexWidth, unsigned valueWidth)
+{
+  ASTSymbol temp_sym(this, name);
+  temp_sym._index_width = indexWidth;
+  temp_sym._value_width = valueWidth;
+  ASTNode n(LookupOrCreateSymbol(temp_sym));
+  if (n.GetIndexWidth() != indexWidth)
+    n.SetIndexWidth(indexWidth);
+  if (n.GetValueWidth() != valueWidth)
+    n.SetValueWidth(valueWidth);
+  return n;
+}
+
 // FIXME: _name is now a constant field, and this assigns to it
 // because it tries not to copy the string unless it needs to.  How
 // do I avoid copying children in ASTInterior?  Perhaps I don't!
@@ -127,34 +139,21 @@ ASTSymbol* STPMgr::LookupOrCreateSymbol(ASTSymbol& s)
   // return s_ptr;
   // Do an explicit lookup to see if we need to create a copy of the
   // string.
-  ASTSymbolSet::const_iterator it = _symbol_unique_table.find(s_ptr);
-  if (it == _symbol_unique_table.end())
-  {
+  return _symbol_unique_table.lookupOrCreate(s_ptr, [&]() {
     // Make a new ASTSymbol with duplicated string (can't assign
-    // _name because it's const).  Can cast the iterator to
-    // non-const -- carefully.
-    // std::string strname(s_ptr->GetName());
+    // _name because it's const).
     ASTSymbol* s_ptr1 = new ASTSymbol(this, strdup(s_ptr->GetName()));
     s_ptr1->_value_width = s_ptr->_value_width;
-    std::pair<ASTSymbolSet::const_iterator, bool> p =
-        _symbol_unique_table.insert(s_ptr1);
-    return *p.first;
-  }
-  else
-  {
-    // return symbol found in table.
-    return *it;
-  }
+    s_ptr1->_index_width = s_ptr->_index_width;
+    return s_ptr1;
+  });
 }
 
 bool STPMgr::LookupSymbol(ASTSymbol& s)
 {
   ASTSymbol* s_ptr = &s; // it's a temporary key.
 
-  if (_symbol_unique_table.find(s_ptr) == _symbol_unique_table.end())
-    return false;
-  else
-    return true;
+  return _symbol_unique_table.find(s_ptr) != NULL;
 }
 
 bool STPMgr::LookupSymbol(const char* const name)
@@ -162,19 +161,16 @@ bool STPMgr::LookupSymbol(const char* const name)
   ASTSymbol s(this, name);
   ASTSymbol* s_ptr = &s; // it's a temporary key.
 
-  if (_symbol_unique_table.find(s_ptr) == _symbol_unique_table.end())
-    return false;
-  else
-    return true;
+  return _symbol_unique_table.find(s_ptr) != NULL;
 }
 
 bool STPMgr::LookupSymbol(const char* const name, ASTNode& output)
 {
   ASTSymbol temp_sym(this, name);
-  ASTSymbolSet::const_iterator it = _symbol_unique_table.find(&temp_sym);
-  if (it != _symbol_unique_table.end())
+  ASTSymbol* found = _symbol_unique_table.find(&temp_sym);
+  if (found != NULL)
   {
-    output = ASTNode(*it);
+    output = ASTNode(found);
     return true;
   }
   return false;
@@ -190,11 +186,7 @@ ASTNode STPMgr::CreateBVConst(unsigned int width,
                "unsigned long long of width: ",
                ASTUndefined, width);
 
-  // We create a single bvconst that gets reused.
-  if (NULL == CreateBVConstVal)
-    CreateBVConstVal = CONSTANTBV::BitVector_Create(65, true);
-  CreateBVConstVal = CONSTANTBV::BitVector_Resize(CreateBVConstVal, width);
-  CONSTANTBV::BitVector_Empty(CreateBVConstVal);
+  CBV value = scratchBitVector(width);
 
   unsigned long c_val = (~((unsigned long)0)) & bvconst;
   unsigned int copied = 0;
@@ -211,8 +203,7 @@ ASTNode STPMgr::CreateBVConst(unsigned int width,
   const int shift_amount = sizeof(unsigned long) * 8;
   while (copied + shift_amount < width)
   {
-    CONSTANTBV::BitVector_Chunk_Store(CreateBVConstVal, shift_amount, copied,
-                                      c_val);
+    CONSTANTBV::BitVector_Chunk_Store(value, shift_amount, copied, c_val);
     if (shift_amount < (sizeof(bvconst) * 8))
     {
       bvconst >>= shift_amount;
@@ -224,11 +215,12 @@ ASTNode STPMgr::CreateBVConst(unsigned int width,
     c_val = (~((unsigned long)0)) & bvconst;
     copied += shift_amount;
   }
-  CONSTANTBV::BitVector_Chunk_Store(CreateBVConstVal, width - copied, copied,
-                                    c_val);
+  CONSTANTBV::BitVector_Chunk_Store(value, width - copied, copied, c_val);
 
-  ASTBVConst temp_bvconst(this, CreateBVConstVal, width, true);
-  return ASTNode(LookupOrCreateBVConst(temp_bvconst));
+  ASTBVConst temp_bvconst(this, value, width, true);
+  ASTNode n(LookupOrCreateBVConst(temp_bvconst));
+  releaseScratch(value);
+  return n;
 }
 
 ASTNode STPMgr::charToASTNode(unsigned char* strval, int base, int bit_width)
@@ -244,24 +236,20 @@ ASTNode STPMgr::charToASTNode(unsigned char* strval, int base, int bit_width)
   }
   assert(bit_width > 0);
 
-  // We create a single bvconst that gets reused.
-  if (NULL == CreateBVConstVal)
-    CreateBVConstVal = CONSTANTBV::BitVector_Create(65, true);
-  CreateBVConstVal = CONSTANTBV::BitVector_Resize(CreateBVConstVal, bit_width);
-  CONSTANTBV::BitVector_Empty(CreateBVConstVal);
+  CBV value = scratchBitVector(bit_width);
 
   CONSTANTBV::ErrCode e;
   if (2 == base)
   {
-    e = CONSTANTBV::BitVector_from_Bin(CreateBVConstVal, strval);
+    e = CONSTANTBV::BitVector_from_Bin(value, strval);
   }
   else if (10 == base)
   {
-    e = CONSTANTBV::BitVector_from_Dec(CreateBVConstVal, strval);
+    e = CONSTANTBV::BitVector_from_Dec(value, strval);
   }
   else // (16 == base)
   {
-    e = CONSTANTBV::BitVector_from_Hex(CreateBVConstVal, strval);
+    e = CONSTANTBV::BitVector_from_Hex(value, strval);
   }
 
   if (0 != e)
@@ -270,11 +258,31 @@ ASTNode STPMgr::charToASTNode(unsigned char* strval, int base, int bit_width)
     FatalError("", ASTUndefined);
   }
 
-  ASTBVConst temp_bvconst(this, CreateBVConstVal, bit_width, true);
+  ASTBVConst temp_bvconst(this, value, bit_width, true);
   ASTNode n(LookupOrCreateBVConst(temp_bvconst));
+  releaseScratch(value);
   return n;
 }
 
+// Outside of concurrent mode a single bit-vector gets reused.
+CBV STPMgr::scratchBitVector(unsigned width)
+{
+  if (concurrent)
+    return CONSTANTBV::BitVector_Create(width, true);
+
+  if (NULL == CreateBVConstVal)
+    CreateBVConstVal = CONSTANTBV::BitVector_Create(65, true);
+  CreateBVConstVal = CONSTANTBV::BitVector_Resize(CreateBVConstVal, width);
+  CONSTANTBV::BitVector_Empty(CreateBVConstVal);
+  return CreateBVConstVal;
+}
+
+void STPMgr::releaseScratch(CBV bv)
+{
+  if (bv != CreateBVConstVal)
+    CONSTANTBV::BitVector_Destroy(bv);
+}
+
 ASTNode STPMgr::CreateBVConst(string strval, int base, int bit_width)
 {
   if (bit_width <= 0)
@@ -388,23 +396,9 @@ ASTBVConst* STPMgr::LookupOrCreateBVConst(ASTBVConst& s)
 {
   ASTBVConst* s_ptr = &s; // it's a temporary key.
 
-  // Do an explicit lookup to see if we need to create a copy of the string.
-  ASTBVConstSet::const_iterator it;
-  if ((it = _bvconst_unique_table.find(s_ptr)) == _bvconst_unique_table.end())
-  {
-    // Make a new ASTBVConst with duplicated constant.
-
-    ASTBVConst* s_copy = new ASTBVConst(s);
-
-    std::pair<ASTBVConstSet::const_iterator, bool> p =
-        _bvconst_unique_table.insert(s_copy);
-    return *p.first;
-  }
-  else
-  {
-    // return constant found in table.
-    return *it;
-  }
+  // Make a new ASTBVConst with duplicated constant if it's not found.
+  return _bvconst_unique_table.lookupOrCreate(
+      s_ptr, [&]() { return new ASTBVConst(s); });
 }
 
 ////////////////////////////////////////////////////////////////
@@ -514,6 +508,29 @@ const ASTVec STPMgr::GetAsserts(void)
 }
 
 // prints statistics for the ASTNode
+size_t STPMgr::memoryUsed() const
+{
+  size_t result = 0;
+  _interior_unique_table.forEach([&](const ASTInterior* n) {
+    result +=
+        sizeof(ASTInterior) + n->GetChildren().capacity() * sizeof(ASTNode);
+  });
+
+  _symbol_unique_table.forEach([&](const ASTSymbol* n) {
+    result += sizeof(ASTSymbol) + strlen(n->GetName()) + 1;
+  });
+
+  _bvconst_unique_table.forEach([&](const ASTBVConst* n) {
+    result += sizeof(ASTBVConst) + (n->getValueWidth() + 31) / 32 * 4;
+  });
+
+  result += (_interior_unique_table.bucket_count() +
+             _symbol_unique_table.bucket_count() +
+             _bvconst_unique_table.bucket_count()) *
+            sizeof(void*);
+  return result;
+}
+
 void STPMgr::ASTNodeStats(const char* c, const ASTNode& a)
 {
   if (!UserFlags.stats_flag)
@@ -599,6 +616,57 @@ ASTNode STPMgr::NewParameterized_BooleanVar(const ASTNode& var,
   return CurrentSymbol;
 }
 
+void STPMgr::beginConcurrent(unsigned threads)
+{
+  assert(!concurrent);
+
+  // The constant caches are filled lazily, so fill them now.
+  CreateZeroConst(1);
+  CreateOneConst(1);
+  CreateMaxConst(1);
+
+  // About four shards per thread keeps the contention low.
+  unsigned log2 = 0;
+  while (log2 < 10 && (1u << log2) < 4 * threads)
+    log2++;
+  _interior_unique_table.setShards(log2);
+  _symbol_unique_table.setShards(log2);
+  _bvconst_unique_table.setShards(log2);
+
+  sharedNodeNum = ASTInternal::node_uid_cntr;
+  concurrent = true;
+}
+
+// Nodes without references are in no other node's children, so deleting
+// them only deletes nodes that aren't collected here.
+void STPMgr::sweepUnreferenced()
+{
+  vector<ASTInternal*> dead;
+  auto collect = [&](ASTInternal* n) {
+    if (n->_ref_count.load(std::memory_order_relaxed) == 0)
+      dead.push_back(n);
+  };
+  _interior_unique_table.forEach(collect);
+  _symbol_unique_table.forEach(collect);
+  _bvconst_unique_table.forEach(collect);
+
+  for (ASTInternal* n : dead)
+    n->CleanUp();
+}
+
+void STPMgr::endConcurrent()
+{
+  assert(concurrent);
+  concurrent = false;
+  ASTInternal::node_uid_cntr = sharedNodeNum;
+
+  _interior_unique_table.setShards(0);
+  _symbol_unique_table.setShards(0);
+  _bvconst_unique_table.setShards(0);
+
+  sweepUnreferenced();
+}
+
 // If ASTNode remain with references (somewhere), this will segfault.
 STPMgr::~STPMgr()
 {
@@ -0,0 +1,442 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/STPManager/Snapshot.h"
+#include "extlib-constbv/constantbv.h"
+#include "stp/STPManager/STPManager.h"
+#include <cstring>
+#include <fstream>
+
+#if !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(_MSC_VER)
+#define SNAPSHOT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stp
+{
+
+namespace
+{
+const char magic[8] = {'S', 'T', 'P', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t version = 1;
+
+// Magic, version, kinds, then the six counts.
+const size_t headerBytes = sizeof(magic) + 8 * 4;
+
+const unsigned numberOfKinds = BOOLEAN + 1;
+
+// A hash of the kind names, so that a snapshot isn't read by a build that
+// numbers the kinds differently.
+uint32_t kindsHash()
+{
+  uint32_t h = 2166136261u;
+  for (unsigned k = 0; k < numberOfKinds; k++)
+  {
+    for (const char* c = _kind_names[k]; *c != '\0'; c++)
+      h = (h ^ (unsigned char)*c) * 16777619u;
+    h = (h ^ 0xff) * 16777619u;
+  }
+  return h;
+}
+
+void put(std::string& out, uint32_t v)
+{
+  const char bytes[4] = {(char)(v & 0xff), (char)((v >> 8) & 0xff),
+                         (char)((v >> 16) & 0xff), (char)(v >> 24)};
+  out.append(bytes, 4);
+}
+
+uint32_t get(const unsigned char* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+typedef std::unordered_map<ASTNode, uint32_t, ASTNode::ASTNodeHasher,
+                           ASTNode::ASTNodeEqual>
+    NodeNumbers;
+
+// Numbers the nodes reachable from "n" that aren't numbered yet, children
+// before parents.
+void number(const ASTNode& n, NodeNumbers& numbers, ASTVec& order)
+{
+  if (numbers.find(n) != numbers.end())
+    return;
+
+  std::vector<std::pair<ASTNode, size_t>> stack;
+  stack.push_back(std::make_pair(n, 0));
+  while (!stack.empty())
+  {
+    const ASTNode node = stack.back().first;
+    const size_t next = stack.back().second;
+    if (next < node.Degree())
+    {
+      stack.back().second++;
+      const ASTNode& child = node.GetChildren()[next];
+      if (numbers.find(child) == numbers.end())
+        stack.push_back(std::make_pair(child, 0));
+      continue;
+    }
+    stack.pop_back();
+    if (numbers.insert(std::make_pair(node, (uint32_t)order.size())).second)
+      order.push_back(node);
+  }
+}
+
+// Size in 32-bit words of a constant's value.
+uint32_t wordsOf(const ASTNode& n)
+{
+  return size_(n.GetBVConst());
+}
+
+} // namespace
+
+std::string snapshotBytes(const Snapshot& snapshot)
+{
+  NodeNumbers numbers;
+  ASTVec order;
+  for (const ASTNode& r : snapshot.roots)
+    number(r, numbers, order);
+  for (const auto& entry : snapshot.solverMap)
+  {
+    number(entry.first, numbers, order);
+    number(entry.second, numbers, order);
+  }
+
+  uint32_t children = 0, words = 0, nameBytes = 0;
+  for (const ASTNode& n : order)
+  {
+    if (n.GetKind() == SYMBOL)
+      nameBytes += strlen(n.GetName());
+    else if (n.GetKind() == BVCONST)
+      words += wordsOf(n);
+    else
+      children += n.Degree();
+  }
+
+  std::string out;
+  out.reserve(headerBytes +
+              4 * (4 * order.size() + children + words +
+                   snapshot.roots.size() + 2 * snapshot.solverMap.size()) +
+              nameBytes);
+  out.append(magic, sizeof(magic));
+  put(out, version);
+  put(out, kindsHash());
+  put(out, order.size());
+  put(out, children);
+  put(out, words);
+  put(out, snapshot.roots.size());
+  put(out, snapshot.solverMap.size());
+  put(out, nameBytes);
+
+  for (const ASTNode& n : order)
+  {
+    put(out, n.GetKind());
+    put(out, n.GetValueWidth());
+    put(out, n.GetIndexWidth());
+    if (n.GetKind() == SYMBOL)
+      put(out, strlen(n.GetName()));
+    else if (n.GetKind() == BVCONST)
+      put(out, wordsOf(n));
+    else
+      put(out, n.Degree());
+  }
+
+  for (const ASTNode& n : order)
+    if (n.GetKind() != SYMBOL && n.GetKind() != BVCONST)
+      for (const ASTNode& c : n.GetChildren())
+        put(out, numbers[c]);
+
+  for (const ASTNode& n : order)
+    if (n.GetKind() == BVCONST)
+    {
+      const CBV cbv = n.GetBVConst();
+      for (uint32_t i = 0; i < wordsOf(n); i++)
+        put(out, cbv[i]);
+    }
+
+  for (const ASTNode& r : snapshot.roots)
+    put(out, numbers[r]);
+  for (const auto& entry : snapshot.solverMap)
+  {
+    put(out, numbers[entry.first]);
+    put(out, numbers[entry.second]);
+  }
+
+  for (const ASTNode& n : order)
+    if (n.GetKind() == SYMBOL)
+      out.append(n.GetName());
+
+  return out;
+}
+
+bool saveSnapshot(const Snapshot& snapshot, const std::string& filename)
+{
+  const std::string bytes = snapshotBytes(snapshot);
+  std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file)
+    return false;
+  file.write(bytes.data(), bytes.size());
+  file.close();
+  return !file.fail();
+}
+
+bool loadSnapshot(STPMgr* bm, const char* data, size_t size,
+                  Snapshot& snapshot, std::string& error)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  if (size < headerBytes || memcmp(p, magic, sizeof(magic)) != 0)
+  {
+    error = "not a snapshot";
+    return false;
+  }
+  p += sizeof(magic);
+  if (get(p) != version)
+  {
+    error = "unsupported snapshot version";
+    return false;
+  }
+  if (get(p + 4) != kindsHash())
+  {
+    error = "snapshot was written by a build with different node kinds";
+    return false;
+  }
+
+  const uint64_t nodeCount = get(p + 8);
+  const uint64_t childCount = get(p + 12);
+  const uint64_t wordCount = get(p + 16);
+  const uint64_t rootCount = get(p + 20);
+  const uint64_t mapCount = get(p + 24);
+  const uint64_t nameBytes = get(p + 28);
+  p += 32;
+
+  if (headerBytes + 4 * (4 * nodeCount + childCount + wordCount + rootCount +
+                         2 * mapCount) +
+          nameBytes !=
+      size)
+  {
+    error = "snapshot is truncated";
+    return false;
+  }
+
+  const unsigned char* records = p;
+  const unsigned char* childIds = records + 16 * nodeCount;
+  const unsigned char* words = childIds + 4 * childCount;
+  const unsigned char* rootIds = words + 4 * wordCount;
+  const unsigned char* mapIds = rootIds + 4 * rootCount;
+  const char* names = reinterpret_cast<const char*>(mapIds + 8 * mapCount);
+
+  uint64_t childrenUsed = 0, wordsUsed = 0, namesUsed = 0;
+  NodeFactory* nf = bm->hashingNodeFactory;
+  ASTVec nodes;
+  nodes.reserve(nodeCount);
+  ASTVec children;
+  std::string name;
+
+  for (uint64_t i = 0; i < nodeCount; i++, records += 16)
+  {
+    const uint32_t k = get(records);
+    const uint32_t valueWidth = get(records + 4);
+    const uint32_t indexWidth = get(records + 8);
+    const uint32_t count = get(records + 12);
+    if (k >= numberOfKinds)
+    {
+      error = "snapshot has an unknown node kind";
+      return false;
+    }
+    const Kind kind = (Kind)k;
+
+    if (kind == SYMBOL)
+    {
+      if (count > nameBytes - namesUsed)
+      {
+        error = "snapshot has a bad symbol name";
+        return false;
+      }
+      name.assign(names + namesUsed, count);
+      namesUsed += count;
+      nodes.push_back(nf->CreateSymbol(name.c_str(), indexWidth, valueWidth));
+      continue;
+    }
+
+    if (kind == BVCONST)
+    {
+      if (valueWidth == 0 || count != (valueWidth + 31) / 32 ||
+          count > wordCount - wordsUsed)
+      {
+        error = "snapshot has a bad constant";
+        return false;
+      }
+      CBV cbv = CONSTANTBV::BitVector_Create(valueWidth, true);
+      for (uint32_t w = 0; w < count; w++)
+        cbv[w] = get(words + 4 * (wordsUsed + w));
+      cbv[count - 1] &= mask_(cbv);
+      wordsUsed += count;
+      nodes.push_back(bm->CreateBVConst(cbv, valueWidth));
+      continue;
+    }
+
+    if (kind == TRUE || kind == FALSE)
+    {
+      nodes.push_back(kind == TRUE ? bm->ASTTrue : bm->ASTFalse);
+      continue;
+    }
+
+    if (count > childCount - childrenUsed)
+    {
+      error = "snapshot has too many children";
+      return false;
+    }
+    children.clear();
+    for (uint32_t c = 0; c < count; c++)
+    {
+      const uint32_t id = get(childIds + 4 * (childrenUsed + c));
+      if (id >= i)
+      {
+        error = "snapshot nodes are out of order";
+        return false;
+      }
+      children.push_back(nodes[id]);
+    }
+    childrenUsed += count;
+
+    const bool formula = (valueWidth == 0 && indexWidth == 0);
+    if (count == 0 || (formula ? !is_Form_kind(kind) : !is_Term_kind(kind)))
+    {
+      error = "snapshot has a malformed node";
+      return false;
+    }
+
+    if (formula)
+      nodes.push_back(nf->CreateNode(kind, children));
+    else if (indexWidth == 0)
+      nodes.push_back(nf->CreateTerm(kind, valueWidth, children));
+    else
+      nodes.push_back(
+          nf->CreateArrayTerm(kind, indexWidth, valueWidth, children));
+  }
+
+  if (childrenUsed != childCount || wordsUsed != wordCount ||
+      namesUsed != nameBytes)
+  {
+    error = "snapshot has unused data";
+    return false;
+  }
+
+  snapshot.roots.clear();
+  snapshot.solverMap.clear();
+  for (uint64_t i = 0; i < rootCount + 2 * mapCount; i++)
+    if (get(rootIds + 4 * i) >= nodeCount)
+    {
+      error = "snapshot refers to a missing node";
+      return false;
+    }
+
+  for (uint64_t i = 0; i < rootCount; i++)
+    snapshot.roots.push_back(nodes[get(rootIds + 4 * i)]);
+  for (uint64_t i = 0; i < mapCount; i++)
+    snapshot.solverMap[nodes[get(mapIds + 8 * i)]] =
+        nodes[get(mapIds + 8 * i + 4)];
+
+  return true;
+}
+
+bool loadSnapshot(STPMgr* bm, const std::string& filename, Snapshot& snapshot,
+                  std::string& error)
+{
+#ifdef SNAPSHOT_MMAP
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    error = "can't open " + filename;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    error = "can't read " + filename;
+    return false;
+  }
+  const size_t size = st.st_size;
+  if (size == 0)
+  {
+    close(fd);
+    error = "not a snapshot";
+    return false;
+  }
+  void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    error = "can't read " + filename;
+    return false;
+  }
+  const bool result =
+      loadSnapshot(bm, static_cast<const char*>(data), size, snapshot, error);
+  munmap(data, size);
+  return result;
+#else
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  if (!file)
+  {
+    error = "can't open " + filename;
+    return false;
+  }
+  const std::string bytes((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+  return loadSnapshot(bm, bytes.data(), bytes.size(), snapshot, error);
+#endif
+}
+
+bool isSnapshot(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  char start[sizeof(magic)];
+  return file.read(start, sizeof(start)) &&
+         memcmp(start, magic, sizeof(magic)) == 0;
+}
+
+bool isSnapshot(const char* data, size_t size)
+{
+  return size >= sizeof(magic) && memcmp(data, magic, sizeof(magic)) == 0;
+}
+
+ASTNode substitutionsAsFormula(STPMgr* bm, const ASTNodeMap& solverMap)
+{
+  ASTVec equalities;
+  for (const auto& entry : solverMap)
+    equalities.push_back(bm->CreateNode(
+        entry.first.GetType() == BOOLEAN_TYPE ? IFF : EQ, entry.first,
+        entry.second));
+
+  if (equalities.empty())
+    return bm->ASTTrue;
+  if (equalities.size() == 1)
+    return equalities[0];
+  return bm->CreateNode(AND, equalities);
+}
+
+} // namespace stp
@@ -67,6 +67,11 @@ void CryptoMiniSat5::setMaxTime(int64_t _max_time)
   max_time = _max_time;
 }
 
+void CryptoMiniSat5::interrupt()
+{
+  s->interrupt_asap();
+}
+
 bool CryptoMiniSat5::addClause(
     const vec_literals& ps) // Add a clause to the solver.
 {
@@ -83,6 +88,32 @@ bool CryptoMiniSat5::addClause(
   return s->add_clause(real_temp_cl);
 }
 
+bool CryptoMiniSat5::addClauses(const int* lits, const int* offsets, size_t n)
+{
+  vector<CMSat::Lit>& real_temp_cl = *(vector<CMSat::Lit>*)temp_cl;
+  for (size_t i = 0; i < n; i++)
+  {
+    real_temp_cl.clear();
+    for (int j = offsets[i]; j < offsets[i + 1]; j++)
+      real_temp_cl.push_back(CMSat::Lit(lits[j] >> 1, lits[j] & 1));
+    if (!s->add_clause(real_temp_cl))
+      return false;
+  }
+  return true;
+}
+
+bool CryptoMiniSat5::addXorClause(const vector<uint32_t>& vars, bool rhs)
+{
+  if (!gauss)
+  {
+    s->set_allow_otf_gauss();
+    gauss = true;
+  }
+
+  const vector<unsigned> v(vars.begin(), vars.end());
+  return s->add_xor_clause(v, rhs);
+}
+
 bool CryptoMiniSat5::okay()
     const // FALSE means solver is in a conflicting state
 {
@@ -90,6 +121,12 @@ bool CryptoMiniSat5::okay()
 }
 
 bool CryptoMiniSat5::solve(bool& timeout_expired) // Search without assumptions.
+{
+  return solveAssuming(timeout_expired, vec_literals());
+}
+
+bool CryptoMiniSat5::solveAssuming(bool& timeout_expired,
+                                   const vec_literals& assumptions)
 {
   if (max_confl > 0) {
      s->set_max_confl(std::max(max_confl - s->get_sum_conflicts(), (uint64_t)1));
@@ -104,7 +141,11 @@ bool CryptoMiniSat5::solve(bool& timeout_expired) // Search without assumptions.
      s->set_max_time(max_time);
   }
 
-  CMSat::lbool ret = s->solve();
+  vector<CMSat::Lit> assumps;
+  for (int i = 0; i < assumptions.size(); i++)
+    assumps.push_back(CMSat::Lit(var(assumptions[i]), sign(assumptions[i])));
+
+  CMSat::lbool ret = s->solve(&assumps);
   if (ret == CMSat::l_Undef)
   {
     timeout_expired = true;
@@ -112,6 +153,14 @@ bool CryptoMiniSat5::solve(bool& timeout_expired) // Search without assumptions.
   return ret == CMSat::l_True;
 }
 
+// The conflict holds the negations of the assumptions it refuted.
+void CryptoMiniSat5::failedAssumptions(std::vector<uint32_t>& vars) const
+{
+  vars.clear();
+  for (CMSat::Lit l : s->get_conflict())
+    vars.push_back(l.var());
+}
+
 uint8_t CryptoMiniSat5::modelValue(uint32_t x) const
 {
   return (s->get_model().at(x) == CMSat::l_True);
@@ -123,6 +172,11 @@ uint32_t CryptoMiniSat5::newVar()
   return s->nVars() - 1;
 }
 
+void CryptoMiniSat5::newVars(uint32_t n)
+{
+  s->new_vars(n);
+}
+
 void CryptoMiniSat5::setVerbosity(int v)
 {
   s->set_verbosity(v);
@@ -0,0 +1,265 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/Sat/CubeAndConquer.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <thread>
+
+namespace stp
+{
+
+CubeAndConquer::CubeAndConquer(Factory factory_, unsigned threads_,
+                               unsigned depth_)
+    : factory(factory_), threads(std::max(threads_, 1u)),
+      depth(std::min(depth_, 16u)), vars(0), ok(true), max_conflicts(-1),
+      max_time(-1), max_memory(-1)
+{
+  offsets.push_back(0);
+}
+
+CubeAndConquer::~CubeAndConquer() {}
+
+bool CubeAndConquer::addClause(const vec_literals& ps)
+{
+  for (int i = 0; i < ps.size(); i++)
+    lits.push_back(ps[i].x);
+  offsets.push_back(lits.size());
+
+  if (ps.size() == 0)
+    ok = false;
+  return ok;
+}
+
+bool CubeAndConquer::addClauses(const int* lits_, const int* offsets_,
+                                size_t n)
+{
+  const int base = (int)lits.size() - offsets_[0];
+  lits.insert(lits.end(), lits_ + offsets_[0], lits_ + offsets_[n]);
+  for (size_t i = 0; i < n; i++)
+  {
+    offsets.push_back(offsets_[i + 1] + base);
+    if (offsets_[i] == offsets_[i + 1])
+      ok = false;
+  }
+  return ok;
+}
+
+size_t CubeAndConquer::memoryUsed() const
+{
+  return (lits.size() + offsets.size()) * sizeof(int) +
+         (model ? model->memoryUsed() : 0);
+}
+
+uint8_t CubeAndConquer::modelValue(uint32_t x) const
+{
+  assert(model);
+  return model->modelValue(x);
+}
+
+SATSolver::lbool CubeAndConquer::true_literal()
+{
+  assert(model);
+  return model->true_literal();
+}
+
+SATSolver::lbool CubeAndConquer::false_literal()
+{
+  assert(model);
+  return model->false_literal();
+}
+
+SATSolver::lbool CubeAndConquer::undef_literal()
+{
+  assert(model);
+  return model->undef_literal();
+}
+
+void CubeAndConquer::printStats() const
+{
+  const size_t count = std::count(refuted.begin(), refuted.end(), 1);
+  std::cerr << "Cubes:" << refuted.size() << " unsatisfiable:" << count
+            << " split variables:" << split.size() << std::endl;
+  if (model)
+    model->printStats();
+}
+
+// The candidates first, then the variables in the most clauses. In the CNF
+// of an AIG, those are the nodes with the largest fan-out.
+void CubeAndConquer::chooseSplit()
+{
+  std::vector<uint32_t> occurs(vars, 0);
+  std::vector<char> skip(vars, 0);
+  for (size_t i = 0; i + 1 < offsets.size(); i++)
+    for (int j = offsets[i]; j < offsets[i + 1]; j++)
+    {
+      occurs[lits[j] >> 1]++;
+      if (offsets[i + 1] - offsets[i] == 1) // already fixed.
+        skip[lits[j] >> 1] = 1;
+    }
+
+  for (uint32_t v : candidates)
+    if (split.size() < depth && v < vars && !skip[v])
+    {
+      skip[v] = 1;
+      split.push_back(v);
+    }
+
+  std::vector<uint32_t> order;
+  for (uint32_t v = 0; v < vars; v++)
+    if (!skip[v] && occurs[v] > 0)
+      order.push_back(v);
+
+  const size_t want = std::min(order.size(), depth - split.size());
+  std::partial_sort(order.begin(), order.begin() + want, order.end(),
+                    [&](uint32_t a, uint32_t b) {
+                      return occurs[a] > occurs[b] ||
+                             (occurs[a] == occurs[b] && a < b);
+                    });
+  split.insert(split.end(), order.begin(), order.begin() + want);
+
+  refuted.assign(1u << split.size(), 0);
+}
+
+SATSolver* CubeAndConquer::build(unsigned cube, int64_t memory)
+{
+  SATSolver* s = factory();
+  s->newVars(vars);
+  for (uint32_t v : frozen)
+    s->setFrozen(v);
+
+  if (max_conflicts >= 0)
+    s->setMaxConflicts(max_conflicts);
+  if (max_time >= 0)
+    s->setMaxTime(max_time);
+  if (memory >= 0)
+    s->setMaxMemory(memory);
+
+  if (!s->addClauses(lits.data(), offsets.data(), offsets.size() - 1))
+    return s;
+
+  // Bit i of the cube is the sign of the i-th split variable.
+  vec_literals unit;
+  for (size_t i = 0; i < split.size(); i++)
+  {
+    unit.clear();
+    unit.push(mkLit(split[i], (cube >> i) & 1));
+    if (!s->addClause(unit))
+      break;
+  }
+  return s;
+}
+
+bool CubeAndConquer::solve(bool& timeout_expired)
+{
+  model.reset();
+  if (!ok)
+    return false;
+
+  if (refuted.empty())
+    chooseSplit();
+
+  const unsigned cubes = refuted.size();
+  const unsigned running = std::min(threads, cubes);
+
+  int64_t memory = -1;
+  if (max_memory >= 0)
+  {
+    const int64_t store = (lits.size() + offsets.size()) * sizeof(int);
+    memory = std::max<int64_t>(max_memory - store, 0) / running;
+  }
+
+  std::atomic<unsigned> next(0);
+  std::atomic<bool> stop(false);
+  std::mutex m; // guards the rest.
+  std::vector<SATSolver*> active(cubes, NULL);
+  std::unique_ptr<SATSolver> found;
+  bool gave_up = false;
+
+  auto work = [&]() {
+    while (!stop)
+    {
+      const unsigned cube = next++;
+      if (cube >= cubes)
+        return;
+      if (refuted[cube])
+        continue;
+
+      std::unique_ptr<SATSolver> s(build(cube, memory));
+      {
+        std::lock_guard<std::mutex> lock(m);
+        if (stop)
+          return;
+        active[cube] = s.get();
+      }
+
+      bool timeout = false;
+      // Some backends report a cube they gave up on as satisfiable.
+      const bool sat = s->solve(timeout) && !timeout;
+
+      std::lock_guard<std::mutex> lock(m);
+      active[cube] = NULL;
+      if (sat)
+      {
+        if (!found)
+        {
+          found = std::move(s);
+          stop = true;
+          for (SATSolver* a : active)
+            if (a != NULL)
+              a->interrupt();
+        }
+        return;
+      }
+
+      if (!timeout)
+        refuted[cube] = 1;
+      else if (!stop)
+        gave_up = true;
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < running; i++)
+    pool.emplace_back(work);
+  work();
+  for (std::thread& t : pool)
+    t.join();
+
+  if (found)
+  {
+    model = std::move(found);
+    return true;
+  }
+
+  if (gave_up)
+  {
+    timeout_expired = true;
+    return false;
+  }
+
+  ok = false; // every cube is unsatisfiable.
+  return false;
+}
+}
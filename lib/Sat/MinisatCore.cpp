@@ -25,6 +25,8 @@ THE SOFTWARE.
 #define __STDC_FORMAT_MACROS
 #include "stp/Sat/MinisatCore.h"
 #include "minisat/core/Solver.h"
+#include "minisat/simp/SimpSolver.h"
+#include <algorithm>
 //#include "utils/System.h"
 //#include "simp/SimpSolver.h"
 
@@ -41,7 +43,7 @@ uint8_t MinisatCore::value(uint32_t x) const
   return Minisat::toInt(s->value(x));
 }
 
-MinisatCore::MinisatCore()
+MinisatCore::MinisatCore() : conflict_limit(-1), max_memory(-1)
 {
   s = new Minisat::Solver;
 }
@@ -54,6 +56,108 @@ MinisatCore::~MinisatCore()
 void MinisatCore::setMaxConflicts(int64_t max_confl)
 {
   s->setConfBudget(max_confl);
+  conflict_limit = (max_confl < 0) ? -1 : (int64_t)s->conflicts + max_confl;
+}
+
+void MinisatCore::setMaxMemory(int64_t bytes)
+{
+  max_memory = bytes;
+}
+
+size_t MinisatCore::memoryUsed() const
+{
+  return memoryUsed(*s);
+}
+
+void MinisatCore::interrupt()
+{
+  s->interrupt();
+}
+
+size_t MinisatCore::memoryUsed(const Minisat::Solver& s)
+{
+  // Literals are 4 bytes. Each clause has a 3 word header and two watchers of
+  // 8 bytes. Each variable has about 48 bytes of assignment, reason, level,
+  // activity, heap and polarity data.
+  return (s.clauses_literals + s.learnts_literals) * 4 +
+         (size_t)(s.nClauses() + s.nLearnts()) * (3 * 4 + 2 * 8) +
+         (size_t)s.nVars() * 48;
+}
+
+namespace
+{
+// "S" is the solver's static type, which picks its solveLimited().
+template <class S>
+bool solveLimitedWithin(S& s, int64_t conflict_limit, int64_t max_memory,
+                        bool& timeout_expired,
+                        const SATSolver::vec_literals& assumps)
+{
+  // The conflicts between checks of the clause database's size.
+  const int64_t round = 10000;
+
+  Minisat::lbool ret;
+  if (max_memory < 0)
+    ret = s.solveLimited(assumps);
+  else
+  {
+    // Minisat has no memory limit, so search in rounds, checking in between.
+    // The learnt clauses, and the activities, are kept between rounds.
+    while (true)
+    {
+      int64_t next = round;
+      if (conflict_limit >= 0)
+        next = std::min(next, conflict_limit - (int64_t)s.conflicts);
+      if (next <= 0 || MinisatCore::memoryUsed(s) > (size_t)max_memory)
+      {
+        ret = Minisat::l_Undef;
+        break;
+      }
+
+      const uint64_t end = s.conflicts + next;
+      s.setConfBudget(next);
+      ret = s.solveLimited(assumps);
+      if (ret != (Minisat::lbool)Minisat::l_Undef)
+        break;
+      if (s.conflicts < end) // stopped short of the budget, so interrupted.
+        break;
+    }
+
+    if (conflict_limit >= 0)
+      s.setConfBudget(std::max<int64_t>(conflict_limit - s.conflicts, 0));
+    else
+      s.budgetOff();
+  }
+
+  if (ret == (Minisat::lbool)Minisat::l_Undef)
+    timeout_expired = true;
+
+  return ret == (Minisat::lbool)Minisat::l_True;
+}
+}
+
+bool MinisatCore::solveWithin(Minisat::Solver& s, int64_t conflict_limit,
+                              int64_t max_memory, bool& timeout_expired,
+                              const vec_literals& assumps)
+{
+  return solveLimitedWithin(s, conflict_limit, max_memory, timeout_expired,
+                            assumps);
+}
+
+bool MinisatCore::solveWithin(Minisat::SimpSolver& s, int64_t conflict_limit,
+                              int64_t max_memory, bool& timeout_expired,
+                              const vec_literals& assumps)
+{
+  return solveLimitedWithin(s, conflict_limit, max_memory, timeout_expired,
+                            assumps);
+}
+
+// The conflict holds the negations of the assumptions it refuted.
+void MinisatCore::failedAssumptions(const Minisat::Solver& s,
+                                    std::vector<uint32_t>& vars)
+{
+  vars.clear();
+  for (int i = 0; i < s.conflict.size(); i++)
+    vars.push_back(Minisat::var(s.conflict[i]));
 }
 
 bool MinisatCore::addClause(
@@ -62,6 +166,21 @@ bool MinisatCore::addClause(
   return s->addClause(ps);
 }
 
+bool MinisatCore::addClauses(const int* lits, const int* offsets, size_t n)
+{
+  // ABC's literals are encoded as Minisat's are.
+  Minisat::vec<Minisat::Lit> clause;
+  for (size_t i = 0; i < n; i++)
+  {
+    clause.clear();
+    for (int j = offsets[i]; j < offsets[i + 1]; j++)
+      clause.push(Minisat::toLit(lits[j]));
+    if (!s->addClause_(clause))
+      return false;
+  }
+  return true;
+}
+
 bool MinisatCore::okay() const // FALSE means solver is in a conflicting state
 {
   return s->okay();
@@ -86,14 +205,22 @@ bool MinisatCore::solve(bool& timeout_expired) // Search without assumptions.
   if (!s->simplify())
     return false;
 
-  Minisat::vec<Minisat::Lit> assumps;
-  Minisat::lbool ret = s->solveLimited(assumps);
-  if (ret == (Minisat::lbool)Minisat::l_Undef)
-  {
-    timeout_expired = true;
-  }
+  return solveWithin(*s, conflict_limit, max_memory, timeout_expired);
+}
 
-  return ret == (Minisat::lbool)Minisat::l_True;
+bool MinisatCore::solveAssuming(bool& timeout_expired,
+                                const vec_literals& assumptions)
+{
+  if (!s->simplify())
+    return false;
+
+  return solveWithin(*s, conflict_limit, max_memory, timeout_expired,
+                     assumptions);
+}
+
+void MinisatCore::failedAssumptions(std::vector<uint32_t>& vars) const
+{
+  failedAssumptions(*s, vars);
 }
 
 uint8_t MinisatCore::modelValue(uint32_t x) const
@@ -62,6 +62,11 @@ void RissCore::setMaxConflicts(int64_t max_confl)
   s->setConfBudget(max_confl);
 }
 
+void RissCore::interrupt()
+{
+  s->interrupt();
+}
+
 bool RissCore::addClause(
     const SATSolver::vec_literals& ps) // Add a clause to the solver.
 {
@@ -74,6 +79,20 @@ bool RissCore::addClause(
   return s->addClause(v);
 }
 
+bool RissCore::addClauses(const int* lits, const int* offsets, size_t n)
+{
+  Riss::vec<Lit>& v = *(Riss::vec<Riss::Lit>*)riss_clause;
+  for (size_t i = 0; i < n; i++)
+  {
+    v.clear();
+    for (int j = offsets[i]; j < offsets[i + 1]; j++)
+      v.push(Riss::toLit(lits[j]));
+    if (!s->addClause(v))
+      return false;
+  }
+  return true;
+}
+
 bool RissCore::okay() const // FALSE means solver is in a conflicting state
 {
   return s->okay();
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #define __STDC_FORMAT_MACROS
 #include "stp/Sat/SimplifyingMinisat.h"
 #include "minisat/simp/SimpSolver.h"
+#include "stp/Sat/MinisatCore.h"
 
 namespace MiniSat
 {
@@ -35,7 +36,7 @@ namespace stp
 {
 using std::cout;
 
-SimplifyingMinisat::SimplifyingMinisat()
+SimplifyingMinisat::SimplifyingMinisat() : conflict_limit(-1), max_memory(-1)
 {
   s = new Minisat::SimpSolver();
 }
@@ -48,7 +49,30 @@ SimplifyingMinisat::~SimplifyingMinisat()
 void SimplifyingMinisat::setMaxConflicts(int64_t max_confl)
 {
   if (max_confl > 0)
+  {
     s->setConfBudget(max_confl);
+    conflict_limit = (int64_t)s->conflicts + max_confl;
+  }
+  else
+  {
+    s->budgetOff();
+    conflict_limit = -1;
+  }
+}
+
+void SimplifyingMinisat::setMaxMemory(int64_t bytes)
+{
+  max_memory = bytes;
+}
+
+size_t SimplifyingMinisat::memoryUsed() const
+{
+  return MinisatCore::memoryUsed(*s);
+}
+
+void SimplifyingMinisat::interrupt()
+{
+  s->interrupt();
 }
 
 bool SimplifyingMinisat::addClause(
@@ -57,6 +81,21 @@ bool SimplifyingMinisat::addClause(
   return s->addClause(ps);
 }
 
+bool SimplifyingMinisat::addClauses(const int* lits, const int* offsets,
+                                    size_t n)
+{
+  Minisat::vec<Minisat::Lit> clause;
+  for (size_t i = 0; i < n; i++)
+  {
+    clause.clear();
+    for (int j = offsets[i]; j < offsets[i + 1]; j++)
+      clause.push(Minisat::toLit(lits[j]));
+    if (!s->addClause_(clause))
+      return false;
+  }
+  return true;
+}
+
 bool SimplifyingMinisat::okay()
     const // FALSE means solver is in a conflicting state
 {
@@ -69,14 +108,24 @@ bool SimplifyingMinisat::solve(
   if (!s->simplify())
     return false;
 
-  Minisat::vec<Minisat::Lit> assumps;
-  Minisat::lbool ret = s->solveLimited(assumps);
-  if (ret == (Minisat::lbool)Minisat::l_Undef)
-  {
-    timeout_expired = true;
-  }
+  return MinisatCore::solveWithin(*s, conflict_limit, max_memory,
+                                  timeout_expired);
+}
 
-  return s->okay();
+// Unlike solve(), the solver stays okay when it refutes the assumptions.
+bool SimplifyingMinisat::solveAssuming(bool& timeout_expired,
+                                       const vec_literals& assumptions)
+{
+  if (!s->simplify())
+    return false;
+
+  return MinisatCore::solveWithin(*s, conflict_limit, max_memory,
+                                  timeout_expired, assumptions);
+}
+
+void SimplifyingMinisat::failedAssumptions(std::vector<uint32_t>& vars) const
+{
+  MinisatCore::failedAssumptions(*s, vars);
 }
 
 bool SimplifyingMinisat::simplify() // Removes already satisfied clauses.
@@ -33,13 +33,14 @@ THE SOFTWARE.
  *  might actually represent many thousands of AIG nodes, so it doesn't do the
  *"DAG aware" part correctly.
  *  2) The startup of the DAR takes about 150M instructions, which is agggeeesss
- *for small problems.
+ *for small problems. AIGPipeline only does it once per thread now.
  */
 
 // FIXME: External libraries
 #include "stp/Simplifier/AIGSimplifyPropositionalCore.h"
 #include "extlib-abc/dar.h"
 #include "stp/Simplifier/Simplifier.h"
+#include "stp/ToSat/AIGPipeline.h"
 #include "stp/ToSat/BitBlaster.h"
 
 namespace stp
@@ -159,36 +160,10 @@ ASTNode AIGSimplifyPropositionalCore::topLevel(const ASTNode& top)
 
   assert(Aig_ManPoNum(mgr.aigMgr) == 1);
 
-  int initial_nodeCount = mgr.aigMgr->nObjs[AIG_OBJ_AND];
-  // cerr << "Nodes before AIG rewrite:" << initial_nodeCount << endl;
-
-  Dar_LibStart(); // About 150M instructions. Very expensive.
-  Dar_RwrPar_t Pars, *pPars = &Pars;
-  Dar_ManDefaultRwrParams(pPars);
-
-  // Assertion errors occur with this enabled.
-  pPars->fUseZeros = 1;
-
-  const int iterations = 3;
-
-  int lastNodeCount = initial_nodeCount;
-  for (int i = 0; i < iterations; i++)
-  {
-    Aig_Man_t* pTemp;
-    mgr.aigMgr = Aig_ManDup(pTemp = mgr.aigMgr, 0);
-    Aig_ManStop(pTemp);
-    Dar_ManRewrite(mgr.aigMgr, pPars);
-
-    mgr.aigMgr = Aig_ManDup(pTemp = mgr.aigMgr, 0);
-    Aig_ManStop(pTemp);
-
-    // cerr << "After rewrite [" << i << "]  nodes:"
-    //		<< mgr.aigMgr->nObjs[AIG_OBJ_AND] << endl;
-
-    if (lastNodeCount == mgr.aigMgr->nObjs[AIG_OBJ_AND])
-      break;
-    lastNodeCount = mgr.aigMgr->nObjs[AIG_OBJ_AND];
-  }
+  // Three rounds of rewriting, with zero-cost replacements.
+  const std::vector<AIGPipeline::Pass> passes(1, AIGPipeline::REWRITE_ZEROS);
+  AIGPipeline pipeline(bm->UserFlags, passes, 3);
+  pipeline.run(mgr.aigMgr);
 
   cacheType ptrToOrig;
   // This needs to be done after bitblasting because the PI nodes will be
@@ -218,8 +193,6 @@ ASTNode AIGSimplifyPropositionalCore::topLevel(const ASTNode& top)
 
   ASTNode result = convert(mgr, pObj, ptrToOrig);
 
-  Dar_LibStop();
-
   bm->GetRunTimes()->stop(RunTimes::AIGSimplifyCore);
   return result;
   // return simplifier.SimplifyFormula(result,false,NULL);
@@ -24,6 +24,7 @@ THE SOFTWARE.
 
 #include "stp/Simplifier/BVSolver.h"
 #include "stp/AST/AST.h"
+#include "stp/Simplifier/LinearSystemSolver.h"
 #include "stp/STPManager/STPManager.h"
 
 // This file contains the implementation of member functions of
@@ -616,6 +617,16 @@ ASTNode BVSolver::TopLevelBVSolve(const ASTNode& _input,
     _simp->haveAppliedSubstitutionMap();
   }
 
+  // What's left may contain systems of equations that can't be solved one
+  // at a time. Eliminating can grow the DAG, so only when simplifying.
+  if (simplify && _bm->UserFlags.linear_system_solve_flag)
+  {
+    _bm->GetRunTimes()->start(RunTimes::BVSolver);
+    LinearSystemSolver linear(_bm, _simp, nf);
+    output = linear.topLevel(output);
+    _bm->GetRunTimes()->stop(RunTimes::BVSolver);
+  }
+
   UpdateAlreadySolvedMap(_input, output);
   return output;
 }
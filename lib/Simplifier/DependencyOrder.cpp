@@ -0,0 +1,323 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+#include "stp/Simplifier/DependencyOrder.h"
+#include <algorithm>
+
+namespace stp
+{
+
+unsigned DependencyOrder::find(unsigned v)
+{
+  while (parent[v] != v)
+  {
+    if (!trail.recording())
+      parent[v] = parent[parent[v]];
+    v = parent[v];
+  }
+  return v;
+}
+
+void DependencyOrder::setOrder(unsigned v, unsigned position)
+{
+  if (order[v] == position)
+    return;
+  trail.push(Change(Change::ORDER, v, order[v]));
+  order[v] = position;
+}
+
+unsigned DependencyOrder::lookup(const ASTNode& n)
+{
+  IndexMap::const_iterator it = index.find(n);
+  if (it != index.end())
+    return it->second;
+
+  const unsigned v = parent.size();
+  index.insert(std::make_pair(n, v));
+  parent.push_back(v);
+  order.push_back(v); // after everything else.
+  dependsOn.emplace_back();
+  dependents.emplace_back();
+  visited.push_back(0);
+
+  Change c(Change::ADDED);
+  c.node = n;
+  trail.push(std::move(c));
+  return v;
+}
+
+void DependencyOrder::unvisit(const std::vector<unsigned>& nodes)
+{
+  for (unsigned v : nodes)
+    visited[v] = 0;
+}
+
+bool DependencyOrder::hasDependents(const ASTNode& var)
+{
+  IndexMap::const_iterator it = index.find(var);
+  return it != index.end() && !dependents[find(it->second)].empty();
+}
+
+// Everything reachable from a variable comes after it in the order, so the
+// search stops at variables after "var".
+bool DependencyOrder::wouldLoop(const ASTNode& var, const ASTNodeSet& vars)
+{
+  IndexMap::const_iterator it = index.find(var);
+  if (it == index.end())
+    return vars.find(var) != vars.end();
+
+  const unsigned x = find(it->second);
+  bool loops = false;
+  forward.clear();
+  stack.clear();
+
+  for (const ASTNode& n : vars)
+  {
+    IndexMap::const_iterator j = index.find(n);
+    if (j == index.end())
+      continue;
+    const unsigned y = find(j->second);
+    if (y == x)
+    {
+      loops = true;
+      break;
+    }
+    if (visited[y] || order[y] > order[x])
+      continue;
+    visited[y] = 1;
+    forward.push_back(y);
+    stack.push_back(y);
+  }
+
+  while (!loops && !stack.empty())
+  {
+    const unsigned v = stack.back();
+    stack.pop_back();
+    for (unsigned s : dependsOn[v])
+    {
+      const unsigned w = find(s);
+      if (w == x)
+      {
+        loops = true;
+        break;
+      }
+      if (visited[w] || order[w] > order[x])
+        continue;
+      visited[w] = 1;
+      forward.push_back(w);
+      stack.push_back(w);
+    }
+  }
+
+  unvisit(forward);
+  return loops;
+}
+
+bool DependencyOrder::wouldLoop(const ASTNode& var, const ASTNode& other)
+{
+  ASTNodeSet vars;
+  vars.insert(other);
+  return wouldLoop(var, vars);
+}
+
+// "from" depends on "to", so "from" must come first. If it doesn't, the
+// variables reachable from "to" that come before "from", and the variables
+// that reach "from" that come after "to", swap places, keeping their
+// relative orders.
+void DependencyOrder::addEdge(unsigned from, unsigned to)
+{
+  dependsOn[from].push_back(to);
+  dependents[to].push_back(from);
+  trail.push(Change(Change::EDGE, from, to));
+
+  if (order[from] < order[to])
+    return;
+
+  const unsigned lower = order[to];
+  const unsigned upper = order[from];
+
+  forward.clear();
+  stack.assign(1, to);
+  visited[to] = 1;
+  while (!stack.empty())
+  {
+    const unsigned v = stack.back();
+    stack.pop_back();
+    forward.push_back(v);
+    for (unsigned s : dependsOn[v])
+    {
+      const unsigned w = find(s);
+      assert(w != from); // would loop.
+      if (visited[w] || order[w] > upper)
+        continue;
+      visited[w] = 1;
+      stack.push_back(w);
+    }
+  }
+
+  backward.clear();
+  stack.assign(1, from);
+  visited[from] = 1;
+  while (!stack.empty())
+  {
+    const unsigned v = stack.back();
+    stack.pop_back();
+    backward.push_back(v);
+    for (unsigned d : dependents[v])
+    {
+      const unsigned w = find(d);
+      if (visited[w] || order[w] < lower)
+        continue;
+      visited[w] = 1;
+      stack.push_back(w);
+    }
+  }
+
+  auto earlier = [this](unsigned a, unsigned b) { return order[a] < order[b]; };
+  std::sort(forward.begin(), forward.end(), earlier);
+  std::sort(backward.begin(), backward.end(), earlier);
+
+  std::vector<unsigned> slots;
+  slots.reserve(forward.size() + backward.size());
+  for (unsigned v : backward)
+    slots.push_back(order[v]);
+  for (unsigned v : forward)
+    slots.push_back(order[v]);
+  std::sort(slots.begin(), slots.end());
+
+  size_t i = 0;
+  for (unsigned v : backward)
+    setOrder(v, slots[i++]);
+  for (unsigned v : forward)
+    setOrder(v, slots[i++]);
+
+  unvisit(forward);
+  unvisit(backward);
+}
+
+void DependencyOrder::add(const ASTNode& var, const ASTNodeSet& vars)
+{
+  const unsigned x = find(lookup(var));
+  for (const ASTNode& n : vars)
+  {
+    const unsigned y = find(lookup(n));
+    if (y != x)
+      addEdge(x, y);
+  }
+}
+
+void DependencyOrder::addEquality(const ASTNode& var, const ASTNode& other)
+{
+  const unsigned x = find(lookup(var));
+  const unsigned y = find(lookup(other));
+  if (x == y)
+    return;
+
+  addEdge(x, y);
+
+  // If "var" already depends on other variables, merging would lose them.
+  if (dependsOn[x].size() != 1)
+    return;
+
+  // Whatever depended on "var" now depends on "other". "var" stays among
+  // the dependents of "other", so that "other" isn't taken to be free of
+  // them when it appears in a term as "var".
+  parent[x] = y;
+  std::vector<unsigned>& into = dependents[y];
+  if (trail.recording())
+  {
+    Change c(Change::MERGED, x, y);
+    c.size = into.size();
+    c.dependents = dependents[x];
+    trail.push(std::move(c));
+  }
+  into.insert(into.end(), dependents[x].begin(), dependents[x].end());
+  dependents[x].clear();
+  dependsOn[x].clear();
+}
+
+void DependencyOrder::clear()
+{
+  if (trail.clearNeedsSaving())
+  {
+    Change c(Change::CLEARED);
+    c.saved.reset(new Saved{std::move(index), std::move(parent),
+                            std::move(order), std::move(dependsOn),
+                            std::move(dependents)});
+    trail.push(std::move(c));
+  }
+
+  index.clear();
+  parent.clear();
+  order.clear();
+  dependsOn.clear();
+  dependents.clear();
+  visited.clear();
+}
+
+void DependencyOrder::undo(Change& c)
+{
+  switch (c.kind)
+  {
+    case Change::ADDED:
+      index.erase(c.node);
+      parent.pop_back();
+      order.pop_back();
+      dependsOn.pop_back();
+      dependents.pop_back();
+      visited.pop_back();
+      break;
+
+    case Change::ORDER:
+      order[c.v] = c.w;
+      break;
+
+    case Change::EDGE:
+      dependsOn[c.v].pop_back();
+      dependents[c.w].pop_back();
+      break;
+
+    case Change::MERGED:
+      // The edge to w was all "v" depended on.
+      parent[c.v] = c.v;
+      dependsOn[c.v].assign(1, c.w);
+      dependents[c.w].resize(c.size);
+      dependents[c.v] = std::move(c.dependents);
+      break;
+
+    case Change::CLEARED:
+      index = std::move(c.saved->index);
+      parent = std::move(c.saved->parent);
+      order = std::move(c.saved->order);
+      dependsOn = std::move(c.saved->dependsOn);
+      dependents = std::move(c.saved->dependents);
+      visited.assign(parent.size(), 0);
+      break;
+  }
+}
+
+void DependencyOrder::rollback()
+{
+  trail.rollback([this](Change& c) { undo(c); });
+}
+}
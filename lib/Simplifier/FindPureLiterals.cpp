@@ -37,96 +37,39 @@ THE SOFTWARE.
 namespace stp
 {
 
-int FindPureLiterals::swap(polarity_type polarity)
+bool FindPureLiterals::topLevel(ASTNode& n, Simplifier* simplifier,
+                                STPMgr* stpMgr)
 {
-  if (polarity == truePolarity)
-    return falsePolarity;
-
-  if (polarity == falsePolarity)
-    return truePolarity;
-
-  if (polarity == bothPolarity)
-    return bothPolarity;
-
-  throw "SADFSA2332";
+  stpMgr->GetRunTimes()->start(RunTimes::PureLiterals);
+  const ParentIndex index(n);
+  stpMgr->GetRunTimes()->stop(RunTimes::PureLiterals);
+  return topLevel(index, simplifier, stpMgr);
 }
 
-// Build the polarities, then iterate through fixing them.
-bool FindPureLiterals::topLevel(ASTNode& n, Simplifier* simplifier,
-                                STPMgr* stpMgr)
+bool FindPureLiterals::topLevel(const ParentIndex& index,
+                                Simplifier* simplifier, STPMgr* stpMgr)
 {
   stpMgr->GetRunTimes()->start(RunTimes::PureLiterals);
 
-  build(n, truePolarity);
   bool changed = false;
-
-  map<ASTNode, polarity_type>::const_iterator it = nodeToPolarity.begin();
-  while (it != nodeToPolarity.end())
+  for (ParentIndex::Id i = 0; i < index.size(); i++)
   {
-    const ASTNode& n = it->first;
-    const polarity_type polarity = it->second;
+    const ASTNode& n = index.node(i);
+    const ParentIndex::Polarity polarity = index.polarity(i);
     if (n.GetType() == BOOLEAN_TYPE && n.GetKind() == SYMBOL &&
-        polarity != bothPolarity)
+        polarity != ParentIndex::bothPolarity)
     {
-      if (polarity == truePolarity)
+      if (polarity == ParentIndex::truePolarity)
         simplifier->UpdateSubstitutionMap(n, stpMgr->ASTTrue);
       else
       {
-        assert(polarity == falsePolarity);
+        assert(polarity == ParentIndex::falsePolarity);
         simplifier->UpdateSubstitutionMap(n, stpMgr->ASTFalse);
       }
       changed = true;
     }
-    it++;
   }
   stpMgr->GetRunTimes()->stop(RunTimes::PureLiterals);
   return changed;
 }
-
-void FindPureLiterals::build(const ASTNode& n, polarity_type polarity)
-{
-  if (n.isConstant())
-    return;
-
-  map<ASTNode, polarity_type>::iterator it = nodeToPolarity.find(n);
-  if (it != nodeToPolarity.end())
-  {
-    int lookupPolarity = it->second;
-    if ((polarity | lookupPolarity) == lookupPolarity)
-      return; // already traversed.
-
-    it->second |= polarity;
-  }
-  else
-  {
-    nodeToPolarity.insert(std::make_pair(n, polarity));
-  }
-  const Kind k = n.GetKind();
-  switch (k)
-  {
-    case AND:
-    case OR:
-      for (size_t i = 0; i < n.Degree(); i++)
-        build(n[i], polarity);
-      break;
-
-    case NOT:
-      polarity = swap(polarity);
-      build(n[0], polarity);
-      break;
-
-    case ITE:
-      build(n[0], bothPolarity);
-      build(n[1], polarity);
-      build(n[2], polarity);
-      break;
-
-
-    default:
-      polarity = bothPolarity; // both
-      for (size_t i = 0; i < n.Degree(); i++)
-        build(n[i], polarity);
-      break;
-  }
-}
 }
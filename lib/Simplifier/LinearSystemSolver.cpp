@@ -0,0 +1,361 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+#include "stp/Simplifier/LinearSystemSolver.h"
+#include <map>
+
+namespace stp
+{
+
+namespace
+{
+uint64_t maskOf(unsigned width)
+{
+  return (width >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+}
+
+unsigned trailingZeros(uint64_t v)
+{
+  assert(v != 0);
+  unsigned result = 0;
+  while ((v & 1) == 0)
+  {
+    v >>= 1;
+    result++;
+  }
+  return result;
+}
+
+// The inverse of the odd "v" modulo 2^64. Each Newton step doubles the number
+// of correct low bits, starting with three.
+uint64_t inverseOf(uint64_t v)
+{
+  assert(v & 1);
+  uint64_t result = v;
+  for (int i = 0; i < 5; i++)
+    result *= 2 - v * result;
+  assert(result * v == 1);
+  return result;
+}
+
+uint64_t valueOf(const ASTNode& n)
+{
+  assert(BVCONST == n.GetKind() && n.GetValueWidth() <= 64);
+  uint64_t result = 0;
+  const unsigned width = n.GetValueWidth();
+  for (unsigned offset = 0; offset < width; offset += 32)
+  {
+    const unsigned chunk = std::min(32u, width - offset);
+    const uint64_t bits =
+        CONSTANTBV::BitVector_Chunk_Read(n.GetBVConst(), chunk, offset);
+    result |= bits << offset;
+  }
+  return result;
+}
+}
+
+// Adds scale*term to the sum of "monomials" and "constant". Arithmetic is
+// modulo 2^64, which agrees with arithmetic modulo 2^width in the low bits.
+bool LinearSystemSolver::linearise(
+    const ASTNode& term, unsigned width, uint64_t scale,
+    std::vector<std::pair<ASTNode, uint64_t>>& monomials,
+    uint64_t& constant) const
+{
+  // Shared terms are visited once per path, so give up on big DAGs.
+  if (monomials.size() > 4096)
+    return false;
+
+  if (term.GetType() != BITVECTOR_TYPE || term.GetValueWidth() != width)
+    return false;
+
+  switch (term.GetKind())
+  {
+    case BVCONST:
+      constant += scale * valueOf(term);
+      return true;
+
+    case SYMBOL:
+      monomials.push_back(std::make_pair(term, scale));
+      return true;
+
+    case BVPLUS:
+      for (const ASTNode& c : term.GetChildren())
+        if (!linearise(c, width, scale, monomials, constant))
+          return false;
+      return true;
+
+    case BVSUB:
+      return linearise(term[0], width, scale, monomials, constant) &&
+             linearise(term[1], width, -scale, monomials, constant);
+
+    case BVUMINUS:
+      return linearise(term[0], width, -scale, monomials, constant);
+
+    case BVNOT: // ~x = -x - 1
+      constant -= scale;
+      return linearise(term[0], width, -scale, monomials, constant);
+
+    case BVMULT:
+    {
+      ASTNode variable;
+      for (const ASTNode& c : term.GetChildren())
+      {
+        if (BVCONST == c.GetKind())
+          scale *= valueOf(c);
+        else if (variable.IsNull())
+          variable = c;
+        else
+          return false; // non-linear.
+      }
+      if (variable.IsNull())
+      {
+        constant += scale;
+        return true;
+      }
+      return linearise(variable, width, scale, monomials, constant);
+    }
+
+    default:
+      return false;
+  }
+}
+
+bool LinearSystemSolver::solve(const ASTVec& equations, unsigned width,
+                               ASTVec& unsolved)
+{
+  const uint64_t mask = maskOf(width);
+
+  columns.clear();
+  columnOf.clear();
+
+  std::vector<std::vector<std::pair<ASTNode, uint64_t>>> sparse(
+      equations.size());
+  std::vector<Row> rows(equations.size());
+  for (size_t i = 0; i < equations.size(); i++)
+  {
+    // lhs - rhs = 0.
+    uint64_t constant = 0;
+    bool linear = linearise(equations[i][0], width, 1, sparse[i], constant) &&
+                  linearise(equations[i][1], width, -1, sparse[i], constant);
+    assert(linear);
+    (void)linear;
+    rows[i].constant = (0 - constant) & mask;
+
+    for (const auto& m : sparse[i])
+      if (columnOf.find(m.first) == columnOf.end())
+      {
+        columnOf.insert(std::make_pair(m.first, columns.size()));
+        columns.push_back(m.first);
+      }
+  }
+
+  if (rows.size() * columns.size() > max_cells)
+  {
+    unsolved.insert(unsolved.end(), equations.begin(), equations.end());
+    return true;
+  }
+
+  for (size_t i = 0; i < rows.size(); i++)
+  {
+    rows[i].coefficients.assign(columns.size(), 0);
+    for (const auto& m : sparse[i])
+    {
+      uint64_t& c = rows[i].coefficients[columnOf[m.first]];
+      c = (c + m.second) & mask;
+    }
+  }
+
+  struct Pivot
+  {
+    size_t row;
+    size_t column;
+    unsigned shift; // trailing zeros of the coefficient.
+    uint64_t inverse; // of the coefficient's odd part.
+  };
+  std::vector<Pivot> pivots;
+  std::vector<bool> active(rows.size(), true);
+
+  while (true)
+  {
+    Pivot p = {0, 0, width, 0};
+    for (size_t r = 0; r < rows.size() && p.shift > 0; r++)
+    {
+      if (!active[r])
+        continue;
+      for (size_t c = 0; c < columns.size() && p.shift > 0; c++)
+      {
+        const uint64_t a = rows[r].coefficients[c];
+        if (a != 0 && trailingZeros(a) < p.shift)
+        {
+          p.row = r;
+          p.column = c;
+          p.shift = trailingZeros(a);
+        }
+      }
+    }
+
+    if (p.shift == width)
+      break; // all the remaining coefficients are zero.
+
+    Row& pivot = rows[p.row];
+
+    // Every coefficient in the row is a multiple of 2^shift, so the constant
+    // must be too.
+    if ((pivot.constant & maskOf(p.shift)) != 0)
+      return false;
+
+    p.inverse = inverseOf(pivot.coefficients[p.column] >> p.shift);
+    active[p.row] = false;
+    pivots.push_back(p);
+
+    for (size_t r = 0; r < rows.size(); r++)
+    {
+      Row& row = rows[r];
+      if (!active[r] || row.coefficients[p.column] == 0)
+        continue;
+
+      const uint64_t k = (row.coefficients[p.column] >> p.shift) * p.inverse;
+      for (size_t c = 0; c < columns.size(); c++)
+        row.coefficients[c] =
+            (row.coefficients[c] - k * pivot.coefficients[c]) & mask;
+      row.constant = (row.constant - k * pivot.constant) & mask;
+      assert(row.coefficients[p.column] == 0);
+    }
+  }
+
+  for (size_t r = 0; r < rows.size(); r++)
+    if (active[r] && rows[r].constant != 0)
+      return false; // 0 = non-zero.
+
+  // Each pivot row gives the low bits of its symbol in terms of the symbols
+  // whose columns were eliminated later, or never.
+  for (const Pivot& p : pivots)
+  {
+    const Row& row = rows[p.row];
+
+    ASTVec terms;
+    const uint64_t constant = ((row.constant >> p.shift) * p.inverse) & mask;
+    if (constant != 0)
+      terms.push_back(bm->CreateBVConst(width, constant));
+
+    for (size_t c = 0; c < columns.size(); c++)
+    {
+      if (c == p.column || row.coefficients[c] == 0)
+        continue;
+      const uint64_t coefficient =
+          (0 - (row.coefficients[c] >> p.shift) * p.inverse) & mask;
+      if (coefficient == 1)
+        terms.push_back(columns[c]);
+      else
+        terms.push_back(nf->CreateTerm(
+            BVMULT, width, bm->CreateBVConst(width, coefficient), columns[c]));
+    }
+
+    ASTNode value;
+    if (terms.empty())
+      value = bm->CreateZeroConst(width);
+    else if (terms.size() == 1)
+      value = terms[0];
+    else
+      value = nf->CreateTerm(BVPLUS, width, terms);
+
+    if (p.shift > 0)
+    {
+      // Only the low bits are determined. The high bits are unconstrained.
+      const unsigned low = width - p.shift;
+      value = nf->CreateTerm(BVEXTRACT, low, value,
+                             bm->CreateBVConst(32, low - 1),
+                             bm->CreateZeroConst(32));
+      const ASTNode high = bm->CreateFreshVariable(0, p.shift, "v_solver");
+      value = nf->CreateTerm(BVCONCAT, width, high, value);
+    }
+
+    const ASTNode& symbol = columns[p.column];
+    if (simp->UpdateSolverMap(symbol, value))
+      solved++;
+    else
+      unsolved.push_back(nf->CreateNode(EQ, symbol, value));
+  }
+
+  return true;
+}
+
+ASTNode LinearSystemSolver::topLevel(const ASTNode& n)
+{
+  if (EQ != n.GetKind() && AND != n.GetKind())
+    return n;
+
+  const ASTVec conjuncts =
+      (AND == n.GetKind()) ? FlattenKind(AND, n.GetChildren()) : ASTVec{n};
+
+  // The linear equations by width.
+  std::map<unsigned, ASTVec> systems;
+  ASTVec output;
+  for (const ASTNode& c : conjuncts)
+  {
+    bool linear = false;
+    if (EQ == c.GetKind() && BITVECTOR_TYPE == c[0].GetType() &&
+        c[0].GetValueWidth() <= 64)
+    {
+      const unsigned width = c[0].GetValueWidth();
+      std::vector<std::pair<ASTNode, uint64_t>> monomials;
+      uint64_t constant = 0;
+      linear = linearise(c[0], width, 1, monomials, constant) &&
+               linearise(c[1], width, -1, monomials, constant) &&
+               !monomials.empty();
+      if (linear)
+        systems[width].push_back(c);
+    }
+    if (!linear)
+      output.push_back(c);
+  }
+
+  solved = 0;
+  for (const auto& s : systems)
+  {
+    // Single equations are the BVSolver's job.
+    if (s.second.size() < 2)
+    {
+      output.push_back(s.second[0]);
+      continue;
+    }
+
+    if (!solve(s.second, s.first, output))
+      return bm->ASTFalse;
+  }
+
+  if (bm->UserFlags.stats_flag)
+    std::cerr << "{LinearSystemSolver} Symbols solved:" << solved << std::endl;
+
+  if (solved == 0)
+    return n;
+
+  ASTNode result = output.empty()
+                       ? bm->ASTTrue
+                       : (output.size() == 1 ? output[0]
+                                             : nf->CreateNode(AND, output));
+  result = simp->applySubstitutionMap(result);
+  simp->haveAppliedSubstitutionMap();
+  return result;
+}
+}
@@ -0,0 +1,679 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/Simplifier/LocalSearch.h"
+#include "extlib-constbv/constantbv.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace stp
+{
+
+namespace
+{
+uint64_t maskOf(unsigned width)
+{
+  return (width >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+}
+
+unsigned popcount(uint64_t v)
+{
+  unsigned r = 0;
+  for (; v != 0; v &= v - 1)
+    r++;
+  return r;
+}
+
+unsigned bitsIn(uint64_t v)
+{
+  unsigned r = 0;
+  for (; v != 0; v >>= 1)
+    r++;
+  return r;
+}
+
+bool supported(const ASTNode& n)
+{
+  if (n.GetType() == ARRAY_TYPE || n.GetValueWidth() > 64)
+    return false;
+
+  switch (n.GetKind())
+  {
+    case SYMBOL:
+    case BVCONST:
+    case TRUE:
+    case FALSE:
+    case BVNOT:
+    case BVCONCAT:
+    case BVOR:
+    case BVAND:
+    case BVXOR:
+    case BVNAND:
+    case BVNOR:
+    case BVXNOR:
+    case BVEXTRACT:
+    case BVLEFTSHIFT:
+    case BVRIGHTSHIFT:
+    case BVSRSHIFT:
+    case BVPLUS:
+    case BVSUB:
+    case BVUMINUS:
+    case BVMULT:
+    case BVDIV:
+    case BVMOD:
+    case SBVDIV:
+    case SBVREM:
+    case SBVMOD:
+    case BVSX:
+    case BVZX:
+    case ITE:
+    case BOOLEXTRACT:
+    case BVLT:
+    case BVLE:
+    case BVGT:
+    case BVGE:
+    case BVSLT:
+    case BVSLE:
+    case BVSGT:
+    case BVSGE:
+    case EQ:
+    case NOT:
+    case AND:
+    case OR:
+    case NAND:
+    case NOR:
+    case XOR:
+    case IMPLIES:
+      return true;
+    case IFF:
+      return n.Degree() == 2;
+    default:
+      return false;
+  }
+}
+} // namespace
+
+LocalSearch::LocalSearch(STPMgr* bm_,
+                         simplifier::constantBitP::NodeToFixedBitsMap* fixed_)
+    : bm(bm_), fixed(fixed_), total(0), rng(1), moves(0)
+{
+}
+
+bool LocalSearch::build(const ASTNode& form)
+{
+  ASTVec conjuncts;
+  ASTVec todo(1, form);
+  while (!todo.empty())
+  {
+    const ASTNode n = todo.back();
+    todo.pop_back();
+    if (n.GetKind() == AND)
+      todo.insert(todo.end(), n.GetChildren().begin(), n.GetChildren().end());
+    else if (n.GetKind() == FALSE)
+      return false;
+    else if (n.GetKind() != TRUE)
+      conjuncts.push_back(n);
+  }
+
+  std::unordered_map<ASTNode, uint32_t, ASTNode::ASTNodeHasher,
+                     ASTNode::ASTNodeEqual>
+      index;
+  vector<std::pair<ASTNode, unsigned>> stack;
+
+  for (const ASTNode& c : conjuncts)
+  {
+    stack.push_back(std::make_pair(c, 0));
+    while (!stack.empty())
+    {
+      const ASTNode n = stack.back().first;
+      const unsigned next = stack.back().second;
+      if (index.find(n) != index.end())
+      {
+        stack.pop_back();
+        continue;
+      }
+      if (next < n.Degree())
+      {
+        stack.back().second++;
+        if (index.find(n[next]) == index.end())
+          stack.push_back(std::make_pair(n[next], 0));
+        continue;
+      }
+      stack.pop_back();
+
+      if (!supported(n))
+        return false;
+
+      Node node;
+      node.kind = n.GetKind();
+      node.width = (n.GetType() == BOOLEAN_TYPE) ? 1 : n.GetValueWidth();
+      node.mask = maskOf(node.width);
+      node.first = kids.size();
+      node.count = n.Degree();
+      for (const ASTNode& child : n.GetChildren())
+        kids.push_back(index.find(child)->second);
+
+      uint64_t v = 0;
+      if (node.kind == BVCONST)
+      {
+        const CBV bits = n.GetBVConst();
+        for (unsigned i = 0; i < node.width; i++)
+          if (CONSTANTBV::BitVector_bit_test(bits, i))
+            v |= (uint64_t)1 << i;
+      }
+      else if (node.kind == TRUE)
+        v = 1;
+
+      varOf.push_back(-1);
+      if (node.kind == SYMBOL)
+      {
+        uint64_t m = 0, f = 0;
+        if (fixed != NULL)
+        {
+          auto it = fixed->map->find(n);
+          if (it != fixed->map->end())
+            for (unsigned i = 0; i < node.width; i++)
+              if (it->second->isFixed(i))
+              {
+                m |= (uint64_t)1 << i;
+                if (it->second->getValue(i))
+                  f |= (uint64_t)1 << i;
+              }
+        }
+        varOf.back() = vars.size();
+        vars.push_back(nodes.size());
+        symbols.push_back(n);
+        fixedMask.push_back(m);
+        fixedValue.push_back(f);
+        v = f;
+      }
+
+      index.insert(std::make_pair(n, nodes.size()));
+      nodes.push_back(node);
+      value.push_back(v);
+    }
+  }
+
+  rootOf.assign(nodes.size(), -1);
+  for (const ASTNode& c : conjuncts)
+  {
+    const uint32_t n = index.find(c)->second;
+    if (rootOf[n] == -1)
+    {
+      rootOf[n] = roots.size();
+      roots.push_back(n);
+    }
+  }
+
+  // The parents, as one array.
+  parentsBegin.assign(nodes.size() + 1, 0);
+  for (uint32_t k : kids)
+    parentsBegin[k + 1]++;
+  for (size_t i = 0; i < nodes.size(); i++)
+    parentsBegin[i + 1] += parentsBegin[i];
+  parents.resize(kids.size());
+  vector<uint32_t> fill(parentsBegin.begin(), parentsBegin.end() - 1);
+  for (uint32_t i = 0; i < nodes.size(); i++)
+    for (uint32_t j = 0; j < nodes[i].count; j++)
+      parents[fill[kids[nodes[i].first + j]]++] = i;
+
+  queued.assign(nodes.size(), 0);
+  return true;
+}
+
+uint64_t LocalSearch::eval(uint32_t n) const
+{
+  const Node& node = nodes[n];
+  const uint32_t* k = &kids[node.first];
+  const uint64_t m = node.mask;
+  auto v = [&](unsigned i) { return value[k[i]]; };
+  auto w = [&](unsigned i) { return nodes[k[i]].width; };
+
+  switch (node.kind)
+  {
+    case SYMBOL:
+    case BVCONST:
+    case TRUE:
+    case FALSE:
+      return value[n];
+
+    case BVNOT:
+      return ~v(0) & m;
+
+    case BVAND:
+    case BVNAND:
+    case AND:
+    case NAND:
+    {
+      uint64_t r = m;
+      for (unsigned i = 0; i < node.count; i++)
+        r &= v(i);
+      return (node.kind == BVNAND || node.kind == NAND) ? ~r & m : r;
+    }
+
+    case BVOR:
+    case BVNOR:
+    case OR:
+    case NOR:
+    {
+      uint64_t r = 0;
+      for (unsigned i = 0; i < node.count; i++)
+        r |= v(i);
+      return (node.kind == BVNOR || node.kind == NOR) ? ~r & m : r;
+    }
+
+    case BVXOR:
+    case BVXNOR:
+    case XOR:
+    {
+      uint64_t r = 0;
+      for (unsigned i = 0; i < node.count; i++)
+        r ^= v(i);
+      return (node.kind == BVXNOR) ? ~r & m : r;
+    }
+
+    case NOT:
+      return v(0) ^ 1;
+    case IMPLIES:
+      return !v(0) || v(1);
+    case IFF:
+      return v(0) == v(1);
+    case ITE:
+      return v(0) ? v(1) : v(2);
+
+    case BVPLUS:
+    {
+      uint64_t r = 0;
+      for (unsigned i = 0; i < node.count; i++)
+        r += v(i);
+      return r & m;
+    }
+    case BVMULT:
+    {
+      uint64_t r = 1;
+      for (unsigned i = 0; i < node.count; i++)
+        r *= v(i);
+      return r & m;
+    }
+    case BVSUB:
+      return (v(0) - v(1)) & m;
+    case BVUMINUS:
+      return (0 - v(0)) & m;
+
+    case BVDIV:
+      return (v(1) == 0) ? m : v(0) / v(1);
+    case BVMOD:
+      return (v(1) == 0) ? v(0) : v(0) % v(1);
+
+    case SBVDIV:
+    case SBVREM:
+    case SBVMOD:
+    {
+      // On the magnitudes, with the signs fixed up after, as in SMT-LIB.
+      const uint64_t sign = (uint64_t)1 << (node.width - 1);
+      const bool ns = v(0) & sign, nt = v(1) & sign;
+      const uint64_t s = ns ? (0 - v(0)) & m : v(0);
+      const uint64_t t = nt ? (0 - v(1)) & m : v(1);
+      const uint64_t q = (t == 0) ? m : s / t;
+      const uint64_t u = (t == 0) ? s : s % t;
+      if (node.kind == SBVDIV)
+        return (ns != nt) ? (0 - q) & m : q;
+      if (node.kind == SBVREM)
+        return ns ? (0 - u) & m : u;
+      if (u == 0 || t == 0)
+        return (t == 0) ? v(0) : u;
+      if (!ns && !nt)
+        return u;
+      if (ns && !nt)
+        return (v(1) - u) & m;
+      if (!ns && nt)
+        return (u + v(1)) & m;
+      return (0 - u) & m;
+    }
+
+    case BVLEFTSHIFT:
+      return (v(1) >= node.width) ? 0 : (v(0) << v(1)) & m;
+    case BVRIGHTSHIFT:
+      return (v(1) >= node.width) ? 0 : v(0) >> v(1);
+    case BVSRSHIFT:
+    {
+      const bool negative = (v(0) >> (node.width - 1)) & 1;
+      if (v(1) >= node.width)
+        return negative ? m : 0;
+      const uint64_t r = v(0) >> v(1);
+      return negative ? (r | (m & ~(m >> v(1)))) : r;
+    }
+
+    case BVEXTRACT:
+      return (v(0) >> v(2)) & m;
+    case BOOLEXTRACT:
+      return (v(0) >> v(1)) & 1;
+    case BVCONCAT:
+    {
+      uint64_t r = 0;
+      for (unsigned i = 0; i < node.count; i++)
+        r = ((w(i) >= 64) ? 0 : r << w(i)) | v(i);
+      return r & m;
+    }
+    case BVZX:
+      return v(0);
+    case BVSX:
+    {
+      const uint64_t inner = maskOf(w(0));
+      return ((v(0) >> (w(0) - 1)) & 1) ? (v(0) | (m & ~inner)) : v(0);
+    }
+
+    case EQ:
+      return v(0) == v(1);
+
+    case BVLT:
+    case BVLE:
+    case BVGT:
+    case BVGE:
+    case BVSLT:
+    case BVSLE:
+    case BVSGT:
+    case BVSGE:
+    {
+      uint64_t a = v(0), b = v(1);
+      if (node.kind == BVSLT || node.kind == BVSLE || node.kind == BVSGT ||
+          node.kind == BVSGE)
+      {
+        // Flipping the sign bits gives the unsigned order.
+        a ^= (uint64_t)1 << (w(0) - 1);
+        b ^= (uint64_t)1 << (w(0) - 1);
+      }
+      switch (node.kind)
+      {
+        case BVLT:
+        case BVSLT:
+          return a < b;
+        case BVLE:
+        case BVSLE:
+          return a <= b;
+        case BVGT:
+        case BVSGT:
+          return a > b;
+        default:
+          return a >= b;
+      }
+    }
+
+    default:
+      FatalError("LocalSearch: unsupported kind");
+      return 0;
+  }
+}
+
+// 1 if the conjunct is true. Otherwise up to 0.5, more the closer its
+// operands are to making it true.
+double LocalSearch::score(uint32_t root) const
+{
+  const uint32_t n = roots[root];
+  if (value[n] != 0)
+    return 1;
+
+  const Node& node = nodes[n];
+  if (node.count != 2)
+    return 0;
+  const uint32_t* k = &kids[node.first];
+  uint64_t a = value[k[0]], b = value[k[1]];
+  const unsigned width = nodes[k[0]].width;
+
+  switch (node.kind)
+  {
+    case EQ:
+      return 0.5 * (1 - popcount(a ^ b) / (double)width);
+
+    case BVSLT:
+    case BVSLE:
+    case BVSGT:
+    case BVSGE:
+      a ^= (uint64_t)1 << (width - 1);
+      b ^= (uint64_t)1 << (width - 1);
+      // fall through
+    case BVLT:
+    case BVLE:
+    case BVGT:
+    case BVGE:
+    {
+      // How far the first operand is from the boundary.
+      uint64_t distance;
+      if (node.kind == BVLT || node.kind == BVSLT)
+        distance = a - b + 1;
+      else if (node.kind == BVLE || node.kind == BVSLE)
+        distance = a - b;
+      else if (node.kind == BVGT || node.kind == BVSGT)
+        distance = b - a + 1;
+      else
+        distance = b - a;
+      return 0.5 * (1 - bitsIn(distance) / (double)(width + 1));
+    }
+
+    default:
+      return 0;
+  }
+}
+
+void LocalSearch::setScore(uint32_t root)
+{
+  total -= rootScore[root];
+  rootScore[root] = score(root);
+  total += rootScore[root];
+
+  const bool sat = value[roots[root]] != 0;
+  if (!sat && unsatPosition[root] < 0)
+  {
+    unsatPosition[root] = unsat.size();
+    unsat.push_back(root);
+  }
+  else if (sat && unsatPosition[root] >= 0)
+  {
+    const uint32_t last = unsat.back();
+    unsat[unsatPosition[root]] = last;
+    unsatPosition[last] = unsatPosition[root];
+    unsat.pop_back();
+    unsatPosition[root] = -1;
+  }
+}
+
+void LocalSearch::changed(uint32_t n)
+{
+  if (rootOf[n] >= 0)
+    setScore(rootOf[n]);
+  for (uint32_t j = parentsBegin[n]; j < parentsBegin[n + 1]; j++)
+    if (rootOf[parents[j]] >= 0)
+      setScore(rootOf[parents[j]]);
+}
+
+// The scores of the conjuncts above "n" are kept up to date, including
+// those that stay false but whose operands change.
+void LocalSearch::assign(uint32_t var, uint64_t v)
+{
+  const uint32_t n = vars[var];
+  if (value[n] == v)
+    return;
+  trail.push_back(std::make_pair(n, value[n]));
+  value[n] = v;
+  changed(n);
+
+  auto push = [&](uint32_t i) {
+    for (uint32_t j = parentsBegin[i]; j < parentsBegin[i + 1]; j++)
+    {
+      const uint32_t p = parents[j];
+      if (!queued[p])
+      {
+        queued[p] = 1;
+        queue.push_back(p);
+        std::push_heap(queue.begin(), queue.end(), std::greater<uint32_t>());
+      }
+    }
+  };
+  push(n);
+
+  // Lowest first, so each node is evaluated after its children.
+  while (!queue.empty())
+  {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<uint32_t>());
+    const uint32_t i = queue.back();
+    queue.pop_back();
+    queued[i] = 0;
+
+    const uint64_t nv = eval(i);
+    if (nv == value[i])
+      continue;
+    trail.push_back(std::make_pair(i, value[i]));
+    value[i] = nv;
+    changed(i);
+    push(i);
+  }
+}
+
+void LocalSearch::undo()
+{
+  for (size_t i = trail.size(); i > 0; i--)
+  {
+    value[trail[i - 1].first] = trail[i - 1].second;
+    changed(trail[i - 1].first);
+  }
+  trail.clear();
+}
+
+// The symbols below the conjunct with bits that aren't fixed.
+const vector<uint32_t>& LocalSearch::varsBelow(uint32_t root)
+{
+  if (rootVars.size() <= root)
+    rootVars.resize(roots.size());
+  vector<uint32_t>& result = rootVars[root];
+  if (!result.empty())
+    return result;
+
+  vector<char> seen(nodes.size(), 0);
+  vector<uint32_t> todo(1, roots[root]);
+  while (!todo.empty())
+  {
+    const uint32_t n = todo.back();
+    todo.pop_back();
+    if (seen[n])
+      continue;
+    seen[n] = 1;
+
+    const int32_t v = varOf[n];
+    if (v >= 0 && (fixedMask[v] & nodes[n].mask) != nodes[n].mask)
+      result.push_back(v);
+    for (uint32_t j = 0; j < nodes[n].count; j++)
+      todo.push_back(kids[nodes[n].first + j]);
+  }
+  return result;
+}
+
+bool LocalSearch::search(const ASTNode& form, int64_t milliseconds,
+                         ASTNodeMap& model)
+{
+  if (!build(form))
+    return false;
+
+  for (uint32_t i = 0; i < nodes.size(); i++)
+    value[i] = eval(i);
+
+  rootScore.assign(roots.size(), 0);
+  unsatPosition.assign(roots.size(), -1);
+  for (uint32_t r = 0; r < roots.size(); r++)
+    setScore(r);
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+
+  vector<std::pair<uint32_t, uint64_t>> candidates;
+  for (uint64_t step = 0; !unsat.empty(); step++)
+  {
+    if ((step & 15) == 0 && std::chrono::steady_clock::now() > deadline)
+      return false;
+
+    const uint32_t root = unsat[rng() % unsat.size()];
+    const vector<uint32_t>& below = varsBelow(root);
+    if (below.empty())
+      return false; // it's false whatever the symbols are.
+
+    // Bit flips and small changes to a few of the symbols below it.
+    candidates.clear();
+    auto candidate = [&](uint32_t var, uint64_t v) {
+      const uint32_t n = vars[var];
+      v = ((v & ~fixedMask[var]) | fixedValue[var]) & nodes[n].mask;
+      if (v != value[n])
+        candidates.push_back(std::make_pair(var, v));
+    };
+    for (unsigned s = 0; s < std::min<size_t>(below.size(), 8); s++)
+    {
+      const uint32_t var = below[rng() % below.size()];
+      const uint64_t current = value[vars[var]];
+      for (unsigned b = 0; b < nodes[vars[var]].width; b++)
+        candidate(var, current ^ ((uint64_t)1 << b));
+      candidate(var, current + 1);
+      candidate(var, current - 1);
+      candidate(var, ~current);
+    }
+
+    // An equality with a symbol on one side can be made true directly.
+    const Node& r = nodes[roots[root]];
+    if (r.kind == EQ)
+      for (unsigned side = 0; side < 2; side++)
+      {
+        const int32_t var = varOf[kids[r.first + side]];
+        const uint64_t other = value[kids[r.first + 1 - side]];
+        if (var >= 0 && (other & fixedMask[var]) == fixedValue[var])
+          candidate(var, other);
+      }
+
+    if (candidates.empty())
+      return false;
+
+    double best = total;
+    size_t chosen = rng() % candidates.size(); // if nothing's better.
+    for (size_t c = 0; c < candidates.size(); c++)
+    {
+      assign(candidates[c].first, candidates[c].second);
+      if (total > best + 1e-9)
+      {
+        best = total;
+        chosen = c;
+      }
+      undo();
+    }
+
+    assign(candidates[chosen].first, candidates[chosen].second);
+    trail.clear();
+    moves++;
+  }
+
+  for (uint32_t v = 0; v < vars.size(); v++)
+  {
+    const uint32_t n = vars[v];
+    if (symbols[v].GetType() == BOOLEAN_TYPE)
+      model[symbols[v]] = value[n] ? bm->ASTTrue : bm->ASTFalse;
+    else
+      model[symbols[v]] = bm->CreateBVConst(nodes[n].width, value[n]);
+  }
+  return true;
+}
+}
@@ -0,0 +1,172 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+
+#include "stp/Simplifier/PassScheduler.h"
+#include <algorithm>
+#include <limits>
+
+using std::cerr;
+using std::endl;
+
+namespace stp
+{
+
+PassScheduler::PassScheduler(STPMgr* _bm, int64_t _budget_ms)
+    : bm(_bm), budget_ms(_budget_ms)
+{
+}
+
+void PassScheduler::add(const std::string& name, Pass pass)
+{
+  Entry e;
+  e.name = name;
+  e.pass = std::move(pass);
+  passes.push_back(std::move(e));
+}
+
+double PassScheduler::rate(const Entry& e) const
+{
+  if (e.runs == 0)
+    return std::numeric_limits<double>::infinity();
+
+  if (budget_ms >= 0)
+  {
+    const double seconds = std::chrono::duration<double>(e.spent).count();
+    return e.reduction / std::max(seconds, 1e-6);
+  }
+
+  return (double)e.reduction / e.runs;
+}
+
+ASTNode PassScheduler::run(Entry& e, const ASTNode& input)
+{
+  const clock::time_point start = clock::now();
+  const ASTNode result = e.pass(input);
+  e.last = clock::now() - start;
+  e.spent += e.last;
+  e.runs++;
+
+  if (result == input)
+  {
+    e.unchanged = input;
+    e.idle++;
+    // Rest for 0, 1, 3, then 7 rounds.
+    e.rest = (1u << std::min(e.idle - 1, 3u)) - 1;
+    return result;
+  }
+
+  e.changes++;
+  e.idle = 0;
+  e.rest = 0;
+  e.reduction += difficulty.score(input, bm) - difficulty.score(result, bm);
+  return result;
+}
+
+ASTNode PassScheduler::once(const ASTNode& input)
+{
+  ASTNode result = input;
+  for (Entry& e : passes)
+    result = run(e, result);
+  return result;
+}
+
+ASTNode PassScheduler::fixedPoint(const ASTNode& input,
+                                  const std::function<bool()>& keepGoing)
+{
+  const clock::time_point start = clock::now();
+  stopped = false;
+
+  std::vector<Entry*> order;
+  for (Entry& e : passes)
+    order.push_back(&e);
+
+  ASTNode result = input;
+
+  // Set when the passes that ran last round changed nothing, so the rested
+  // ones get to look at the result.
+  bool confirming = false;
+
+  while (true)
+  {
+    if (keepGoing && !keepGoing())
+    {
+      stopped = true;
+      return result;
+    }
+
+    std::stable_sort(order.begin(), order.end(),
+                     [this](const Entry* a, const Entry* b) {
+                       return rate(*a) > rate(*b);
+                     });
+
+    bool changed = false;
+    for (Entry* e : order)
+    {
+      if (e->unchanged == result)
+        continue; // nothing new for it to look at.
+
+      if (e->rest > 0 && !confirming)
+      {
+        e->rest--;
+        e->skips++;
+        continue;
+      }
+
+      // Don't start a pass that took longer last time than is left.
+      if (budget_ms >= 0 &&
+          clock::now() - start + e->last >
+              std::chrono::milliseconds(budget_ms))
+      {
+        if (bm->UserFlags.stats_flag)
+          cerr << "Simplification passes stopped, out of time" << endl;
+        return result;
+      }
+
+      const ASTNode next = run(*e, result);
+      changed |= (next != result);
+      result = next;
+    }
+
+    if (changed)
+    {
+      confirming = false;
+      continue;
+    }
+
+    confirming = std::any_of(order.begin(), order.end(), [&](const Entry* e) {
+      return e->unchanged != result;
+    });
+    if (!confirming)
+      return result;
+  }
+}
+
+void PassScheduler::printStats(std::ostream& os) const
+{
+  for (const Entry& e : passes)
+    os << "Pass " << e.name << ": " << e.runs << " runs, " << e.changes
+       << " changed, " << e.skips << " skipped, "
+       << std::chrono::duration_cast<std::chrono::milliseconds>(e.spent).count()
+       << "ms, difficulty reduced by " << e.reduction << endl;
+}
+} // end namespace stp
@@ -3705,6 +3705,19 @@ void Simplifier::printCacheStatus()
        << substitutionMap.Return_SolverMap()->bucket_count() << endl;
 }
 
+size_t Simplifier::memoryUsed() const
+{
+  // Each map entry is a key, a value, a next pointer and the cached hash.
+  const size_t entry = 2 * sizeof(ASTNode) + 2 * sizeof(void*);
+  return (SimplifyMap->size() + SimplifyNegMap->size() +
+          MultInverseMap.size()) *
+             entry +
+         AlwaysTrueHashSet.size() * (sizeof(int) + sizeof(void*)) +
+         (SimplifyMap->bucket_count() + SimplifyNegMap->bucket_count() +
+          MultInverseMap.bucket_count() + AlwaysTrueHashSet.bucket_count()) *
+             sizeof(void*);
+}
+
 ASTNode Simplifier::BVConstEvaluator(const ASTNode& t)
 {
   if (t.isConstant())
@@ -30,7 +30,6 @@ namespace stp
 {
 using std::endl;
 using std::make_pair;
-using std::set;
 using std::cout;
 
 DLL_PUBLIC SubstitutionMap::~SubstitutionMap()
@@ -38,6 +37,18 @@ DLL_PUBLIC SubstitutionMap::~SubstitutionMap()
   delete SolverMap;
 }
 
+void SubstitutionMap::rollback()
+{
+  trail.rollback([this](Change& c) {
+    if (c.saved)
+      SolverMap->swap(*c.saved);
+    else if (!c.key.IsNull())
+      SolverMap->erase(c.key);
+    substitutionsLastApplied = c.applied;
+  });
+  dependsOn.rollback();
+}
+
 // if a is READ(Arr,const) and b is BVCONST then return 1.
 // if a is a symbol SYMBOL, return 1.
 // if b is READ(Arr,const) and a is BVCONST then return -1
@@ -74,7 +85,8 @@ ASTNode SubstitutionMap::applySubstitutionMap(const ASTNode& n)
 {
   bm->GetRunTimes()->start(RunTimes::ApplyingSubstitutions);
   ASTNodeMap cache;
-  ASTNode result = replace(n, *SolverMap, cache, bm->defaultNodeFactory, false, false);
+  ASTNode result = replace(n, *SolverMap, cache, bm->defaultNodeFactory,
+                           false, false, &vars);
 
   bm->GetRunTimes()->stop(RunTimes::ApplyingSubstitutions);
   return result;
@@ -99,7 +111,8 @@ ASTNode SubstitutionMap::applySubstitutionMapUntilArrays(const ASTNode& n)
 {
   bm->GetRunTimes()->start(RunTimes::ApplyingSubstitutions);
   ASTNodeMap cache;
-  ASTNode result = replace(n, *SolverMap, cache, bm->defaultNodeFactory, true, false);
+  ASTNode result = replace(n, *SolverMap, cache, bm->defaultNodeFactory,
+                           true, false, &vars);
   bm->GetRunTimes()->stop(RunTimes::ApplyingSubstitutions);
   return result;
 }
@@ -124,7 +137,34 @@ ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
 
 ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
                                  ASTNodeMap& cache, NodeFactory* nf,
-                                 bool stopAtArrays, bool preventInfinite)
+                                 bool stopAtArrays, bool preventInfinite,
+                                 VariablesInExpression* symbols)
+{
+  // The symbols in the keys. A key without symbols could be anywhere, so
+  // then nothing is skipped.
+  uint64_t mapped = 0;
+  if (symbols != NULL)
+    for (const auto& e : fromTo)
+    {
+      const uint64_t s = symbols->signature(e.first);
+      if (s == 0)
+      {
+        symbols = NULL;
+        break;
+      }
+      mapped |= s;
+    }
+
+  return replace_helper(n, fromTo, cache, nf, stopAtArrays, preventInfinite,
+                        symbols, mapped);
+}
+
+ASTNode SubstitutionMap::replace_helper(const ASTNode& n, ASTNodeMap& fromTo,
+                                        ASTNodeMap& cache, NodeFactory* nf,
+                                        bool stopAtArrays,
+                                        bool preventInfinite,
+                                        VariablesInExpression* symbols,
+                                        uint64_t mapped)
 {
   const Kind k = n.GetKind();
   if (k == BVCONST || k == TRUE || k == FALSE)
@@ -135,6 +175,10 @@ ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
   if ((it = cache.find(n)) != cache.end())
     return it->second;
 
+  // None of the keys can be below "n".
+  if (symbols != NULL && (symbols->signature(n) & mapped) == 0)
+    return n;
+
   if ((it = fromTo.find(n)) != fromTo.end())
   {
     const ASTNode& r = it->second;
@@ -144,7 +188,8 @@ ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
       cache.insert(make_pair(n, r));
 
     ASTNode replaced =
-        replace(r, fromTo, cache, nf, stopAtArrays, preventInfinite);
+        replace_helper(r, fromTo, cache, nf, stopAtArrays, preventInfinite,
+                       symbols, mapped);
     if (replaced != r)
     {
       fromTo.erase(n);
@@ -178,7 +223,8 @@ ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
   for (ASTVec::const_iterator it = children.begin(); it != children.end(); it++)
   {
     new_children.push_back(
-        replace(*it, fromTo, cache, nf, stopAtArrays, preventInfinite));
+        replace_helper(*it, fromTo, cache, nf, stopAtArrays, preventInfinite,
+                       symbols, mapped));
   }
 
   assert(new_children.size() == children.size());
@@ -221,7 +267,8 @@ ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
     if (preventInfinite)
       cache.insert(make_pair(n, result));
 
-    result = replace(result, fromTo, cache, nf, stopAtArrays, preventInfinite);
+    result = replace_helper(result, fromTo, cache, nf, stopAtArrays,
+                            preventInfinite, symbols, mapped);
   }
 
   assert(result.GetValueWidth() == valueWidth);
@@ -237,8 +284,6 @@ ASTNode SubstitutionMap::replace(const ASTNode& n, ASTNodeMap& fromTo,
 }
 
 // Adds to the dependency graph that n0 depends on the variables in n1.
-// It's not the transitive closure of the dependencies. Just the variables in
-// the expression "n1".
 // This is only needed as long as all the substitution rules haven't been
 // written through.
 void SubstitutionMap::buildDepends(const ASTNode& n0, const ASTNode& n1)
@@ -249,71 +294,18 @@ void SubstitutionMap::buildDepends(const ASTNode& n0, const ASTNode& n1)
   if (n1.isConstant())
     return;
 
-  vector<Symbols*> av;
-  vars.VarSeenInTerm(vars.getSymbol(n1), rhs_visited, rhs, av);
-
-  sort(av.begin(), av.end());
-  for (size_t i = 0; i < av.size(); i++)
-  {
-    if (i != 0 && av[i] == av[i - 1])
-      continue; // Treat it like a set of Symbol* in effect.
-
-    ASTNodeSet* sym = (vars.TermsAlreadySeenMap.find(av[i])->second);
-    if (rhsAlreadyAdded.find(sym) != rhsAlreadyAdded.end())
-      continue;
-    rhsAlreadyAdded.insert(sym);
-
-    // cout << loopCount++ << " ";
-    // cout << "initial" << rhs.size() << " Adding: " <<sym->size();
-    rhs.insert(sym->begin(), sym->end());
-    // cout << "final:" << rhs.size();
-    // cout << "added:" << sym << endl;
-  }
-
-  assert(dependsOn.find(n0) == dependsOn.end());
-  dependsOn.insert(make_pair(n0, vars.getSymbol(n1)));
-}
-
-// Take the transitive closure of the varsToCheck. Storing the result in
-// visited.
-void SubstitutionMap::loops_helper(const set<ASTNode>& varsToCheck,
-                                   set<ASTNode>& visited)
-{
-  set<ASTNode>::const_iterator visitedIt = visited.begin();
-
-  set<ASTNode> toVisit;
-  vector<ASTNode> visitedN;
-
-  // for each variable.
-  for (set<ASTNode>::const_iterator varIt = varsToCheck.begin();
-       varIt != varsToCheck.end(); varIt++)
+  if (n1.GetKind() == SYMBOL)
   {
-    while (visitedIt != visited.end() && *visitedIt < *varIt)
-      visitedIt++;
-
-    if ((visitedIt != visited.end()) && *visitedIt == *varIt)
-      continue;
-
-    visitedN.push_back(*varIt);
-    DependsType::iterator it;
-    if ((it = dependsOn.find(*varIt)) != dependsOn.end())
-    {
-      Symbols* s = it->second;
-      bool destruct;
-      ASTNodeSet* varsSeen = vars.SetofVarsSeenInTerm(s, destruct);
-      toVisit.insert(varsSeen->begin(), varsSeen->end());
-
-      if (destruct)
-        delete varsSeen;
-    }
+    dependsOn.addEquality(n0, n1);
+    return;
   }
 
-  visited.insert(visitedN.begin(), visitedN.end());
-
-  visitedN.clear();
+  bool destruct;
+  ASTNodeSet* symbols = vars.SetofVarsSeenInTerm(n1, destruct);
+  dependsOn.add(n0, *symbols);
 
-  if (toVisit.size() != 0)
-    loops_helper(toVisit, visited);
+  if (destruct)
+    delete symbols;
 }
 
 // If n0 is replaced by n1 in the substitution map. Will it cause a loop?
@@ -332,41 +324,24 @@ bool SubstitutionMap::loops(const ASTNode& n0, const ASTNode& n1)
   // We are adding an edge FROM n0, so unless there is already an edge TO n0,
   // there is no change it can loop. Unless adding this would add a TO and FROM
   // edge.
-  if (rhs.find(n0) == rhs.end())
-  {
+  if (!dependsOn.hasDependents(n0))
     return vars.VarSeenInTerm(n0, n1);
-  }
 
-  if (n1.GetKind() == SYMBOL && dependsOn.find(n1) == dependsOn.end())
-    return false; // The rhs is a symbol and doesn't appear.
+  if (n1.GetKind() == SYMBOL)
+    return dependsOn.wouldLoop(n0, n1);
 
-  if (debug_substn)
-    cout << loopCount++ << endl;
-
-  bool destruct = true;
-  ASTNodeSet* dependN = vars.SetofVarsSeenInTerm(n1, destruct);
+  bool destruct;
+  ASTNodeSet* symbols = vars.SetofVarsSeenInTerm(n1, destruct);
+  const bool result = dependsOn.wouldLoop(n0, *symbols);
 
   if (debug_substn)
-  {
-    cout << n0 << " "
-         << n1.GetNodeNum(); //<< " Expression size:" << bm->NodeSize(n1,true);
-    cout << "Variables in expression: " << dependN->size() << endl;
-  }
-
-  set<ASTNode> depend(dependN->begin(), dependN->end());
+    cout << n0 << " Variables in expression: " << symbols->size()
+         << " Loops:" << result << endl;
 
   if (destruct)
-    delete dependN;
+    delete symbols;
 
-  set<ASTNode> visited;
-  loops_helper(depend, visited);
-
-  bool loops = visited.find(n0) != visited.end();
-
-  if (debug_substn)
-    cout << "Visited:" << visited.size() << "Loops:" << loops << endl;
-
-  return (loops);
+  return result;
 }
 
 bool SubstitutionMap::UpdateSubstitutionMap(const ASTNode& e0,
@@ -410,7 +385,7 @@ bool SubstitutionMap::UpdateSubstitutionMap(const ASTNode& e0,
   if (1 == i && !InsideSubstitutionMap(e0))
   {
     buildDepends(e0, e1);
-    (*SolverMap)[e0] = e1;
+    insert(e0, e1);
     return true;
   }
 
@@ -419,7 +394,7 @@ bool SubstitutionMap::UpdateSubstitutionMap(const ASTNode& e0,
   if (-1 == i && !InsideSubstitutionMap(e1))
   {
     buildDepends(e1, e0);
-    (*SolverMap)[e1] = e0;
+    insert(e1, e0);
     return true;
   }
 
@@ -243,5 +243,28 @@ void VariablesInExpression::ClearAllTables()
 
   symbol_graph.clear();
   TermsAlreadySeenMap.clear();
+  signatures.clear();
+}
+
+uint64_t VariablesInExpression::signature(const ASTNode& n)
+{
+  const Kind k = n.GetKind();
+  if (k == BVCONST || k == TRUE || k == FALSE)
+    return 0;
+
+  if (k == SYMBOL)
+    return (uint64_t)1 << ((n.GetNodeNum() * 0x9E3779B97F4A7C15ull) >> 58);
+
+  std::unordered_map<unsigned, uint64_t>::const_iterator it =
+      signatures.find(n.GetNodeNum());
+  if (it != signatures.end())
+    return it->second;
+
+  uint64_t result = 0;
+  for (const ASTNode& child : n.GetChildren())
+    result |= signature(child);
+
+  signatures.insert(std::make_pair(n.GetNodeNum(), result));
+  return result;
 }
 }
@@ -428,13 +428,8 @@ void notHandled(const Kind& k)
 // add to the work list any nodes that take the result of the "n" node.
 void ConstantBitPropagation::scheduleUp(const ASTNode& n)
 {
-  const set<ASTNode>* toAdd = dependents->getDependents(n);
-  set<ASTNode>::iterator it = toAdd->begin();
-  while (it != toAdd->end())
-  {
-    workList->push(*it);
-    it++;
-  }
+  dependents->forEachDependent(
+      n, [this](const ASTNode& parent) { workList->push(parent); });
 }
 
 void ConstantBitPropagation::scheduleDown(const ASTNode& n)
@@ -0,0 +1,176 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/ToSat/AIGPipeline.h"
+#include "extlib-abc/dar.h"
+#include "stp/AST/AST.h"
+#include "stp/Util/Attributes.h"
+#include <chrono>
+#include <iostream>
+
+namespace stp
+{
+using std::cerr;
+using std::endl;
+
+namespace
+{
+// Starting the library takes about 150M instructions, so each thread
+// starts it once, and stops it when it finishes.
+struct DarLibrary
+{
+  DarLibrary() { Dar_LibStart(); }
+  ~DarLibrary() { Dar_LibStop(); }
+};
+} // namespace
+
+void AIGPipeline::startLibrary()
+{
+  static THREAD_LOCAL DarLibrary library;
+  (void)library;
+}
+
+std::vector<AIGPipeline::Pass> AIGPipeline::parse(const std::string& script)
+{
+  std::vector<Pass> result;
+  size_t begin = 0;
+  while (begin <= script.size())
+  {
+    size_t end = script.find(',', begin);
+    if (end == std::string::npos)
+      end = script.size();
+    const std::string pass = script.substr(begin, end - begin);
+    begin = end + 1;
+
+    if (pass == "rw")
+      result.push_back(REWRITE);
+    else if (pass == "rwz")
+      result.push_back(REWRITE_ZEROS);
+    else if (pass == "b")
+      result.push_back(BALANCE);
+    else if (!pass.empty())
+      FatalError(("Unknown AIG pass: " + pass).c_str());
+  }
+  return result;
+}
+
+const char* AIGPipeline::name(Pass p)
+{
+  switch (p)
+  {
+    case REWRITE:
+      return "rw";
+    case REWRITE_ZEROS:
+      return "rwz";
+    case BALANCE:
+      return "b";
+  }
+  return "?";
+}
+
+AIGPipeline::AIGPipeline(const UserDefinedFlags& _uf,
+                         const std::vector<Pass>& _passes, int64_t _rounds)
+    : uf(_uf), passes(_passes), rounds(_rounds), runs(BALANCE + 1, 0)
+{
+}
+
+void AIGPipeline::apply(Pass p, Aig_Man_t*& aig)
+{
+  Aig_Man_t* pTemp;
+  if (p == BALANCE)
+  {
+    aig = Dar_ManBalance(pTemp = aig, 0);
+    Aig_ManStop(pTemp);
+    return;
+  }
+
+  aig = Aig_ManDup(pTemp = aig, 0);
+  Aig_ManStop(pTemp);
+
+  Dar_RwrPar_t pars;
+  Dar_ManDefaultRwrParams(&pars);
+  pars.fUseZeros = (p == REWRITE_ZEROS);
+  Dar_ManRewrite(aig, &pars);
+
+  // Removes the nodes that the pass left dangling.
+  aig = Aig_ManDup(pTemp = aig, 0);
+  Aig_ManStop(pTemp);
+}
+
+void AIGPipeline::run(Aig_Man_t*& aig)
+{
+  if (passes.empty() || rounds <= 0)
+    return;
+
+  startLibrary();
+
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point start = clock::now();
+
+  // How long each pass took last time, to tell whether it fits in what's
+  // left of the budget.
+  std::vector<clock::duration> last(BALANCE + 1, clock::duration::zero());
+
+  for (int64_t round = 0; round < rounds; round++)
+  {
+    const int before = Aig_ManNodeNum(aig);
+    for (const Pass p : passes)
+    {
+      const int nodes = Aig_ManNodeNum(aig);
+      if (uf.aig_node_limit >= 0 && nodes > uf.aig_node_limit)
+      {
+        if (uf.stats_flag)
+          cerr << "AIG passes skipped, " << nodes << " nodes is over the limit"
+               << endl;
+        return;
+      }
+
+      if (uf.aig_time_budget_ms >= 0 &&
+          clock::now() - start + last[p] >=
+              std::chrono::milliseconds(uf.aig_time_budget_ms))
+      {
+        if (uf.stats_flag)
+          cerr << "AIG passes stopped, out of time" << endl;
+        return;
+      }
+
+      const clock::time_point t = clock::now();
+      apply(p, aig);
+      last[p] = clock::now() - t;
+      runs[p]++;
+
+      if (uf.stats_flag)
+        cerr << "AIG " << name(p) << " [" << round << "] nodes: " << nodes
+             << " -> " << Aig_ManNodeNum(aig) << " ("
+             << std::chrono::duration_cast<std::chrono::milliseconds>(last[p])
+                    .count()
+             << "ms)" << endl;
+    }
+
+    // Stop once a round doesn't remove enough nodes to be worth repeating.
+    const int after = Aig_ManNodeNum(aig);
+    if ((int64_t)(before - after) * 100 <=
+        uf.aig_min_gain_percent * (int64_t)before)
+      break;
+  }
+}
+}
@@ -112,9 +112,12 @@ void BitBlaster<BBNode, BBNodeManagerT>::getConsts(const ASTNode& form,
 {
   assert(form.GetType() == BOOLEAN_TYPE);
 
+  // Dividing by multiplication leaves the quotient and remainder
+  // unconstrained here. What's found is true for every value of them, so
+  // still holds once they're constrained.
   BBNodeSet support;
   BBForm(form, support);
-  assert(support.size() == 0);
+  assert(support.size() == 0 || uf->division_by_multiplication);
 
   {
     typename std::map<ASTNode, BBNode>::iterator it;
@@ -891,31 +894,29 @@ const BBNodeVec BitBlaster<BBNode, BBNodeManagerT>::BBTerm(const ASTNode& _term,
     case BVDIV:
     case BVMOD:
     {
-      const BBNodeVec& dvdd = BBTerm(term[0], support);
-      const BBNodeVec& dvsr = BBTerm(term[1], support);
-      assert(dvdd.size() == num_bits);
-      assert(dvsr.size() == num_bits);
-      BBNodeVec q(num_bits);
-      BBNodeVec r(num_bits);
-      BBDivMod(dvdd, dvsr, q, r, num_bits, support);
+      const std::pair<BBNodeVec, BBNodeVec>& qr =
+          BBQuotientRemainder(term[0], term[1], support);
+      assert(qr.first.size() == num_bits);
+      assert(qr.second.size() == num_bits);
       if (k == BVDIV)
       {
         if (true) // todo. apparently this is not required.
         {
+          const BBNodeVec& dvsr = BBTerm(term[1], support);
           BBNodeVec zero(term.GetValueWidth(), BBFalse);
 
           BBNode eq = BBEQ(zero, dvsr);
           BBNodeVec max(term.GetValueWidth(), BBTrue);
 
-          result = BBITE(eq, max, q);
+          result = BBITE(eq, max, qr.first);
         }
         else
         {
-          result = q;
+          result = qr.first;
         }
       }
       else
-        result = r;
+        result = qr.second;
       break;
     }
     //  n-ary bitwise operators.
@@ -1030,6 +1031,9 @@ const BBNode BitBlaster<BBNode, BBNodeManagerT>::BBForm(const ASTNode& form)
     cb->propagate();
   }
 
+  if (uf->multiplication_variant == 0)
+    findMultiplicationDemand(form);
+
   BBNodeSet support;
   BBNode r = BBForm(form, support);
 
@@ -1039,7 +1043,7 @@ const BBNode BitBlaster<BBNode, BBNodeManagerT>::BBForm(const ASTNode& form)
 
   if (!uf->conjoin_to_top)
   {
-    assert(support.size() == 0);
+    assert(support.size() == 0 || uf->division_by_multiplication);
   }
 
   if (cb != NULL && !cb->isUnsatisfiable())
@@ -1930,6 +1934,141 @@ void BitBlaster<BBNode, BBNodeManagerT>::setColumnsToZero(
   }
 }
 
+// The low bits of sums, products and bitwise operations depend only on the
+// low bits of their operands, so when only the low bits of those are read,
+// only the low bits of their operands are needed.
+template <class BBNode, class BBNodeManagerT>
+void BitBlaster<BBNode, BBNodeManagerT>::findMultiplicationDemand(
+    const ASTNode& form)
+{
+  // Put the parents before their children.
+  ASTVec order;
+  {
+    ASTNodeSet visited;
+    vector<std::pair<ASTNode, unsigned>> stack;
+    stack.push_back(make_pair(form, 0u));
+    visited.insert(form);
+    while (!stack.empty())
+    {
+      if (stack.back().second < stack.back().first.Degree())
+      {
+        const ASTNode c = stack.back().first[stack.back().second++];
+        if (visited.insert(c).second)
+          stack.push_back(make_pair(c, 0u));
+      }
+      else
+      {
+        order.push_back(stack.back().first);
+        stack.pop_back();
+      }
+    }
+  }
+
+  std::map<ASTNode, unsigned> demand;
+  for (size_t i = order.size(); i > 0; i--)
+  {
+    const ASTNode& n = order[i - 1];
+    const unsigned d =
+        (n.GetType() == BITVECTOR_TYPE) ? demand[n] : n.GetValueWidth();
+
+    unsigned offset = 0; // of the child, in a concatenation.
+    for (size_t j = n.Degree(); j > 0; j--)
+    {
+      const ASTNode& c = n[j - 1];
+      if (c.GetType() != BITVECTOR_TYPE)
+        continue;
+
+      const unsigned width = c.GetValueWidth();
+      unsigned needed = width;
+      switch (n.GetKind())
+      {
+        case BVPLUS:
+        case BVSUB:
+        case BVMULT:
+        case BVUMINUS:
+        case BVNOT:
+        case BVAND:
+        case BVOR:
+        case BVXOR:
+        case BVNAND:
+        case BVNOR:
+        case BVXNOR:
+        case ITE:
+          needed = d;
+          break;
+        case BVEXTRACT:
+          if (j == 1)
+            needed = n[2].GetUnsignedConst() + d;
+          break;
+        case BVCONCAT:
+          needed = (d > offset) ? std::min(d - offset, width) : 0;
+          offset += width;
+          break;
+        case BVZX:
+        case BVSX:
+          // Above the operand, sign extension reads the operand's top bit.
+          if (j == 1 && d <= width)
+            needed = d;
+          break;
+        default:
+          break;
+      }
+
+      unsigned& current = demand[c];
+      current = std::max(current, needed);
+    }
+  }
+
+  multiplicationDemand.clear();
+  for (const auto& e : demand)
+    if (e.first.GetKind() == BVMULT && e.second < e.first.GetValueWidth())
+      multiplicationDemand.insert(e);
+}
+
+// Picks the encoding from the width that's read, and from the bits of the
+// operands that are known. Reorders the operands so that the one with the
+// most known bits is first, which is the one mult_normal iterates over, and
+// the one mult_Booth recodes.
+template <class BBNode, class BBNodeManagerT>
+int BitBlaster<BBNode, BBNodeManagerT>::chooseMultiplicationVariant(
+    BBNodeVec& x, BBNodeVec& y, const ASTNode& n)
+{
+  if (uf->upper_multiplication_bound && statsFound(n))
+    return 5;
+
+  unsigned width = n.GetValueWidth();
+  auto it = multiplicationDemand.find(n);
+  if (it != multiplicationDemand.end())
+    width = std::max(it->second, 1u);
+
+  unsigned unknownX = 0, unknownY = 0;
+  for (unsigned i = 0; i < width; i++)
+  {
+    if (x[i] != BBTrue && x[i] != BBFalse)
+      unknownX++;
+    if (y[i] != BBTrue && y[i] != BBFalse)
+      unknownY++;
+  }
+
+  if (unknownY < unknownX)
+  {
+    std::swap(x, y);
+    std::swap(unknownX, unknownY);
+  }
+
+  // When x is constant, or mostly so, there are few partial products, and
+  // Booth recoding cuts them further. Adding them is then cheaper than
+  // sorting the columns.
+  if (2 * unknownX <= width)
+    return 3;
+
+  // Small products are as cheap to add, and smaller than the networks.
+  if (width <= 8)
+    return 1;
+
+  return 7;
+}
+
 // Multiply two bitblasted numbers
 template <class BBNode, class BBNodeManagerT>
 BBNodeVec BitBlaster<BBNode, BBNodeManagerT>::BBMult(const BBNodeVec& _x,
@@ -1957,7 +2096,15 @@ BBNodeVec BitBlaster<BBNode, BBNodeManagerT>::BBMult(const BBNodeVec& _x,
   vector<list<BBNode>> products(bitWidth +
                                 1); // Create one extra to avoid special cases.
 
-  switch (uf->multiplication_variant)
+  int variant = uf->multiplication_variant;
+  if (variant == 0)
+    variant = chooseMultiplicationVariant(x, y, n);
+
+  // mult_Booth recodes its first operand, the adaptive choice orders them.
+  const BBNodeVec& boothX = (uf->multiplication_variant == 0) ? x : _x;
+  const BBNodeVec& boothY = (uf->multiplication_variant == 0) ? y : _y;
+
+  switch (variant)
   {
     case 1: 
     {
@@ -1970,14 +2117,14 @@ BBNodeVec BitBlaster<BBNode, BBNodeManagerT>::BBMult(const BBNodeVec& _x,
 
     case 3: 
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       setColumnsToZero(products, support, n);
       return buildAdditionNetworkResult(products, support, n);
     }
   
     case 4:
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       vector<BBNode> prior;
 
       for (unsigned i = 0; i < bitWidth; i++)
@@ -1994,7 +2141,7 @@ BBNodeVec BitBlaster<BBNode, BBNodeManagerT>::BBMult(const BBNodeVec& _x,
     {
       if (!statsFound(n) || !uf->upper_multiplication_bound)
       {
-        mult_Booth(_x, _y, support, n[0], n[1], products, n);
+        mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
         setColumnsToZero(products, support, n);
         return buildAdditionNetworkResult(products, support, n);
       }
@@ -2006,42 +2153,42 @@ BBNodeVec BitBlaster<BBNode, BBNodeManagerT>::BBMult(const BBNodeVec& _x,
   
     case 6:
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       setColumnsToZero(products, support, n);
       return v6(products, support, n);
     }
 
     case 7: 
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       setColumnsToZero(products, support, n);
       return v7(products, support, n);
     }
 
     case 8:
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       setColumnsToZero(products, support, n);
       return v8(products, support, n);
     }
 
     case 9:
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       setColumnsToZero(products, support, n);
       return v9(products, support, n);
     }
 
     case 13:
     {
-      mult_Booth(_x, _y, support, n[0], n[1], products, n);
+      mult_Booth(boothX, boothY, support, n[0], n[1], products, n);
       setColumnsToZero(products, support, n);
       return v13(products, support, n);
     }
 
     default:
     {
-      cerr << "Unk variant" << uf->multiplication_variant;
+      cerr << "Unk variant" << variant;
       FatalError("sda44f");
     }
   }
@@ -2531,6 +2678,69 @@ BitBlaster<BBNode, BBNodeManagerT>::mergeSorted(const vector<BBNode>& in1,
   return result;
 }
 
+template <class BBNode, class BBNodeManagerT>
+const std::pair<BBNodeVec, BBNodeVec>&
+BitBlaster<BBNode, BBNodeManagerT>::BBQuotientRemainder(const ASTNode& dividend,
+                                                        const ASTNode& divisor,
+                                                        BBNodeSet& support)
+{
+  const std::pair<ASTNode, ASTNode> key(dividend, divisor);
+  auto it = BBDivModMemo.find(key);
+  if (it != BBDivModMemo.end())
+    return it->second;
+
+  const unsigned width = dividend.GetValueWidth();
+  BBNodeVec q(width);
+  BBNodeVec r(width);
+  if (uf->division_by_multiplication)
+    BBDivModByMult(dividend, divisor, q, r, support);
+  else
+  {
+    const BBNodeVec& dvdd = BBTerm(dividend, support);
+    const BBNodeVec& dvsr = BBTerm(divisor, support);
+    BBDivMod(dvdd, dvsr, q, r, width, support);
+  }
+
+  return BBDivModMemo.insert(make_pair(key, make_pair(q, r))).first->second;
+}
+
+// The quotient and remainder are fresh variables, constrained so that
+// x = q*y + r and r < y. The multiplication is twice as wide, so it can't
+// overflow. When y is zero, r = x, and q is unconstrained, but BVDIV
+// replaces it. This is smaller than the long division circuit, but
+// propagates less.
+template <class BBNode, class BBNodeManagerT>
+void BitBlaster<BBNode, BBNodeManagerT>::BBDivModByMult(
+    const ASTNode& dividend, const ASTNode& divisor, BBNodeVec& q,
+    BBNodeVec& r, BBNodeSet& support)
+{
+  STPMgr& bm = ASTNF->getSTPMgr();
+  const unsigned width = dividend.GetValueWidth();
+  const ASTNode quotient =
+      bm.CreateFreshVariable(0, width, "STP_INTERNAL_quotient");
+  const ASTNode remainder =
+      bm.CreateFreshVariable(0, width, "STP_INTERNAL_remainder");
+
+  const ASTNode zero = ASTNF->CreateZeroConst(width);
+  auto extend = [&](const ASTNode& n) {
+    return ASTNF->CreateTerm(BVCONCAT, 2 * width, zero, n);
+  };
+
+  const ASTNode product = ASTNF->CreateTerm(BVMULT, 2 * width,
+                                            extend(quotient), extend(divisor));
+  const ASTNode sum =
+      ASTNF->CreateTerm(BVPLUS, 2 * width, product, extend(remainder));
+  const ASTNode eq = ASTNF->CreateNode(EQ, sum, extend(dividend));
+  const ASTNode less =
+      ASTNF->CreateNode(OR, ASTNF->CreateNode(EQ, divisor, zero),
+                        ASTNF->CreateNode(BVLT, remainder, divisor));
+
+  support.insert(BBForm(ASTNF->CreateNode(AND, eq, less), support));
+
+  q = BBTerm(quotient, support);
+  r = BBTerm(remainder, support);
+}
+
 // This implements a variant of binary long division.
 // q and r are "out" parameters.  rwidth puts a bound on the
 // recursion depth.
@@ -23,6 +23,7 @@ THE SOFTWARE.
 ********************************************************************/
 
 #include "stp/ToSat/ToCNFAIG.h"
+#include "stp/ToSat/AIGPipeline.h"
 
 namespace stp
 {
@@ -61,38 +62,14 @@ void ToCNFAIG::dag_aware_aig_rewrite(const bool needAbsRef,
 {
   if (!needAbsRef && uf.AIG_rewrites_iterations)
   {
-    Dar_LibStart();
-    Dar_RwrPar_t Pars, *pPars = &Pars;
-    Dar_ManDefaultRwrParams(pPars);
-
-    // Assertion errors occur with this enabled.
-    // pPars->fUseZeros = 1;
+    // Assertion errors used to occur with zero-cost replacements ("rwz").
 
     // For mul63bit.smt2 with iterations =3 & nCutsMax = 8
     // CNF generation was taking 139 seconds, solving 10 seconds.
-
-    // With nCutsMax =2, CNF generation takes 16 seconds, solving 10 seconds.
-    // The rewriting doesn't remove as many nodes of course..
-    for (int i = 0; i < uf.AIG_rewrites_iterations; i++)
-    {
-      int nodeCount = mgr.aigMgr->nObjs[AIG_OBJ_AND];
-
-      Aig_Man_t* pTemp;
-      mgr.aigMgr = Aig_ManDup(pTemp = mgr.aigMgr, 0);
-      Aig_ManStop(pTemp);
-      Dar_ManRewrite(mgr.aigMgr, pPars);
-
-      mgr.aigMgr = Aig_ManDup(pTemp = mgr.aigMgr, 0);
-      Aig_ManStop(pTemp);
-
-      if (uf.stats_flag)
-        cerr << "After rewrite [" << i
-             << "]  nodes:" << mgr.aigMgr->nObjs[AIG_OBJ_AND] << endl;
-
-      //Fixedpoint reached?
-      if (nodeCount == mgr.aigMgr->nObjs[AIG_OBJ_AND])
-        break;
-    }
+    // The budgets in the user flags bound that.
+    AIGPipeline pipeline(uf, AIGPipeline::parse(uf.aig_script),
+                         uf.AIG_rewrites_iterations);
+    pipeline.run(mgr.aigMgr);
   }
 }
 
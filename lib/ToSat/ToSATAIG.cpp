@@ -23,8 +23,15 @@ THE SOFTWARE.
 ********************************************************************/
 
 #include "stp/ToSat/ToSATAIG.h"
+#include "stp/ToSat/XorFinder.h"
+#include "stp/NodeFactory/SimplifyingNodeFactory.h"
 #include "stp/Simplifier/Simplifier.h"
 #include "stp/Simplifier/constantBitP/ConstantBitPropagation.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <thread>
 
 namespace stp
 {
@@ -34,6 +41,8 @@ THREAD_LOCAL int ToSATAIG::cnf_calls = 0;
 bool ToSATAIG::CallSAT(SATSolver& satSolver, const ASTNode& input,
                        bool needAbsRef)
 {
+  failed.clear();
+
   if (cb != NULL && cb->isUnsatisfiable())
     return false;
 
@@ -54,10 +63,13 @@ bool ToSATAIG::CallSAT(SATSolver& satSolver, const ASTNode& input,
 
   first = false;
   Cnf_Dat_t* cnfData = bitblast(input, needAbsRef);
+  if (cnfData == NULL) // over the memory budget.
+    return false;
   handle_cnf_options(cnfData, needAbsRef);
 
   assert(satSolver.nVars() == 0);
   add_cnf_to_solver(satSolver, cnfData);
+  bm->memoryUsage.record(MemoryUsage::ClauseDatabase, satSolver.memoryUsed());
 
   if (bm->UserFlags.output_bench_flag)
   {
@@ -66,19 +78,83 @@ bool ToSATAIG::CallSAT(SATSolver& satSolver, const ASTNode& input,
          << endl;
   }
   release_cnf_memory(cnfData);
+  bm->memoryUsage.record(MemoryUsage::CNF, 0);
 
   mark_variables_as_frozen(satSolver);
 
+  if (bm->UserFlags.cube_threads > 1)
+    satSolver.setSplitCandidates(splitCandidates(input));
+
   return runSolver(satSolver);
 }
 
+vector<uint32_t> ToSATAIG::splitCandidates(const ASTNode& input)
+{
+  vector<uint32_t> result;
+
+  // Which reads alias depends mostly on the indexes' high bits. Take the top
+  // bit of each index, then the next one down.
+  vector<const vector<unsigned>*> indexes;
+  for (const auto& arr : arrayTransformer->arrayToIndexToRead)
+    for (const auto& read : arr.second)
+    {
+      ASTNodeToSATVar::const_iterator it =
+          nodeToSATVar.find(read.second.index_symbol);
+      if (it != nodeToSATVar.end())
+        indexes.push_back(&it->second);
+    }
+
+  for (size_t bit = 0; bit < 2; bit++)
+    for (const vector<unsigned>* v : indexes)
+      if (bit < v->size() && (*v)[v->size() - 1 - bit] != ~((unsigned)0))
+        result.push_back((*v)[v->size() - 1 - bit]);
+
+  // The conditions that guard the most ITEs.
+  std::map<ASTNode, unsigned> guards;
+  ASTNodeSet visited;
+  vector<ASTNode> stack(1, input);
+  while (!stack.empty())
+  {
+    const ASTNode n = stack.back();
+    stack.pop_back();
+    if (!visited.insert(n).second)
+      continue;
+
+    if (n.GetKind() == ITE)
+    {
+      const ASTNode& c = n[0].GetKind() == NOT ? n[0][0] : n[0];
+      if (c.GetKind() == SYMBOL)
+        guards[c]++;
+    }
+    for (const ASTNode& c : n.GetChildren())
+      stack.push_back(c);
+  }
+
+  vector<std::pair<unsigned, uint32_t>> conditions;
+  for (const auto& g : guards)
+  {
+    ASTNodeToSATVar::const_iterator it = nodeToSATVar.find(g.first);
+    if (it != nodeToSATVar.end() && it->second[0] != ~((unsigned)0))
+      conditions.push_back(std::make_pair(g.second, it->second[0]));
+  }
+  std::stable_sort(conditions.begin(), conditions.end(),
+                   [](const std::pair<unsigned, uint32_t>& a,
+                      const std::pair<unsigned, uint32_t>& b) {
+                     return a.first > b.first;
+                   });
+  for (const auto& c : conditions)
+    result.push_back(c.second);
+
+  return result;
+}
+
 void ToSATAIG::release_cnf_memory(Cnf_Dat_t* cnfData)
 {
   // This releases the memory used by the CNF generator, particularly some data
   // tables.
   // If CNF generation is going to be called lots, we'd rather keep it around.
   // because the datatables are expensive to generate.
-  if (cnf_calls == 0)
+  if (cnf_calls == 0 && !bm->UserFlags.keep_cnf_memory)
     Cnf_ClearMemory();
 
   Cnf_DataFree(cnfData);
@@ -113,6 +189,14 @@ void ToSATAIG::handle_cnf_options(Cnf_Dat_t* cnfData, bool needAbsRef)
 
 Cnf_Dat_t* ToSATAIG::bitblast(const ASTNode& input, bool needAbsRef)
 {
+  const unsigned threads = std::max(bm->UserFlags.bitblast_threads, 1);
+  if (threads > 1 && canBitblastInParallel())
+  {
+    const vector<ASTVec> groups = partition(input, threads);
+    if (groups.size() > 1)
+      return bitblastInParallel(groups, needAbsRef);
+  }
+
   stp::SubstitutionMap sm(bm);
   Simplifier simp(bm, &sm);
 
@@ -123,54 +207,352 @@ Cnf_Dat_t* ToSATAIG::bitblast(const ASTNode& input, bool needAbsRef)
   bm->GetRunTimes()->start(RunTimes::BitBlasting);
   BBNodeAIG BBFormula = bb.BBForm(input);
   bm->GetRunTimes()->stop(RunTimes::BitBlasting);
+  bm->memoryUsage.record(MemoryUsage::AIG, mgr.memoryUsed());
 
   delete cb;
   cb = NULL;
   bb.cb = NULL;
 
+  // Give up before the CNF, which is usually larger still.
+  if (bm->memoryUsage.exceeded())
+  {
+    bm->soft_timeout_expired = true;
+    bm->memoryUsage.record(MemoryUsage::AIG, 0);
+    return NULL;
+  }
+
   bm->GetRunTimes()->start(RunTimes::CNFConversion);
   Cnf_Dat_t* cnfData = NULL;
   toCNF.toCNF(BBFormula, cnfData, nodeToSATVar, needAbsRef, mgr);
   bm->GetRunTimes()->stop(RunTimes::CNFConversion);
+  bm->memoryUsage.record(MemoryUsage::CNF,
+                         cnfData->nLiterals * sizeof(int) +
+                             (cnfData->nClauses + 1) * sizeof(int*) +
+                             cnfData->nVars * sizeof(int));
 
   // Free the memory in the AIGs.
   BBFormula = BBNodeAIG(); // null node
   mgr.stop();
+  bm->memoryUsage.record(MemoryUsage::AIG, 0);
 
   return cnfData;
 }
 
+vector<ASTVec> ToSATAIG::partition(const ASTNode& input, unsigned count)
+{
+  const ASTVec conjuncts =
+      input.GetKind() == AND ? input.GetChildren() : ASTVec(1, input);
+
+  // Union-find over the conjuncts.
+  vector<unsigned> parent(conjuncts.size());
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](unsigned i) {
+    while (parent[i] != i)
+      i = parent[i] = parent[parent[i]];
+    return i;
+  };
+
+  // Each term belongs to the first conjunct that reaches it. A conjunct that
+  // reaches a term belonging to another is joined with it, and doesn't go
+  // further down, so each term is visited once.
+  std::unordered_map<unsigned, unsigned> owner;
+  vector<size_t> size(conjuncts.size(), 0);
+  ASTVec stack;
+  for (unsigned i = 0; i < conjuncts.size(); i++)
+  {
+    stack.push_back(conjuncts[i]);
+    while (!stack.empty())
+    {
+      const ASTNode n = stack.back();
+      stack.pop_back();
+      if (n.isAtom())
+        continue;
+
+      auto found = owner.insert(std::make_pair(n.GetNodeNum(), i));
+      if (!found.second)
+      {
+        const unsigned a = find(i), b = find(found.first->second);
+        if (a != b)
+        {
+          parent[a] = b;
+          size[b] += size[a];
+        }
+        continue;
+      }
+
+      size[find(i)]++;
+      for (const ASTNode& c : n.GetChildren())
+        stack.push_back(c);
+    }
+  }
+
+  // The biggest components first, each into the smallest group so far.
+  vector<unsigned> roots;
+  for (unsigned i = 0; i < conjuncts.size(); i++)
+    if (find(i) == i)
+      roots.push_back(i);
+  std::stable_sort(roots.begin(), roots.end(), [&](unsigned a, unsigned b) {
+    return size[a] > size[b];
+  });
+
+  count = std::max(1u, std::min(count, (unsigned)roots.size()));
+  vector<size_t> load(count, 0);
+  vector<unsigned> groupOf(conjuncts.size());
+  for (unsigned r : roots)
+  {
+    const unsigned g =
+        std::min_element(load.begin(), load.end()) - load.begin();
+    load[g] += size[r];
+    groupOf[r] = g;
+  }
+
+  vector<ASTVec> result(count);
+  for (unsigned i = 0; i < conjuncts.size(); i++)
+    result[groupOf[find(i)]].push_back(conjuncts[i]);
+  return result;
+}
+
+bool ToSATAIG::canBitblastInParallel() const
+{
+#if USE_THREAD_LOCAL
+  // ABC keeps its CNF manager per thread. Each thread gets its own node
+  // factory, which is enough for the signed division, remainder and modulus
+  // that are rewritten while bit-blasting. Simplifying during bit-blasting,
+  // and dividing by multiplication, share more than that.
+  return !bm->isConcurrent() && !bm->UserFlags.simplify_during_BB_flag &&
+         !bm->UserFlags.division_by_multiplication;
+#else
+  return false;
+#endif
+}
+
+namespace
+{
+// A group of conjuncts, bit-blasted and converted to CNF on its own thread.
+struct Chunk
+{
+  ASTVec conjuncts;
+  std::unique_ptr<SimplifyingNodeFactory> nf;
+  std::unique_ptr<SubstitutionMap> sm;
+  std::unique_ptr<Simplifier> simp;
+  Cnf_Dat_t* cnf = NULL;
+  ToSATBase::ASTNodeToSATVar vars;
+  size_t aigMemory = 0;
+};
+
+void convert(STPMgr* bm, Chunk* chunk, bool needAbsRef)
+{
+  CONSTANTBV::BitVector_Boot();
+  BBNodeManagerAIG mgr;
+  {
+    BitBlaster<BBNodeAIG, BBNodeManagerAIG> bb(
+        &mgr, chunk->simp.get(), chunk->nf.get(), &bm->UserFlags);
+
+    vector<BBNodeAIG> parts;
+    for (const ASTNode& c : chunk->conjuncts)
+      parts.push_back(bb.BBForm(c));
+    const BBNodeAIG top =
+        parts.size() == 1 ? parts[0] : mgr.CreateNode(AND, parts);
+    chunk->aigMemory = mgr.memoryUsed();
+
+    ToCNFAIG toCNF(bm->UserFlags);
+    toCNF.toCNF(top, chunk->cnf, chunk->vars, needAbsRef, mgr);
+  }
+  mgr.stop();
+
+  // The CNF manager belongs to this thread, which is finishing.
+  Cnf_ClearMemory();
+}
+} // namespace
+
+Cnf_Dat_t* ToSATAIG::bitblastInParallel(const vector<ASTVec>& groups,
+                                        bool needAbsRef)
+{
+  // Constant bit propagation can't be shared between the threads. It has
+  // already simplified the input.
+  delete cb;
+  cb = NULL;
+
+  vector<Chunk> chunks(groups.size());
+  for (size_t i = 0; i < groups.size(); i++)
+  {
+    chunks[i].conjuncts = groups[i];
+    chunks[i].nf.reset(
+        new SimplifyingNodeFactory(*bm->hashingNodeFactory, *bm));
+    chunks[i].sm.reset(new SubstitutionMap(bm));
+    chunks[i].simp.reset(new Simplifier(bm, chunks[i].sm.get()));
+  }
+
+  bm->GetRunTimes()->start(RunTimes::BitBlasting);
+  bm->beginConcurrent(chunks.size());
+  vector<std::thread> workers;
+  for (Chunk& c : chunks)
+    workers.emplace_back(convert, bm, &c, needAbsRef);
+  for (std::thread& w : workers)
+    w.join();
+  bm->endConcurrent();
+  bm->GetRunTimes()->stop(RunTimes::BitBlasting);
+
+  size_t aigMemory = 0;
+  for (const Chunk& c : chunks)
+    aigMemory += c.aigMemory;
+  bm->memoryUsage.record(MemoryUsage::AIG, aigMemory);
+  const bool exceeded = bm->memoryUsage.exceeded();
+  bm->memoryUsage.record(MemoryUsage::AIG, 0);
+  if (exceeded)
+  {
+    bm->soft_timeout_expired = true;
+    for (Chunk& c : chunks)
+      Cnf_DataFree(c.cnf);
+    return NULL;
+  }
+
+  // The bits of symbols get the same variable in every chunk. The other
+  // variables of each chunk follow on.
+  bm->GetRunTimes()->start(RunTimes::CNFConversion);
+  assert(nodeToSATVar.empty());
+  const unsigned unused = ~((unsigned)0);
+  int nVars = 0, nLiterals = 0, nClauses = 0;
+  vector<vector<int>> renumber(chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    const Cnf_Dat_t* cnf = chunks[i].cnf;
+    vector<int>& to = renumber[i];
+    to.assign(cnf->nVars, -1);
+    for (const auto& symbol : chunks[i].vars)
+    {
+      vector<unsigned>& global =
+          nodeToSATVar
+              .insert(std::make_pair(
+                  symbol.first, vector<unsigned>(symbol.second.size(), unused)))
+              .first->second;
+      for (size_t b = 0; b < symbol.second.size(); b++)
+      {
+        const unsigned v = symbol.second[b];
+        if (v == unused)
+          continue;
+        if (global[b] == unused)
+          global[b] = nVars++;
+        to[v] = global[b];
+      }
+    }
+    for (int& v : to)
+      if (v == -1)
+        v = nVars++;
+
+    nLiterals += cnf->nLiterals;
+    nClauses += cnf->nClauses;
+  }
+
+  // Laid out like ABC's, so that it's freed by Cnf_DataFree().
+  Cnf_Dat_t* result = (Cnf_Dat_t*)calloc(1, sizeof(Cnf_Dat_t));
+  result->nVars = nVars;
+  result->nLiterals = nLiterals;
+  result->nClauses = nClauses;
+  result->pClauses = (int**)malloc(sizeof(int*) * (nClauses + 1));
+  result->pClauses[0] = (int*)malloc(sizeof(int) * std::max(nLiterals, 1));
+
+  int* lit = result->pClauses[0];
+  int clause = 0;
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    Cnf_Dat_t* cnf = chunks[i].cnf;
+    const vector<int>& to = renumber[i];
+    for (int c = 0; c < cnf->nClauses; c++)
+    {
+      result->pClauses[clause++] = lit;
+      for (int* l = cnf->pClauses[c]; l < cnf->pClauses[c + 1]; l++)
+        *lit++ = 2 * to[*l >> 1] + (*l & 1);
+    }
+    Cnf_DataFree(cnf);
+    chunks[i].cnf = NULL;
+  }
+  result->pClauses[clause] = lit;
+  bm->GetRunTimes()->stop(RunTimes::CNFConversion);
+
+  bm->memoryUsage.record(MemoryUsage::CNF,
+                         result->nLiterals * sizeof(int) +
+                             (result->nClauses + 1) * sizeof(int*) +
+                             result->nVars * sizeof(int));
+  return result;
+}
+
 void ToSATAIG::add_cnf_to_solver(SATSolver& satSolver, Cnf_Dat_t* cnfData)
 {
   bm->GetRunTimes()->start(RunTimes::SendingToSAT);
 
   // Create a new sat variable for each of the variables in the CNF.
-  int satV = satSolver.nVars();
-  for (int i = 0; i < cnfData->nVars - satV; i++)
-    satSolver.newVar();
+  const int satV = satSolver.nVars();
+  if (cnfData->nVars > satV)
+    satSolver.newVars(cnfData->nVars - satV);
+
+  // Send the XORs whole, rather than the clauses that encode them.
+  std::unique_ptr<XorFinder> xors;
+  if (bm->UserFlags.native_xor_clauses && satSolver.hasNativeXor())
+  {
+    xors.reset(new XorFinder(cnfData->pClauses, cnfData->nClauses));
+    for (const XorFinder::Xor& x : xors->getXors())
+      if (!satSolver.addXorClause(x.vars, x.rhs))
+        break;
+
+    if (bm->UserFlags.stats_flag)
+      cerr << "XOR clauses:" << xors->getXors().size() << endl;
+  }
 
-  SATSolver::vec_literals satSolverClause;
-  for (int i = 0; i < cnfData->nClauses; i++)
+  if (!xors)
   {
-    satSolverClause.clear();
-    for (int *pLit = cnfData->pClauses[i], *pStop = cnfData->pClauses[i + 1];
-         pLit < pStop; pLit++)
+    // ABC's clauses are consecutive in one array, so they're passed as they
+    // are, in batches, with each batch's offsets into that array.
+    const int batch = 1 << 16;
+    vector<int> offsets;
+    offsets.reserve(batch + 1);
+    for (int begin = 0; begin < cnfData->nClauses; begin += batch)
     {
-      uint32_t var = (*pLit) >> 1;
-      assert((var < satSolver.nVars()));
-      Minisat::Lit l = SATSolver::mkLit(var, (*pLit) & 1);
-      satSolverClause.push(l);
+      const int end = std::min(begin + batch, cnfData->nClauses);
+      const int* base = cnfData->pClauses[begin];
+      offsets.clear();
+      for (int i = begin; i <= end; i++)
+        offsets.push_back(cnfData->pClauses[i] - base);
+
+      if (!satSolver.addClauses(base, offsets.data(), end - begin))
+        break;
     }
+  }
+  else
+  {
+    SATSolver::vec_literals satSolverClause;
+    for (int i = 0; i < cnfData->nClauses; i++)
+    {
+      if (xors->isCovered(i))
+        continue;
+
+      satSolverClause.clear();
+      for (int *pLit = cnfData->pClauses[i], *pStop = cnfData->pClauses[i + 1];
+           pLit < pStop; pLit++)
+      {
+        uint32_t var = (*pLit) >> 1;
+        assert((var < satSolver.nVars()));
+        Minisat::Lit l = SATSolver::mkLit(var, (*pLit) & 1);
+        satSolverClause.push(l);
+      }
 
-    satSolver.addClause(satSolverClause);
-    if (!satSolver.okay())
-      break;
+      satSolver.addClause(satSolverClause);
+      if (!satSolver.okay())
+        break;
+    }
   }
   bm->GetRunTimes()->stop(RunTimes::SendingToSAT);
 }
 
 void ToSATAIG::mark_variables_as_frozen(SATSolver& satSolver)
 {
+  for (const ASTNode& a : assumptions)
+  {
+    ASTNodeToSATVar::const_iterator it = nodeToSATVar.find(a);
+    if (it != nodeToSATVar.end() && it->second[0] != ~((unsigned)0))
+      satSolver.setFrozen(it->second[0]);
+  }
+
   for (ArrayTransformer::ArrType::iterator it =
            arrayTransformer->arrayToIndexToRead.begin();
        it != arrayTransformer->arrayToIndexToRead.end(); it++)
@@ -202,10 +584,41 @@ void ToSATAIG::mark_variables_as_frozen(SATSolver& satSolver)
 
 bool ToSATAIG::runSolver(SATSolver& satSolver)
 {
+  if (bm->memoryUsage.hasLimit())
+    satSolver.setMaxMemory(
+        bm->memoryUsage.remaining(MemoryUsage::ClauseDatabase));
+
+  SATSolver::vec_literals assumed;
+  for (const ASTNode& a : assumptions)
+  {
+    ASTNodeToSATVar::const_iterator it = nodeToSATVar.find(a);
+    if (it != nodeToSATVar.end() && it->second[0] != ~((unsigned)0))
+      assumed.push(SATSolver::mkLit(it->second[0], false));
+  }
+
   bm->GetRunTimes()->start(RunTimes::Solving);
-  bool result = satSolver.solve(bm->soft_timeout_expired);
+  bool result =
+      (assumed.size() == 0)
+          ? satSolver.solve(bm->soft_timeout_expired)
+          : satSolver.solveAssuming(bm->soft_timeout_expired, assumed);
   bm->GetRunTimes()->stop(RunTimes::Solving);
 
+  failed.clear();
+  if (!result && !bm->soft_timeout_expired && assumed.size() > 0)
+  {
+    vector<uint32_t> vars;
+    satSolver.failedAssumptions(vars);
+    std::sort(vars.begin(), vars.end());
+    for (const ASTNode& a : assumptions)
+    {
+      ASTNodeToSATVar::const_iterator it = nodeToSATVar.find(a);
+      if (it != nodeToSATVar.end() &&
+          std::binary_search(vars.begin(), vars.end(), it->second[0]))
+        failed.push_back(a);
+    }
+  }
+  bm->memoryUsage.record(MemoryUsage::ClauseDatabase, satSolver.memoryUsed());
+
   if (bm->UserFlags.stats_flag)
     satSolver.printStats();
 
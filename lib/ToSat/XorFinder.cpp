@@ -0,0 +1,108 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/ToSat/XorFinder.h"
+#include <algorithm>
+#include <map>
+
+namespace stp
+{
+
+XorFinder::XorFinder(int** clauses, int count) : covered(count, false)
+{
+  // Candidate clauses, grouped by their variables.
+  std::map<std::vector<uint32_t>, std::vector<int>> byVars;
+
+  std::vector<int> lits;
+  for (int i = 0; i < count; i++)
+  {
+    const size_t size = clauses[i + 1] - clauses[i];
+    if (size < 3 || size > max_size)
+      continue;
+
+    lits.assign(clauses[i], clauses[i + 1]);
+    std::sort(lits.begin(), lits.end());
+
+    std::vector<uint32_t> vars;
+    for (int l : lits)
+      vars.push_back(l >> 1);
+    if (std::adjacent_find(vars.begin(), vars.end()) != vars.end())
+      continue; // repeats a variable.
+
+    byVars[vars].push_back(i);
+  }
+
+  for (const auto& group : byVars)
+  {
+    const std::vector<uint32_t>& vars = group.first;
+    const std::vector<int>& ids = group.second;
+    const unsigned k = vars.size();
+    const unsigned needed = 1u << (k - 1);
+    if (ids.size() < needed)
+      continue;
+
+    // A clause excludes the assignment that makes each of its literals
+    // false, i.e. sets each variable to whether it's negated. Sort the
+    // clauses by the parity of that assignment. If all 2^(k-1) assignments
+    // of one parity are excluded, the XOR has the other parity.
+    std::vector<std::vector<bool>> seen(2, std::vector<bool>(1u << k, false));
+    std::vector<std::vector<int>> which(2);
+    unsigned distinct[2] = {0, 0};
+
+    for (int i : ids)
+    {
+      lits.assign(clauses[i], clauses[i + 1]);
+      std::sort(lits.begin(), lits.end());
+
+      unsigned assignment = 0;
+      unsigned parity = 0;
+      for (unsigned j = 0; j < k; j++)
+      {
+        const unsigned negated = lits[j] & 1;
+        assignment |= negated << j;
+        parity ^= negated;
+      }
+
+      if (!seen[parity][assignment])
+      {
+        seen[parity][assignment] = true;
+        distinct[parity]++;
+      }
+      which[parity].push_back(i);
+    }
+
+    for (unsigned parity = 0; parity < 2; parity++)
+    {
+      if (distinct[parity] != needed)
+        continue;
+
+      Xor x;
+      x.vars = vars;
+      x.rhs = (parity == 0);
+      xors.push_back(x);
+      for (int i : which[parity])
+        covered[i] = true;
+    }
+  }
+}
+
+} // end namespace stp
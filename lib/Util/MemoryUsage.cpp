@@ -0,0 +1,82 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+#include "stp/Util/MemoryUsage.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace stp
+{
+
+namespace
+{
+const char* names[MemoryUsage::NumberOfSubsystems] = {
+    "Node Tables", "Simplifier Caches", "AIG", "CNF", "Clause Database"};
+}
+
+void MemoryUsage::reset()
+{
+  std::fill(current, current + NumberOfSubsystems, 0);
+  std::fill(peak, peak + NumberOfSubsystems, 0);
+}
+
+void MemoryUsage::record(Subsystem s, size_t bytes)
+{
+  current[s] = bytes;
+  peak[s] = std::max(peak[s], bytes);
+}
+
+size_t MemoryUsage::total() const
+{
+  size_t result = 0;
+  for (unsigned i = 0; i < NumberOfSubsystems; i++)
+    result += current[i];
+  return result;
+}
+
+int64_t MemoryUsage::remaining(Subsystem s) const
+{
+  if (!hasLimit())
+    return -1;
+
+  const size_t others = total() - current[s];
+  return (others >= (size_t)limit) ? 0 : limit - (int64_t)others;
+}
+
+void MemoryUsage::print(std::ostream& os) const
+{
+  std::ios_base::fmtflags f(os.flags());
+  os << std::fixed << std::setprecision(2);
+
+  for (unsigned i = 0; i < NumberOfSubsystems; i++)
+    os << "Memory " << names[i] << ": " << current[i] / (1024.0 * 1024.0)
+       << "MB (peak " << peak[i] / (1024.0 * 1024.0) << "MB)" << std::endl;
+
+  os << "Memory Total: " << total() / (1024.0 * 1024.0) << "MB";
+  if (hasLimit())
+    os << " of " << limit / (1024.0 * 1024.0) << "MB";
+  os << std::endl;
+
+  os.flags(f);
+}
+
+} // end namespace stp
@@ -117,6 +117,23 @@ Cnf_Man_t * Cnf_ManRead()
     return s_pManCnf;
 }
 
+/**Function*************************************************************
+
+  Synopsis    [Allocates the CNF manager ahead of the first derivation.]
+
+  Description []
+               
+  SideEffects []
+
+  SeeAlso     []
+
+***********************************************************************/
+void Cnf_ManPrepare()
+{
+    if ( s_pManCnf == NULL )
+        s_pManCnf = Cnf_ManStart();
+}
+
 /**Function*************************************************************
 
   Synopsis    []
@@ -0,0 +1,73 @@
+/***********
+AUTHORS:   Trevor Hansen, Dan Liew
+
+BEGIN DATE: Nov, 2011
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**********************/
+
+#include "stp/c_interface.h"
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <vector>
+
+// Many reads of the same array at symbolic indexes. Read "k" returns "k", so
+// the reads must all be at different indexes, and there are only "cells" to
+// choose from.
+static int pigeons(VC vc, int reads, int cells, std::vector<Expr>& indexes)
+{
+  Expr a = vc_varExpr(vc, "a", vc_arrayType(vc, vc_bvType(vc, 8),
+                                            vc_bvType(vc, 8)));
+  Expr limit = vc_bvConstExprFromInt(vc, 8, cells);
+
+  for (int k = 0; k < reads; k++)
+  {
+    char name[10];
+    sprintf(name, "i%d", k);
+    Expr i = vc_varExpr(vc, name, vc_bvType(vc, 8));
+    indexes.push_back(i);
+
+    vc_assertFormula(vc, vc_bvLtExpr(vc, i, limit));
+    vc_assertFormula(vc, vc_eqExpr(vc, vc_readExpr(vc, a, i),
+                                   vc_bvConstExprFromInt(vc, 8, k)));
+  }
+  return vc_query(vc, vc_falseExpr(vc));
+}
+
+TEST(array_lemmas, unsat)
+{
+  VC vc = vc_createValidityChecker();
+  std::vector<Expr> indexes;
+  ASSERT_EQ(1, pigeons(vc, 6, 5, indexes)); // Valid.
+  vc_Destroy(vc);
+}
+
+TEST(array_lemmas, sat)
+{
+  VC vc = vc_createValidityChecker();
+  std::vector<Expr> indexes;
+  ASSERT_EQ(0, pigeons(vc, 40, 40, indexes)); // Invalid.
+
+  // Every read was at a different index.
+  std::vector<bool> seen(40, false);
+  for (size_t k = 0; k < indexes.size(); k++)
+  {
+    const unsigned long long i =
+        getBVUnsigned(vc_getCounterExample(vc, indexes[k]));
+    ASSERT_LT(i, 40u);
+    ASSERT_FALSE(seen[i]);
+    seen[i] = true;
+  }
+  vc_Destroy(vc);
+}
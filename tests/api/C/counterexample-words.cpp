@@ -0,0 +1,82 @@
+/***********
+AUTHORS:   Trevor Hansen, Dan Liew
+
+BEGIN DATE: Nov, 2011
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**********************/
+
+
+#include "stp/c_interface.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(counterexample_words, bitvectors)
+{
+  VC vc = vc_createValidityChecker();
+  Expr x = vc_varExpr(vc, "x", vc_bvType(vc, 8));
+  Expr y = vc_varExpr(vc, "y", vc_bvType(vc, 100));
+  Expr b = vc_varExpr(vc, "b", vc_boolType(vc));
+
+  // y = 2^70 + 5.
+  Expr big = vc_bvConcatExpr(vc, vc_bvConstExprFromLL(vc, 36, 64),
+                             vc_bvConstExprFromLL(vc, 64, 5));
+  vc_assertFormula(vc, vc_eqExpr(vc, x, vc_bvConstExprFromInt(vc, 8, 200)));
+  vc_assertFormula(vc, vc_eqExpr(vc, y, big));
+  vc_assertFormula(vc, b);
+  ASSERT_EQ(0, vc_query(vc, vc_falseExpr(vc))); // Invalid.
+
+  Expr exprs[] = {x, y, b};
+  ASSERT_EQ(4u, vc_getCounterExampleWords(vc, exprs, 3, NULL, 0));
+
+  std::vector<uint64_t> words(4, 99);
+  ASSERT_EQ(4u, vc_getCounterExampleWords(vc, exprs, 3, words.data(), 4));
+  ASSERT_EQ(200u, words[0]);
+  ASSERT_EQ(5u, words[1]);
+  ASSERT_EQ(64u, words[2]);
+  ASSERT_EQ(1u, words[3]);
+  vc_Destroy(vc);
+}
+
+TEST(counterexample_words, arrays)
+{
+  VC vc = vc_createValidityChecker();
+  Type bv8 = vc_bvType(vc, 8);
+  Expr a = vc_varExpr(vc, "a", vc_arrayType(vc, bv8, bv8));
+  Expr c = vc_varExpr(vc, "c", vc_arrayType(vc, bv8, bv8));
+
+  for (int k = 0; k < 3; k++)
+  {
+    Expr r = vc_readExpr(vc, a, vc_bvConstExprFromInt(vc, 8, k));
+    vc_assertFormula(vc, vc_eqExpr(vc, r, vc_bvConstExprFromInt(vc, 8, 10 + k)));
+  }
+  Expr r = vc_readExpr(vc, c, vc_bvConstExprFromInt(vc, 8, 7));
+  vc_assertFormula(vc, vc_eqExpr(vc, r, vc_bvConstExprFromInt(vc, 8, 70)));
+  ASSERT_EQ(0, vc_query(vc, vc_falseExpr(vc))); // Invalid.
+
+  Expr arrays[] = {a, c};
+  int sizes[2];
+  std::vector<uint64_t> words(8);
+  ASSERT_EQ(8u, vc_getCounterExampleArrayWords(vc, arrays, 2, words.data(),
+                                               words.size(), sizes));
+  ASSERT_EQ(3, sizes[0]);
+  ASSERT_EQ(1, sizes[1]);
+
+  // Each entry is an index word followed by a value word.
+  for (int k = 0; k < 3; k++)
+    ASSERT_EQ(words[2 * k] + 10, words[2 * k + 1]);
+  ASSERT_EQ(7u, words[6]);
+  ASSERT_EQ(70u, words[7]);
+  vc_Destroy(vc);
+}
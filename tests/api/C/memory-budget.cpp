@@ -0,0 +1,58 @@
+/***********
+AUTHORS:   Trevor Hansen, Dan Liew
+
+BEGIN DATE: Nov, 2011
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**********************/
+
+
+#include "stp/c_interface.h"
+#include <gtest/gtest.h>
+
+// Splits a 64-bit number into a product of three numbers greater than one.
+// Bit-blasting the two multiplications takes a few megabytes.
+static void factor(VC vc, unsigned long long n)
+{
+  Type bv64 = vc_bvType(vc, 64);
+  Expr one = vc_bvConstExprFromLL(vc, 64, 1);
+  Expr product = one;
+  for (int i = 0; i < 3; i++)
+  {
+    char name[10];
+    sprintf(name, "x%d", i);
+    Expr x = vc_varExpr(vc, name, bv64);
+    vc_assertFormula(vc, vc_bvGtExpr(vc, x, one));
+    product = vc_bvMultExpr(vc, 64, product, x);
+  }
+  vc_assertFormula(vc, vc_eqExpr(vc, product, vc_bvConstExprFromLL(vc, 64, n)));
+}
+
+TEST(memory_budget, gives_up)
+{
+  VC vc = vc_createValidityChecker();
+  vc_setMemoryBudget(vc, 1);
+  factor(vc, 4294967291ULL * 4294967279ULL);
+  ASSERT_EQ(3, vc_query(vc, vc_falseExpr(vc))); // Timeout.
+  vc_Destroy(vc);
+}
+
+TEST(memory_budget, enough)
+{
+  VC vc = vc_createValidityChecker();
+  vc_setMemoryBudget(vc, 1000);
+  factor(vc, 4294967291ULL * 4294967279ULL);
+  ASSERT_EQ(0, vc_query(vc, vc_falseExpr(vc))); // Invalid.
+  vc_Destroy(vc);
+}
@@ -0,0 +1,79 @@
+/***********
+AUTHORS:   Trevor Hansen, Dan Liew
+
+BEGIN DATE: Nov, 2011
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**********************/
+
+
+#include "stp/c_interface.h"
+#include <gtest/gtest.h>
+
+// A long chain of writes, mostly to constant indexes, with one write to the
+// symbolic index "j" half way along. Cell "k" holds "k" except where "j"
+// points, which holds 200.
+static Expr chain(VC vc, Expr j)
+{
+  Type bv8 = vc_bvType(vc, 8);
+  Expr a = vc_varExpr(vc, "a", vc_arrayType(vc, bv8, bv8));
+  for (int k = 0; k < 100; k++)
+  {
+    if (k == 50)
+      a = vc_writeExpr(vc, a, j, vc_bvConstExprFromInt(vc, 8, 200));
+    a = vc_writeExpr(vc, a, vc_bvConstExprFromInt(vc, 8, k),
+                     vc_bvConstExprFromInt(vc, 8, k));
+  }
+  return a;
+}
+
+TEST(write_chain, constant_reads)
+{
+  VC vc = vc_createValidityChecker();
+  Expr j = vc_varExpr(vc, "j", vc_bvType(vc, 8));
+  Expr a = chain(vc, j);
+
+  // Cells written after "j" always hold their own index.
+  for (int k = 50; k < 100; k += 7)
+  {
+    Expr r = vc_readExpr(vc, a, vc_bvConstExprFromInt(vc, 8, k));
+    Expr e = vc_eqExpr(vc, r, vc_bvConstExprFromInt(vc, 8, k));
+    ASSERT_EQ(1, vc_query(vc, e)); // Valid.
+  }
+
+  // Only "j" can make cell 10 hold 200.
+  Expr r = vc_readExpr(vc, a, vc_bvConstExprFromInt(vc, 8, 10));
+  vc_assertFormula(vc, vc_eqExpr(vc, r, vc_bvConstExprFromInt(vc, 8, 200)));
+  ASSERT_EQ(0, vc_query(vc, vc_falseExpr(vc))); // Invalid.
+  ASSERT_EQ(10u, getBVUnsigned(vc_getCounterExample(vc, j)));
+  vc_Destroy(vc);
+}
+
+TEST(write_chain, unwritten_cell)
+{
+  VC vc = vc_createValidityChecker();
+  Type bv8 = vc_bvType(vc, 8);
+  Expr j = vc_varExpr(vc, "j", bv8);
+  Expr a = chain(vc, j);
+  Expr base = vc_varExpr(vc, "a", vc_arrayType(vc, bv8, bv8));
+  Expr i = vc_bvConstExprFromInt(vc, 8, 150);
+  Expr v = vc_bvConstExprFromInt(vc, 8, 200);
+
+  // Cell 150 is only written through "j", so if "j" points elsewhere, cell
+  // 150 still holds whatever the base array had there.
+  vc_assertFormula(vc, vc_eqExpr(vc, vc_readExpr(vc, a, i), v));
+  vc_assertFormula(vc, vc_bvLtExpr(vc, j, vc_bvConstExprFromInt(vc, 8, 100)));
+  ASSERT_EQ(1, vc_query(vc, vc_eqExpr(vc, vc_readExpr(vc, base, i), v)));
+  vc_Destroy(vc);
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+"""
+Starts "stp --server" on a socket, sends it one request, then stops it with
+SIGTERM. Prints the response, then whether the server exited and removed its
+socket. The socket is in a new temporary directory, as its path is limited to
+about a hundred bytes.
+
+Usage: server_client.py REQUEST SOLVER [ARGS...]
+"""
+
+import os
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+TIMEOUT = 30
+
+
+def read_exactly(sock, size):
+    data = b""
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise IOError("the server closed the connection")
+        data += chunk
+    return data
+
+
+def read_frame(sock):
+    length = b""
+    while True:
+        c = read_exactly(sock, 1)
+        if c == b"\n":
+            break
+        length += c
+    return read_exactly(sock, int(length))
+
+
+def connect(path, server):
+    deadline = time.time() + TIMEOUT
+    while True:
+        if server.poll() is not None:
+            raise IOError("the server exited with %d" % server.returncode)
+        try:
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            sock.connect(path)
+            return sock
+        except socket.error:
+            sock.close()
+            if time.time() > deadline:
+                raise
+            time.sleep(0.05)
+
+
+def main():
+    request_file = sys.argv[1]
+    solver = sys.argv[2:]
+    directory = tempfile.mkdtemp()
+    path = os.path.join(directory, "stp.sock")
+
+    with open(request_file, "rb") as f:
+        request = f.read()
+
+    server = subprocess.Popen(solver + ["--server", path])
+    try:
+        sock = connect(path, server)
+        sock.sendall(str(len(request)).encode() + b"\n" + request)
+        sys.stdout.write(read_frame(sock).decode())
+        sock.close()
+    except Exception:
+        server.kill()
+        raise
+
+    server.send_signal(signal.SIGTERM)
+    deadline = time.time() + TIMEOUT
+    while server.poll() is None and time.time() < deadline:
+        time.sleep(0.05)
+    if server.poll() is None:
+        server.kill()
+        print("still running")
+        return 1
+
+    print("exited %d" % server.returncode)
+    if os.path.exists(path):
+        print("socket left")
+        os.unlink(path)
+    else:
+        print("socket removed")
+    os.rmdir(directory)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,10 @@
+; REQUIRES: shell
+; RUN: %python %S/Inputs/server_client.py %s %solver | %OutputCheck %s
+(set-logic QF_BV)
+(declare-fun x () (_ BitVec 8))
+(assert (= (bvmul x (_ bv3 8)) (_ bv21 8)))
+; CHECK-NEXT: ^sat
+(check-sat)
+(exit)
+; CHECK-NEXT: ^exited 0
+; CHECK-NEXT: ^socket removed
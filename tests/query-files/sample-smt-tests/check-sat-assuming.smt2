@@ -0,0 +1,23 @@
+; RUN: %solver %s | %OutputCheck %s
+(set-logic QF_BV)
+(declare-fun p () Bool)
+(declare-fun q () Bool)
+(declare-fun r () Bool)
+(declare-fun x () (_ BitVec 8))
+
+(assert (=> p q))
+(assert (= r (= x (_ bv5 8))))
+
+; CHECK-NEXT: ^unsat
+(check-sat-assuming (p r (not q)))
+; CHECK-NEXT: ^\(p \(not q\)\)
+(get-unsat-assumptions)
+
+; The assumptions don't persist.
+; CHECK-NEXT: ^sat
+(check-sat-assuming (p))
+; CHECK-NEXT: ^sat
+(check-sat-assuming ())
+; CHECK-NEXT: ^sat
+(check-sat)
+(exit)
@@ -0,0 +1,30 @@
+; RUN: %solver %s | %OutputCheck %s
+(set-option :produce-unsat-cores true)
+(set-logic QF_BV)
+(declare-fun x () (_ BitVec 8))
+(declare-fun y () (_ BitVec 8))
+
+(assert (! (= x (_ bv1 8)) :named a))
+(assert (! (= y (_ bv3 8)) :named c))
+; CHECK-NEXT: ^sat
+(check-sat)
+
+(push 1)
+(assert (! (= x (_ bv2 8)) :named b))
+; CHECK-NEXT: ^unsat
+(check-sat)
+; CHECK-NEXT: ^\(a b\)
+(get-unsat-core)
+(pop 1)
+
+; The named assertion was popped away with its frame.
+; CHECK-NEXT: ^sat
+(check-sat)
+
+; Unnamed assertions are never in the core.
+(assert (bvult y (_ bv3 8)))
+; CHECK-NEXT: ^unsat
+(check-sat)
+; CHECK-NEXT: ^\(c\)
+(get-unsat-core)
+(exit)
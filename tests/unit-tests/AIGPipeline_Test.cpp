@@ -0,0 +1,107 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/ToSat/AIGPipeline.h"
+#include <gtest/gtest.h>
+
+using stp::AIGPipeline;
+
+namespace
+{
+// Majority functions, written with a redundant term.
+Aig_Man_t* redundant(int inputs)
+{
+  Aig_Man_t* aig = Aig_ManStart(1000);
+  std::vector<Aig_Obj_t*> pis;
+  for (int i = 0; i < inputs; i++)
+    pis.push_back(Aig_ObjCreatePi(aig));
+
+  Aig_Obj_t* all = Aig_ManConst1(aig);
+  for (int i = 0; i + 2 < inputs; i++)
+  {
+    Aig_Obj_t* a = pis[i];
+    Aig_Obj_t* b = pis[i + 1];
+    Aig_Obj_t* c = pis[i + 2];
+    Aig_Obj_t* ab = Aig_And(aig, a, b);
+    Aig_Obj_t* maj =
+        Aig_Or(aig, Aig_Or(aig, ab, Aig_And(aig, a, c)), Aig_And(aig, b, c));
+    maj = Aig_Or(aig, maj, Aig_And(aig, ab, c));
+    all = Aig_And(aig, all, maj);
+  }
+  Aig_ObjCreatePo(aig, all);
+  return aig;
+}
+} // namespace
+
+TEST(AIGPipeline, parse)
+{
+  const std::vector<AIGPipeline::Pass> passes = AIGPipeline::parse("rw,b,rwz");
+  ASSERT_EQ(passes.size(), 3u);
+  ASSERT_EQ(passes[0], AIGPipeline::REWRITE);
+  ASSERT_EQ(passes[1], AIGPipeline::BALANCE);
+  ASSERT_EQ(passes[2], AIGPipeline::REWRITE_ZEROS);
+  ASSERT_TRUE(AIGPipeline::parse("").empty());
+}
+
+TEST(AIGPipeline, shrinks)
+{
+  stp::UserDefinedFlags uf;
+  Aig_Man_t* aig = redundant(12);
+  const int before = Aig_ManNodeNum(aig);
+
+  AIGPipeline pipeline(uf, AIGPipeline::parse("rw,b"), 3);
+  pipeline.run(aig);
+  ASSERT_LT(Aig_ManNodeNum(aig), before);
+  ASSERT_LT(0u, pipeline.getRuns(AIGPipeline::REWRITE));
+  ASSERT_LT(0u, pipeline.getRuns(AIGPipeline::BALANCE));
+  ASSERT_EQ(pipeline.getRuns(AIGPipeline::REWRITE_ZEROS), 0u);
+  ASSERT_EQ(Aig_ManPiNum(aig), 12);
+  ASSERT_EQ(Aig_ManPoNum(aig), 1);
+
+  // The library is started once, so running again is fine.
+  AIGPipeline again(uf, AIGPipeline::parse("rwz"), 1);
+  again.run(aig);
+  Aig_ManStop(aig);
+}
+
+TEST(AIGPipeline, budgets)
+{
+  stp::UserDefinedFlags uf;
+  uf.aig_node_limit = 10;
+  Aig_Man_t* aig = redundant(12);
+  const int before = Aig_ManNodeNum(aig);
+
+  AIGPipeline pipeline(uf, AIGPipeline::parse("rw"), 3);
+  pipeline.run(aig);
+  ASSERT_EQ(Aig_ManNodeNum(aig), before);
+  ASSERT_EQ(pipeline.getRuns(AIGPipeline::REWRITE), 0u);
+
+  uf.aig_node_limit = -1;
+  uf.aig_time_budget_ms = 0;
+  pipeline.run(aig);
+  ASSERT_EQ(Aig_ManNodeNum(aig), before);
+  ASSERT_EQ(pipeline.getRuns(AIGPipeline::REWRITE), 0u);
+
+  // With the budgets lifted, the same pipeline does run.
+  uf.aig_time_budget_ms = -1;
+  pipeline.run(aig);
+  ASSERT_LT(0u, pipeline.getRuns(AIGPipeline::REWRITE));
+  Aig_ManStop(aig);
+}
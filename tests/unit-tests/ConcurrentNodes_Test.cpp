@@ -0,0 +1,84 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/NodeFactory/SimplifyingNodeFactory.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using stp::ASTVec;
+
+// Each thread builds the same nodes, dropping some along the way. The
+// simplifying factory has state, so each thread needs its own.
+static void build(stp::STPMgr* mgr, ASTVec* out)
+{
+  CONSTANTBV::BitVector_Boot();
+  NodeFactory* hf = mgr->hashingNodeFactory;
+  SimplifyingNodeFactory simplifying(*hf, *mgr);
+  NodeFactory* nf = &simplifying;
+  for (unsigned i = 0; i < 500; i++)
+  {
+    const std::string name = "x" + std::to_string(i % 50);
+    const ASTNode x = mgr->CreateSymbol(name.c_str(), 0, 16);
+    const ASTNode c = mgr->CreateBVConst(16, i);
+    const ASTNode sum = hf->CreateTerm(stp::BVPLUS, 16, x, c);
+    hf->CreateNode(stp::BVGT, sum, c); // dropped.
+    out->push_back(hf->CreateNode(stp::NOT, hf->CreateNode(stp::EQ, sum, x)));
+    out->push_back(nf->CreateTerm(stp::BVPLUS, 16, x, mgr->CreateZeroConst(16)));
+  }
+}
+
+TEST(ConcurrentNodes, sharedBetweenThreads)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  const unsigned threads = 4;
+
+  mgr.beginConcurrent(threads);
+  std::vector<ASTVec> built(threads);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; t++)
+    workers.emplace_back(build, &mgr, &built[t]);
+  for (std::thread& w : workers)
+    w.join();
+  mgr.endConcurrent();
+
+  for (unsigned t = 1; t < threads; t++)
+    ASSERT_EQ(built[0], built[t]);
+
+  // x + 0 is x.
+  ASSERT_EQ(stp::SYMBOL, built[0][1].GetKind());
+
+  // NOTs are one more than their child, and the node numbers are unique.
+  std::set<unsigned> numbers;
+  for (unsigned i = 0; i < built[0].size(); i += 2)
+  {
+    const ASTNode& n = built[0][i];
+    ASSERT_EQ(stp::NOT, n.GetKind());
+    ASSERT_EQ(n[0].GetNodeNum() + 1, n.GetNodeNum());
+    numbers.insert(n.GetNodeNum());
+  }
+  ASSERT_EQ(500u, numbers.size());
+
+  // The nodes are still unique after the threads have finished.
+  ASTVec again;
+  build(&mgr, &again);
+  ASSERT_EQ(built[0], again);
+}
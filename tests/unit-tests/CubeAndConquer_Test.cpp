@@ -0,0 +1,139 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Sat/CubeAndConquer.h"
+#include "stp/Sat/MinisatCore.h"
+#include "stp/Sat/SimplifyingMinisat.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using stp::CubeAndConquer;
+using stp::SATSolver;
+
+namespace
+{
+SATSolver* minisat()
+{
+  return new stp::MinisatCore;
+}
+
+// Variable p * holes + h is: pigeon p is in hole h.
+std::vector<std::vector<int>> pigeons(int count, int holes)
+{
+  std::vector<std::vector<int>> clauses;
+  for (int p = 0; p < count; p++)
+  {
+    std::vector<int> somewhere;
+    for (int h = 0; h < holes; h++)
+      somewhere.push_back(2 * (p * holes + h));
+    clauses.push_back(somewhere);
+  }
+
+  for (int h = 0; h < holes; h++)
+    for (int p = 0; p < count; p++)
+      for (int q = p + 1; q < count; q++)
+        clauses.push_back({2 * (p * holes + h) + 1, 2 * (q * holes + h) + 1});
+  return clauses;
+}
+
+void add(SATSolver& s, const std::vector<std::vector<int>>& clauses)
+{
+  std::vector<int> lits, offsets(1, 0);
+  for (const auto& c : clauses)
+  {
+    lits.insert(lits.end(), c.begin(), c.end());
+    offsets.push_back(lits.size());
+  }
+  s.addClauses(lits.data(), offsets.data(), clauses.size());
+}
+
+bool satisfied(SATSolver& s, const std::vector<std::vector<int>>& clauses)
+{
+  for (const auto& c : clauses)
+  {
+    bool sat = false;
+    for (int l : c)
+      sat |= (s.modelValue(l >> 1) == s.true_literal()) != (l & 1);
+    if (!sat)
+      return false;
+  }
+  return true;
+}
+} // namespace
+
+TEST(CubeAndConquer, unsatisfiable)
+{
+  CubeAndConquer s(minisat, 4, 3);
+  s.newVars(6 * 5);
+  add(s, pigeons(6, 5));
+
+  bool timeout = false;
+  ASSERT_FALSE(s.solve(timeout));
+  ASSERT_FALSE(timeout);
+  ASSERT_EQ(s.getSplitVariables().size(), 3u);
+  ASSERT_FALSE(s.okay());
+}
+
+TEST(CubeAndConquer, satisfiable)
+{
+  const std::vector<std::vector<int>> clauses = pigeons(5, 5);
+  CubeAndConquer s(minisat, 3, 4);
+  s.newVars(5 * 5);
+  add(s, clauses);
+
+  bool timeout = false;
+  ASSERT_TRUE(s.solve(timeout));
+  ASSERT_TRUE(satisfied(s, clauses));
+
+  // Later clauses make it unsatisfiable: there's one hole fewer.
+  std::vector<std::vector<int>> full;
+  for (int p = 0; p < 5; p++)
+    full.push_back({2 * (p * 5 + 4) + 1});
+  add(s, full);
+  ASSERT_FALSE(s.solve(timeout));
+  ASSERT_FALSE(timeout);
+}
+
+TEST(CubeAndConquer, candidates)
+{
+  CubeAndConquer s(minisat, 2, 2);
+  s.newVars(4 * 4);
+  add(s, pigeons(4, 4));
+  s.setSplitCandidates({7, 3, 1});
+
+  bool timeout = false;
+  ASSERT_TRUE(s.solve(timeout));
+  ASSERT_EQ(s.getSplitVariables(), std::vector<uint32_t>({7, 3}));
+}
+
+TEST(CubeAndConquer, budget)
+{
+  CubeAndConquer s([]() -> SATSolver* { return new stp::SimplifyingMinisat; },
+                   2, 1);
+  s.newVars(8 * 7);
+  add(s, pigeons(8, 7));
+  s.setMaxConflicts(1);
+
+  // Neither cube is refuted in one conflict, so it's neither sat nor unsat.
+  bool timeout = false;
+  ASSERT_FALSE(s.solve(timeout));
+  ASSERT_TRUE(timeout);
+  ASSERT_TRUE(s.okay());
+}
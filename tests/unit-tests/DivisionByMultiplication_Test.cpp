@@ -0,0 +1,126 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Sat/MinisatCore.h"
+#include "stp/Simplifier/Simplifier.h"
+#include "stp/ToSat/BBNodeManagerAIG.h"
+#include "stp/ToSat/BitBlaster.h"
+#include "stp/ToSat/ToSATAIG.h"
+#include <gtest/gtest.h>
+
+using stp::BBNodeAIG;
+using stp::BBNodeManagerAIG;
+using stp::BitBlaster;
+
+namespace
+{
+struct Query
+{
+  stp::STPMgr mgr;
+  NodeFactory* nf;
+  ASTNode x, y;
+
+  Query()
+  {
+    CONSTANTBV::BitVector_Boot();
+    nf = mgr.hashingNodeFactory;
+    x = mgr.CreateSymbol("x", 0, 8);
+    y = mgr.CreateSymbol("y", 0, 8);
+    mgr.UserFlags.division_by_multiplication = true;
+  }
+
+  ASTNode constant(unsigned v) { return mgr.CreateBVConst(8, v); }
+
+  // x / y = q and x % y = r.
+  ASTNode divMod(const ASTNode& divisor, unsigned q, unsigned r)
+  {
+    return nf->CreateNode(
+        stp::AND,
+        nf->CreateNode(stp::EQ, nf->CreateTerm(stp::BVDIV, 8, x, divisor),
+                       constant(q)),
+        nf->CreateNode(stp::EQ, nf->CreateTerm(stp::BVMOD, 8, x, divisor),
+                       constant(r)));
+  }
+};
+} // namespace
+
+// The division and remainder of the same operands share one quotient and
+// one remainder.
+TEST(DivisionByMultiplication, shared)
+{
+  Query q;
+  stp::SubstitutionMap sm(&q.mgr);
+  stp::Simplifier simp(&q.mgr, &sm);
+  BBNodeManagerAIG nm;
+  {
+    BitBlaster<BBNodeAIG, BBNodeManagerAIG> bb(&nm, &simp, q.nf,
+                                               &q.mgr.UserFlags);
+    const unsigned before = q.mgr._symbol_count;
+    bb.BBForm(q.divMod(q.y, 3, 1));
+    ASSERT_EQ(before + 2, q.mgr._symbol_count);
+  }
+  nm.stop();
+}
+
+// Simplifying with the bit-blaster sees the quotient and remainder without
+// their constraints.
+TEST(DivisionByMultiplication, getConsts)
+{
+  Query q;
+  stp::SubstitutionMap sm(&q.mgr);
+  stp::Simplifier simp(&q.mgr, &sm);
+  const ASTNode masked =
+      q.nf->CreateTerm(stp::BVAND, 8, q.y, q.constant(0));
+  const ASTNode form = q.nf->CreateNode(
+      stp::AND, q.divMod(q.y, 3, 1),
+      q.nf->CreateNode(stp::BVLT, masked, q.x));
+
+  BBNodeManagerAIG nm;
+  {
+    BitBlaster<BBNodeAIG, BBNodeManagerAIG> bb(&nm, &simp, q.nf,
+                                               &q.mgr.UserFlags);
+    stp::ASTNodeMap fromTo, equivs;
+    bb.getConsts(form, fromTo, equivs);
+    ASSERT_TRUE(fromTo.find(masked) != fromTo.end());
+    ASSERT_EQ(q.constant(0), fromTo[masked]);
+  }
+  nm.stop();
+}
+
+TEST(DivisionByMultiplication, solve)
+{
+  Query q;
+  stp::ToSATAIG toSAT(&q.mgr, NULL);
+  stp::MinisatCore solver;
+  Cnf_Dat_t* cnf = toSAT.bitblast(q.divMod(q.constant(5), 3, 1), false);
+  toSAT.add_cnf_to_solver(solver, cnf);
+  toSAT.release_cnf_memory(cnf);
+
+  bool timeout = false;
+  ASSERT_TRUE(solver.solve(timeout));
+
+  // x is 3 * 5 + 1.
+  const vector<unsigned>& bits = toSAT.SATVar_to_SymbolIndexMap()[q.x];
+  unsigned x = 0;
+  for (unsigned i = 0; i < bits.size(); i++)
+    if (solver.modelValue(bits[i]) == solver.true_literal())
+      x |= 1u << i;
+  ASSERT_EQ(16u, x);
+}
@@ -0,0 +1,135 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Simplifier/LinearSystemSolver.h"
+#include "stp/Simplifier/SubstitutionMap.h"
+#include <gtest/gtest.h>
+
+using stp::ASTNodeMap;
+using stp::LinearSystemSolver;
+
+namespace
+{
+struct System
+{
+  stp::STPMgr mgr;
+  stp::SubstitutionMap sm;
+  stp::Simplifier simp;
+  NodeFactory* nf;
+  ASTNode x, y, z;
+  ASTVec equations;
+
+  System() : sm(&mgr), simp(&mgr, &sm), nf(mgr.hashingNodeFactory)
+  {
+    x = mgr.CreateSymbol("x", 0, 8);
+    y = mgr.CreateSymbol("y", 0, 8);
+    z = mgr.CreateSymbol("z", 0, 8);
+  }
+
+  ASTNode c(unsigned value) { return mgr.CreateBVConst(8, value); }
+
+  ASTNode times(unsigned a, const ASTNode& v)
+  {
+    return nf->CreateTerm(stp::BVMULT, 8, c(a), v);
+  }
+
+  void add(ASTVec lhs, unsigned rhs)
+  {
+    equations.push_back(nf->CreateNode(
+        stp::EQ, nf->CreateTerm(stp::BVPLUS, 8, lhs), c(rhs)));
+  }
+
+  ASTNode solve()
+  {
+    LinearSystemSolver solver(&mgr, &simp, nf);
+    return solver.topLevel(nf->CreateNode(stp::AND, equations));
+  }
+
+  // Whether the equations hold once the solved symbols are substituted, and
+  // the remaining (fresh) symbols are given "value".
+  bool holds(unsigned value)
+  {
+    ASTNode n = simp.applySubstitutionMap(nf->CreateNode(stp::AND, equations));
+    ASTNodeMap fromTo;
+    for (const ASTNode& s : mgr.getSymbols())
+      fromTo[s] = mgr.CreateBVConst(s.GetValueWidth(), value);
+    ASTNodeMap cache;
+    n = stp::SubstitutionMap::replace(n, fromTo, cache, nf);
+    return mgr.ASTTrue == stp::NonMemberBVConstEvaluator(&mgr, n);
+  }
+};
+}
+
+TEST(LinearSystemSolver, oddSystem)
+{
+  CONSTANTBV::BitVector_Boot();
+  System s;
+  // Every symbol appears in every equation, with an odd coefficient in one.
+  s.add({s.x, s.times(3, s.y), s.times(5, s.z)}, 22);
+  s.add({s.times(7, s.x), s.y, s.times(2, s.z)}, 15);
+  s.add({s.times(2, s.x), s.times(6, s.y), s.z}, 17);
+
+  ASSERT_EQ(s.mgr.ASTTrue, s.solve());
+  ASSERT_TRUE(s.simp.InsideSubstitutionMap(s.x));
+  ASSERT_TRUE(s.simp.InsideSubstitutionMap(s.y));
+  ASSERT_TRUE(s.simp.InsideSubstitutionMap(s.z));
+  ASSERT_TRUE(s.holds(0));
+}
+
+TEST(LinearSystemSolver, evenCoefficients)
+{
+  CONSTANTBV::BitVector_Boot();
+  System s;
+  // 2x + 4y = 6 and 6x + 2y = 2 fix only the low bits of x and y.
+  s.add({s.times(2, s.x), s.times(4, s.y)}, 6);
+  s.add({s.times(6, s.x), s.times(2, s.y)}, 2);
+
+  ASSERT_EQ(s.mgr.ASTTrue, s.solve());
+  for (unsigned value : {0u, 1u, 0x80u, 0xffu})
+    ASSERT_TRUE(s.holds(value));
+}
+
+TEST(LinearSystemSolver, unsatisfiable)
+{
+  CONSTANTBV::BitVector_Boot();
+  System s;
+  // 2*(2x + 4y = 6) - (4x + 8y = 5) gives 0 = 7.
+  s.add({s.times(2, s.x), s.times(4, s.y)}, 6);
+  s.add({s.times(4, s.x), s.times(8, s.y)}, 5);
+
+  ASSERT_EQ(s.mgr.ASTFalse, s.solve());
+}
+
+TEST(LinearSystemSolver, keepsNonLinear)
+{
+  CONSTANTBV::BitVector_Boot();
+  System s;
+  s.add({s.x, s.y}, 3);
+  s.add({s.x, s.times(255, s.y)}, 1);
+  const ASTNode product = s.nf->CreateNode(
+      stp::EQ, s.nf->CreateTerm(stp::BVMULT, 8, s.y, s.z), s.c(4));
+  s.equations.push_back(product);
+
+  const ASTNode result = s.solve();
+  ASSERT_FALSE(s.simp.InsideSubstitutionMap(s.z));
+  ASSERT_EQ(s.simp.applySubstitutionMap(product), result);
+  ASSERT_TRUE(s.simp.InsideSubstitutionMap(s.x));
+  ASSERT_TRUE(s.simp.InsideSubstitutionMap(s.y));
+}
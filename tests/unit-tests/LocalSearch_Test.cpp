@@ -0,0 +1,110 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Simplifier/LocalSearch.h"
+#include "stp/Simplifier/Simplifier.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+
+using stp::ASTNodeMap;
+using stp::LocalSearch;
+
+namespace
+{
+ASTNode eval(stp::STPMgr& mgr, const ASTNode& n, const ASTNodeMap& model,
+             ASTNodeMap& cache)
+{
+  if (n.isConstant())
+    return n;
+  if (n.GetKind() == stp::SYMBOL)
+    return model.find(n)->second;
+
+  ASTNodeMap::const_iterator it = cache.find(n);
+  if (it != cache.end())
+    return it->second;
+
+  ASTVec children;
+  for (const auto& c : n.GetChildren())
+    children.push_back(eval(mgr, c, model, cache));
+
+  const ASTNode result = stp::NonMemberBVConstEvaluator(
+      &mgr, n.GetKind(), children, n.GetValueWidth());
+  cache.insert(std::make_pair(n, result));
+  return result;
+}
+} // namespace
+
+// x + y = 100, x ^ y = 84, x * 3 < y over 8 bits. The model found must
+// satisfy the formula.
+TEST(LocalSearch, finds)
+{
+  CONSTANTBV::BitVector_Boot(); // before the manager allocates constants.
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+
+  const ASTNode sum = nf->CreateTerm(stp::BVPLUS, 8, x, y);
+  const ASTNode diff = nf->CreateTerm(stp::BVXOR, 8, x, y);
+  const ASTNode triple =
+      nf->CreateTerm(stp::BVMULT, 8, x, mgr.CreateBVConst(8, 3));
+  const ASTNode form = nf->CreateNode(
+      stp::AND, nf->CreateNode(stp::EQ, sum, mgr.CreateBVConst(8, 100)),
+      nf->CreateNode(stp::EQ, diff, mgr.CreateBVConst(8, 84)),
+      nf->CreateNode(stp::BVLT, triple, y));
+
+  LocalSearch search(&mgr, NULL);
+  ASTNodeMap model;
+  ASSERT_TRUE(search.search(form, 10000, model));
+  ASSERT_EQ(model.size(), 2u);
+
+  ASTNodeMap cache;
+  ASSERT_TRUE(eval(mgr, form, model, cache) == mgr.ASTTrue);
+}
+
+TEST(LocalSearch, unsatisfiable)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 16);
+
+  LocalSearch search(&mgr, NULL);
+  ASTNodeMap model;
+  ASSERT_FALSE(search.search(nf->CreateNode(stp::BVLT, x, x), 20, model));
+  ASSERT_TRUE(model.empty());
+}
+
+// Array reads are left to the refinement loop.
+TEST(LocalSearch, arrays)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode a = mgr.CreateSymbol("a", 8, 8);
+  const ASTNode i = mgr.CreateSymbol("i", 0, 8);
+  const ASTNode read = nf->CreateTerm(stp::READ, 8, a, i);
+
+  LocalSearch search(&mgr, NULL);
+  ASTNodeMap model;
+  ASSERT_FALSE(search.search(
+      nf->CreateNode(stp::EQ, read, mgr.CreateBVConst(8, 7)), 1000, model));
+  ASSERT_EQ(search.movesMade(), 0u);
+}
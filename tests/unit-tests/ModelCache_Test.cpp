@@ -0,0 +1,84 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/AbsRefineCounterExample/ModelCache.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+
+using stp::ASTNodeMap;
+using stp::ModelCache;
+
+TEST(ModelCache, unsatisfiableSubsets)
+{
+  CONSTANTBV::BitVector_Boot(); // before the manager allocates constants.
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+  const ASTNode a = nf->CreateNode(stp::BVLT, x, y);
+  const ASTNode b = nf->CreateNode(stp::BVLT, y, x);
+  const ASTNode c = nf->CreateNode(stp::EQ, x, mgr.CreateZeroConst(8));
+
+  ModelCache cache;
+  ASSERT_FALSE(cache.knownUnsatisfiable(nf->CreateNode(stp::AND, a, b)));
+  cache.addUnsatisfiable(nf->CreateNode(stp::AND, a, b), 2);
+
+  ASSERT_TRUE(cache.knownUnsatisfiable(nf->CreateNode(stp::AND, b, a)));
+  ASSERT_TRUE(cache.knownUnsatisfiable(
+      nf->CreateNode(stp::AND, c, nf->CreateNode(stp::AND, a, b))));
+  ASSERT_FALSE(cache.knownUnsatisfiable(nf->CreateNode(stp::AND, a, c)));
+  ASSERT_FALSE(cache.knownUnsatisfiable(a));
+
+  // Capacity evicts the oldest.
+  cache.addUnsatisfiable(c, 1);
+  ASSERT_TRUE(cache.knownUnsatisfiable(nf->CreateNode(stp::AND, a, c)));
+  ASSERT_FALSE(cache.knownUnsatisfiable(nf->CreateNode(stp::AND, a, b)));
+}
+
+TEST(ModelCache, models)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+  const ASTNode sum = mgr.CreateTerm(stp::BVPLUS, 8, x, y);
+
+  ASTNodeMap first;
+  first[x] = mgr.CreateOneConst(8);
+  first[sum] = mgr.CreateOneConst(8); // memoised terms aren't kept.
+  ASTNodeMap second;
+  second[y] = mgr.CreateZeroConst(8);
+
+  ModelCache cache;
+  cache.addModel(first, 2);
+  cache.addModel(second, 2);
+  ASSERT_EQ(cache.getModels().size(), 2u);
+  ASSERT_EQ(cache.getModels()[1].size(), 1u);
+  ASSERT_TRUE(cache.getModels()[1].count(x) == 1);
+
+  cache.used(1);
+  ASSERT_TRUE(cache.getModels()[0].count(x) == 1);
+
+  // The least recently used goes.
+  cache.addModel(first, 2);
+  ASSERT_EQ(cache.getModels().size(), 2u);
+  ASSERT_TRUE(cache.getModels()[1].count(x) == 1);
+  ASSERT_TRUE(cache.getModels()[0].count(x) == 1);
+}
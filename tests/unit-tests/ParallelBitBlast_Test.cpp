@@ -0,0 +1,144 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Sat/MinisatCore.h"
+#include "stp/ToSat/ToSATAIG.h"
+#include <gtest/gtest.h>
+
+using stp::ASTVec;
+using stp::ToSATAIG;
+
+namespace
+{
+struct Query
+{
+  stp::STPMgr mgr;
+  NodeFactory* nf;
+  ASTNode x, y;
+  ASTVec conjuncts;
+
+  // x * 3 = 21, y + 1 = 10, and x + 2 = y, which only share symbols.
+  Query()
+  {
+    CONSTANTBV::BitVector_Boot();
+    nf = mgr.hashingNodeFactory;
+    x = mgr.CreateSymbol("x", 0, 8);
+    y = mgr.CreateSymbol("y", 0, 8);
+    conjuncts.push_back(nf->CreateNode(
+        stp::EQ, nf->CreateTerm(stp::BVMULT, 8, x, constant(3)),
+        constant(21)));
+    conjuncts.push_back(nf->CreateNode(
+        stp::EQ, nf->CreateTerm(stp::BVPLUS, 8, y, constant(1)),
+        constant(10)));
+    conjuncts.push_back(nf->CreateNode(
+        stp::EQ, nf->CreateTerm(stp::BVPLUS, 8, x, constant(2)), y));
+  }
+
+  ASTNode constant(unsigned v) { return mgr.CreateBVConst(8, v); }
+
+  ASTNode all() { return nf->CreateNode(stp::AND, conjuncts); }
+
+  // Solves the query with bit-blasting split between three threads. On
+  // success "model" is the value of "v".
+  bool solve(unsigned& model, const ASTNode& v)
+  {
+    mgr.UserFlags.bitblast_threads = 3;
+    ToSATAIG toSAT(&mgr, NULL);
+    stp::MinisatCore solver;
+    Cnf_Dat_t* cnf = toSAT.bitblast(all(), false);
+    toSAT.add_cnf_to_solver(solver, cnf);
+    toSAT.release_cnf_memory(cnf);
+
+    bool timeout = false;
+    if (!solver.solve(timeout))
+      return false;
+
+    const vector<unsigned>& bits = toSAT.SATVar_to_SymbolIndexMap()[v];
+    model = 0;
+    for (unsigned i = 0; i < bits.size(); i++)
+      if (solver.modelValue(bits[i]) == solver.true_literal())
+        model |= 1u << i;
+    return true;
+  }
+};
+} // namespace
+
+TEST(ParallelBitBlast, partition)
+{
+  Query q;
+  const vector<ASTVec> groups = ToSATAIG::partition(q.all(), 3);
+  ASSERT_EQ(3u, groups.size());
+  for (const ASTVec& g : groups)
+    ASSERT_EQ(1u, g.size());
+
+  // A conjunct sharing x * 3 goes with the first one.
+  q.conjuncts.push_back(q.nf->CreateNode(
+      stp::BVGT, q.nf->CreateTerm(stp::BVMULT, 8, q.x, q.constant(3)),
+      q.constant(1)));
+  size_t largest = 0;
+  for (const ASTVec& g : ToSATAIG::partition(q.all(), 8))
+    largest = std::max(largest, g.size());
+  ASSERT_EQ(2u, largest);
+
+  ASSERT_EQ(1u, ToSATAIG::partition(q.all(), 1).size());
+}
+
+TEST(ParallelBitBlast, satisfiable)
+{
+  Query q;
+  unsigned x = 0;
+  ASSERT_TRUE(q.solve(x, q.x));
+  ASSERT_EQ(7u, x);
+}
+
+TEST(ParallelBitBlast, unsatisfiable)
+{
+  Query q;
+  q.conjuncts.push_back(q.nf->CreateNode(stp::EQ, q.x, q.constant(8)));
+  unsigned x = 0;
+  ASSERT_FALSE(q.solve(x, q.x));
+}
+
+// Signed division is rewritten into new nodes while bit-blasting, in each
+// thread.
+TEST(ParallelBitBlast, signedDivision)
+{
+  Query q;
+  q.conjuncts.clear();
+  auto eq = [&](stp::Kind k, const ASTNode& a, unsigned b, unsigned result) {
+    q.conjuncts.push_back(q.nf->CreateNode(
+        stp::EQ, q.nf->CreateTerm(k, 8, a, q.constant(b)),
+        q.constant(result)));
+  };
+
+  // x / -3 = -2 and x rem -3 = 1, so x is 7.
+  eq(stp::SBVDIV, q.x, 0xfd, 0xfe);
+  eq(stp::SBVREM, q.x, 0xfd, 1);
+  // y / 5 = -1 and y mod 5 = 3, so y is -7.
+  eq(stp::SBVDIV, q.y, 5, 0xff);
+  eq(stp::SBVMOD, q.y, 5, 3);
+  ASSERT_LT(1u, ToSATAIG::partition(q.all(), 3).size());
+
+  unsigned v = 0;
+  ASSERT_TRUE(q.solve(v, q.x));
+  ASSERT_EQ(7u, v);
+  ASSERT_TRUE(q.solve(v, q.y));
+  ASSERT_EQ(0xf9u, v);
+}
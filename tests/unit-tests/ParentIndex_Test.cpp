@@ -0,0 +1,64 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/AST/ParentIndex.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+
+using stp::ParentIndex;
+
+TEST(ParentIndex, parentsAndPolarity)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode a = mgr.CreateSymbol("a", 0, 0);
+  const ASTNode b = mgr.CreateSymbol("b", 0, 0);
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode sum = nf->CreateTerm(stp::BVPLUS, 8, x, x);
+  const ASTNode eq = nf->CreateNode(stp::EQ, sum, x);
+  const ASTNode root =
+      nf->CreateNode(stp::AND, a, nf->CreateNode(stp::NOT, b), eq);
+
+  ParentIndex index(root);
+  ASSERT_EQ(root, index.node(index.root()));
+  ASSERT_EQ(ParentIndex::none, index.find(mgr.CreateSymbol("y", 0, 8)));
+
+  // Children come first.
+  for (ParentIndex::Id i = 0; i < index.size(); i++)
+    for (const ParentIndex::Id* c = index.childrenBegin(i);
+         c != index.childrenEnd(i); c++)
+      ASSERT_LT(*c, i);
+
+  // x is used by the sum, twice, and the equality.
+  const ParentIndex::Id ix = index.find(x);
+  ASSERT_EQ(2u, index.uses(ix));
+  ASSERT_TRUE(index.isParent(index.find(sum), ix));
+  ASSERT_TRUE(index.isParent(index.find(eq), ix));
+
+  ASSERT_EQ(ParentIndex::truePolarity, index.polarity(index.find(a)));
+  ASSERT_EQ(ParentIndex::falsePolarity, index.polarity(index.find(b)));
+  ASSERT_EQ(ParentIndex::bothPolarity, index.polarity(ix));
+
+  index.removeParent(ix, index.find(sum));
+  ASSERT_EQ(1u, index.uses(ix));
+  ASSERT_FALSE(index.isParent(index.find(sum), ix));
+  ASSERT_EQ(index.find(eq), *index.parentsBegin(ix));
+}
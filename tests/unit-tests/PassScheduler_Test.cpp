@@ -0,0 +1,117 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Simplifier/PassScheduler.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+
+using stp::PassScheduler;
+
+namespace
+{
+// Removes the first conjunct whose name starts with "prefix".
+ASTNode drop(stp::STPMgr& mgr, const ASTNode& n, char prefix)
+{
+  ASTVec children = n.GetChildren();
+  for (auto it = children.begin(); it != children.end(); ++it)
+    if (it->GetKind() == stp::SYMBOL && it->GetName()[0] == prefix)
+    {
+      children.erase(it);
+      return mgr.hashingNodeFactory->CreateNode(stp::AND, children);
+    }
+  return n;
+}
+}
+
+TEST(PassScheduler, reachesAFixedPointOfEveryPass)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  ASTVec conjuncts;
+  for (const char* name : {"a1", "a2", "a3", "a4", "b1", "z1", "z2"})
+    conjuncts.push_back(mgr.CreateSymbol(name, 0, 0));
+  const ASTNode input = mgr.hashingNodeFactory->CreateNode(stp::AND, conjuncts);
+
+  PassScheduler scheduler(&mgr, -1);
+  std::vector<ASTNode> seenByIdle;
+  scheduler.add("idle", [&](const ASTNode& n) {
+    seenByIdle.push_back(n);
+    return n;
+  });
+  // Removes the b conjunct only once the a conjuncts have gone.
+  scheduler.add("b", [&](const ASTNode& n) {
+    return drop(mgr, n, 'a') == n ? drop(mgr, n, 'b') : n;
+  });
+  scheduler.add("a", [&](const ASTNode& n) { return drop(mgr, n, 'a'); });
+
+  const ASTNode result = scheduler.fixedPoint(input);
+  ASSERT_FALSE(scheduler.interrupted());
+  ASSERT_EQ(2u, result.Degree());
+
+  // The idle pass has seen the result, but not every formula on the way.
+  ASSERT_EQ(result, seenByIdle.back());
+  ASSERT_LT(seenByIdle.size(), 5u);
+  for (size_t i = 1; i < seenByIdle.size(); i++)
+    ASSERT_NE(seenByIdle[i - 1], seenByIdle[i]);
+}
+
+TEST(PassScheduler, productivePassesGoFirst)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  ASTVec conjuncts;
+  for (const char* name : {"a1", "a2", "z1"})
+    conjuncts.push_back(mgr.CreateSymbol(name, 0, 0));
+  const ASTNode input = mgr.hashingNodeFactory->CreateNode(stp::AND, conjuncts);
+
+  PassScheduler scheduler(&mgr, -1);
+  std::vector<std::string> order;
+  scheduler.add("idle", [&](const ASTNode& n) {
+    order.push_back("idle");
+    return n;
+  });
+  scheduler.add("a", [&](const ASTNode& n) {
+    order.push_back("a");
+    return drop(mgr, n, 'a');
+  });
+
+  const ASTNode once = scheduler.once(input);
+  ASSERT_EQ((std::vector<std::string>{"idle", "a"}), order);
+  ASSERT_EQ(2u, once.Degree());
+
+  order.clear();
+  ASSERT_EQ(1u, scheduler.fixedPoint(once).Degree());
+  ASSERT_EQ("a", order.front());
+}
+
+TEST(PassScheduler, stopsWhenAsked)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode input = nf->CreateNode(stp::AND, mgr.CreateSymbol("a1", 0, 0),
+                                       mgr.CreateSymbol("z1", 0, 0));
+
+  PassScheduler scheduler(&mgr, -1);
+  scheduler.add("a", [&](const ASTNode& n) { return drop(mgr, n, 'a'); });
+
+  ASSERT_EQ(input, scheduler.fixedPoint(input, [] { return false; }));
+  ASSERT_TRUE(scheduler.interrupted());
+}
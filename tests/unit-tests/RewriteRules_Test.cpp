@@ -0,0 +1,184 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/NodeFactory/RuleMatcher.h"
+#include "stp/NodeFactory/SimplifyingNodeFactory.h"
+#include "stp/Simplifier/Simplifier.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+#include <map>
+
+using stp::ASTNodeMap;
+using stp::RuleMatcher;
+
+struct Context
+{
+  stp::STPMgr mgr;
+  SimplifyingNodeFactory snf;
+
+  Context() : snf(*(mgr.hashingNodeFactory), mgr)
+  {
+    mgr.defaultNodeFactory = &snf;
+  }
+
+  ASTNode eval(const ASTNode& n, const ASTNodeMap& assignment,
+               ASTNodeMap& cache)
+  {
+    if (n.isConstant())
+      return n;
+    if (n.GetKind() == stp::SYMBOL)
+      return assignment.find(n)->second;
+
+    ASTNodeMap::const_iterator it = cache.find(n);
+    if (it != cache.end())
+      return it->second;
+
+    ASTVec children;
+    for (const auto& c : n.GetChildren())
+      children.push_back(eval(c, assignment, cache));
+
+    const ASTNode result = stp::NonMemberBVConstEvaluator(
+        &mgr, n.GetKind(), children, n.GetValueWidth());
+    cache.insert(std::make_pair(n, result));
+    return result;
+  }
+
+  // Checks a and b agree on every assignment to vars.
+  bool equivalent(const ASTNode& a, const ASTNode& b, const ASTVec& vars)
+  {
+    const bool is_bool = vars[0].GetType() == stp::BOOLEAN_TYPE;
+    const unsigned width = is_bool ? 1 : vars[0].GetValueWidth();
+    const uint64_t combinations = 1ULL << (width * vars.size());
+
+    for (uint64_t i = 0; i < combinations; i++)
+    {
+      ASTNodeMap assignment;
+      for (size_t v = 0; v < vars.size(); v++)
+      {
+        const uint64_t value = (i >> (v * width)) & ((1ULL << width) - 1);
+        if (is_bool)
+          assignment[vars[v]] = value ? mgr.ASTTrue : mgr.ASTFalse;
+        else
+          assignment[vars[v]] = mgr.CreateBVConst(width, value);
+      }
+
+      ASTNodeMap cache_a, cache_b;
+      if (eval(a, assignment, cache_a) != eval(b, assignment, cache_b))
+        return false;
+    }
+    return true;
+  }
+
+  ASTVec variables(unsigned count, bool is_bool, unsigned width)
+  {
+    ASTVec vars;
+    for (unsigned i = 0; i < count; i++)
+    {
+      const std::string name = "v" + std::to_string(i) + "_" +
+                               std::to_string(is_bool ? 0 : width);
+      vars.push_back(mgr.CreateSymbol(name.c_str(), 0, is_bool ? 0 : width));
+    }
+    return vars;
+  }
+};
+
+// Each rule's replacement must equal its pattern, for all small widths, and
+// building the pattern through the simplifying factory must not change its
+// meaning either.
+TEST(RewriteRules, sound)
+{
+  CONSTANTBV::BitVector_Boot(); // before the manager allocates constants.
+  Context c;
+  RuleMatcher& matcher = c.snf.getRuleMatcher();
+  ASSERT_GT(RuleMatcher::numberOfRules(), 0u);
+
+  for (unsigned r = 0; r < RuleMatcher::numberOfRules(); r++)
+  {
+    const stp::rules::RuleInfo& info = stp::rules::rule_info[r];
+    const unsigned first = std::max<unsigned>(1, info.min_width);
+    ASSERT_GT(info.vars, 0) << info.text;
+
+    for (unsigned width = first; width < first + 4; width++)
+    {
+      // Rules are untyped. Try bit-vector variables, then boolean ones.
+      bool built = false;
+      for (int is_bool = 0; is_bool < 2 && !built; is_bool++)
+      {
+        const ASTVec vars = c.variables(info.vars, is_bool, width);
+        const ASTNode lhs =
+            matcher.instantiate(r, true, width, vars, c.mgr.hashingNodeFactory);
+        if (lhs.IsNull())
+          continue;
+        built = true;
+
+        const ASTNode rhs =
+            matcher.instantiate(r, false, width, vars, c.mgr.hashingNodeFactory);
+        ASSERT_FALSE(rhs.IsNull()) << info.text;
+
+        ASSERT_TRUE(c.equivalent(lhs, rhs, vars))
+            << info.text << " width " << width;
+
+        const ASTNode simplified =
+            matcher.instantiate(r, true, width, vars, &c.snf);
+        ASSERT_FALSE(simplified.IsNull()) << info.text;
+        ASSERT_TRUE(c.equivalent(lhs, simplified, vars))
+            << info.text << " width " << width;
+      }
+      ASSERT_TRUE(built) << info.text;
+    }
+  }
+  ASSERT_GT(matcher.rulesApplied(), 0u);
+}
+
+TEST(RewriteRules, fires)
+{
+  CONSTANTBV::BitVector_Boot(); // before the manager allocates constants.
+  Context c;
+  const ASTNode x = c.mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = c.mgr.CreateSymbol("y", 0, 8);
+
+  // (BVOR x (BVAND x y)) -> x
+  const ASTNode a = c.mgr.CreateTerm(stp::BVAND, 8, y, x);
+  ASSERT_TRUE(c.mgr.CreateTerm(stp::BVOR, 8, a, x) == x);
+
+  // (BVXOR x (BVXOR x y)) -> y
+  const ASTNode b = c.mgr.CreateTerm(stp::BVXOR, 8, x, y);
+  ASSERT_TRUE(c.mgr.CreateTerm(stp::BVXOR, 8, x, b) == y);
+
+  // (BVMOD x one) -> zero
+  ASSERT_TRUE(c.mgr.CreateTerm(stp::BVMOD, 8, x, c.mgr.CreateOneConst(8)) ==
+              c.mgr.CreateZeroConst(8));
+
+  ASSERT_GE(c.snf.getRuleMatcher().rulesApplied(), 3u);
+}
+
+TEST(RewriteRules, disabled)
+{
+  CONSTANTBV::BitVector_Boot(); // before the manager allocates constants.
+  Context c;
+  c.mgr.UserFlags.enable_rewrite_rules = false;
+
+  const ASTNode x = c.mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = c.mgr.CreateSymbol("y", 0, 8);
+  const ASTNode a = c.mgr.CreateTerm(stp::BVAND, 8, x, y);
+  c.mgr.CreateTerm(stp::BVOR, 8, x, a);
+
+  ASSERT_EQ(c.snf.getRuleMatcher().rulesApplied(), 0u);
+}
@@ -0,0 +1,110 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/STPManager/STPManager.h"
+#include "stp/STPManager/Snapshot.h"
+#include <gtest/gtest.h>
+
+using stp::Snapshot;
+
+namespace
+{
+// A formula with symbols, a wide constant, arrays and booleans.
+Snapshot example(stp::STPMgr& mgr)
+{
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 100);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 100);
+  const ASTNode p = mgr.CreateSymbol("p", 0, 0);
+  const ASTNode a = mgr.CreateSymbol("a", 8, 100);
+  const ASTNode i = mgr.CreateSymbol("i", 0, 8);
+  const ASTNode big =
+      mgr.CreateBVConst(std::string("633825300114114700748351602689"), 10,
+                        100);
+
+  const ASTNode sum = nf->CreateTerm(stp::BVPLUS, 100, x, big);
+  const ASTNode written = nf->CreateArrayTerm(stp::WRITE, 8, 100, a, i, sum);
+  const ASTNode read = nf->CreateTerm(stp::READ, 100, written, i);
+
+  Snapshot snapshot;
+  snapshot.roots.push_back(nf->CreateNode(
+      stp::AND, p, nf->CreateNode(stp::EQ, read, y),
+      nf->CreateNode(stp::BVLT, sum, sum)));
+  snapshot.roots.push_back(mgr.ASTFalse);
+  snapshot.solverMap[mgr.CreateSymbol("z", 0, 8)] =
+      nf->CreateTerm(stp::BVNOT, 8, i);
+  return snapshot;
+}
+}
+
+TEST(Snapshot, sameManager)
+{
+  CONSTANTBV::BitVector_Boot(); // before the manager allocates constants.
+  stp::STPMgr mgr;
+  const Snapshot saved = example(mgr);
+  const std::string bytes = stp::snapshotBytes(saved);
+
+  Snapshot loaded;
+  std::string error;
+  ASSERT_TRUE(
+      stp::loadSnapshot(&mgr, bytes.data(), bytes.size(), loaded, error));
+  ASSERT_EQ(loaded.roots, saved.roots);
+  ASSERT_EQ(loaded.solverMap, saved.solverMap);
+}
+
+TEST(Snapshot, freshManager)
+{
+  CONSTANTBV::BitVector_Boot();
+  std::string bytes;
+  {
+    stp::STPMgr mgr;
+    bytes = stp::snapshotBytes(example(mgr));
+  }
+
+  stp::STPMgr mgr;
+  Snapshot loaded;
+  std::string error;
+  ASSERT_TRUE(
+      stp::loadSnapshot(&mgr, bytes.data(), bytes.size(), loaded, error));
+  ASSERT_EQ(loaded.roots.size(), 2u);
+  ASSERT_EQ(loaded.roots[0].GetKind(), stp::AND);
+  ASSERT_EQ(loaded.solverMap.size(), 1u);
+
+  // Writing it out again gives the same bytes.
+  ASSERT_EQ(stp::snapshotBytes(loaded), bytes);
+}
+
+TEST(Snapshot, rejectsDamage)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  const std::string bytes = stp::snapshotBytes(example(mgr));
+
+  Snapshot loaded;
+  std::string error;
+  ASSERT_FALSE(
+      stp::loadSnapshot(&mgr, bytes.data(), bytes.size() - 1, loaded, error));
+  ASSERT_FALSE(stp::loadSnapshot(&mgr, "not a snapshot", 14, loaded, error));
+
+  std::string versioned = bytes;
+  versioned[8] = 99;
+  ASSERT_FALSE(stp::loadSnapshot(&mgr, versioned.data(), versioned.size(),
+                                 loaded, error));
+}
@@ -0,0 +1,167 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/Simplifier/SubstitutionMap.h"
+#include "stp/STPManager/STPManager.h"
+#include <gtest/gtest.h>
+
+using stp::ASTNodeMap;
+using stp::SubstitutionMap;
+
+TEST(SubstitutionMap, rejectsLoops)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+  const ASTNode z = mgr.CreateSymbol("z", 0, 8);
+  const ASTNode w = mgr.CreateSymbol("w", 0, 8);
+
+  SubstitutionMap sm(&mgr);
+  ASSERT_FALSE(sm.UpdateSolverMap(x, nf->CreateTerm(stp::BVPLUS, 8, x, y)));
+  ASSERT_TRUE(sm.UpdateSolverMap(x, nf->CreateTerm(stp::BVPLUS, 8, y, z)));
+  ASSERT_TRUE(sm.UpdateSolverMap(z, nf->CreateTerm(stp::BVMULT, 8, w, w)));
+
+  // w -> x -> z -> w.
+  ASSERT_FALSE(sm.UpdateSolverMap(w, nf->CreateTerm(stp::BVUMINUS, 8, x)));
+  ASSERT_TRUE(sm.UpdateSolverMap(y, nf->CreateTerm(stp::BVUMINUS, 8, w)));
+  ASSERT_TRUE(sm.InsideSubstitutionMap(y));
+  ASSERT_FALSE(sm.InsideSubstitutionMap(w));
+}
+
+TEST(SubstitutionMap, variableEqualities)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  ASTVec v;
+  for (int i = 0; i < 100; i++)
+    v.push_back(mgr.CreateSymbol(("v" + std::to_string(i)).c_str(), 0, 8));
+
+  // v0 = v1 = ... = v99.
+  SubstitutionMap sm(&mgr);
+  for (int i = 0; i < 99; i++)
+    ASSERT_TRUE(sm.UpdateSubstitutionMap(v[i], v[i + 1]));
+
+  ASSERT_FALSE(sm.UpdateSolverMap(v[99], nf->CreateTerm(stp::BVUMINUS, 8, v[0])));
+  ASSERT_FALSE(sm.UpdateSolverMap(v[99], v[50]));
+
+  // Once written through, the dependencies are forgotten.
+  sm.haveAppliedSubstitutionMap();
+  ASSERT_EQ(v[99], sm.applySubstitutionMap(v[0]));
+}
+
+TEST(SubstitutionMap, replaceSkipsUnmappedParts)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+  const ASTNode a = mgr.CreateSymbol("a", 8, 8);
+  const ASTNode one = mgr.CreateOneConst(8);
+  const ASTNode read = nf->CreateTerm(stp::READ, 8, a, one);
+
+  stp::VariablesInExpression symbols;
+  ASSERT_EQ(0u, symbols.signature(one));
+  ASSERT_EQ(symbols.signature(a), symbols.signature(read));
+
+  const ASTNode product = nf->CreateTerm(stp::BVMULT, 8, y, y);
+  const ASTNode n =
+      nf->CreateNode(stp::EQ, nf->CreateTerm(stp::BVPLUS, 8, read, x), product);
+
+  ASTNodeMap fromTo;
+  fromTo[read] = y;
+  ASTNodeMap cache;
+  const ASTNode result = SubstitutionMap::replace(
+      n, fromTo, cache, nf, false, false, &symbols);
+  ASSERT_EQ(
+      nf->CreateNode(stp::EQ, nf->CreateTerm(stp::BVPLUS, 8, y, x), product),
+      result);
+}
+
+TEST(SubstitutionMap, rollback)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+  const ASTNode z = mgr.CreateSymbol("z", 0, 8);
+  const ASTNode w = mgr.CreateSymbol("w", 0, 8);
+
+  SubstitutionMap sm(&mgr);
+  ASSERT_TRUE(sm.UpdateSolverMap(x, nf->CreateTerm(stp::BVPLUS, 8, y, z)));
+
+  sm.checkpoint();
+  ASSERT_TRUE(sm.UpdateSubstitutionMap(y, w));
+  ASSERT_TRUE(sm.UpdateSolverMap(z, nf->CreateTerm(stp::BVMULT, 8, w, w)));
+
+  sm.checkpoint();
+  sm.clear();
+  ASSERT_TRUE(sm.UpdateSolverMap(w, nf->CreateTerm(stp::BVUMINUS, 8, x)));
+  sm.clear();
+  ASSERT_FALSE(sm.InsideSubstitutionMap(x));
+
+  // Back to before the clears.
+  sm.rollback();
+  ASSERT_TRUE(sm.InsideSubstitutionMap(y));
+  ASSERT_TRUE(sm.InsideSubstitutionMap(z));
+  ASSERT_FALSE(sm.InsideSubstitutionMap(w));
+  ASSERT_TRUE(sm.hasUnappliedSubstitutions());
+
+  // x -> z -> w, and y is merged with w.
+  ASSERT_FALSE(sm.UpdateSolverMap(w, nf->CreateTerm(stp::BVUMINUS, 8, x)));
+
+  sm.rollback();
+  ASSERT_EQ(1u, sm.Return_SolverMap()->size());
+  ASSERT_TRUE(sm.InsideSubstitutionMap(x));
+
+  // Without the dependencies of y and z, it doesn't loop.
+  ASSERT_TRUE(sm.UpdateSolverMap(w, nf->CreateTerm(stp::BVUMINUS, 8, z)));
+}
+
+TEST(SubstitutionMap, releaseKeepsChanges)
+{
+  CONSTANTBV::BitVector_Boot();
+  stp::STPMgr mgr;
+  NodeFactory* nf = mgr.hashingNodeFactory;
+  const ASTNode x = mgr.CreateSymbol("x", 0, 8);
+  const ASTNode y = mgr.CreateSymbol("y", 0, 8);
+  const ASTNode z = mgr.CreateSymbol("z", 0, 8);
+
+  SubstitutionMap sm(&mgr);
+  sm.checkpoint();
+  ASSERT_TRUE(sm.UpdateSolverMap(x, nf->CreateTerm(stp::BVPLUS, 8, y, z)));
+
+  sm.checkpoint();
+  sm.clear();
+  ASSERT_TRUE(sm.UpdateSubstitutionMap(y, z));
+  sm.release();
+  ASSERT_FALSE(sm.InsideSubstitutionMap(x));
+  ASSERT_TRUE(sm.InsideSubstitutionMap(y));
+
+  // The outer checkpoint undoes the inner one's changes too.
+  sm.rollback();
+  ASSERT_EQ(0u, sm.Return_SolverMap()->size());
+  ASSERT_FALSE(sm.hasUnappliedSubstitutions());
+  ASSERT_TRUE(sm.UpdateSubstitutionMap(z, y));
+}
@@ -0,0 +1,129 @@
+/***********
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+**********************/
+
+#include "stp/ToSat/XorFinder.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <vector>
+
+using stp::XorFinder;
+
+// Builds clauses in ABC's layout: pointers into one array of literals.
+struct Clauses
+{
+  std::vector<std::vector<int>> clauses;
+  std::vector<int> literals;
+  std::vector<int*> pointers;
+
+  // The clauses that encode: the XOR of vars is rhs.
+  void addXor(const std::vector<int>& vars, bool rhs)
+  {
+    const unsigned n = vars.size();
+    for (unsigned a = 0; a < (1u << n); a++)
+    {
+      std::vector<int> clause;
+      bool parity = false;
+      for (unsigned i = 0; i < n; i++)
+      {
+        const int value = (a >> i) & 1;
+        parity ^= value;
+        clause.push_back(2 * vars[i] + value);
+      }
+      if (parity != rhs)
+        clauses.push_back(clause);
+    }
+  }
+
+  int** get()
+  {
+    literals.clear();
+    for (const auto& c : clauses)
+      literals.insert(literals.end(), c.begin(), c.end());
+
+    pointers.clear();
+    int* p = literals.data();
+    for (const auto& c : clauses)
+    {
+      pointers.push_back(p);
+      p += c.size();
+    }
+    pointers.push_back(p);
+    return pointers.data();
+  }
+};
+
+TEST(XorFinder, finds)
+{
+  Clauses c;
+  c.addXor({1, 2, 3}, true);
+  c.addXor({4, 5, 6, 7}, false);
+  c.clauses.push_back({2 * 1, 2 * 4 + 1, 2 * 8}); // not part of an XOR.
+
+  XorFinder f(c.get(), c.clauses.size());
+  ASSERT_EQ(2u, f.getXors().size());
+
+  for (const XorFinder::Xor& x : f.getXors())
+  {
+    if (x.vars.size() == 3)
+    {
+      ASSERT_TRUE(x.vars == std::vector<uint32_t>({1, 2, 3}));
+      ASSERT_TRUE(x.rhs);
+    }
+    else
+    {
+      ASSERT_TRUE(x.vars == std::vector<uint32_t>({4, 5, 6, 7}));
+      ASSERT_FALSE(x.rhs);
+    }
+  }
+
+  for (size_t i = 0; i + 1 < c.clauses.size(); i++)
+    ASSERT_TRUE(f.isCovered(i));
+  ASSERT_FALSE(f.isCovered(c.clauses.size() - 1));
+}
+
+// Missing one of the clauses, it's not an XOR.
+TEST(XorFinder, incomplete)
+{
+  Clauses c;
+  c.addXor({3, 1, 2}, false);
+  c.clauses.pop_back();
+
+  XorFinder f(c.get(), c.clauses.size());
+  ASSERT_EQ(0u, f.getXors().size());
+  for (size_t i = 0; i < c.clauses.size(); i++)
+    ASSERT_FALSE(f.isCovered(i));
+}
+
+// Literal order within a clause, and repeated clauses, don't matter.
+TEST(XorFinder, unordered)
+{
+  Clauses c;
+  c.addXor({5, 9, 2}, true);
+  for (auto& clause : c.clauses)
+    std::reverse(clause.begin(), clause.end());
+  c.clauses.push_back(c.clauses[0]);
+
+  XorFinder f(c.get(), c.clauses.size());
+  ASSERT_EQ(1u, f.getXors().size());
+  ASSERT_TRUE(f.getXors()[0].vars == std::vector<uint32_t>({2, 5, 9}));
+  ASSERT_TRUE(f.getXors()[0].rhs);
+  for (size_t i = 0; i < c.clauses.size(); i++)
+    ASSERT_TRUE(f.isCovered(i));
+}
@@ -1479,10 +1479,48 @@ template <class T> std::string to_string(T i)
   return ss.str();
 }
 
+// Prints n in the syntax of lib/NodeFactory/RewriteRules.rules. Returns false
+// if it contains something that the syntax can't express.
+bool ruleText(const ASTNode& n, string& out)
+{
+  if (n.GetKind() == SYMBOL)
+  {
+    string name = n.GetName();
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    out += name;
+    return true;
+  }
+  if (n == zero)
+    out += "zero";
+  else if (n == one)
+    out += "one";
+  else if (n == maxNode)
+    out += "max";
+  else if (n == mgr->ASTTrue)
+    out += "true";
+  else if (n == mgr->ASTFalse)
+    out += "false";
+  else if (n.isConstant())
+    return false;
+  else
+  {
+    out += "(" + string(_kind_names[n.GetKind()]);
+    for (const auto& c : n.GetChildren())
+    {
+      out += " ";
+      if (!ruleText(c, out))
+        return false;
+    }
+    out += ")";
+  }
+  return true;
+}
+
 /* Writes out:
  * rewrite_data_new.cpp: rules coded in C++.
  * array.cpp: rules in SMT2 in one big conjunct.
  * rules_new.smt2: rules in SMT2 one rule per frame.
+ * rules_new.rules: rules for genrules.pl, where they can be expressed.
  */
 
 // Write out all the rules that have been discovered to various files in
@@ -1609,6 +1647,23 @@ void writeOutRules()
   }
   outputFile.close();
 
+  ///////////////
+  // The rules were found at width "bits", so only apply them from there on.
+  outputFile.open("rules_new.rules", ios::trunc);
+  for (Rewrite_system::RewriteRuleContainer::iterator it =
+           rewrite_system.toWrite.begin();
+       it != rewrite_system.toWrite.end(); it++)
+  {
+    string from, to;
+    if (!ruleText(it->getFrom(), from) || !ruleText(it->getTo(), to))
+      continue;
+    if (it->getFrom().isAtom() ||
+        mgr->NodeSize(it->getTo()) >= mgr->NodeSize(it->getFrom()))
+      continue;
+    outputFile << from << " -> " << to << " if width >= " << bits << endl;
+  }
+  outputFile.close();
+
   /////////////////
   outputFile.open("array.smt2", ios::trunc);
   ASTVec v;
@@ -167,10 +167,41 @@ void ExtraMain::create_options()
       INT64_ARG(bm->UserFlags.AIG_rewrites_iterations),
       "Iterations of AIG rewriting to perform")
 
+      ("aig-script",
+      po::value<string>(&bm->UserFlags.aig_script)
+          ->default_value(bm->UserFlags.aig_script),
+      "The AIG passes of each iteration, comma separated: rw (rewrite), "
+      "rwz (rewrite with zero-cost replacements), b (balance)")
+
+      ("aig-time-budget-ms",
+      INT64_ARG(bm->UserFlags.aig_time_budget_ms),
+      "Stop the AIG passes after this many milliseconds. -1 means never")
+
+      ("aig-node-limit",
+      INT64_ARG(bm->UserFlags.aig_node_limit),
+      "Skip the AIG passes on AIGs with more AND nodes than this. "
+      "-1 means no limit")
+
+      ("aig-min-gain-percent",
+      INT64_ARG(bm->UserFlags.aig_min_gain_percent),
+      "Stop iterating the AIG passes once an iteration removes no more than "
+      "this percentage of the nodes")
+
+      ("bitblast-threads",
+      po::value<int>(&bm->UserFlags.bitblast_threads)
+          ->default_value(bm->UserFlags.bitblast_threads),
+      "Bit-blast and convert to CNF the independent parts of the query on "
+      "this many threads")
+
       ("flattening", 
       BOOL_ARG(bm->UserFlags.enable_flatten),
       "Enable sharing-aware flattening of >2 arity nodes")
 
+      ("linear-systems",
+      BOOL_ARG(bm->UserFlags.linear_system_solve_flag),
+      "Solve the systems of linear equations that the word-level solver can't "
+      "solve one at a time")
+
       ("rewriting", 
       BOOL_ARG(bm->UserFlags.enable_sharing_aware_rewriting),
       "Enable sharing-aware rewriting")
@@ -203,6 +234,10 @@ void ExtraMain::create_options()
       BOOL_ARG(bm->UserFlags.enable_merge_same),
       "Uses simple boolean algebra rules to combine conjuncts at the top level")
 
+      ("rewrite-rules", 
+      BOOL_ARG(bm->UserFlags.enable_rewrite_rules),
+      "Apply the compiled rewrite rules when nodes are created")
+
   
       ("bit-blast-simplification", 
       INT64_ARG(bm->UserFlags.bitblast_simplification),
@@ -211,6 +246,11 @@ void ExtraMain::create_options()
       INT64_ARG(bm->UserFlags.size_reducing_fixed_point),
       "If the number of non-leaf nodes is fewer than this number, run size-reducing simplifications to a fixed-point. -1 means always.")
 
+      ("simplification-time-budget-ms",
+      INT64_ARG(bm->UserFlags.simplification_time_budget_ms),
+      "Stop running the simplification passes to a fixed point after this "
+      "many milliseconds. -1 means never")
+
       ("simplify-to-constants-only,simply_to_constants_only", 
       BOOL_ARG(bm->UserFlags.simplify_to_constants_only),
       "Use just the simplifications from the potentially size increasing suite that transform nodes to constants")
@@ -225,6 +265,21 @@ void ExtraMain::create_options()
 
   po::options_description solver_options("SAT Solver options");
   solver_options.add_options()
+      ("local-search-ms", INT64_ARG(bm->UserFlags.local_search_ms),
+       "Look for a model by word-level local search for this many "
+       "milliseconds before bit-blasting. 0 disables it")
+      ("model-cache", INT64_ARG(bm->UserFlags.model_cache_size),
+       "Remember this many models and unsatisfiable inputs, to answer later "
+       "queries without solving. 0 disables it")
+      ("cube-threads",
+       po::value<int>(&bm->UserFlags.cube_threads)
+           ->default_value(bm->UserFlags.cube_threads),
+       "Split the search into cubes, and solve them in parallel on this many "
+       "threads")
+      ("cube-depth",
+       po::value<int>(&bm->UserFlags.cube_depth)
+           ->default_value(bm->UserFlags.cube_depth),
+       "Split on this many variables, giving 2^depth cubes")
 #ifdef USE_CRYPTOMINISAT
       ("cryptominisat",
        "use cryptominisat as the solver. Only use CryptoMiniSat 5.0 or above "
@@ -232,6 +287,9 @@ void ExtraMain::create_options()
                      po::value<int>(&bm->UserFlags.num_solver_threads)
                          ->default_value(bm->UserFlags.num_solver_threads),
                      "Number of threads for cryptominisat")
+      ("xor-clauses", BOOL_ARG(bm->UserFlags.native_xor_clauses),
+       "Send the XORs found in the CNF to cryptominisat as XOR clauses, "
+       "with Gaussian elimination")
 #endif
 #ifdef USE_RISS
       ("riss",
@@ -254,7 +312,9 @@ void ExtraMain::create_options()
   po::options_description refinement_options("Refinement options");
   refinement_options.add_options()(
       "ackermanize,r", po::bool_switch(&(bm->UserFlags.ackermannisation)),
-      "eagerly encode array-read axioms (Ackermannistaion)");
+      "eagerly encode array-read axioms (Ackermannistaion)")(
+      "array-lemmas", BOOL_ARG(bm->UserFlags.array_lemmas_on_demand),
+      "when refining, only add the array-read axioms the model violates");
 
   po::options_description print_options("Printing options");
   print_options.add_options()(
@@ -307,7 +367,15 @@ void ExtraMain::create_options()
       "back, and problems solved by the preprocessing simplifier alone will "
       "not generate any CNF as the SAT solver is never invoked")(
       "output-bench", po::bool_switch(&(bm->UserFlags.output_bench_flag)),
-      "save in ABC's bench format to output.bench");
+      "save in ABC's bench format to output.bench")(
+      "save-snapshot", po::value<string>(&snapshot_out),
+      "save the parsed asserts and query to this file in STP's binary "
+      "snapshot format, which STP reads back faster than text. Not for "
+      "SMT-LIB2 input")(
+      "save-simplified-snapshot",
+      po::value<string>(&bm->UserFlags.simplified_snapshot_file),
+      "save the formula, after simplification, to this file in STP's binary "
+      "snapshot format");
 
 
   po::options_description bb_options("Bit-blasting options");
@@ -324,6 +392,10 @@ void ExtraMain::create_options()
       BOOL_ARG(bm->UserFlags.division_variant_3),
       "unsigned division encoding variant 3")
 
+    ("bb.div-mult", 
+      BOOL_ARG(bm->UserFlags.division_by_multiplication),
+      "unsigned division as a multiplication: x = q*y + r, r < y")
+
     ("bb.add-v1", 
       BOOL_ARG(bm->UserFlags.adder_variant),
       "addition encoding variant 1")
@@ -338,7 +410,7 @@ void ExtraMain::create_options()
 
     ("bb.mult-variant", 
      INT64_ARG(bm->UserFlags.multiplication_variant),
-    "unsigned multiplication variant")
+    "unsigned multiplication variant, 0 chooses for each multiplication")
 
     ("bb.mult-v2", 
       BOOL_ARG(bm->UserFlags.upper_multiplication_bound),
@@ -352,6 +424,16 @@ void ExtraMain::create_options()
 
   po::options_description misc_options("Output options");
   misc_options.add_options()
+      ("server", po::value<string>(&server_address),
+       "Serve SMT-LIB2 scripts and snapshots from a Unix socket at this "
+       "path, or from stdin if it's -, keeping STP warm between them. Each "
+       "request and response is its length in bytes, a newline, then the "
+       "bytes")
+
+      ("server-workers",
+       po::value<int>(&server_workers)->default_value(server_workers),
+       "Number of processes that serve the socket")
+
       ("exit-after-CNF",
        po::bool_switch(&(bm->UserFlags.exit_after_CNF)),
        "exit after the CNF has been generated")
@@ -366,6 +448,11 @@ void ExtraMain::create_options()
       "Number of seconds after which the SAT solver gives up. "
       "-1 means never.")
 
+      ("max-memory", 
+      INT64_ARG(bm->UserFlags.memory_budget_mb),
+      "Megabytes that a query may use before STP drops caches, skips "
+      "optional simplifications, and finally gives up. -1 means never.")
+
       ("check-sanity,d", 
         po::bool_switch(&(bm->UserFlags.check_counterexample_flag)),
         "construct counterexample and check it");
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #include "main_common.h"
 #include "extlib-abc/cnf_short.h"
 #include "stp/Parser/parser.h"
+#include "stp/STPManager/Snapshot.h"
 #include "stp/cpp_interface.h"
 #include "stp/ToSat/ToSATAIG.h"
 #include <memory>
@@ -237,6 +238,29 @@ void Main::read_file()
   }
 }
 
+// A snapshot holds the asserts and the query, and possibly the
+// substitutions made while simplifying them, which become asserts again.
+void Main::read_snapshot(ASTVec* AssertsQuery)
+{
+  bm->UserFlags.smtlib1_parser_flag = false;
+  bm->UserFlags.smtlib2_parser_flag = false;
+
+  Snapshot snapshot;
+  std::string error;
+  if (!loadSnapshot(bm, infile, snapshot, error))
+    FatalError((infile + ": " + error).c_str());
+  if (snapshot.roots.size() != 2)
+    FatalError((infile + ": snapshot must hold asserts and a query").c_str());
+
+  ASTNode asserts = snapshot.roots[0];
+  if (!snapshot.solverMap.empty())
+    asserts = bm->CreateNode(
+        AND, asserts, substitutionsAsFormula(bm, snapshot.solverMap));
+
+  AssertsQuery->push_back(asserts);
+  AssertsQuery->push_back(snapshot.roots[1]);
+}
+
 int Main::create_and_parse_options(int /*argc*/, char** /*argv*/)
 {
   return 0;
@@ -281,17 +305,31 @@ int Main::main(int argc, char** argv)
 
   STP* stp = new STP(bm);
 
+  if (!server_address.empty())
+    return serve(stp);
+
   GlobalSTP = stp;
-  // If we're not reading the file from stdin.
-  if (!infile.empty())
-    read_file();
 
   // want to print the output always from the commandline.
   bm->UserFlags.print_output_flag = true;
   ASTVec* AssertsQuery = new ASTVec;
 
   bm->GetRunTimes()->start(RunTimes::Parsing);
-  parse_file(AssertsQuery);
+  if (!infile.empty() && isSnapshot(infile))
+  {
+    read_snapshot(AssertsQuery);
+  }
+  else
+  {
+    // If we're not reading the file from stdin.
+    if (!infile.empty())
+      read_file();
+
+    if (!snapshot_out.empty() && bm->UserFlags.smtlib2_parser_flag)
+      FatalError("Snapshots can't be saved from SMT-LIB2 input");
+
+    parse_file(AssertsQuery);
+  }
   bm->GetRunTimes()->stop(RunTimes::Parsing);
 
   GlobalSTP = NULL;
@@ -312,6 +350,15 @@ int Main::main(int argc, char** argv)
     ASTNode asserts = (*AssertsQuery)[0];
     ASTNode query = (*AssertsQuery)[1];
 
+    if (!snapshot_out.empty())
+    {
+      Snapshot snapshot;
+      snapshot.roots.push_back(asserts);
+      snapshot.roots.push_back(query);
+      if (!saveSnapshot(snapshot, snapshot_out))
+        FatalError(("Can't write the snapshot " + snapshot_out).c_str());
+    }
+
     if (onePrintBack)
     {
       print_back(query, asserts);
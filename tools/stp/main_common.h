@@ -47,6 +47,7 @@ public:
   void parse_file(ASTVec* AssertsQuery);
   void print_back(ASTNode& query, ASTNode& asserts);
   void read_file();
+  void read_snapshot(ASTVec* AssertsQuery);
   void printVersionInfo();
 
   STPMgr* bm;
@@ -59,6 +60,16 @@ public:
   std::string infile;
   void check_infile_type();
 
+  // Save the parsed input to this file as a snapshot, if it's set.
+  std::string snapshot_out;
+
+  // Serve requests from a Unix socket at this path, or from stdin if it's
+  // "-", instead of solving one input.
+  std::string server_address;
+  int server_workers = 1;
+  int serve(stp::STP* stp);
+  void serve_requests(stp::STP* stp, int listener);
+
 };
 
 #endif //__MAIN_COMMON_H__
@@ -0,0 +1,361 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+/*
+ * Server mode. The server answers SMT-LIB2 scripts, or snapshots, without
+ * starting a new process and STPMgr for each one, and with the CNF and AIG
+ * rewriting tables already built.
+ *
+ * A request is its length in bytes as decimal digits, a newline, and then
+ * the script. The response is framed the same way, and holds what the
+ * script printed. A client may send any number of requests. Each script
+ * starts afresh, as if it began with (reset).
+ *
+ * The simplifier's caches aren't kept between requests. STP empties them
+ * before each query is bit-blasted anyway, and what they hold depends on
+ * the request's assertions and symbols.
+ *
+ * The server reads requests from stdin, or accepts connections on a Unix
+ * socket. Sockets are served by a pool of worker processes, each forked
+ * from the warmed-up server. STP gives up on some errors by exiting, so a
+ * worker that dies is replaced. On a socket its client sees the connection
+ * close; on stdin the response is an error.
+ */
+
+#include "main_common.h"
+#include "extlib-abc/cnf_short.h"
+#include "stp/Parser/parser.h"
+#include "stp/STPManager/Snapshot.h"
+#include "stp/ToSat/AIGPipeline.h"
+
+#if !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(_MSC_VER)
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace stp;
+
+namespace
+{
+volatile sig_atomic_t stopping = 0;
+
+void stop(int)
+{
+  stopping = 1;
+}
+
+// Unlike signal(), doesn't restart the calls it interrupts, so the server
+// sees the flag rather than waiting on in waitpid().
+void onSignal(int signum, void (*handler)(int))
+{
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = handler;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = 0;
+  sigaction(signum, &action, NULL);
+}
+
+bool readAll(int fd, char* buffer, size_t size)
+{
+  while (size > 0)
+  {
+    const ssize_t n = read(fd, buffer, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    buffer += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool writeAll(int fd, const char* buffer, size_t size)
+{
+  while (size > 0)
+  {
+    const ssize_t n = write(fd, buffer, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    buffer += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Reads the length a byte at a time, so nothing past the frame is consumed.
+bool readFrame(int fd, std::string& frame)
+{
+  size_t size = 0;
+  int digits = 0;
+  char c;
+  while (true)
+  {
+    if (!readAll(fd, &c, 1))
+      return false;
+    if (c == '\n' && digits > 0)
+      break;
+    if (c < '0' || c > '9' || ++digits > 18)
+      return false;
+    size = size * 10 + (c - '0');
+  }
+
+  frame.resize(size);
+  return size == 0 || readAll(fd, &frame[0], size);
+}
+
+bool writeFrame(int fd, const std::string& frame)
+{
+  const std::string length = std::to_string(frame.size()) + "\n";
+  return writeAll(fd, length.data(), length.size()) &&
+         writeAll(fd, frame.data(), frame.size());
+}
+
+// Runs requests on one STP, and collects what they print.
+class Worker
+{
+  STPMgr* bm;
+  STP* stp;
+  TypeChecker typeChecker;
+  Cpp_interface parser;
+  FILE* capture;
+
+  void runScript(const std::string& script)
+  {
+    FILE* in = fmemopen(const_cast<char*>(script.data()), script.size(), "r");
+    if (in == NULL)
+      FatalError("Can't read the request");
+    setSMT2In(in);
+    SMT2Parse();
+    smt2lex_destroy();
+    fclose(in);
+    parser.reset();
+  }
+
+  void runSnapshot(const std::string& bytes)
+  {
+    Snapshot snapshot;
+    std::string error;
+    if (!loadSnapshot(bm, bytes.data(), bytes.size(), snapshot, error) ||
+        snapshot.roots.size() != 2)
+    {
+      parser.error(error.empty() ? "snapshot must hold asserts and a query"
+                                 : error);
+      return;
+    }
+
+    ASTNode asserts = snapshot.roots[0];
+    if (!snapshot.solverMap.empty())
+      asserts = bm->CreateNode(AND, asserts,
+                               substitutionsAsFormula(bm, snapshot.solverMap));
+
+    stp->ClearAllTables();
+    bm->ClearAllTables();
+    stp->tosat->PrintOutput(stp->TopLevelSTP(asserts, snapshot.roots[1]));
+  }
+
+public:
+  Worker(STPMgr* bm_, STP* stp_)
+      : bm(bm_), stp(stp_), typeChecker(*bm->defaultNodeFactory, *bm),
+        parser(*bm, &typeChecker), capture(tmpfile())
+  {
+    if (capture == NULL)
+      FatalError("Can't create a file for the server's output");
+    parser.startup();
+  }
+
+  ~Worker() { fclose(capture); }
+
+  std::string run(const std::string& request)
+  {
+    const int captured = fileno(capture);
+    if (ftruncate(captured, 0) != 0)
+      FatalError("Can't reuse the server's output file");
+
+    // Everything STP prints goes to stdout, so point stdout at the file.
+    fflush(stdout);
+    const int saved = dup(STDOUT_FILENO);
+    dup2(captured, STDOUT_FILENO);
+
+    GlobalSTP = stp;
+    GlobalParserInterface = &parser;
+    if (isSnapshot(request.data(), request.size()))
+      runSnapshot(request);
+    else if (!request.empty())
+      runScript(request);
+    GlobalParserInterface = NULL;
+    GlobalSTP = NULL;
+
+    std::cout.flush();
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::string response(lseek(captured, 0, SEEK_END), '\0');
+    if (!response.empty() &&
+        pread(captured, &response[0], response.size(), 0) !=
+            (ssize_t)response.size())
+      FatalError("Can't read the server's output file");
+    lseek(captured, 0, SEEK_SET);
+    return response;
+  }
+};
+
+int listenOn(const std::string& path)
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    FatalError("The server's socket path is too long");
+  strcpy(address.sun_path, path.c_str());
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    FatalError("Can't create the server's socket");
+  unlink(path.c_str());
+  if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(fd, SOMAXCONN) != 0)
+    FatalError(("Can't listen on " + path).c_str());
+  return fd;
+}
+} // namespace
+
+// Serves requests until the input ends, for stdin, or until a signal.
+void Main::serve_requests(STP* stp, int listener)
+{
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+
+  Worker worker(bm, stp);
+  std::string request;
+  if (listener < 0)
+  {
+    const int out = dup(STDOUT_FILENO);
+    while (readFrame(STDIN_FILENO, request))
+      if (!writeFrame(out, worker.run(request)))
+        break;
+    return;
+  }
+
+  while (true)
+  {
+    const int client = accept(listener, NULL, NULL);
+    if (client < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      FatalError("The server can't accept connections");
+    }
+    while (readFrame(client, request))
+      if (!writeFrame(client, worker.run(request)))
+        break;
+    close(client);
+  }
+}
+
+int Main::serve(STP* stp)
+{
+  bm->UserFlags.print_output_flag = true;
+  bm->UserFlags.smtlib1_parser_flag = false;
+  bm->UserFlags.smtlib2_parser_flag = true;
+  bm->UserFlags.keep_cnf_memory = true;
+
+  // Build the tables once, so that every worker starts with them.
+  Cnf_ManPrepare();
+  AIGPipeline::startLibrary();
+
+  const bool onStdin = (server_address == "-");
+  const int listener = onStdin ? -1 : listenOn(server_address);
+  const int count = onStdin ? 1 : std::max(1, server_workers);
+
+  onSignal(SIGINT, stop);
+  onSignal(SIGTERM, stop);
+  signal(SIGPIPE, SIG_IGN);
+
+  fflush(stdout);
+  std::vector<pid_t> workers;
+  auto spawn = [&]() {
+    const pid_t pid = fork();
+    if (pid < 0)
+      FatalError("The server can't start a worker");
+    if (pid == 0)
+    {
+      serve_requests(stp, listener);
+      exit(0);
+    }
+    workers.push_back(pid);
+  };
+  for (int i = 0; i < count; i++)
+    spawn();
+
+  while (!stopping)
+  {
+    int status;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    workers.erase(std::remove(workers.begin(), workers.end(), pid),
+                  workers.end());
+
+    const bool finished = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (onStdin && finished)
+      break;
+    if (onStdin)
+      writeFrame(STDOUT_FILENO, "error(\"the request stopped STP\")\n");
+    spawn();
+  }
+
+  for (pid_t pid : workers)
+    kill(pid, SIGTERM);
+  for (pid_t pid : workers)
+    waitpid(pid, NULL, 0);
+
+  if (listener >= 0)
+  {
+    close(listener);
+    unlink(server_address.c_str());
+  }
+  return 0;
+}
+
+#else
+
+int Main::serve(stp::STP*)
+{
+  FatalError("Server mode isn't available on this platform");
+}
+
+#endif
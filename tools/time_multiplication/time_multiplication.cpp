@@ -0,0 +1,227 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+// Compares the multiplication encodings on a few shapes of multiplication.
+// For each, prints the size of the CNF and how long the SAT solver took,
+// for each of the fixed variants and for the adaptive choice (variant 0).
+
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+
+#include "extlib-constbv/constantbv.h"
+#include "stp/STPManager/STP.h"
+#include "stp/STPManager/STPManager.h"
+#include "stp/Sat/MinisatCore.h"
+#include "stp/Util/StopWatch.h"
+
+using namespace stp;
+
+const int variants[] = {0, 1, 3, 4, 6, 7, 8, 9, 13};
+
+// Gives up on a query after this many conflicts.
+int64_t max_conflicts = 200000;
+
+// Width "width" with the low "bits" bits free, the rest zero.
+ASTNode narrow(STPMgr* mgr, const std::string& name, unsigned width,
+               unsigned bits)
+{
+  const ASTNode v = mgr->CreateSymbol(name.c_str(), 0, bits);
+  if (bits == width)
+    return v;
+  return mgr->CreateTerm(BVCONCAT, width, mgr->CreateZeroConst(width - bits),
+                         v);
+}
+
+ASTNode hex(STPMgr* mgr, const std::string& digits, unsigned width)
+{
+  std::string s;
+  while (s.size() * 4 < width)
+    s += digits;
+  s = s.substr(0, (width + 3) / 4);
+  return mgr->CreateBVConst(s, 16, width);
+}
+
+ASTNode product(STPMgr* mgr, const ASTNode& a, const ASTNode& b)
+{
+  return mgr->CreateTerm(BVMULT, a.GetValueWidth(), a, b);
+}
+
+ASTNode greaterThanOne(STPMgr* mgr, const ASTNode& a)
+{
+  return mgr->CreateNode(BVGT, a, mgr->CreateOneConst(a.GetValueWidth()));
+}
+
+// x * y = c, with x and y both greater than one, and only half as wide as
+// the product. So splitting c into two factors.
+ASTNode factor(STPMgr* mgr, unsigned width)
+{
+  const ASTNode x = narrow(mgr, "x", width, width / 2);
+  const ASTNode y = narrow(mgr, "y", width, width / 2);
+
+  // Two primes a little below 2^(width/2 - 1).
+  const uint64_t primes[] = {11, 13, 251, 241, 4093, 4091, 65521, 65519};
+  const unsigned p = std::min<unsigned>(width / 8 - 1, 3);
+  const ASTNode c = mgr->CreateBVConst(width, primes[2 * p] * primes[2 * p + 1]);
+
+  return mgr->CreateNode(AND, mgr->CreateNode(EQ, product(mgr, x, y), c),
+                         greaterThanOne(mgr, x), greaterThanOne(mgr, y));
+}
+
+// x * k = c, for a constant k whose bits are in long runs.
+ASTNode constantRuns(STPMgr* mgr, unsigned width)
+{
+  const ASTNode x = mgr->CreateSymbol("x", 0, width);
+  const ASTNode k = hex(mgr, "f00f", width);
+  return mgr->CreateNode(EQ, product(mgr, x, k), hex(mgr, "1234567", width));
+}
+
+// x * k = c, for a constant k whose bits alternate.
+ASTNode constantAlternating(STPMgr* mgr, unsigned width)
+{
+  const ASTNode x = mgr->CreateSymbol("x", 0, width);
+  const ASTNode k = hex(mgr, "5", width);
+  return mgr->CreateNode(EQ, product(mgr, x, k), hex(mgr, "2468ace", width));
+}
+
+// Only the low byte of x * y is read.
+ASTNode lowBits(STPMgr* mgr, unsigned width)
+{
+  const ASTNode x = mgr->CreateSymbol("x", 0, width);
+  const ASTNode y = mgr->CreateSymbol("y", 0, width);
+  const ASTNode low = mgr->CreateTerm(BVEXTRACT, 8, product(mgr, x, y),
+                                      mgr->CreateBVConst(32, 7),
+                                      mgr->CreateBVConst(32, 0));
+  return mgr->CreateNode(AND, mgr->CreateNode(EQ, low, hex(mgr, "2b", 8)),
+                         greaterThanOne(mgr, x), greaterThanOne(mgr, y));
+}
+
+// Products of 8, 16, 32 and "width" bits, in one query.
+ASTNode mixed(STPMgr* mgr, unsigned width)
+{
+  ASTVec conjuncts;
+  for (unsigned w = 8; w <= width; w *= 2)
+  {
+    const std::string suffix = std::to_string(w);
+    const ASTNode x = mgr->CreateSymbol(("x" + suffix).c_str(), 0, w);
+    const ASTNode y = mgr->CreateSymbol(("y" + suffix).c_str(), 0, w);
+    const ASTNode z = mgr->CreateSymbol(("z" + suffix).c_str(), 0, w);
+    // (x * y) * z = 6, with x, y and z > 1.
+    conjuncts.push_back(mgr->CreateNode(
+        EQ, product(mgr, product(mgr, x, y), z), mgr->CreateBVConst(w, 30)));
+    conjuncts.push_back(greaterThanOne(mgr, x));
+    conjuncts.push_back(greaterThanOne(mgr, y));
+    conjuncts.push_back(greaterThanOne(mgr, z));
+  }
+  return mgr->CreateNode(AND, conjuncts);
+}
+
+struct Case
+{
+  const char* name;
+  ASTNode (*build)(STPMgr*, unsigned);
+  unsigned widths[4];
+};
+
+const Case cases[] = {
+    {"factor", factor, {8, 16, 24, 32}},
+    {"const-runs", constantRuns, {16, 32, 64, 128}},
+    {"const-alternating", constantAlternating, {16, 32, 64, 128}},
+    {"low-bits", lowBits, {16, 32, 64, 128}},
+    {"mixed", mixed, {8, 16, 32, 64}},
+};
+
+void run(const Case& c, unsigned width, int variant, uint64_t& clauses,
+         clock_t& time)
+{
+  STPMgr* mgr = new STPMgr();
+  STP* stp = new STP(mgr);
+  mgr->UserFlags.multiplication_variant = variant;
+
+  const ASTNode form = c.build(mgr, width);
+
+  MinisatCore solver;
+  solver.setMaxConflicts(max_conflicts);
+
+  Stopwatch s;
+  const bool sat = stp->tosat->CallSAT(solver, form, false);
+  time = s.stop2();
+  clauses = solver.nClauses();
+
+  std::cout << c.name << " & " << width << " & " << variant << " & "
+            << solver.nVars() << " vars & " << clauses << " clauses & "
+            << std::fixed << std::setprecision(3)
+            << (float(time) / CLOCKS_PER_SEC) << "s & "
+            << (mgr->soft_timeout_expired ? "timeout" : (sat ? "sat" : "unsat"))
+            << std::endl;
+
+  delete stp;
+  delete mgr;
+}
+
+int main(int argc, char** argv)
+{
+  CONSTANTBV::BitVector_Boot();
+
+  if (argc > 1)
+    max_conflicts = atoll(argv[1]);
+
+  std::cout << "%case & width & variant & variables & clauses & time & result"
+            << std::endl;
+
+  for (const Case& c : cases)
+  {
+    for (unsigned width : c.widths)
+    {
+      // The smallest CNF, and the quickest solve, of the fixed variants.
+      uint64_t best_clauses = ~0ULL;
+      clock_t best_time = ~0UL >> 1;
+      uint64_t adaptive_clauses = 0;
+      clock_t adaptive_time = 0;
+
+      for (int variant : variants)
+      {
+        uint64_t clauses;
+        clock_t time;
+        run(c, width, variant, clauses, time);
+        if (variant == 0)
+        {
+          adaptive_clauses = clauses;
+          adaptive_time = time;
+        }
+        else
+        {
+          best_clauses = std::min(best_clauses, clauses);
+          best_time = std::min(best_time, time);
+        }
+      }
+
+      std::cout << "%" << c.name << " " << width << " adaptive/best clauses "
+                << std::setprecision(2)
+                << (double)adaptive_clauses / std::max<uint64_t>(best_clauses, 1)
+                << " time "
+                << (double)adaptive_time / std::max<clock_t>(best_time, 1)
+                << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+/********************************************************************
+ *
+ *
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+********************************************************************/
+
+// Times node creation through the SimplifyingNodeFactory with the compiled
+// rewrite rules on and off. The same random DAG is built in both runs.
+
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+
+#include "extlib-constbv/constantbv.h"
+#include "stp/NodeFactory/RuleMatcher.h"
+#include "stp/NodeFactory/SimplifyingNodeFactory.h"
+#include "stp/STPManager/STPManager.h"
+#include "stp/Util/StopWatch.h"
+
+using namespace stp;
+
+const unsigned bitWidth = 16;
+const unsigned symbols = 20;
+
+const Kind term_kinds[] = {BVAND, BVOR,  BVXOR, BVNOT, BVPLUS, BVSUB,
+                           BVMULT, BVUMINUS, BVDIV, BVMOD};
+const Kind pred_kinds[] = {EQ, BVGT, BVSGT, BVLT};
+
+void run(const unsigned nodes, const bool rules)
+{
+  STPMgr* mgr = new STPMgr();
+  SimplifyingNodeFactory* snf =
+      new SimplifyingNodeFactory(*(mgr->hashingNodeFactory), *mgr);
+  mgr->defaultNodeFactory = snf;
+  NodeFactory* nf = snf;
+  mgr->UserFlags.enable_rewrite_rules = rules;
+
+  std::mt19937 rng(1);
+  ASTVec terms;
+  for (unsigned i = 0; i < symbols; i++)
+  {
+    const std::string name = "v" + std::to_string(i);
+    terms.push_back(mgr->CreateSymbol(name.c_str(), 0, bitWidth));
+  }
+
+  // Mostly pick recent terms, so that patterns spanning several nodes occur.
+  auto pick = [&]() -> const ASTNode {
+    const size_t window = std::min<size_t>(terms.size(), 32);
+    if (rng() % 4 == 0)
+      return terms[rng() % terms.size()];
+    return terms[terms.size() - 1 - rng() % window];
+  };
+
+  Stopwatch s;
+  for (unsigned i = 0; i < nodes; i++)
+  {
+    if (rng() % 8 == 0)
+    {
+      const Kind k = pred_kinds[rng() % (sizeof(pred_kinds) / sizeof(Kind))];
+      nf->CreateNode(k, pick(), pick());
+      continue;
+    }
+
+    const Kind k = term_kinds[rng() % (sizeof(term_kinds) / sizeof(Kind))];
+    const ASTNode a = pick();
+    // Reusing a child, or its complement, is what most of the rules need.
+    ASTNode b;
+    switch (rng() % 4)
+    {
+      case 0:
+        b = a;
+        break;
+      case 1:
+        b = nf->CreateTerm(BVNOT, bitWidth, a);
+        break;
+      default:
+        b = pick();
+    }
+
+    if (k == BVNOT || k == BVUMINUS)
+      terms.push_back(nf->CreateTerm(k, bitWidth, a));
+    else
+      terms.push_back(nf->CreateTerm(k, bitWidth, a, b));
+  }
+  const clock_t t = s.stop2();
+
+  const RuleMatcher& matcher = snf->getRuleMatcher();
+  const ASTNodeSet distinct(terms.begin(), terms.end());
+
+  std::cout << (rules ? "rules on " : "rules off") << " & " << std::fixed
+            << std::setprecision(3) << (float(t) / CLOCKS_PER_SEC) << "s"
+            << " & " << std::setprecision(0)
+            << (nodes * (double)CLOCKS_PER_SEC / std::max<clock_t>(t, 1))
+            << " nodes/s"
+            << " & " << distinct.size() << " distinct terms"
+            << " & " << matcher.rulesApplied() << " rewrites"
+            << " & " << matcher.edgesVisited() << " edges" << std::endl;
+
+  mgr->defaultNodeFactory = mgr->hashingNodeFactory;
+  delete snf;
+  delete mgr;
+}
+
+int main(int argc, char** argv)
+{
+  CONSTANTBV::BitVector_Boot();
+
+  const unsigned nodes = (argc > 1) ? atoi(argv[1]) : 200000;
+  std::cout << "%rules " << RuleMatcher::numberOfRules() << " nodes " << nodes
+            << " bit-width " << bitWidth << std::endl;
+
+  run(nodes, false);
+  run(nodes, true);
+  run(nodes, false);
+  run(nodes, true);
+
+  return 0;
+}